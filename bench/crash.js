@@ -0,0 +1,154 @@
+'use strict';
+
+const fs = require('node:fs');
+const os = require('node:os');
+const path = require('node:path');
+const { spawn, spawnSync } = require('node:child_process');
+
+const root = path.resolve(__dirname, '..');
+
+// Printed right before the crash, with the monotonic time in ns
+const MARKER = 'bench-crash';
+
+
+// A child that recurses `depth` JS frames deep, then crashes with the given settings
+const getChildScript = (config) => `
+const fs = require('node:fs');
+const sf = require(${JSON.stringify(root)});
+${config.format === 'none' ? 'sf.setSignal(sf.SIGSEGV, false);' : `
+sf.setOutputFormat(${config.format.endsWith('json')});
+sf.setRawAddresses(${config.format.startsWith('raw')});
+sf.setUnwinder('${config.unwinder}');
+sf.setCaptureOptions({ maxFrames: 256 });
+`}
+const recurse = (n) => {
+	if (n) {
+		return recurse(n - 1) + 1;
+	}
+	fs.writeSync(1, '${MARKER} ' + process.hrtime.bigint() + '\\n');
+	sf.causeSegfault();
+	return 0;
+};
+recurse(${config.depth});
+`;
+
+
+// Milliseconds from the marker to the exit of the child, and the bytes it wrote to stderr
+const runOnce = (config, cwd) => new Promise((resolve, reject) => {
+	const child = spawn(process.execPath, ['-e', getChildScript(config)], { cwd });
+	let stdout = '';
+	let stderrBytes = 0;
+	child.stdout.on('data', (data) => { stdout += data; });
+	child.stderr.on('data', (data) => { stderrBytes += data.length; });
+	child.on('error', reject);
+	child.on('exit', (_code, signal) => {
+		const exitTime = process.hrtime.bigint();
+		child.on('close', () => {
+			const found = stdout.match(new RegExp(`${MARKER} (\\d+)`));
+			if (!found) {
+				reject(new Error(`No marker from the child (${signal})`));
+				return;
+			}
+			resolve({ ms: Number(exitTime - BigInt(found[1])) / 1e6, stderrBytes, signal });
+		});
+	});
+});
+
+
+const hasStrace = () => spawnSync('strace', ['-V'], { stdio: 'ignore' }).status === 0;
+
+// Syscalls made by the crashing thread after the marker, and the bytes it wrote to
+// anything but stdout. Needs `strace`.
+const traceOnce = (config, cwd) => {
+	const tracePath = path.join(cwd, 'trace.txt');
+	spawnSync(
+		'strace',
+		['-f', '-qq', '-s', '0', '-o', tracePath, process.execPath, '-e', getChildScript(config)],
+		{ cwd, stdio: 'ignore' },
+	);
+	const lines = fs.readFileSync(tracePath, 'utf8').split('\n');
+	fs.rmSync(tracePath, { force: true });
+
+	// The marker is the first write to stdout, strings are not printed
+	const markerIndex = lines.findIndex((line) => /^\d+ write\(1, /.test(line));
+	if (markerIndex < 0) {
+		return null;
+	}
+	const tid = lines[markerIndex].split(' ')[0];
+	let syscalls = 0;
+	let bytes = 0;
+	lines.slice(markerIndex + 1).forEach((line) => {
+		if (!line.startsWith(`${tid} `) || /^\d+ (---|\+\+\+|<\.\.\.)/.test(line)) {
+			return;
+		}
+		syscalls++;
+		const write = line.match(/^\d+ (?:write|writev|pwrite64)\((\d+),.*= (\d+)$/);
+		if (write && write[1] !== '1') {
+			bytes += Number(write[2]);
+		}
+	});
+	return { syscalls, bytes };
+};
+
+
+const median = (values) => {
+	const sorted = [...values].sort((a, b) => a - b);
+	const middle = Math.floor(sorted.length / 2);
+	return sorted.length % 2 ? sorted[middle] : (sorted[middle - 1] + sorted[middle]) / 2;
+};
+
+
+const getCrashConfigs = () => {
+	const configs = [{ name: 'baseline', format: 'none', unwinder: 'cfi', depth: 8 }];
+	['text', 'json', 'raw-text', 'raw-json'].forEach((format) => {
+		['cfi', 'fp'].forEach((unwinder) => {
+			[8, 64, 200].forEach((depth) => {
+				configs.push({ name: `${format}/${unwinder}/${depth}`, format, unwinder, depth });
+			});
+		});
+	});
+	return configs;
+};
+
+
+// Crash a fresh process `runs` times per configuration. The baseline has the handler
+// off, its latency is the cost of the crash and exit themselves.
+const runCrashBenchmarks = async ({ runs, filter, log }) => {
+	const cwd = fs.mkdtempSync(path.join(os.tmpdir(), 'segfault-bench-'));
+	const useStrace = hasStrace();
+	const results = [];
+	try {
+		for (const config of getCrashConfigs()) {
+			if (filter && !config.name.includes(filter) && config.name !== 'baseline') {
+				continue;
+			}
+			const samples = [];
+			for (let i = 0; i < runs; i++) {
+				samples.push(await runOnce(config, cwd));
+			}
+			const traced = useStrace ? traceOnce(config, cwd) : null;
+			const result = {
+				name: `crash/${config.name}`,
+				format: config.format,
+				unwinder: config.unwinder,
+				depth: config.depth,
+				runs,
+				signal: samples[0].signal,
+				latencyMs: median(samples.map((sample) => sample.ms)),
+				minLatencyMs: Math.min(...samples.map((sample) => sample.ms)),
+				stderrBytes: median(samples.map((sample) => sample.stderrBytes)),
+				syscalls: traced ? traced.syscalls : null,
+				bytesWritten: traced ? traced.bytes : null,
+			};
+			log(`${result.name}: ${result.latencyMs.toFixed(2)} ms, ${result.stderrBytes} B` +
+				(traced ? `, ${traced.syscalls} syscalls` : ''));
+			results.push(result);
+		}
+	} finally {
+		fs.rmSync(cwd, { recursive: true, force: true });
+	}
+	return { results, strace: useStrace };
+};
+
+
+module.exports = { runCrashBenchmarks, median };
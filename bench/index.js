@@ -0,0 +1,97 @@
+#!/usr/bin/env node
+'use strict';
+
+// Crash handling benchmarks: end-to-end crash latency, syscalls and bytes written per output
+// format, unwinder and stack depth, and microbenchmarks of the capture, symbolization and
+// decoding primitives.
+// Usage: node bench [--runs N] [--filter text] [--crash-only | --micro-only] [--out file]
+//     [--baseline file] [--threshold 0.25]
+// Prints JSON results to STDOUT, or to `--out`. With `--baseline`, exits with 1 if any result
+// is slower than the baseline by more than `--threshold`.
+
+const fs = require('node:fs');
+const os = require('node:os');
+const { runCrashBenchmarks } = require('./crash');
+const { runMicroBenchmarks } = require('./micro');
+
+
+const args = process.argv.slice(2);
+const getArg = (name, fallback) => {
+	const index = args.indexOf(name);
+	return index >= 0 && index + 1 < args.length ? args[index + 1] : fallback;
+};
+const log = (message) => process.stderr.write(`${message}\n`);
+
+
+const getLibc = () => {
+	if (process.platform !== 'linux') {
+		return null;
+	}
+	const { glibcVersionRuntime } = process.report.getReport().header;
+	return glibcVersionRuntime ? `glibc ${glibcVersionRuntime}` : 'musl';
+};
+
+// Latency for crashes, time per call for microbenchmarks: lower is better for both
+const getCost = (result) => (result.latencyMs !== undefined ? result.latencyMs : result.nsPerOp);
+
+const compare = (results, baseline, threshold) => {
+	const previous = new Map(baseline.results.map((result) => [result.name, getCost(result)]));
+	return results.filter((result) => {
+		const before = previous.get(result.name);
+		return before && getCost(result) > before * (1 + threshold);
+	}).map((result) => ({
+		name: result.name,
+		before: previous.get(result.name),
+		after: getCost(result),
+	}));
+};
+
+
+const main = async () => {
+	const runs = Number(getArg('--runs', 5));
+	const filter = getArg('--filter', null);
+	const output = {
+		meta: {
+			time: new Date().toISOString(),
+			node: process.version,
+			platform: process.platform,
+			arch: process.arch,
+			libc: getLibc(),
+			cpu: os.cpus()[0] && os.cpus()[0].model,
+		},
+		results: [],
+	};
+
+	if (!args.includes('--micro-only')) {
+		const crash = await runCrashBenchmarks({ runs, filter, log });
+		output.meta.strace = crash.strace;
+		output.results.push(...crash.results);
+	}
+	if (!args.includes('--crash-only')) {
+		const micro = await runMicroBenchmarks({ filter, log });
+		output.results.push(...micro.results);
+	}
+
+	const baselinePath = getArg('--baseline', null);
+	if (baselinePath) {
+		const threshold = Number(getArg('--threshold', 0.25));
+		output.regressions = compare(output.results, JSON.parse(fs.readFileSync(baselinePath, 'utf8')), threshold);
+		output.regressions.forEach(({ name, before, after }) => {
+			log(`REGRESSION ${name}: ${before.toFixed(3)} -> ${after.toFixed(3)}`);
+		});
+	}
+
+	const json = `${JSON.stringify(output, null, '\t')}\n`;
+	const outPath = getArg('--out', null);
+	if (outPath) {
+		fs.writeFileSync(outPath, json);
+	} else {
+		process.stdout.write(json);
+	}
+	process.exitCode = output.regressions && output.regressions.length ? 1 : 0;
+};
+
+main().catch((error) => {
+	log(error.stack);
+	process.exitCode = 2;
+});
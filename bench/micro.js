@@ -0,0 +1,109 @@
+'use strict';
+
+const fs = require('node:fs');
+const os = require('node:os');
+const path = require('node:path');
+const { spawnSync } = require('node:child_process');
+
+const Segfault = require('..');
+const { symbolizeReport } = require('../src/js/symbolize');
+const { median } = require('./crash');
+
+const root = path.resolve(__dirname, '..');
+const BATCHES = 5;
+const BATCH_MS = 100;
+
+
+// Nanoseconds per call, the median of a few batches of about `BATCH_MS` each
+const measure = async (fn) => {
+	const isAsync = fn() instanceof Promise;
+	const perBatch = [];
+	let iterations = 1;
+	for (;;) {
+		const start = process.hrtime.bigint();
+		for (let i = 0; i < iterations; i++) {
+			isAsync ? await fn() : fn();
+		}
+		const elapsed = Number(process.hrtime.bigint() - start);
+		if (elapsed >= BATCH_MS * 1e6 / 4) {
+			iterations = Math.max(1, Math.round(iterations * BATCH_MS * 1e6 / elapsed));
+			break;
+		}
+		iterations *= 2;
+	}
+	for (let b = 0; b < BATCHES; b++) {
+		const start = process.hrtime.bigint();
+		for (let i = 0; i < iterations; i++) {
+			isAsync ? await fn() : fn();
+		}
+		perBatch.push(Number(process.hrtime.bigint() - start) / iterations);
+	}
+	return { iterations, nsPerOp: median(perBatch) };
+};
+
+
+// One crash record and the matching raw text report, from a crashing child
+const getCrashArtifacts = () => {
+	const cwd = fs.mkdtempSync(path.join(os.tmpdir(), 'segfault-bench-'));
+	const recordPath = path.join(cwd, 'crash.bin');
+	const { stderr } = spawnSync(process.execPath, ['-e', `
+		const sf = require(${JSON.stringify(root)});
+		sf.setRawAddresses(true);
+		sf.setCrashRecordFile(${JSON.stringify(recordPath)});
+		sf.causeSegfault();
+	`], { cwd, encoding: 'utf8' });
+	const record = fs.existsSync(recordPath) ? fs.readFileSync(recordPath) : null;
+	fs.rmSync(cwd, { recursive: true, force: true });
+	return { record, rawReport: stderr };
+};
+
+const getProfile = () => {
+	Segfault.startProfiler({ hz: 1000 });
+	const until = Date.now() + 200;
+	let x = 0;
+	while (Date.now() < until) {
+		x += Math.sqrt(x + 1);
+	}
+	return Segfault.stopProfiler();
+};
+
+
+const runMicroBenchmarks = async ({ filter, log }) => {
+	const cases = [];
+	const add = (name, fn) => {
+		if (!filter || name.includes(filter)) {
+			cases.push({ name, fn });
+		}
+	};
+
+	if (process.platform !== 'win32') {
+		const stack = Segfault.captureStack({ format: 'buffer', maxFrames: 64 });
+		add('capture/buffer/64', () => Segfault.captureStack({ format: 'buffer', maxFrames: 64 }));
+		add('capture/array/64', () => Segfault.captureStack({ symbolize: false, maxFrames: 64 }));
+		add('capture/symbolized/64', () => Segfault.captureStack({ maxFrames: 64 }));
+		add('symbolize/async/64', () => Segfault.symbolizeStack(stack));
+	}
+
+	if (process.platform === 'linux') {
+		const { record, rawReport } = getCrashArtifacts();
+		if (record) {
+			add('record/decode', () => Segfault.decodeCrashRecord(record));
+		}
+		add('report/symbolize-offline', () => symbolizeReport(rawReport, { lines: false, demangle: false }));
+
+		const profile = getProfile();
+		add('profile/folded', () => Segfault.profileToFolded(profile));
+		add('profile/pprof', () => Segfault.profileToPprof(profile));
+	}
+
+	const results = [];
+	for (const { name, fn } of cases) {
+		const { iterations, nsPerOp } = await measure(fn);
+		log(`micro/${name}: ${(nsPerOp / 1000).toFixed(2)} us/op`);
+		results.push({ name: `micro/${name}`, iterations, nsPerOp });
+	}
+	return { results };
+};
+
+
+module.exports = { runMicroBenchmarks };
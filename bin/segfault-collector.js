@@ -0,0 +1,42 @@
+#!/usr/bin/env node
+'use strict';
+
+// Reference collector for socket crash sinks, e.g. in a log sidecar.
+// Usage: segfault-collector [--out file] <socket-path>
+// Listens at the socket path, and prints every report received to STDOUT, or appends it
+// to the file. Each report arrives whole, in the format of its sink.
+
+const fs = require('node:fs');
+const { openCrashCollector, readCrashCollector, closeCrashCollector } = require('..');
+
+// Reports are rare, polling keeps the collector free of native event loop glue
+const POLL_MS = 50;
+
+
+const args = process.argv.slice(2);
+const outAt = args.indexOf('--out');
+const outPath = outAt >= 0 ? args[outAt + 1] : null;
+const socketPath = args.find((arg, i) => !arg.startsWith('--') && (outAt < 0 || i !== outAt + 1));
+if (!socketPath) {
+	process.stderr.write('Usage: segfault-collector [--out file] <socket-path>\n');
+	process.exit(2);
+}
+
+const fd = openCrashCollector(socketPath);
+const out = outPath ? fs.openSync(outPath, 'a') : 1;
+process.stderr.write(`Listening at ${socketPath}\n`);
+
+const timer = setInterval(() => {
+	for (const report of readCrashCollector(fd)) {
+		fs.writeSync(out, report.endsWith('\n') ? report : `${report}\n`);
+	}
+}, POLL_MS);
+
+const stop = () => {
+	clearInterval(timer);
+	closeCrashCollector(fd);
+	fs.rmSync(socketPath, { force: true });
+	process.exit(0);
+};
+process.on('SIGINT', stop);
+process.on('SIGTERM', stop);
@@ -0,0 +1,26 @@
+#!/usr/bin/env node
+'use strict';
+
+// Decode binary crash records written with `setCrashRecordFile()`.
+// Usage: segfault-decode [--symbolize] [--no-lines] [--no-demangle] [record-file]
+// Reads records from STDIN when no file is given, prints one JSON report per line to STDOUT.
+
+const fs = require('node:fs');
+const { decodeCrashRecords } = require('../src/js/crash-record');
+const { symbolizeReport } = require('../src/js/symbolize');
+
+
+const args = process.argv.slice(2);
+const files = args.filter((arg) => !arg.startsWith('--'));
+
+const records = fs.readFileSync(files.length ? files[0] : 0);
+const reports = decodeCrashRecords(records).map((report) => JSON.stringify(report)).join('\n');
+
+if (!args.includes('--symbolize')) {
+	process.stdout.write(`${reports}\n`);
+} else {
+	process.stdout.write(`${symbolizeReport(reports, {
+		lines: !args.includes('--no-lines'),
+		demangle: !args.includes('--no-demangle'),
+	})}\n`);
+}
@@ -0,0 +1,20 @@
+#!/usr/bin/env node
+'use strict';
+
+// Symbolize crash reports written with `setRawAddresses(true)`.
+// Usage: segfault-symbolize [--no-lines] [--no-demangle] [report-file]
+// Reads the report from STDIN when no file is given, prints the result to STDOUT.
+
+const fs = require('node:fs');
+const { symbolizeReport } = require('../src/js/symbolize');
+
+
+const args = process.argv.slice(2);
+const options = {
+	lines: !args.includes('--no-lines'),
+	demangle: !args.includes('--no-demangle'),
+};
+const files = args.filter((arg) => !arg.startsWith('--'));
+
+const report = fs.readFileSync(files.length ? files[0] : 0, 'utf8');
+process.stdout.write(symbolizeReport(report, options));
@@ -1,6 +1,8 @@
 {
 	'variables': {
 		'arch': '<!(node -p "process.arch")',
+		# Diagnostic profile: SEGFAULT_DIAGNOSTIC=1 keeps frame pointers and debug info
+		'diagnostic': '<!(node -p "[\'1\', \'true\'].includes(process.env.SEGFAULT_DIAGNOSTIC) ? \'true\' : \'false\'")',
 	},
 	'conditions': [
 		['OS=="win"', {
@@ -16,8 +18,28 @@
 	'targets': [{
 		'target_name': 'vlad_fresha_segfault_handler',
 		'sources': [
+			'src/cpp/alt-stack.cpp',
 			'src/cpp/bindings.cpp',
+			'src/cpp/crash-dedup.cpp',
+			'src/cpp/crash-dump.cpp',
+			'src/cpp/crash-file.cpp',
+			'src/cpp/crash-guard.cpp',
+			'src/cpp/crash-record.cpp',
+			'src/cpp/crash-socket.cpp',
+			'src/cpp/emitter.cpp',
+			'src/cpp/handler-stats.cpp',
+			'src/cpp/journal.cpp',
+			'src/cpp/module-map.cpp',
+			'src/cpp/profiler.cpp',
+			'src/cpp/report-prologue.cpp',
+			'src/cpp/safe-memory.cpp',
 			'src/cpp/segfault-handler.cpp',
+			'src/cpp/symbol-cache.cpp',
+			'src/cpp/symbol-index.cpp',
+			'src/cpp/thread-dump.cpp',
+			'src/cpp/thread-registry.cpp',
+			'src/cpp/unwinder.cpp',
+			'src/cpp/watchdog.cpp',
 		],
 		'include_dirs': [
 			'<!@(node -p "require(\'node-addon-api\').include")',
@@ -25,6 +47,11 @@
 		'cflags_cc': ['-std=c++17', '-fno-exceptions', '-Wall', '-Werror', '-Wno-unused-result', '-Wno-unused-variable'],
 		'cflags': ['-O0', '-funwind-tables', '-fno-exceptions', '-Wall', '-Werror', '-Wno-unused-result', '-Wno-unused-variable'],
 		'conditions': [
+			['diagnostic=="true" and OS=="linux"', {
+				'defines': ['SEGFAULT_FRAME_POINTERS'],
+				'cflags+': ['-g', '-fno-omit-frame-pointer', '-mno-omit-leaf-frame-pointer'],
+				'cflags_cc+': ['-g', '-fno-omit-frame-pointer', '-mno-omit-leaf-frame-pointer'],
+			}],
 			['OS=="linux"', {
 				'defines': ['__linux__'],
 				'conditions': [
@@ -0,0 +1,205 @@
+# This file is generated by gyp; do not edit.
+
+TOOLSET := target
+TARGET := vlad_fresha_segfault_handler
+DEFS_Debug := \
+	'-DNODE_GYP_MODULE_NAME=vlad_fresha_segfault_handler' \
+	'-DUSING_UV_SHARED=1' \
+	'-DUSING_V8_SHARED=1' \
+	'-DV8_DEPRECATION_WARNINGS=1' \
+	'-D_GLIBCXX_USE_CXX11_ABI=1' \
+	'-D_FILE_OFFSET_BITS=64' \
+	'-D_LARGEFILE_SOURCE' \
+	'-D__STDC_FORMAT_MACROS' \
+	'-DOPENSSL_NO_PINSHARED' \
+	'-DOPENSSL_THREADS' \
+	'-D__linux__' \
+	'-DBUILDING_NODE_EXTENSION' \
+	'-DDEBUG' \
+	'-D_DEBUG'
+
+# Flags passed to all source files.
+CFLAGS_Debug := \
+	-fPIC \
+	-pthread \
+	-Wall \
+	-Wextra \
+	-Wno-unused-parameter \
+	-O0 \
+	-funwind-tables \
+	-fno-exceptions \
+	-Wall \
+	-Werror \
+	-Wno-unused-result \
+	-Wno-unused-variable \
+	-m64 \
+	-g \
+	-O0
+
+# Flags passed to only C files.
+CFLAGS_C_Debug :=
+
+# Flags passed to only C++ files.
+CFLAGS_CC_Debug := \
+	-fno-rtti \
+	-fno-exceptions \
+	-std=gnu++17 \
+	-std=c++17 \
+	-fno-exceptions \
+	-Wall \
+	-Werror \
+	-Wno-unused-result \
+	-Wno-unused-variable
+
+INCS_Debug := \
+	-I/usr/include/node \
+	-I/usr/src \
+	-I/usr/deps/openssl/config \
+	-I/usr/deps/openssl/openssl/include \
+	-I/usr/deps/uv/include \
+	-I/usr/deps/zlib \
+	-I/usr/deps/v8/include \
+	-I/tmp/shim/node_modules/node-addon-api
+
+DEFS_Release := \
+	'-DNODE_GYP_MODULE_NAME=vlad_fresha_segfault_handler' \
+	'-DUSING_UV_SHARED=1' \
+	'-DUSING_V8_SHARED=1' \
+	'-DV8_DEPRECATION_WARNINGS=1' \
+	'-D_GLIBCXX_USE_CXX11_ABI=1' \
+	'-D_FILE_OFFSET_BITS=64' \
+	'-D_LARGEFILE_SOURCE' \
+	'-D__STDC_FORMAT_MACROS' \
+	'-DOPENSSL_NO_PINSHARED' \
+	'-DOPENSSL_THREADS' \
+	'-D__linux__' \
+	'-DBUILDING_NODE_EXTENSION'
+
+# Flags passed to all source files.
+CFLAGS_Release := \
+	-fPIC \
+	-pthread \
+	-Wall \
+	-Wextra \
+	-Wno-unused-parameter \
+	-O0 \
+	-funwind-tables \
+	-fno-exceptions \
+	-Wall \
+	-Werror \
+	-Wno-unused-result \
+	-Wno-unused-variable \
+	-m64 \
+	-O3 \
+	-fno-omit-frame-pointer
+
+# Flags passed to only C files.
+CFLAGS_C_Release :=
+
+# Flags passed to only C++ files.
+CFLAGS_CC_Release := \
+	-fno-rtti \
+	-fno-exceptions \
+	-std=gnu++17 \
+	-std=c++17 \
+	-fno-exceptions \
+	-Wall \
+	-Werror \
+	-Wno-unused-result \
+	-Wno-unused-variable
+
+INCS_Release := \
+	-I/usr/include/node \
+	-I/usr/src \
+	-I/usr/deps/openssl/config \
+	-I/usr/deps/openssl/openssl/include \
+	-I/usr/deps/uv/include \
+	-I/usr/deps/zlib \
+	-I/usr/deps/v8/include \
+	-I/tmp/shim/node_modules/node-addon-api
+
+OBJS := \
+	$(obj).target/$(TARGET)/src/cpp/alt-stack.o \
+	$(obj).target/$(TARGET)/src/cpp/bindings.o \
+	$(obj).target/$(TARGET)/src/cpp/crash-dedup.o \
+	$(obj).target/$(TARGET)/src/cpp/crash-dump.o \
+	$(obj).target/$(TARGET)/src/cpp/crash-file.o \
+	$(obj).target/$(TARGET)/src/cpp/crash-guard.o \
+	$(obj).target/$(TARGET)/src/cpp/crash-record.o \
+	$(obj).target/$(TARGET)/src/cpp/crash-socket.o \
+	$(obj).target/$(TARGET)/src/cpp/emitter.o \
+	$(obj).target/$(TARGET)/src/cpp/handler-stats.o \
+	$(obj).target/$(TARGET)/src/cpp/journal.o \
+	$(obj).target/$(TARGET)/src/cpp/module-map.o \
+	$(obj).target/$(TARGET)/src/cpp/profiler.o \
+	$(obj).target/$(TARGET)/src/cpp/report-prologue.o \
+	$(obj).target/$(TARGET)/src/cpp/safe-memory.o \
+	$(obj).target/$(TARGET)/src/cpp/segfault-handler.o \
+	$(obj).target/$(TARGET)/src/cpp/symbol-cache.o \
+	$(obj).target/$(TARGET)/src/cpp/symbol-index.o \
+	$(obj).target/$(TARGET)/src/cpp/thread-dump.o \
+	$(obj).target/$(TARGET)/src/cpp/thread-registry.o \
+	$(obj).target/$(TARGET)/src/cpp/unwinder.o \
+	$(obj).target/$(TARGET)/src/cpp/watchdog.o
+
+# Add to the list of files we specially track dependencies for.
+all_deps += $(OBJS)
+
+# CFLAGS et al overrides must be target-local.
+# See "Target-specific Variable Values" in the GNU Make manual.
+$(OBJS): TOOLSET := $(TOOLSET)
+$(OBJS): GYP_CFLAGS := $(DEFS_$(BUILDTYPE)) $(INCS_$(BUILDTYPE))  $(CFLAGS_$(BUILDTYPE)) $(CFLAGS_C_$(BUILDTYPE))
+$(OBJS): GYP_CXXFLAGS := $(DEFS_$(BUILDTYPE)) $(INCS_$(BUILDTYPE))  $(CFLAGS_$(BUILDTYPE)) $(CFLAGS_CC_$(BUILDTYPE))
+
+# Suffix rules, putting all outputs into $(obj).
+
+$(obj).$(TOOLSET)/$(TARGET)/%.o: $(srcdir)/%.cpp FORCE_DO_CMD
+	@$(call do_cmd,cxx,1)
+
+# Try building from generated source, too.
+
+$(obj).$(TOOLSET)/$(TARGET)/%.o: $(obj).$(TOOLSET)/%.cpp FORCE_DO_CMD
+	@$(call do_cmd,cxx,1)
+
+$(obj).$(TOOLSET)/$(TARGET)/%.o: $(obj)/%.cpp FORCE_DO_CMD
+	@$(call do_cmd,cxx,1)
+
+# End of this set of suffix rules
+### Rules for final target.
+LDFLAGS_Debug := \
+	-pthread \
+	-rdynamic \
+	-m64
+
+LDFLAGS_Release := \
+	-pthread \
+	-rdynamic \
+	-m64
+
+LIBS :=
+
+$(obj).target/vlad_fresha_segfault_handler.node: GYP_LDFLAGS := $(LDFLAGS_$(BUILDTYPE))
+$(obj).target/vlad_fresha_segfault_handler.node: LIBS := $(LIBS)
+$(obj).target/vlad_fresha_segfault_handler.node: TOOLSET := $(TOOLSET)
+$(obj).target/vlad_fresha_segfault_handler.node: $(OBJS) FORCE_DO_CMD
+	$(call do_cmd,solink_module)
+
+all_deps += $(obj).target/vlad_fresha_segfault_handler.node
+# Add target alias
+.PHONY: vlad_fresha_segfault_handler
+vlad_fresha_segfault_handler: $(builddir)/vlad_fresha_segfault_handler.node
+
+# Copy this to the executable output path.
+$(builddir)/vlad_fresha_segfault_handler.node: TOOLSET := $(TOOLSET)
+$(builddir)/vlad_fresha_segfault_handler.node: $(obj).target/vlad_fresha_segfault_handler.node FORCE_DO_CMD
+	$(call do_cmd,copy)
+
+all_deps += $(builddir)/vlad_fresha_segfault_handler.node
+# Short alias for building this executable.
+.PHONY: vlad_fresha_segfault_handler.node
+vlad_fresha_segfault_handler.node: $(obj).target/vlad_fresha_segfault_handler.node $(builddir)/vlad_fresha_segfault_handler.node
+
+# Add executable to "all" target.
+.PHONY: all
+all: $(builddir)/vlad_fresha_segfault_handler.node
+
@@ -4,7 +4,11 @@
  */
 export declare const causeSegfault: () => void;
 export declare const causeDivisionInt: () => void;
-export declare const causeOverflow: () => void;
+/**
+ * Run infinite recursion (stack overflow)
+ * @param onThread On a new native thread, after 200 ms. Default: false
+ */
+export declare const causeOverflow: (onThread?: boolean) => void;
 export declare const causeIllegal: () => void;
 
 /**
@@ -26,6 +30,512 @@ export declare const setOutputFormat: (jsonOutput: boolean) => void;
  */
 export declare const getOutputFormat: () => boolean;
 
+/**
+ * Report raw addresses instead of symbols
+ * Frames only carry the PC, module path, module base and offset, which keeps the
+ * crash-time work minimal. Use `segfault-symbolize` to resolve them offline.
+ * @param rawAddresses Whether to skip symbolization in the handler
+ */
+export declare const setRawAddresses: (rawAddresses: boolean) => void;
+
+/**
+ * Get current raw address mode
+ * @returns Whether symbolization is skipped in the handler
+ */
+export declare const getRawAddresses: () => boolean;
+
+/**
+ * Append a compact binary record of each crash to a file
+ * The record (registers, raw frames, referenced modules) is written with a single `write()`,
+ * in addition to the usual report. Use `decodeCrashRecord()` or `segfault-decode` to read it.
+ * @param path File to append records to, `null` to stop writing them
+ */
+export declare const setCrashRecordFile: (path: string | null) => void;
+
+/**
+ * Get the file crash records are appended to
+ * @returns The file path, or `null` if records are off
+ */
+export declare const getCrashRecordFile: () => string | null;
+
+/**
+ * Copy every report into a pre-mapped crash journal file
+ * The file is mapped at this call, so the handler opens and writes nothing: reports land
+ * in the page cache even if the process dies mid-report, or has no free fds left.
+ * The journal is a ring, a journal of the same size is continued. Read it with `readCrashJournal()`.
+ * @param path Journal file, `null` to unmap it
+ * @param size Total file size in bytes, at least 16 KiB. Default: 1 MiB
+ */
+export declare const setCrashJournal: (path: string | null, size?: number) => void;
+
+/**
+ * Get the mapped crash journal
+ * @returns Path and size of the journal, or `null` if there is none
+ */
+export declare const getCrashJournal: () => { path: string; size: number } | null;
+
+export type TCrashDedupOptions = {
+	/** Full reports per signature per window, 0 to 1000000. Default: 3 */
+	limit?: number;
+	/** Window length in seconds, 1 to 2592000. Default: 3600 */
+	window?: number;
+};
+
+/**
+ * Deduplicate crash reports by stack signature, across restarts and processes
+ * The signature hashes the signal and the module-relative PCs of the crash stack. Counts are
+ * kept in a small table file, mapped at this call and shared by every process that maps it.
+ * Past `limit` reports of a signature in a window, a crash only gets a one-line
+ * `segfault_repeat` record. Not available on Windows.
+ * @param path Table file, `null` to unmap it
+ * @param options Report limit and window
+ */
+export declare const setCrashDedup: (path: string | null, options?: TCrashDedupOptions) => void;
+
+/**
+ * Get the crash dedup settings, `null` if it is off
+ */
+export declare const getCrashDedup: () => { path: string; limit: number; window: number } | null;
+
+export type TCrashSink = {
+	/**
+	 * `file` appends to `path`, or to "segfault.log" if it existed at startup.
+	 * `socket` sends each report as one message to the collector listening at `path`.
+	 * `directory` writes each report to a new file "crash-<pid>-<time>.json", ".log" or
+	 * ".summary.json" in
+	 * `path`, which appears there only once complete
+	 */
+	type: 'stderr' | 'file' | 'journal' | 'socket' | 'directory';
+	/**
+	 * `summary` is one JSON line of at most 4096 bytes (PIPE_BUF where it is smaller), written
+	 * in a single `write()`: signal, address, stack signature and the top 16 frames that fit.
+	 * Default: 'text'
+	 */
+	format?: 'text' | 'json' | 'summary';
+	/** File, socket and directory sinks only */
+	path?: string;
+};
+
+/**
+ * Choose where crash reports go, each sink in its own format
+ * The stack is unwound and symbolized once, then each format is composed once and written to
+ * all of its sinks. Without sinks, reports go to stderr, the journal and, for text reports,
+ * "segfault.log", in the format of `setOutputFormat()`. Not available on Windows.
+ * @param sinks Up to 8 sinks, `null` to go back to the default
+ */
+export declare const setCrashSinks: (sinks: TCrashSink[] | null) => void;
+
+/**
+ * Get the configured sinks, `null` if the default is used
+ */
+export declare const getCrashSinks: () => TCrashSink[] | null;
+
+/**
+ * Listen for crash reports of `socket` sinks at a Unix socket path
+ * A stale socket file at `path` is replaced. See "bin/segfault-collector.js". Linux only.
+ * @returns The listening descriptor
+ */
+export declare const openCrashCollector: (path: string) => number;
+
+/**
+ * Accept pending connections and receive the reports sent so far, one per item
+ * Doesn't block.
+ * @param fd As returned by `openCrashCollector()`
+ */
+export declare const readCrashCollector: (fd: number) => string[];
+
+/**
+ * Stop listening and drop the connections of `openCrashCollector()`
+ */
+export declare const closeCrashCollector: (fd: number) => void;
+
+/**
+ * Report the values of these environment variables with every crash
+ * Reports also carry the hostname, Node.js version, command line, working directory and
+ * build-ids of Node.js and this addon. All of it is rendered when the module loads, and
+ * again with this call, so that the handler only copies it: later changes to the working
+ * directory or the variables show up after calling this again. Unset variables are left out.
+ * @param names Up to 64 names, `null` for none
+ */
+export declare const setReportEnv: (names: string[] | null) => void;
+
+/**
+ * Get the names of the environment variables that are reported
+ */
+export declare const getReportEnv: () => string[];
+
+export type TCrashDumpOptions = {
+	/** Bytes of every thread's stack, from its stack pointer up, 0 to 1 MiB. Default: 32 KiB */
+	stackSize?: number;
+	/** Bytes around pointer-valued registers and the fault address, 0 to 64 KiB. Default: 256 */
+	windowSize?: number;
+};
+
+/**
+ * Write a crash dump file for every reported crash
+ * The dump holds the registers, frames and stack memory of the crashed thread, memory around
+ * its pointer-valued registers and the fault address, and the loaded modules with their
+ * build-ids. With `setThreadDump()`, other threads are included too. Files are named
+ * `segfault-<time>-<pid>.sfdump`, reports carry the path as `dump`. Read them with
+ * `decodeCrashDump()`. Not available on Windows.
+ * @param directory Where dumps go, `null` to stop writing them
+ * @param options Amounts of memory to copy
+ */
+export declare const setCrashDump: (directory: string | null, options?: TCrashDumpOptions) => void;
+
+/**
+ * Get the crash dump settings, `null` if it is off
+ */
+export declare const getCrashDump: () => { directory: string; stackSize: number; windowSize: number } | null;
+
+/**
+ * Report the stacks of all threads on a crash
+ * The handler signals every other thread with a real-time signal (`SIGRTMIN+5`), and waits
+ * for their stacks. JSON reports then have `tid`, `thread_name` and a `threads` array
+ * of `{ tid, name, captured, stack }`. Linux only.
+ * @param enabled Dump all threads, off by default
+ * @param timeout Milliseconds to wait for the other threads, 1 to 10000. Default: 500
+ */
+export declare const setThreadDump: (enabled: boolean, timeout?: number) => void;
+
+/**
+ * Get the thread dump settings, `null` if it is off
+ */
+export declare const getThreadDump: () => { timeout: number } | null;
+
+export type TPhaseStats = {
+	/** Reports timed */
+	count: number;
+	avgUs: number;
+	maxUs: number;
+	/** Element `i` counts durations under 2^i microseconds, the last one counts the rest */
+	histogram: number[];
+};
+
+export type THandlerStats = {
+	/** Signals handled, by signal number (exception code on Windows) */
+	signals: Record<number, number>;
+	/** Reports written in full */
+	reports: number;
+	/** Bytes of those reports, once per report whatever the number of targets */
+	bytes: number;
+	/** Crashes not reported in full: deduplicated, or concurrent with no slot left */
+	dropped: number;
+	phases: Record<'unwind' | 'symbolize' | 'format' | 'write', TPhaseStats>;
+};
+
+/**
+ * Get the counters of the crash handler since the process started
+ * Each report also ends with the time its phases took (`phases_us` in JSON),
+ * not counting its own final write, which the stats include.
+ */
+export declare const getHandlerStats: () => THandlerStats;
+
+/**
+ * Set the size of alternate signal stacks given to threads from now on
+ * Each stack has a guard page below it. Not available on Windows.
+ * @param size Bytes, 16384 to 16777216, rounded up to pages. Default: 65536
+ */
+export declare const setAltStackSize: (size: number) => void;
+
+/**
+ * Give every thread of the process an alternate signal stack
+ * Threads are asked with a real-time signal (`SIGRTMIN+6`) and take their stacks shortly after.
+ * Called by `setSignal()` too, and by `captureStack()` when threads started or exited.
+ * Linux only, elsewhere only the calling thread is covered.
+ * Returns the number of threads covered or asked.
+ */
+export declare const updateAltStacks: () => number;
+
+/**
+ * Get the alternate stack size and the number of threads running with one, `null` on Windows
+ */
+export declare const getAltStacks: () => { size: number; threads: number } | null;
+
+/**
+ * Read the reports kept in a crash journal, oldest first
+ * @param journal Path or contents of the journal file
+ */
+export declare const readCrashJournal: (journal: string | Uint8Array) => string;
+
+export type TProfilerOptions = {
+	/** Samples per second of CPU time, per thread, 1 to 1000. Default: 99 */
+	hz?: number;
+	/** Threads to sample: all running now, the calling one, or a list of TIDs. Default: 'all' */
+	threads?: 'all' | 'current' | number[];
+	/** Stack depth of a sample, 1 to 256. Default: 64 */
+	maxFrames?: number;
+	/** Bytes of the preallocated sample ring, samples are dropped once it is full. Default: 8 MiB */
+	bufferSize?: number;
+};
+
+export type TProfileLocation = {
+	/** Sampled PC; return addresses of callers are moved back into the call instruction */
+	address: number;
+	/** Index in `modules` */
+	module?: number;
+	/** Demangled function name */
+	symbol?: string;
+	symbolOffset?: number;
+};
+
+export type TProfile = {
+	hz: number;
+	/** Start time, milliseconds since the epoch */
+	startTime: number;
+	/** Wall time sampled, in nanoseconds */
+	duration: number;
+	samples: number;
+	/** Samples lost to a full ring, or to another thread being sampled at the same time */
+	dropped: number;
+	threads: number;
+	modules: { path: string; start: number; end: number; base: number }[];
+	locations: TProfileLocation[];
+	/** Distinct stacks with their sample counts, locations innermost first */
+	stacks: { tid: number; count: number; locations: number[] }[];
+};
+
+/**
+ * Start sampling native stacks
+ * Each thread gets a CPU-time timer that sends SIGPROF, and the handler records the stack
+ * with the built-in unwinder into a preallocated ring. Threads started later are not sampled.
+ * Linux only.
+ */
+export declare const startProfiler: (options?: TProfilerOptions) => void;
+
+/**
+ * Stop sampling and collect the profile, symbolized
+ */
+export declare const stopProfiler: () => TProfile;
+
+/**
+ * Format a profile as folded stacks ("outer;inner count" lines), for flame graph tools
+ */
+export declare const profileToFolded: (profile: TProfile) => string;
+
+/**
+ * Format a profile as gzipped pprof protobuf, e.g. for `go tool pprof`
+ */
+export declare const profileToPprof: (profile: TProfile) => Buffer;
+
+export type TStackFrame = {
+	/** Return address */
+	address: number;
+	/** Path of the module containing the address */
+	module?: string;
+	/** Load bias of the module */
+	base?: number;
+	/** Address minus `base` */
+	offset?: number;
+	/** Demangled function name, resolved at the call instruction */
+	symbol?: string;
+	symbolOffset?: number;
+};
+
+export type TStackOptions = {
+	/** Frames to capture, 1 to 256. Default: as set by `setCaptureOptions` */
+	maxFrames?: number;
+	/** Resolve modules and symbols, for the 'array' format. Default: true */
+	symbolize?: boolean;
+	/** An array, or a Buffer of native-endian 64-bit addresses. Default: 'array' */
+	format?: 'array' | 'buffer';
+};
+
+/**
+ * Capture the native stack of the calling thread, without a crash
+ * Frames start at the caller of the addon. Symbols come from an LRU cache shared with
+ * `symbolizeStack()`, so repeated captures are cheap. Not supported on Windows.
+ */
+export declare function captureStack(options: TStackOptions & { format: 'buffer' }): Buffer;
+export declare function captureStack(options: TStackOptions & { symbolize: false }): number[];
+export declare function captureStack(options?: TStackOptions): TStackFrame[];
+
+/**
+ * Symbolize addresses from `captureStack()` on the libuv threadpool
+ * @param frames Buffer or array of addresses
+ */
+export declare const symbolizeStack: (frames: Buffer | number[]) => Promise<TStackFrame[]>;
+
+export type TWatchdogOptions = {
+	/** Milliseconds without an event loop turn that count as a stall, 10 to 3600000. Default: 1000 */
+	threshold?: number;
+	/** Stack depth of a stall report, 1 to 256. Default: as set by `setCaptureOptions` */
+	maxFrames?: number;
+};
+
+/**
+ * Watch the event loop of the calling thread
+ * A separate thread checks a heartbeat timer of the loop. When the loop is blocked for longer
+ * than `threshold`, the stalled thread is interrupted with a real-time signal, its native
+ * stack is captured, and a non-fatal report (`"type":"stall"` in JSON) is written where
+ * crash reports go. One report per stall. Linux only.
+ */
+export declare const startWatchdog: (options?: TWatchdogOptions) => void;
+
+/**
+ * Stop watching the event loop
+ */
+export declare const stopWatchdog: () => void;
+
+/**
+ * Get the watchdog status, `null` if it is not running
+ */
+export declare const getWatchdog: () => ({ stalls: number } | null);
+
+export type TCrashFrame = {
+	frame: number;
+	address: string;
+	module?: string;
+	base?: string;
+	offset?: string;
+};
+
+export type TCrashReport = {
+	time: string;
+	level: 'ERROR';
+	type: 'segfault';
+	signal: number;
+	signal_name: string;
+	message: string;
+	address: string;
+	pid: number;
+	tid: number;
+	/** Register values at the crash, named after the recording architecture */
+	registers: Record<string, string>;
+	stack: TCrashFrame[];
+	/** Set if some module paths did not fit into the record */
+	truncated?: boolean;
+};
+
+/**
+ * Decode a binary crash record into the JSON report shape of raw address mode
+ * @param buffer Data holding the record, e.g. the contents of the record file
+ * @param offset Where the record starts. Default: 0
+ */
+export declare const decodeCrashRecord: (buffer: Uint8Array, offset?: number) => TCrashReport;
+
+export type TCrashDumpThread = {
+	tid: number;
+	name: string;
+	/** The thread that crashed, the others come from the thread dump */
+	crashed: boolean;
+	/** Register values, named after the recording architecture, empty if not captured */
+	registers: Record<string, string>;
+	/** Return addresses, innermost first */
+	stack: string[];
+};
+
+export type TCrashDump = {
+	time: string;
+	signal: number;
+	signal_name: string;
+	address: string;
+	pid: number;
+	tid: number;
+	stackSize: number;
+	windowSize: number;
+	threads: TCrashDumpThread[];
+	/** Readable memory copied at the crash, sorted by address */
+	memory: { address: string; size: number; data: Buffer }[];
+	modules: { path: string; base: string; start: string; end: string; buildId: string }[];
+	/** Set if the file ends within a stream */
+	truncated?: boolean;
+};
+
+/**
+ * Decode a crash dump file, as written with `setCrashDump()`
+ * @param buffer Contents of the dump file
+ */
+export declare const decodeCrashDump: (buffer: Uint8Array) => TCrashDump;
+
+/**
+ * Read memory of a decoded crash dump
+ * @param dump As returned by `decodeCrashDump()`
+ * @param address Where to read
+ * @param size How many bytes
+ * @returns A view into the dump, or `null` if the dump has no copy of all these bytes
+ */
+export declare const readCrashDumpMemory: (dump: TCrashDump, address: string | bigint, size: number) => Buffer | null;
+
+export type TFrameOptions = {
+	/** Frames to report, 1 to 256. Default: 32 */
+	maxFrames?: number;
+	/** Innermost frames of the crashed code to leave out, e.g. `abort()` internals. Default: 0 */
+	skipFrames?: number;
+};
+
+export type TCaptureOptions = TFrameOptions & {
+	/**
+	 * Overrides by signal number, missing fields come from the common options.
+	 * Replaces all previous overrides, `null` removes them.
+	 */
+	perSignal?: Record<number, TFrameOptions> | null;
+};
+
+/**
+ * Configure stack capture
+ * Handler and signal trampoline frames are never reported, the crash PC comes first.
+ * @param options common and per-signal depth and skip
+ */
+export declare const setCaptureOptions: (options: TCaptureOptions) => void;
+
+/**
+ * Get the stack capture configuration
+ * @returns Current options, `perSignal` only lists overridden fields
+ */
+export declare const getCaptureOptions: () => Required<TFrameOptions> & {
+	perSignal: Record<number, TFrameOptions>;
+};
+
+/**
+ * Stack walking method of the built-in unwinder (Linux x86_64 and aarch64)
+ * - `'cfi'` - DWARF CFI from `.eh_frame`, frame pointers where there is none. Default.
+ * - `'fp'` - frame pointer chain, validated against the thread's stack bounds,
+ * with CFI where the chain is broken. Fastest, needs frame pointers to be kept.
+ * Default in the diagnostic build (`SEGFAULT_DIAGNOSTIC=1`).
+ */
+export type TUnwinder = 'cfi' | 'fp';
+
+/**
+ * Select the stack walking method
+ * @param unwinder `'cfi'` or `'fp'`
+ */
+export declare const setUnwinder: (unwinder: TUnwinder) => void;
+
+/**
+ * Get the stack walking method
+ * @returns Current unwinder
+ */
+export declare const getUnwinder: () => TUnwinder;
+
+/**
+ * A loaded executable or shared library
+ */
+export type TModule = {
+	path: string;
+	/** Lowest mapped address */
+	start: number;
+	/** One past the highest mapped address */
+	end: number;
+	/** Load bias: runtime address minus ELF virtual address */
+	base: number;
+	/** Number of function symbols indexed for crash reports */
+	symbols: number;
+};
+
+/**
+ * Refresh the module table used to resolve crash addresses
+ * Called automatically after `process.dlopen()`. Only needed for libraries
+ * loaded by other means, e.g. `dlopen()` from native code.
+ */
+export declare const updateModules: () => void;
+
+/**
+ * Get the module table, sorted by address
+ * @returns Modules known to the crash handler (empty on Windows)
+ */
+export declare const getModules: () => TModule[];
+
 // Windows exception constants
 export declare const EXCEPTION_ALL: number | null;
 export declare const EXCEPTION_ACCESS_VIOLATION: number | null;
@@ -86,11 +596,53 @@ export declare const SIGWINCH: number | null;
 declare const segfault: {
 	causeSegfault: () => void;
 	causeDivisionInt: () => void;
-	causeOverflow: () => void;
+	causeOverflow: (onThread?: boolean) => void;
 	causeIllegal: () => void;
 	setSignal: (signalId: number | null, value: boolean) => void;
 	setOutputFormat: (jsonOutput: boolean) => void;
 	getOutputFormat: () => boolean;
+	setRawAddresses: (rawAddresses: boolean) => void;
+	getRawAddresses: () => boolean;
+	setCrashRecordFile: (path: string | null) => void;
+	getCrashRecordFile: () => string | null;
+	decodeCrashRecord: (buffer: Uint8Array, offset?: number) => TCrashReport;
+	setCrashJournal: (path: string | null, size?: number) => void;
+	getCrashJournal: () => { path: string; size: number } | null;
+	setCrashDedup: (path: string | null, options?: TCrashDedupOptions) => void;
+	getCrashDedup: () => { path: string; limit: number; window: number } | null;
+	setCrashSinks: (sinks: TCrashSink[] | null) => void;
+	getCrashSinks: () => TCrashSink[] | null;
+	openCrashCollector: (path: string) => number;
+	readCrashCollector: (fd: number) => string[];
+	closeCrashCollector: (fd: number) => void;
+	setReportEnv: (names: string[] | null) => void;
+	getReportEnv: () => string[];
+	setCrashDump: (directory: string | null, options?: TCrashDumpOptions) => void;
+	getCrashDump: () => { directory: string; stackSize: number; windowSize: number } | null;
+	decodeCrashDump: (buffer: Uint8Array) => TCrashDump;
+	readCrashDumpMemory: (dump: TCrashDump, address: string | bigint, size: number) => Buffer | null;
+	setThreadDump: (enabled: boolean, timeout?: number) => void;
+	getThreadDump: () => { timeout: number } | null;
+	getHandlerStats: () => THandlerStats;
+	setAltStackSize: (size: number) => void;
+	updateAltStacks: () => number;
+	getAltStacks: () => { size: number; threads: number } | null;
+	readCrashJournal: (journal: string | Uint8Array) => string;
+	startProfiler: (options?: TProfilerOptions) => void;
+	stopProfiler: () => TProfile;
+	profileToFolded: (profile: TProfile) => string;
+	profileToPprof: (profile: TProfile) => Buffer;
+	startWatchdog: (options?: TWatchdogOptions) => void;
+	stopWatchdog: () => void;
+	getWatchdog: () => ({ stalls: number } | null);
+	captureStack: typeof captureStack;
+	symbolizeStack: (frames: Buffer | number[]) => Promise<TStackFrame[]>;
+	setCaptureOptions: (options: TCaptureOptions) => void;
+	getCaptureOptions: () => Required<TFrameOptions> & { perSignal: Record<number, TFrameOptions> };
+	setUnwinder: (unwinder: TUnwinder) => void;
+	getUnwinder: () => TUnwinder;
+	updateModules: () => void;
+	getModules: () => TModule[];
 
 	// Windows exception constants
 	EXCEPTION_ALL: number | null;
@@ -9,6 +9,37 @@ if (global['segfault-raub']) {
 		require('./binding-options')
 	  );
 	
+	// Native addons loaded later show up in the module map right away
+	const { dlopen } = process;
+	process.dlopen = function (...args) {
+		try {
+			return dlopen.apply(this, args);
+		} finally {
+			core.updateModules();
+		}
+	};
+	
+	// The working directory in reports follows the process
+	const { chdir } = process;
+	process.chdir = function (...args) {
+		try {
+			return chdir.apply(this, args);
+		} finally {
+			core.setReportEnv(core.getReportEnv());
+		}
+	};
+	
+	core.decodeCrashRecord = require('./src/js/crash-record').decodeCrashRecord;
+	core.readCrashJournal = require('./src/js/journal').readCrashJournal;
+	
+	const { decodeCrashDump, readCrashDumpMemory } = require('./src/js/crash-dump');
+	core.decodeCrashDump = decodeCrashDump;
+	core.readCrashDumpMemory = readCrashDumpMemory;
+	
+	const { profileToFolded, profileToPprof } = require('./src/js/profile');
+	core.profileToFolded = profileToFolded;
+	core.profileToPprof = profileToPprof;
+	
 	global['segfault-raub'] = core;
 	module.exports = core;
 }
@@ -11,6 +11,48 @@ export const {
 	setSignal,
 	setOutputFormat,
 	getOutputFormat,
+	setRawAddresses,
+	getRawAddresses,
+	setCrashRecordFile,
+	getCrashRecordFile,
+	decodeCrashRecord,
+	setCrashJournal,
+	getCrashJournal,
+	setCrashDedup,
+	getCrashDedup,
+	setCrashSinks,
+	getCrashSinks,
+	openCrashCollector,
+	readCrashCollector,
+	closeCrashCollector,
+	setReportEnv,
+	getReportEnv,
+	setCrashDump,
+	getCrashDump,
+	decodeCrashDump,
+	readCrashDumpMemory,
+	setThreadDump,
+	getThreadDump,
+	getHandlerStats,
+	setAltStackSize,
+	updateAltStacks,
+	getAltStacks,
+	readCrashJournal,
+	startProfiler,
+	stopProfiler,
+	profileToFolded,
+	profileToPprof,
+	startWatchdog,
+	stopWatchdog,
+	getWatchdog,
+	captureStack,
+	symbolizeStack,
+	setCaptureOptions,
+	getCaptureOptions,
+	setUnwinder,
+	getUnwinder,
+	updateModules,
+	getModules,
 	// Signal constants
 	SIGINT,
 	SIGILL,
@@ -0,0 +1,342 @@
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#ifndef _WIN32
+#include <signal.h>
+#include <ucontext.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+#ifdef __linux__
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#endif
+
+#include "alt-stack.hpp"
+#include "thread-registry.hpp"
+
+
+namespace segfault {
+
+#ifndef _WIN32
+constexpr size_t MAX_ALT_STACKS = 1024;
+#ifdef __linux__
+constexpr size_t MAX_LISTED_THREADS = 4096;
+// Real-time signal that asks a thread to install a stack, next to the thread dump's
+constexpr int ALT_STACK_SIGNAL_OFFSET = 6;
+static bool _isHandlerInstalled = false;
+// Links of "/proc/self/task" at the last update, see `_getTaskLinks()`
+static std::atomic<uint64_t> _updatedLinks(0);
+// Some `AltStackSlot::stackPointer` waits to be registered
+static std::atomic<bool> _hasStackPointers(false);
+#endif
+
+enum AltStackState : int {
+	STACK_FREE = 0, // the mapping, if any, is ready for reuse
+	STACK_REQUESTED, // reserved for `tid`, waiting for its signal handler
+	STACK_ACTIVE, // installed on `tid`
+	STACK_FOREIGN, // `tid` had a stack of its own, the mapping is idle
+};
+
+struct AltStackSlot {
+	std::atomic<int> state;
+	int tid;
+	uint64_t startTime; // with `tid`, tells a thread from a later one that reuses its ID
+	std::atomic<uintptr_t> stackPointer; // seen by the signal handler, for the stack bounds
+	char *memory; // guard page, then the stack
+	size_t size; // of the stack, without the guard page
+};
+
+// Slots are filled before the count is published, the signal handler only reads them
+static AltStackSlot _slots[MAX_ALT_STACKS];
+static std::atomic<size_t> _slotCount(0);
+static std::mutex _poolMutex;
+static size_t _stackSize = DEFAULT_ALT_STACK_SIZE;
+
+
+static inline size_t _getPageSize() {
+	static size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	return pageSize;
+}
+
+static inline bool _hasAltStack() {
+	stack_t current;
+	return sigaltstack(nullptr, &current) == 0 && !(current.ss_flags & SS_DISABLE);
+}
+
+static inline bool _install(const AltStackSlot &slot) {
+	stack_t stack;
+	memset(&stack, 0, sizeof(stack));
+	stack.ss_sp = slot.memory + _getPageSize();
+	stack.ss_size = slot.size;
+	return sigaltstack(&stack, nullptr) == 0;
+}
+
+// Take a free slot for `tid`, with a mapping of the configured size. Call holding `_poolMutex`.
+static AltStackSlot *_reserveSlot(int tid, uint64_t startTime, int state) {
+	size_t count = _slotCount.load();
+	AltStackSlot *slot = nullptr;
+	for (size_t i = 0; i < count && !slot; i++) {
+		if (_slots[i].state.load() == STACK_FREE) {
+			slot = &_slots[i];
+		}
+	}
+	if (!slot) {
+		if (count >= MAX_ALT_STACKS) {
+			return nullptr;
+		}
+		slot = &_slots[count];
+		slot->state.store(STACK_FREE);
+		slot->memory = nullptr;
+		slot->size = 0;
+		_slotCount.store(count + 1);
+	}
+
+	size_t pageSize = _getPageSize();
+	if (slot->memory && slot->size != _stackSize) {
+		munmap(slot->memory, slot->size + pageSize);
+		slot->memory = nullptr;
+	}
+	if (!slot->memory) {
+		void *mapped = mmap(
+			nullptr, _stackSize + pageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0
+		);
+		if (mapped == MAP_FAILED) {
+			return nullptr;
+		}
+		// The stack grows down, into the guard page
+		if (mprotect(mapped, pageSize, PROT_NONE) != 0) {
+			munmap(mapped, _stackSize + pageSize);
+			return nullptr;
+		}
+		slot->memory = static_cast<char*>(mapped);
+		slot->size = _stackSize;
+	}
+
+	slot->tid = tid;
+	slot->startTime = startTime;
+	slot->stackPointer.store(0);
+	slot->state.store(state);
+	return slot;
+}
+
+
+// The stack of the calling thread goes back to the pool at thread exit
+struct LocalAltStack {
+	AltStackSlot *slot = nullptr;
+
+	~LocalAltStack() {
+		if (!slot) {
+			return;
+		}
+		stack_t disabled;
+		memset(&disabled, 0, sizeof(disabled));
+		disabled.ss_flags = SS_DISABLE;
+		sigaltstack(&disabled, nullptr);
+		slot->state.store(STACK_FREE);
+	}
+};
+static thread_local LocalAltStack _localStack;
+
+
+#ifdef __linux__
+// Procfs counts the threads of the process as links of the task directory, one `stat()` away
+static inline uint64_t _getTaskLinks() {
+	struct stat task;
+	return stat("/proc/self/task", &task) == 0 ? static_cast<uint64_t>(task.st_nlink) : 0;
+}
+
+// Returning from a handler restores the stack settings saved in its context, so the stack
+// is installed there rather than with `sigaltstack()`
+static void _handleAltStackSignal(int, siginfo_t *info, void *context) {
+	int savedErrno = errno;
+	if (info->si_code != SI_TKILL || info->si_pid != getpid()) {
+		errno = savedErrno;
+		return;
+	}
+
+	int tid = getCurrentThreadId();
+	size_t count = _slotCount.load();
+	for (size_t i = 0; i < count; i++) {
+		AltStackSlot &slot = _slots[i];
+		int expected = STACK_REQUESTED;
+		if (slot.tid != tid || !slot.state.compare_exchange_strong(expected, STACK_ACTIVE)) {
+			continue;
+		}
+		// The handler runs on the thread's own stack, its bounds are looked up in normal context
+		slot.stackPointer.store(reinterpret_cast<uintptr_t>(&savedErrno));
+		_hasStackPointers.store(true);
+		// E.g. another library has set one up for this thread
+		stack_t &stack = static_cast<ucontext_t*>(context)->uc_stack;
+		if (!(stack.ss_flags & SS_DISABLE)) {
+			slot.state.store(STACK_FOREIGN);
+		} else {
+			stack.ss_sp = slot.memory + _getPageSize();
+			stack.ss_size = slot.size;
+			stack.ss_flags = 0;
+		}
+		break;
+	}
+	errno = savedErrno;
+}
+#endif
+#endif
+
+
+DBG_EXPORT void setAltStackSize(size_t size) {
+#ifndef _WIN32
+	size = size < MIN_ALT_STACK_SIZE ? MIN_ALT_STACK_SIZE : size;
+	size = size > MAX_ALT_STACK_SIZE ? MAX_ALT_STACK_SIZE : size;
+	size_t pageSize = _getPageSize();
+	std::lock_guard<std::mutex> lock(_poolMutex);
+	_stackSize = (size + pageSize - 1) / pageSize * pageSize;
+#else
+	(void)size;
+#endif
+}
+
+DBG_EXPORT size_t getAltStackSize() {
+#ifndef _WIN32
+	std::lock_guard<std::mutex> lock(_poolMutex);
+	return _stackSize;
+#else
+	return 0;
+#endif
+}
+
+
+DBG_EXPORT bool ensureAltStack() {
+#ifndef _WIN32
+	if (_localStack.slot || _hasAltStack()) {
+		return true;
+	}
+	std::lock_guard<std::mutex> lock(_poolMutex);
+	int tid = getCurrentThreadId();
+	AltStackSlot *slot = _reserveSlot(tid, getThreadStartTime(tid), STACK_ACTIVE);
+	if (!slot) {
+		return false;
+	}
+	if (!_install(*slot)) {
+		slot->state.store(STACK_FREE);
+		return false;
+	}
+	_localStack.slot = slot;
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+DBG_EXPORT size_t updateAltStacks() {
+#ifdef __linux__
+	ensureAltStack();
+
+	// Threads started after this are seen by the next refresh
+	_updatedLinks.store(_getTaskLinks());
+	std::vector<int> tids(MAX_LISTED_THREADS);
+	tids.resize(listThreads(tids.data(), tids.size()));
+	std::vector<uint64_t> startTimes(tids.size());
+	for (size_t i = 0; i < tids.size(); i++) {
+		startTimes[i] = getThreadStartTime(tids[i]);
+	}
+	auto isAlive = [&tids, &startTimes](const AltStackSlot &slot) {
+		for (size_t i = 0; i < tids.size(); i++) {
+			if (tids[i] == slot.tid && startTimes[i] == slot.startTime) {
+				return true;
+			}
+		}
+		return false;
+	};
+
+	std::lock_guard<std::mutex> lock(_poolMutex);
+	int signalId = SIGRTMIN + ALT_STACK_SIGNAL_OFFSET;
+	if (!_isHandlerInstalled) {
+		struct sigaction action;
+		memset(&action, 0, sizeof(action));
+		sigemptyset(&action.sa_mask);
+		action.sa_sigaction = _handleAltStackSignal;
+		action.sa_flags = SA_SIGINFO | SA_RESTART;
+		if (sigaction(signalId, &action, nullptr) != 0) {
+			return 0;
+		}
+		_isHandlerInstalled = true;
+	}
+
+	size_t count = _slotCount.load();
+	_hasStackPointers.store(false);
+	for (size_t i = 0; i < count; i++) {
+		AltStackSlot &slot = _slots[i];
+		// The thread is gone, maybe with its ID taken by a new one. Its handler can't be running.
+		if (slot.state.load() != STACK_FREE && !isAlive(slot)) {
+			slot.state.store(STACK_FREE);
+			continue;
+		}
+		// Threads that never registered themselves get their stack bounds for the unwinder
+		uintptr_t low = 0;
+		uintptr_t high = 0;
+		uintptr_t stackPointer = slot.stackPointer.exchange(0);
+		if (stackPointer && findStackMapping(stackPointer, &low, &high)) {
+			registerThread(slot.tid, low, high);
+		}
+	}
+	forgetExitedThreads();
+
+	int pid = getpid();
+	int self = getCurrentThreadId();
+	size_t covered = 0;
+	for (size_t t = 0; t < tids.size(); t++) {
+		int tid = tids[t];
+		bool isKnown = tid == self;
+		for (size_t i = 0; i < _slotCount.load() && !isKnown; i++) {
+			isKnown = _slots[i].state.load() != STACK_FREE &&
+				_slots[i].tid == tid && _slots[i].startTime == startTimes[t];
+		}
+		if (isKnown) {
+			covered++;
+			continue;
+		}
+		AltStackSlot *slot = _reserveSlot(tid, startTimes[t], STACK_REQUESTED);
+		if (!slot) {
+			break;
+		}
+		if (syscall(SYS_tgkill, pid, tid, signalId) != 0) {
+			slot->state.store(STACK_FREE);
+			continue;
+		}
+		covered++;
+	}
+	return covered;
+#else
+	return ensureAltStack() ? 1 : 0;
+#endif
+}
+
+
+DBG_EXPORT void refreshAltStacks() {
+#ifdef __linux__
+	uint64_t links = _getTaskLinks();
+	if (links && links == _updatedLinks.load() && !_hasStackPointers.load()) {
+		return;
+	}
+#endif
+	updateAltStacks();
+}
+
+
+DBG_EXPORT size_t getAltStackCount() {
+	size_t active = 0;
+#ifndef _WIN32
+	size_t count = _slotCount.load();
+	for (size_t i = 0; i < count; i++) {
+		active += _slots[i].state.load() == STACK_ACTIVE;
+	}
+#endif
+	return active;
+}
+
+} // namespace segfault
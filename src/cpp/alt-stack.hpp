@@ -0,0 +1,47 @@
+#ifndef _ALT_STACK_HPP_
+#define _ALT_STACK_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#define DBG_EXPORT __declspec(dllexport)
+#else
+#define DBG_EXPORT
+#endif
+
+
+namespace segfault {
+	// Alternate signal stacks. `sigaltstack()` is per thread, and a stack overflow can only be
+	// reported on a thread that has one. Stacks come from a pool of mappings with a PROT_NONE
+	// guard page below, so an overflowing handler faults instead of corrupting memory.
+	constexpr size_t DEFAULT_ALT_STACK_SIZE = 64 * 1024;
+	constexpr size_t MIN_ALT_STACK_SIZE = 16 * 1024;
+	constexpr size_t MAX_ALT_STACK_SIZE = 16 * 1024 * 1024;
+
+	// Size of stacks assigned from now on, rounded up to pages. Threads keep their stacks.
+	DBG_EXPORT void setAltStackSize(size_t size);
+	DBG_EXPORT size_t getAltStackSize();
+
+	// Give the calling thread a stack from the pool, unless it has one already. It goes back
+	// to the pool at thread exit. Call in normal context.
+	DBG_EXPORT bool ensureAltStack();
+
+	// Ask every other thread of the process to take a stack from the pool, with a real-time
+	// signal, unless it has one already. Threads that blocked the signal take it once they
+	// unblock it. Stacks of threads that are gone are reclaimed, also if a new thread reuses
+	// the ID: threads are told apart by start time. Threads that took their stacks since the
+	// last update are registered with their stack bounds. Doesn't wait for the threads.
+	// Returns the number of threads covered or asked. Linux only, call in normal context.
+	DBG_EXPORT size_t updateAltStacks();
+
+	// `updateAltStacks()`, if threads started or exited since it last ran, or took stacks
+	// since and are to be registered. Cheap enough for every stack capture, to cover threads
+	// the process starts at any time. Normal context.
+	DBG_EXPORT void refreshAltStacks();
+
+	// Threads running with a stack from the pool
+	DBG_EXPORT size_t getAltStackCount();
+}
+
+#endif /* _ALT_STACK_HPP_ */
@@ -22,6 +22,7 @@
 
 Napi::Object initModule(Napi::Env env, Napi::Object exports) {
 	segfault::init();
+	segfault::renderPrologue(env);
 	
 	JS_SF_SET_METHOD(causeSegfault);
 	JS_SF_SET_METHOD(causeDivisionInt);
@@ -30,6 +31,42 @@ Napi::Object initModule(Napi::Env env, Napi::Object exports) {
 	JS_SF_SET_METHOD(setSignal);
 	JS_SF_SET_METHOD(setOutputFormat);
 	JS_SF_SET_METHOD(getOutputFormat);
+	JS_SF_SET_METHOD(setRawAddresses);
+	JS_SF_SET_METHOD(getRawAddresses);
+	JS_SF_SET_METHOD(setCrashRecordFile);
+	JS_SF_SET_METHOD(getCrashRecordFile);
+	JS_SF_SET_METHOD(setCrashJournal);
+	JS_SF_SET_METHOD(getCrashJournal);
+	JS_SF_SET_METHOD(setCrashDedup);
+	JS_SF_SET_METHOD(getCrashDedup);
+	JS_SF_SET_METHOD(setCrashSinks);
+	JS_SF_SET_METHOD(getCrashSinks);
+	JS_SF_SET_METHOD(openCrashCollector);
+	JS_SF_SET_METHOD(readCrashCollector);
+	JS_SF_SET_METHOD(closeCrashCollector);
+	JS_SF_SET_METHOD(setReportEnv);
+	JS_SF_SET_METHOD(getReportEnv);
+	JS_SF_SET_METHOD(setCrashDump);
+	JS_SF_SET_METHOD(getCrashDump);
+	JS_SF_SET_METHOD(setThreadDump);
+	JS_SF_SET_METHOD(getThreadDump);
+	JS_SF_SET_METHOD(getHandlerStats);
+	JS_SF_SET_METHOD(setAltStackSize);
+	JS_SF_SET_METHOD(updateAltStacks);
+	JS_SF_SET_METHOD(getAltStacks);
+	JS_SF_SET_METHOD(startProfiler);
+	JS_SF_SET_METHOD(stopProfiler);
+	JS_SF_SET_METHOD(startWatchdog);
+	JS_SF_SET_METHOD(stopWatchdog);
+	JS_SF_SET_METHOD(getWatchdog);
+	JS_SF_SET_METHOD(captureStack);
+	JS_SF_SET_METHOD(symbolizeStack);
+	JS_SF_SET_METHOD(updateModules);
+	JS_SF_SET_METHOD(getModules);
+	JS_SF_SET_METHOD(setCaptureOptions);
+	JS_SF_SET_METHOD(getCaptureOptions);
+	JS_SF_SET_METHOD(setUnwinder);
+	JS_SF_SET_METHOD(getUnwinder);
 	
 #ifdef _WIN32
 	JS_SF_CONSTANT(EXCEPTION_ACCESS_VIOLATION);
@@ -0,0 +1,232 @@
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "crash-dedup.hpp"
+#include "module-map.hpp"
+
+
+namespace segfault {
+
+static const char DEDUP_MAGIC[8] = { 'S', 'F', 'D', 'E', 'D', 'U', 'P', '1' };
+constexpr uint32_t DEDUP_VERSION = 1;
+// Yields while another process is seen writing the header, then the table is started over
+constexpr int DEDUP_INIT_SPINS = 1000;
+// A signature is looked for in this many entries from its home, then the stalest is reused
+constexpr size_t DEDUP_PROBES = 16;
+constexpr uint64_t FNV_OFFSET = 0xcbf29ce484222325ULL;
+constexpr uint64_t FNV_PRIME = 0x100000001b3ULL;
+
+struct DedupHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t headerSize;
+	uint32_t capacity;
+	uint8_t reserved[DEDUP_HEADER_SIZE - 20];
+};
+static_assert(sizeof(DedupHeader) == DEDUP_HEADER_SIZE, "Dedup header must be 64 bytes");
+
+struct DedupEntry {
+	uint64_t signature; // 0 if free
+	uint64_t window; // start second << 32 | count
+	uint64_t total;
+	uint64_t lastSeen;
+};
+static_assert(sizeof(DedupEntry) == 32, "Dedup entry must be 32 bytes");
+
+constexpr size_t DEDUP_FILE_SIZE = DEDUP_HEADER_SIZE + DEDUP_CAPACITY * sizeof(DedupEntry);
+
+static std::atomic<DedupHeader*> _table(nullptr);
+
+
+static inline uint64_t _hashBytes(uint64_t hash, const void *data, size_t size) {
+	const uint8_t *bytes = static_cast<const uint8_t*>(data);
+	for (size_t i = 0; i < size; i++) {
+		hash = (hash ^ bytes[i]) * FNV_PRIME;
+	}
+	return hash;
+}
+
+#ifndef _WIN32
+static inline DedupEntry *_getEntries(DedupHeader *header) {
+	return reinterpret_cast<DedupEntry*>(reinterpret_cast<char*>(header) + DEDUP_HEADER_SIZE);
+}
+
+// The entry of `signature`, claiming a free or the stalest probed one if it has none
+static inline DedupEntry *_findEntry(DedupHeader *header, uint64_t signature) {
+	DedupEntry *entries = _getEntries(header);
+	DedupEntry *stalest = nullptr;
+	for (size_t i = 0; i < DEDUP_PROBES; i++) {
+		DedupEntry *entry = &entries[(signature + i) % DEDUP_CAPACITY];
+		uint64_t current = __atomic_load_n(&entry->signature, __ATOMIC_ACQUIRE);
+		if (!current && __atomic_compare_exchange_n(
+			&entry->signature, &current, signature, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE
+		)) {
+			return entry;
+		}
+		if (current == signature) {
+			return entry;
+		}
+		if (!stalest || __atomic_load_n(&entry->lastSeen, __ATOMIC_RELAXED) < stalest->lastSeen) {
+			stalest = entry;
+		}
+	}
+
+	// Another process may take it over at the same time, the counts are then shared
+	uint64_t previous = __atomic_load_n(&stalest->signature, __ATOMIC_ACQUIRE);
+	if (__atomic_compare_exchange_n(
+		&stalest->signature, &previous, signature, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE
+	)) {
+		__atomic_store_n(&stalest->window, 0, __ATOMIC_RELEASE);
+		__atomic_store_n(&stalest->total, 0, __ATOMIC_RELEASE);
+	}
+	return stalest;
+}
+#endif
+
+
+DBG_EXPORT int openCrashDedup(const char *path) {
+#ifdef _WIN32
+	(void)path;
+	return ENOTSUP;
+#else
+	int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if (fd < 0) {
+		return errno;
+	}
+
+	struct stat status;
+	int error = 0;
+	if (fstat(fd, &status) != 0) {
+		error = errno;
+	} else if (static_cast<size_t>(status.st_size) != DEDUP_FILE_SIZE) {
+		// Zeroed by the kernel: an empty table, whoever else creates it at the same time
+		error = ftruncate(fd, static_cast<off_t>(DEDUP_FILE_SIZE)) != 0 ? errno : 0;
+	}
+	void *mapped = MAP_FAILED;
+	if (!error) {
+		mapped = mmap(nullptr, DEDUP_FILE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		error = mapped == MAP_FAILED ? errno : 0;
+	}
+	close(fd);
+	if (error) {
+		return error;
+	}
+
+	// The version is published last: with the layout matching, the header is complete.
+	// Until then, every process opening a new file writes the same header.
+	DedupHeader *header = static_cast<DedupHeader*>(mapped);
+	uint32_t version = __atomic_load_n(&header->version, __ATOMIC_ACQUIRE);
+	for (int i = 0; version == DEDUP_VERSION && i < DEDUP_INIT_SPINS; i++) {
+		if (__atomic_load_n(&header->headerSize, __ATOMIC_ACQUIRE)) {
+			break;
+		}
+		// Being written by another process
+		sched_yield();
+		version = __atomic_load_n(&header->version, __ATOMIC_ACQUIRE);
+	}
+	bool isOwnLayout = version == DEDUP_VERSION && header->headerSize == DEDUP_HEADER_SIZE &&
+		header->capacity == DEDUP_CAPACITY && !memcmp(header->magic, DEDUP_MAGIC, sizeof(DEDUP_MAGIC));
+	if (!isOwnLayout) {
+		// A table of another layout is started over
+		if (version) {
+			memset(mapped, 0, DEDUP_FILE_SIZE);
+		}
+		header->headerSize = DEDUP_HEADER_SIZE;
+		header->capacity = DEDUP_CAPACITY;
+		memcpy(header->magic, DEDUP_MAGIC, sizeof(DEDUP_MAGIC));
+		__atomic_store_n(&header->version, DEDUP_VERSION, __ATOMIC_RELEASE);
+	}
+
+	closeCrashDedup();
+	_table.store(header, std::memory_order_release);
+	return 0;
+#endif
+}
+
+
+DBG_EXPORT void closeCrashDedup() {
+	DedupHeader *header = _table.exchange(nullptr, std::memory_order_acq_rel);
+#ifndef _WIN32
+	if (header) {
+		munmap(header, DEDUP_FILE_SIZE);
+	}
+#else
+	(void)header;
+#endif
+}
+
+
+DBG_EXPORT bool isCrashDedupOpen() {
+	return _table.load(std::memory_order_acquire) != nullptr;
+}
+
+
+DBG_EXPORT uint64_t computeCrashSignature(uint32_t signal, void *const *frames, size_t count) {
+	uint64_t hash = _hashBytes(FNV_OFFSET, &signal, sizeof(signal));
+	for (size_t i = 0; i < count; i++) {
+		uintptr_t pc = reinterpret_cast<uintptr_t>(frames[i]);
+		const ModuleInfo *module = findModule(pc);
+		if (!module) {
+			continue;
+		}
+		// The file name only, the same build may be deployed to different directories
+		const char *name = module->path;
+		for (const char *c = module->path; *c; c++) {
+			if (*c == '/' || *c == '\\') {
+				name = c + 1;
+			}
+		}
+		uint64_t offset = pc - module->base;
+		hash = _hashBytes(hash, name, strlen(name));
+		hash = _hashBytes(hash, &offset, sizeof(offset));
+	}
+	// 0 marks free entries
+	return hash ? hash : 1;
+}
+
+
+DBG_EXPORT uint32_t countCrashSignature(uint64_t signature, uint32_t windowSec) {
+#ifdef _WIN32
+	(void)signature;
+	(void)windowSec;
+	return 0;
+#else
+	DedupHeader *header = _table.load(std::memory_order_acquire);
+	if (!header) {
+		return 0;
+	}
+	uint64_t now = static_cast<uint64_t>(time(nullptr));
+	DedupEntry *entry = _findEntry(header, signature ? signature : 1);
+	__atomic_store_n(&entry->lastSeen, now, __ATOMIC_RELAXED);
+	__atomic_fetch_add(&entry->total, 1, __ATOMIC_RELAXED);
+
+	// Start and count change together, so concurrent crashes never lose a window reset
+	uint64_t window = __atomic_load_n(&entry->window, __ATOMIC_ACQUIRE);
+	uint64_t next;
+	do {
+		uint64_t start = window >> 32;
+		uint64_t count = window & 0xffffffffULL;
+		if (now < start || now - start >= windowSec) {
+			start = now;
+			count = 0;
+		}
+		count = count < 0xffffffffULL ? count + 1 : count;
+		next = (start << 32) | count;
+	} while (!__atomic_compare_exchange_n(
+		&entry->window, &window, next, true, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE
+	));
+	return static_cast<uint32_t>(next & 0xffffffffULL);
+#endif
+}
+
+} // namespace segfault
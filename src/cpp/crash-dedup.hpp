@@ -0,0 +1,43 @@
+#ifndef _CRASH_DEDUP_HPP_
+#define _CRASH_DEDUP_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#define DBG_EXPORT __declspec(dllexport)
+#else
+#define DBG_EXPORT
+#endif
+
+
+namespace segfault {
+	// Crash dedup table: a small file mapped with MAP_SHARED, counting crashes per stack
+	// signature. Every process that maps the same file shares the counters, and they
+	// outlive restarts.
+	//
+	// Layout: a 64-byte header ("SFDEDUP1", u32 version, u32 header size, u32 capacity),
+	// then `capacity` 32-byte entries of u64 signature, u64 window state (start second
+	// in the high half, count in the low half), u64 total count, u64 last second seen.
+	// Entries are claimed with a CAS on the signature, and probed linearly.
+	constexpr size_t DEDUP_HEADER_SIZE = 64;
+	constexpr size_t DEDUP_CAPACITY = 512;
+
+	// Map the table at `path`, creating it if needed. Returns 0 or an errno value. Not
+	// signal-safe.
+	DBG_EXPORT int openCrashDedup(const char *path);
+	DBG_EXPORT void closeCrashDedup();
+	DBG_EXPORT bool isCrashDedupOpen();
+
+	// Stable hash of a crash: the signal, then each frame as its module file name and the
+	// offset into the module, so it survives ASLR and restarts. Frames outside of known
+	// modules (e.g. JIT code) are left out. Signal-safe.
+	DBG_EXPORT uint64_t computeCrashSignature(uint32_t signal, void *const *frames, size_t count);
+
+	// Count one crash with `signature` in the current window of `windowSec` seconds, a new
+	// window starts once it is over. Returns the count in the window, including this one,
+	// or 0 if no table is open. Signal-safe, safe across processes.
+	DBG_EXPORT uint32_t countCrashSignature(uint64_t signature, uint32_t windowSec);
+}
+
+#endif /* _CRASH_DEDUP_HPP_ */
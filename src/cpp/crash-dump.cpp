@@ -0,0 +1,383 @@
+#include <cerrno>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <limits.h>
+#include <unistd.h>
+#endif
+
+#include "crash-dump.hpp"
+#include "crash-file.hpp"
+#include "module-map.hpp"
+#include "safe-memory.hpp"
+#include "thread-dump.hpp"
+
+
+namespace segfault {
+
+#ifndef _WIN32
+constexpr uint32_t CRASH_DUMP_MAGIC = 0x44434653; // "SFCD" when little-endian
+constexpr size_t CRASH_DUMP_HEADER_SIZE = 64;
+constexpr size_t CRASH_DUMP_STREAM_SIZE = 16;
+constexpr size_t CRASH_DUMP_THREAD_SIZE = 32;
+constexpr size_t CRASH_DUMP_MODULE_SIZE = 32;
+constexpr size_t DUMP_BUFFER_SIZE = 64 * 1024;
+// Memory is copied in pieces `readMemory()` can take, aligned so that a piece never
+// straddles the end of a mapping
+constexpr size_t DUMP_CHUNK_SIZE = PIPE_BUF;
+constexpr size_t MAX_DUMP_REGIONS = 512;
+// Below the stack pointer, leaf functions may keep data without moving it (x86_64 ABI)
+constexpr uintptr_t STACK_RED_ZONE = 128;
+
+// Header field offsets
+enum : size_t {
+	CRASH_DUMP_MAGIC_AT = 0, // u32
+	CRASH_DUMP_VERSION_AT = 4, // u16
+	CRASH_DUMP_HEADER_SIZE_AT = 6, // u16
+	CRASH_DUMP_ARCH_AT = 8, // u16
+	CRASH_DUMP_SIGNAL_AT = 12, // u32
+	CRASH_DUMP_PID_AT = 16, // i32
+	CRASH_DUMP_TID_AT = 20, // i32
+	CRASH_DUMP_TIME_AT = 24, // i64, seconds
+	CRASH_DUMP_ADDRESS_AT = 32, // u64
+	CRASH_DUMP_STACK_SIZE_AT = 40, // u32
+	CRASH_DUMP_WINDOW_SIZE_AT = 44, // u32
+};
+
+struct MemoryRegion {
+	uintptr_t start;
+	uintptr_t end;
+};
+
+// Output is buffered, `offset` counts every byte appended so far
+struct DumpWriter {
+	int fd;
+	uint64_t offset;
+	size_t used;
+	bool isFailed;
+};
+
+static int _directoryFd = -1;
+static char _buffer[DUMP_BUFFER_SIZE];
+static MemoryRegion _regions[MAX_DUMP_REGIONS];
+
+
+template <typename T>
+static inline void _put(char *buffer, size_t offset, T value) {
+	memcpy(buffer + offset, &value, sizeof(T));
+}
+
+static inline void _flush(DumpWriter &writer) {
+	size_t done = 0;
+	while (done < writer.used && !writer.isFailed) {
+		ssize_t written = write(writer.fd, _buffer + done, writer.used - done);
+		if (written < 0 && errno == EINTR) {
+			continue;
+		}
+		writer.isFailed = written <= 0;
+		done += written > 0 ? static_cast<size_t>(written) : 0;
+	}
+	writer.used = 0;
+}
+
+// Make room for `size` more bytes in the buffer
+static inline char *_reserve(DumpWriter &writer, size_t size) {
+	if (writer.used + size > DUMP_BUFFER_SIZE) {
+		_flush(writer);
+	}
+	return _buffer + writer.used;
+}
+
+static inline void _append(DumpWriter &writer, const void *data, size_t size) {
+	memcpy(_reserve(writer, size), data, size);
+	writer.used += size;
+	writer.offset += size;
+}
+
+static inline void _pad(DumpWriter &writer) {
+	static const char zeros[8] = {};
+	_append(writer, zeros, (8 - writer.offset % 8) % 8);
+}
+
+// Overwrite bytes appended earlier, whether still buffered or already in the file
+static inline void _patch(DumpWriter &writer, uint64_t at, const void *data, size_t size) {
+	uint64_t flushed = writer.offset - writer.used;
+	if (at >= flushed) {
+		memcpy(_buffer + (at - flushed), data, size);
+		return;
+	}
+	ssize_t written = pwrite(writer.fd, data, size, static_cast<off_t>(at));
+	writer.isFailed = writer.isFailed || written != static_cast<ssize_t>(size);
+}
+
+static inline void _appendStream(DumpWriter &writer, uint32_t type, uint64_t size) {
+	char header[CRASH_DUMP_STREAM_SIZE] = {};
+	_put<uint32_t>(header, 0, type);
+	_put<uint64_t>(header, 8, size);
+	_append(writer, header, sizeof(header));
+}
+
+
+static inline void _appendThread(
+	DumpWriter &writer, int tid, uint16_t flags, const char *name,
+	const uint64_t *registers, size_t registerCount, void *const *frames, size_t count
+) {
+	char thread[CRASH_DUMP_THREAD_SIZE] = {};
+	_put<int32_t>(thread, 0, tid);
+	_put<uint16_t>(thread, 4, flags);
+	_put<uint16_t>(thread, 6, static_cast<uint16_t>(registerCount));
+	memcpy(thread + 8, name, strnlen(name, THREAD_NAME_SIZE - 1));
+	_put<uint32_t>(thread, 24, static_cast<uint32_t>(count));
+
+	_appendStream(writer, CRASH_DUMP_THREAD, sizeof(thread) + (registerCount + count) * sizeof(uint64_t));
+	_append(writer, thread, sizeof(thread));
+	_append(writer, registers, registerCount * sizeof(uint64_t));
+	for (size_t i = 0; i < count; i++) {
+		uint64_t frame = reinterpret_cast<uintptr_t>(frames[i]);
+		_append(writer, &frame, sizeof(frame));
+	}
+}
+
+// Copy the readable run of [start, end): unreadable chunks before it are skipped, the
+// first one after it ends the region. Nothing is written if no chunk is readable.
+static inline void _appendMemory(DumpWriter &writer, uintptr_t start, uintptr_t end) {
+	// The stream header stays in the buffer until the first chunk, so it can be taken back
+	_reserve(writer, CRASH_DUMP_STREAM_SIZE + sizeof(uint64_t) + DUMP_CHUNK_SIZE);
+	uint64_t headerAt = writer.offset;
+	_appendStream(writer, CRASH_DUMP_MEMORY, 0);
+	uint64_t address = start;
+	_append(writer, &address, sizeof(address));
+
+	uintptr_t first = 0;
+	uint64_t copied = 0;
+	for (uintptr_t at = start; at < end;) {
+		uintptr_t next = (at / DUMP_CHUNK_SIZE + 1) * DUMP_CHUNK_SIZE;
+		size_t size = static_cast<size_t>((next < end ? next : end) - at);
+		if (readMemory(at, _reserve(writer, size), size)) {
+			first = copied ? first : at;
+			copied += size;
+			writer.used += size;
+			writer.offset += size;
+		} else if (copied) {
+			break;
+		}
+		at += size;
+	}
+
+	if (!copied) {
+		writer.used -= static_cast<size_t>(writer.offset - headerAt);
+		writer.offset = headerAt;
+		return;
+	}
+	uint64_t streamSize = sizeof(address) + copied;
+	address = first;
+	_patch(writer, headerAt + 8, &streamSize, sizeof(streamSize));
+	_patch(writer, headerAt + CRASH_DUMP_STREAM_SIZE, &address, sizeof(address));
+	_pad(writer);
+}
+
+static inline void _appendModule(DumpWriter &writer, const ModuleInfo &module) {
+	size_t pathLength = strnlen(module.path, UINT16_MAX);
+	char entry[CRASH_DUMP_MODULE_SIZE] = {};
+	_put<uint64_t>(entry, 0, module.base);
+	_put<uint64_t>(entry, 8, module.start);
+	_put<uint64_t>(entry, 16, module.end);
+	_put<uint16_t>(entry, 24, static_cast<uint16_t>(pathLength));
+	_put<uint8_t>(entry, 26, module.buildIdSize);
+
+	_appendStream(writer, CRASH_DUMP_MODULE, sizeof(entry) + pathLength + module.buildIdSize);
+	_append(writer, entry, sizeof(entry));
+	_append(writer, module.path, pathLength);
+	_append(writer, module.buildId, module.buildIdSize);
+	_pad(writer);
+}
+
+
+static inline void _addRegion(size_t *count, uintptr_t start, uintptr_t end) {
+	// Nothing lives in the first page, these are integers rather than pointers
+	if (*count >= MAX_DUMP_REGIONS || end <= start || end <= DUMP_CHUNK_SIZE) {
+		return;
+	}
+	_regions[(*count)++] = { start & ~uintptr_t(7), (end + 7) & ~uintptr_t(7) };
+}
+
+static inline void _addWindow(size_t *count, uintptr_t center, uint32_t size) {
+	uintptr_t half = size / 2;
+	uintptr_t start = center > half ? center - half : 0;
+	_addRegion(count, start, center + half < center ? UINTPTR_MAX : center + half);
+}
+
+static inline void _addStack(
+	size_t *count, const uint64_t *registers, size_t registerCount, uint16_t arch, uint32_t size
+) {
+	int index = getStackPointerIndex(arch);
+	if (index < 0 || static_cast<size_t>(index) >= registerCount) {
+		return;
+	}
+	uintptr_t stackPointer = static_cast<uintptr_t>(registers[index]);
+	uintptr_t start = stackPointer > STACK_RED_ZONE ? stackPointer - STACK_RED_ZONE : 0;
+	_addRegion(count, start, stackPointer + size < stackPointer ? UINTPTR_MAX : stackPointer + size);
+}
+
+// Sort by address and merge overlapping regions, returns the new count
+static inline size_t _mergeRegions(size_t count) {
+	for (size_t i = 1; i < count; i++) {
+		MemoryRegion region = _regions[i];
+		size_t j = i;
+		for (; j && _regions[j - 1].start > region.start; j--) {
+			_regions[j] = _regions[j - 1];
+		}
+		_regions[j] = region;
+	}
+	size_t merged = 0;
+	for (size_t i = 0; i < count; i++) {
+		if (merged && _regions[i].start <= _regions[merged - 1].end) {
+			if (_regions[i].end > _regions[merged - 1].end) {
+				_regions[merged - 1].end = _regions[i].end;
+			}
+			continue;
+		}
+		_regions[merged++] = _regions[i];
+	}
+	return merged;
+}
+#endif
+
+
+DBG_EXPORT int openCrashDump(const char *directory) {
+#ifndef _WIN32
+	int fd = open(directory, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (fd < 0) {
+		return errno;
+	}
+	closeCrashDump();
+	// Fault the buffers in now, not at crash time
+	memset(_buffer, 0, sizeof(_buffer));
+	memset(static_cast<void*>(_regions), 0, sizeof(_regions));
+	_directoryFd = fd;
+	return 0;
+#else
+	(void)directory;
+	return ENOTSUP;
+#endif
+}
+
+DBG_EXPORT void closeCrashDump() {
+#ifndef _WIN32
+	if (_directoryFd >= 0) {
+		close(_directoryFd);
+		_directoryFd = -1;
+	}
+#endif
+}
+
+DBG_EXPORT bool isCrashDumpOpen() {
+#ifndef _WIN32
+	return _directoryFd >= 0;
+#else
+	return false;
+#endif
+}
+
+
+DBG_EXPORT bool writeCrashDump(
+	const CrashRecordInfo &info, const CrashDumpOptions &options,
+	void *context, void *const *frames, size_t count, size_t threadCount,
+	char *name, size_t nameSize
+) {
+#ifndef _WIN32
+	if (_directoryFd < 0 || !nameSize) {
+		return false;
+	}
+	// Collectors only ever see complete dumps
+	CrashFile file;
+	if (!openCrashFile(_directoryFd, &file)) {
+		return false;
+	}
+	DumpWriter writer = { file.fd, 0, 0, false };
+
+	uint64_t registers[MAX_CONTEXT_REGISTERS];
+	uint16_t arch = CRASH_RECORD_ARCH_UNKNOWN;
+	size_t registerCount = readContextRegisters(context, registers, &arch);
+
+	char header[CRASH_DUMP_HEADER_SIZE] = {};
+	_put<uint32_t>(header, CRASH_DUMP_MAGIC_AT, CRASH_DUMP_MAGIC);
+	_put<uint16_t>(header, CRASH_DUMP_VERSION_AT, CRASH_DUMP_VERSION);
+	_put<uint16_t>(header, CRASH_DUMP_HEADER_SIZE_AT, CRASH_DUMP_HEADER_SIZE);
+	_put<uint16_t>(header, CRASH_DUMP_ARCH_AT, arch);
+	_put<uint32_t>(header, CRASH_DUMP_SIGNAL_AT, info.signal);
+	_put<int32_t>(header, CRASH_DUMP_PID_AT, info.pid);
+	_put<int32_t>(header, CRASH_DUMP_TID_AT, info.tid);
+	_put<int64_t>(header, CRASH_DUMP_TIME_AT, info.time);
+	_put<uint64_t>(header, CRASH_DUMP_ADDRESS_AT, info.address);
+	_put<uint32_t>(header, CRASH_DUMP_STACK_SIZE_AT, options.stackSize);
+	_put<uint32_t>(header, CRASH_DUMP_WINDOW_SIZE_AT, options.windowSize);
+	_append(writer, header, sizeof(header));
+
+	char threadName[THREAD_NAME_SIZE];
+	readThreadName(threadName);
+	_appendThread(
+		writer, info.tid, CRASH_DUMP_THREAD_CRASHED, threadName, registers, registerCount, frames, count
+	);
+	size_t regionCount = 0;
+	_addStack(&regionCount, registers, registerCount, arch, options.stackSize);
+	if (options.windowSize) {
+		int stackPointer = getStackPointerIndex(arch);
+		for (size_t i = 0; i < registerCount; i++) {
+			if (static_cast<int>(i) != stackPointer) {
+				_addWindow(&regionCount, static_cast<uintptr_t>(registers[i]), options.windowSize);
+			}
+		}
+		_addWindow(&regionCount, static_cast<uintptr_t>(info.address), options.windowSize);
+	}
+
+	for (size_t i = 0; i < threadCount; i++) {
+		const DumpedThread *thread = getDumpedThread(i);
+		if (!thread) {
+			break;
+		}
+		size_t threadRegisters = thread->isCaptured ? thread->registerCount : 0;
+		_appendThread(
+			writer, thread->tid, 0, thread->name,
+			thread->registers, threadRegisters, thread->frames, thread->isCaptured ? thread->count : 0
+		);
+		_addStack(&regionCount, thread->registers, threadRegisters, thread->arch, options.stackSize);
+	}
+
+	regionCount = _mergeRegions(regionCount);
+	for (size_t i = 0; i < regionCount; i++) {
+		_appendMemory(writer, _regions[i].start, _regions[i].end);
+	}
+
+	size_t moduleCount = getModuleCount();
+	for (size_t i = 0; i < moduleCount; i++) {
+		const ModuleInfo *module = getModule(i);
+		if (module) {
+			_appendModule(writer, *module);
+		}
+	}
+
+	_flush(writer);
+	if (writer.isFailed) {
+		discardCrashFile(&file);
+		return false;
+	}
+	return commitCrashFile(
+		&file, "segfault-", static_cast<uint64_t>(info.time), static_cast<uint64_t>(info.pid), ".sfdump",
+		name, nameSize
+	);
+#else
+	(void)info;
+	(void)options;
+	(void)context;
+	(void)frames;
+	(void)count;
+	(void)threadCount;
+	(void)name;
+	(void)nameSize;
+	return false;
+#endif
+}
+
+} // namespace segfault
@@ -0,0 +1,70 @@
+#ifndef _CRASH_DUMP_HPP_
+#define _CRASH_DUMP_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "crash-record.hpp"
+
+#ifdef _WIN32
+#define DBG_EXPORT __declspec(dllexport)
+#else
+#define DBG_EXPORT
+#endif
+
+
+namespace segfault {
+	// Crash dump: registers, stack memory and modules of a crash, enough to unwind and
+	// inspect it offline. One file per crash, in native byte order (the magic tells which):
+	//
+	//   header   64 bytes, see `CRASH_DUMP_*` offsets in crash-dump.cpp
+	//   streams  { u32 type; u32 reserved; u64 size; payload } up to the end of the file,
+	//            the payload padded to 8 bytes
+	//
+	// Stream payloads, by type:
+	//   THREAD  { i32 tid; u16 flags; u16 registerCount; char name[16]; u32 frameCount; u32 reserved }
+	//           then u64 x registerCount (see `readContextRegisters()`), u64 x frameCount
+	//   MEMORY  { u64 address } then the bytes, readable ones only
+	//   MODULE  { u64 base; u64 start; u64 end; u16 pathLength; u8 buildIdLength; u8 reserved[5] }
+	//           then the path and the build-id
+	//
+	// Readers must skip unknown stream types: later versions may add some.
+	constexpr uint16_t CRASH_DUMP_VERSION = 1;
+
+	constexpr uint32_t DEFAULT_DUMP_STACK_SIZE = 32 * 1024;
+	constexpr uint32_t MAX_DUMP_STACK_SIZE = 1024 * 1024;
+	constexpr uint32_t DEFAULT_DUMP_WINDOW_SIZE = 256;
+	constexpr uint32_t MAX_DUMP_WINDOW_SIZE = 64 * 1024;
+
+	enum CrashDumpStream {
+		CRASH_DUMP_THREAD = 1,
+		CRASH_DUMP_MEMORY,
+		CRASH_DUMP_MODULE,
+	};
+
+	// The thread that crashed, other threads come from the thread dump
+	constexpr uint16_t CRASH_DUMP_THREAD_CRASHED = 1;
+
+	struct CrashDumpOptions {
+		uint32_t stackSize; // bytes of every thread's stack, from its stack pointer up
+		uint32_t windowSize; // bytes around pointer-valued registers and the fault address
+	};
+
+	// Open `directory` to write dumps into, kept open so that crashes need no path lookup.
+	// Returns 0 or an errno value. Not signal-safe.
+	DBG_EXPORT int openCrashDump(const char *directory);
+	DBG_EXPORT void closeCrashDump();
+	DBG_EXPORT bool isCrashDumpOpen();
+
+	// Write the dump of a crash into a new file of the directory: the crashed thread from
+	// `context` and `frames`, then the `threadCount` threads of `dumpThreads()`, then the
+	// loaded modules. The file appears once complete, see `CrashFile`, and its name goes to
+	// `name`. Returns false if nothing was written. Signal-safe.
+	DBG_EXPORT bool writeCrashDump(
+		const CrashRecordInfo &info, const CrashDumpOptions &options,
+		void *context, void *const *frames, size_t count, size_t threadCount,
+		char *name, size_t nameSize
+	);
+}
+
+#endif /* _CRASH_DUMP_HPP_ */
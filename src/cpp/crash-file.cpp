@@ -0,0 +1,189 @@
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#ifndef RENAME_NOREPLACE
+#define RENAME_NOREPLACE (1 << 0)
+#endif
+#endif
+
+#include "crash-file.hpp"
+
+
+namespace segfault {
+
+#ifndef _WIN32
+// A few tries for a free name, if files of other processes took this one
+constexpr int MAX_NAME_TRIES = 16;
+constexpr size_t MAX_NAME_SIZE = 128;
+// Two numbers, the try and the extension always fit after the prefix
+constexpr size_t NAME_SUFFIX_SIZE = 64;
+
+// Temporary names of concurrent crashes in one process must differ
+static std::atomic<uint32_t> _temporaryCount(0);
+
+
+static inline size_t _appendDecimal(char *out, uint64_t value) {
+	char digits[20];
+	size_t count = 0;
+	do {
+		digits[count++] = static_cast<char>('0' + value % 10);
+		value /= 10;
+	} while (value);
+	for (size_t i = 0; i < count; i++) {
+		out[i] = digits[count - 1 - i];
+	}
+	return count;
+}
+
+// Copy `text`, as long as it fits before `end`
+static inline size_t _appendText(char *out, const char *end, const char *text) {
+	size_t size = strlen(text);
+	size = size < static_cast<size_t>(end - out) ? size : static_cast<size_t>(end - out);
+	memcpy(out, text, size);
+	return size;
+}
+
+static inline bool _link(const CrashFile &file, const char *name) {
+	if (!file.temporary[0]) {
+#ifdef __linux__
+		char path[32] = "/proc/self/fd/";
+		path[14 + _appendDecimal(path + 14, static_cast<uint64_t>(file.fd))] = '\0';
+		if (linkat(AT_FDCWD, path, file.directoryFd, name, AT_SYMLINK_FOLLOW) == 0) {
+			return true;
+		}
+		// Without /proc, only privileged processes may link a descriptor
+		if (errno != EEXIST && linkat(file.fd, "", file.directoryFd, name, AT_EMPTY_PATH) == 0) {
+			return true;
+		}
+#endif
+		return false;
+	}
+	if (linkat(file.directoryFd, file.temporary, file.directoryFd, name, 0) == 0) {
+		return true;
+	}
+#if defined(__linux__) && defined(SYS_renameat2)
+	// E.g. a filesystem without hard links. A plain rename would replace an existing file.
+	if (errno != EEXIST && syscall(
+		SYS_renameat2, file.directoryFd, file.temporary, file.directoryFd, name, RENAME_NOREPLACE
+	) == 0) {
+		return true;
+	}
+#endif
+	return false;
+}
+#endif
+
+
+DBG_EXPORT bool openCrashFile(int directoryFd, CrashFile *file) {
+#ifndef _WIN32
+	file->fd = -1;
+	file->directoryFd = directoryFd;
+	file->temporary[0] = '\0';
+	if (directoryFd < 0) {
+		return false;
+	}
+#ifdef O_TMPFILE
+	file->fd = openat(directoryFd, ".", O_TMPFILE | O_WRONLY | O_CLOEXEC, 0644);
+	if (file->fd >= 0) {
+		return true;
+	}
+#endif
+	for (int attempt = 0; attempt < MAX_NAME_TRIES; attempt++) {
+		char *out = file->temporary;
+		out += _appendText(out, file->temporary + sizeof(file->temporary), ".segfault-");
+		out += _appendDecimal(out, static_cast<uint64_t>(getpid()));
+		*out++ = '-';
+		out += _appendDecimal(out, _temporaryCount.fetch_add(1));
+		memcpy(out, ".tmp", 5);
+		file->fd = openat(directoryFd, file->temporary, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+		if (file->fd >= 0 || errno != EEXIST) {
+			break;
+		}
+	}
+	if (file->fd < 0) {
+		file->temporary[0] = '\0';
+	}
+	return file->fd >= 0;
+#else
+	(void)directoryFd;
+	(void)file;
+	return false;
+#endif
+}
+
+
+DBG_EXPORT bool commitCrashFile(
+	CrashFile *file, const char *prefix, uint64_t first, uint64_t second, const char *extension,
+	char *name, size_t nameSize
+) {
+#ifndef _WIN32
+	if (file->fd < 0) {
+		return false;
+	}
+	char path[MAX_NAME_SIZE];
+	const char *end = path + sizeof(path) - 1;
+	bool isLinked = false;
+	for (int attempt = 0; attempt < MAX_NAME_TRIES && !isLinked; attempt++) {
+		char *out = path;
+		out += _appendText(out, end - NAME_SUFFIX_SIZE, prefix);
+		out += _appendDecimal(out, first);
+		*out++ = '-';
+		out += _appendDecimal(out, second);
+		if (attempt) {
+			*out++ = '-';
+			out += _appendDecimal(out, static_cast<uint64_t>(attempt));
+		}
+		out += _appendText(out, end, extension);
+		*out = '\0';
+		isLinked = _link(*file, path);
+		if (!isLinked && errno != EEXIST) {
+			break;
+		}
+	}
+	if (isLinked && name && nameSize) {
+		size_t length = strlen(path);
+		size_t copied = length < nameSize ? length : nameSize - 1;
+		memcpy(name, path, copied);
+		name[copied] = '\0';
+	}
+	discardCrashFile(file);
+	return isLinked;
+#else
+	(void)file;
+	(void)prefix;
+	(void)first;
+	(void)second;
+	(void)extension;
+	(void)name;
+	(void)nameSize;
+	return false;
+#endif
+}
+
+
+DBG_EXPORT void discardCrashFile(CrashFile *file) {
+#ifndef _WIN32
+	if (file->fd >= 0) {
+		close(file->fd);
+		file->fd = -1;
+	}
+	// After a link, or without one, the temporary name is still there
+	if (file->temporary[0]) {
+		unlinkat(file->directoryFd, file->temporary, 0);
+		file->temporary[0] = '\0';
+	}
+#else
+	(void)file;
+#endif
+}
+
+} // namespace segfault
@@ -0,0 +1,41 @@
+#ifndef _CRASH_FILE_HPP_
+#define _CRASH_FILE_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#define DBG_EXPORT __declspec(dllexport)
+#else
+#define DBG_EXPORT
+#endif
+
+
+namespace segfault {
+	// A file written at crash time that shows up in its directory only once it is complete,
+	// so that collectors watching the directory never read a partial one. On Linux it is an
+	// unnamed O_TMPFILE, linked into place. Elsewhere, or if the filesystem lacks O_TMPFILE,
+	// it is a hidden ".segfault-<pid>-<n>.tmp", linked to its name and then unlinked.
+	struct CrashFile {
+		int fd;
+		int directoryFd;
+		char temporary[48]; // empty for O_TMPFILE
+	};
+
+	// Create the file in the open directory `directoryFd`. Returns false if it can't.
+	// Signal-safe.
+	DBG_EXPORT bool openCrashFile(int directoryFd, CrashFile *file);
+
+	// Give the file its name "<prefix><first>-<second><extension>", with "-<n>" before the
+	// extension if the name is taken, and close it. Existing files are never replaced. The
+	// name goes to `name`, if given. Returns false if the file is lost. Signal-safe.
+	DBG_EXPORT bool commitCrashFile(
+		CrashFile *file, const char *prefix, uint64_t first, uint64_t second, const char *extension,
+		char *name, size_t nameSize
+	);
+
+	// Close and remove a file that won't be committed. Signal-safe.
+	DBG_EXPORT void discardCrashFile(CrashFile *file);
+}
+
+#endif /* _CRASH_FILE_HPP_ */
@@ -0,0 +1,134 @@
+#include <atomic>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "crash-guard.hpp"
+#include "thread-registry.hpp"
+#include "unwinder.hpp"
+
+
+namespace segfault {
+
+constexpr size_t MAX_SECONDARY_CRASHES = 8;
+constexpr size_t MAX_SECONDARY_FRAMES = sizeof(SecondaryCrash::frames) / sizeof(void*);
+// Set in `_claimed` once the owner stops taking secondaries
+constexpr uint32_t SLOTS_CLOSED = 0x80000000;
+// Secondaries take turns on the unwinder, the owner holds it briefly
+constexpr int UNWINDER_MAX_SPINS = 100000;
+
+// TID of the thread that owns the report, 0 before the first crash
+static std::atomic<int> _owner(0);
+static std::atomic<bool> _isDone(false);
+
+// Slot count, and `SLOTS_CLOSED`. A slot is reserved with a CAS, then filled and committed.
+static std::atomic<uint32_t> _claimed(0);
+static std::atomic<bool> _isCommitted[MAX_SECONDARY_CRASHES];
+static SecondaryCrash _slots[MAX_SECONDARY_CRASHES];
+// Indices of the committed slots, as collected by the owner
+static size_t _collected[MAX_SECONDARY_CRASHES];
+static size_t _collectedCount = 0;
+
+
+static inline void _sleepMs(uint32_t ms) {
+#ifdef _WIN32
+	Sleep(ms);
+#else
+	struct timespec pause = { 0, static_cast<long>(ms) * 1000000 };
+	nanosleep(&pause, nullptr);
+#endif
+}
+
+static inline SecondaryCrash *_claimSlot(size_t *index) {
+	uint32_t claimed = _claimed.load();
+	do {
+		if (claimed & SLOTS_CLOSED || claimed >= MAX_SECONDARY_CRASHES) {
+			return nullptr;
+		}
+	} while (!_claimed.compare_exchange_weak(claimed, claimed + 1));
+	*index = claimed;
+	return &_slots[claimed];
+}
+
+
+DBG_EXPORT CrashRole enterCrash() {
+	int self = getCurrentThreadId();
+	int expected = 0;
+	if (_owner.compare_exchange_strong(expected, self)) {
+		return CRASH_OWNER;
+	}
+	return expected == self ? CRASH_RECURSIVE : CRASH_SECONDARY;
+}
+
+
+DBG_EXPORT bool isCrashInProgress() {
+	return _owner.load() != 0;
+}
+
+
+DBG_EXPORT bool recordSecondaryCrash(
+	uint32_t signal, uint64_t address, void *context, uint32_t maxFrames, int unwindMethod
+) {
+	size_t index = 0;
+	SecondaryCrash *slot = _claimSlot(&index);
+	if (slot) {
+		slot->tid = getCurrentThreadId();
+		slot->signal = signal;
+		slot->address = address;
+		readThreadName(slot->name);
+		slot->count = 0;
+		if (maxFrames > MAX_SECONDARY_FRAMES) {
+			maxFrames = MAX_SECONDARY_FRAMES;
+		}
+		if (context && lockUnwinder(UNWINDER_MAX_SPINS)) {
+			slot->count = unwindStack(context, slot->frames, maxFrames, static_cast<UnwindMethod>(unwindMethod));
+			unlockUnwinder();
+		}
+		_isCommitted[index].store(true);
+	}
+
+	while (!_isDone.load()) {
+		_sleepMs(1);
+	}
+	return slot != nullptr;
+}
+
+
+DBG_EXPORT size_t collectSecondaryCrashes(uint32_t timeoutMs) {
+	// Late secondaries find the slots closed, and only park
+	uint32_t claimed = _claimed.fetch_or(SLOTS_CLOSED) & ~SLOTS_CLOSED;
+	for (uint32_t waited = 0; waited < timeoutMs; waited++) {
+		size_t pending = 0;
+		for (uint32_t i = 0; i < claimed; i++) {
+			pending += !_isCommitted[i].load();
+		}
+		if (!pending) {
+			break;
+		}
+		_sleepMs(1);
+	}
+
+	// A secondary still unwinding is not reported, and may still write its slot
+	_collectedCount = 0;
+	for (uint32_t i = 0; i < claimed; i++) {
+		if (_isCommitted[i].load()) {
+			_collected[_collectedCount++] = i;
+		}
+	}
+	return _collectedCount;
+}
+
+
+DBG_EXPORT const SecondaryCrash *getSecondaryCrash(size_t index) {
+	return index < _collectedCount ? &_slots[_collected[index]] : nullptr;
+}
+
+
+DBG_EXPORT void finishCrash() {
+	_isDone.store(true);
+}
+
+} // namespace segfault
@@ -0,0 +1,59 @@
+#ifndef _CRASH_GUARD_HPP_
+#define _CRASH_GUARD_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#define DBG_EXPORT __declspec(dllexport)
+#else
+#define DBG_EXPORT
+#endif
+
+#include "thread-dump.hpp"
+
+
+namespace segfault {
+	// How a crash handler proceeds, see `enterCrash()`
+	enum CrashRole {
+		// The first crash of the process, this thread writes the report
+		CRASH_OWNER = 0,
+		// Another thread owns the report, record into a secondary slot and park
+		CRASH_SECONDARY,
+		// This thread faulted again while writing the report
+		CRASH_RECURSIVE,
+	};
+
+	// A crash on another thread while the report was being written
+	struct SecondaryCrash {
+		int tid;
+		uint32_t signal;
+		uint64_t address;
+		char name[THREAD_NAME_SIZE];
+		void *frames[64]; // innermost first
+		size_t count;
+	};
+
+	// Take the role of the calling thread with a CAS on the owner TID. Signal-safe.
+	DBG_EXPORT CrashRole enterCrash();
+
+	// True from the first `enterCrash()` on. Signal-safe.
+	DBG_EXPORT bool isCrashInProgress();
+
+	// Secondary: unwind `context` into a free slot, if any, for the owner to append to
+	// its report. Then park until the report is done. Returns false if there was no slot
+	// left, or the owner stopped taking secondaries. Signal-safe.
+	DBG_EXPORT bool recordSecondaryCrash(
+		uint32_t signal, uint64_t address, void *context, uint32_t maxFrames, int unwindMethod
+	);
+
+	// Owner: wait at most `timeoutMs` for secondaries that are still unwinding, and close
+	// the slots. Returns the number of recorded crashes, see `getSecondaryCrash()`. Signal-safe.
+	DBG_EXPORT size_t collectSecondaryCrashes(uint32_t timeoutMs);
+	DBG_EXPORT const SecondaryCrash *getSecondaryCrash(size_t index);
+
+	// Owner: the report is complete, parked secondaries may go on to terminate. Signal-safe.
+	DBG_EXPORT void finishCrash();
+}
+
+#endif /* _CRASH_GUARD_HPP_ */
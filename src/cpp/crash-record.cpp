@@ -0,0 +1,182 @@
+#include <cstring>
+
+#if defined(__linux__)
+#include <ucontext.h>
+#endif
+
+#include "crash-record.hpp"
+#include "module-map.hpp"
+
+
+namespace segfault {
+
+constexpr uint32_t CRASH_RECORD_MAGIC = 0x52434653; // "SFCR" when little-endian
+constexpr size_t CRASH_RECORD_HEADER_SIZE = 64;
+constexpr size_t CRASH_RECORD_FRAME_SIZE = 16;
+constexpr size_t CRASH_RECORD_MODULE_SIZE = 32;
+constexpr size_t MAX_RECORD_FRAMES = 1024;
+constexpr size_t MAX_RECORD_MODULES = 256;
+constexpr uint32_t NO_MODULE = UINT32_MAX;
+
+// Header field offsets
+enum : size_t {
+	CRASH_RECORD_MAGIC_AT = 0, // u32
+	CRASH_RECORD_VERSION_AT = 4, // u16
+	CRASH_RECORD_HEADER_SIZE_AT = 6, // u16
+	CRASH_RECORD_LENGTH_AT = 8, // u32
+	CRASH_RECORD_ARCH_AT = 12, // u16
+	CRASH_RECORD_REGISTER_COUNT_AT = 14, // u16
+	CRASH_RECORD_SIGNAL_AT = 16, // u32
+	CRASH_RECORD_PID_AT = 20, // i32
+	CRASH_RECORD_TID_AT = 24, // i32
+	CRASH_RECORD_FRAME_COUNT_AT = 28, // u16
+	CRASH_RECORD_MODULE_COUNT_AT = 30, // u16
+	CRASH_RECORD_TIME_AT = 32, // i64, seconds
+	CRASH_RECORD_ADDRESS_AT = 40, // u64
+	CRASH_RECORD_FLAGS_AT = 48, // u32, see `CRASH_RECORD_FLAG_*`
+};
+
+// Some module paths did not fit, and were left empty
+constexpr uint32_t CRASH_RECORD_FLAG_TRUNCATED = 1;
+
+
+// Records are byte-packed, fields may be unaligned
+template <typename T>
+static inline void _put(char *buffer, size_t offset, T value) {
+	memcpy(buffer + offset, &value, sizeof(T));
+}
+
+
+DBG_EXPORT size_t readContextRegisters(void *context, uint64_t *out, uint16_t *arch) {
+	*arch = CRASH_RECORD_ARCH_UNKNOWN;
+	if (!context) {
+		return 0;
+	}
+#if defined(__linux__) && defined(__x86_64__) && defined(REG_RIP)
+	static const int gregs[] = {
+		REG_RAX, REG_RBX, REG_RCX, REG_RDX, REG_RSI, REG_RDI, REG_RBP, REG_RSP,
+		REG_R8, REG_R9, REG_R10, REG_R11, REG_R12, REG_R13, REG_R14, REG_R15,
+		REG_RIP, REG_EFL,
+	};
+	const ucontext_t *uc = static_cast<const ucontext_t*>(context);
+	for (size_t i = 0; i < sizeof(gregs) / sizeof(gregs[0]); i++) {
+		out[i] = static_cast<uint64_t>(uc->uc_mcontext.gregs[gregs[i]]);
+	}
+	*arch = CRASH_RECORD_ARCH_X86_64;
+	return sizeof(gregs) / sizeof(gregs[0]);
+#elif defined(__linux__) && defined(__aarch64__)
+	// x0..x30, sp, pc, pstate
+	const ucontext_t *uc = static_cast<const ucontext_t*>(context);
+	for (size_t i = 0; i < 31; i++) {
+		out[i] = uc->uc_mcontext.regs[i];
+	}
+	out[31] = uc->uc_mcontext.sp;
+	out[32] = uc->uc_mcontext.pc;
+	out[33] = uc->uc_mcontext.pstate;
+	*arch = CRASH_RECORD_ARCH_AARCH64;
+	return 34;
+#else
+	(void)out;
+	return 0;
+#endif
+}
+
+DBG_EXPORT int getStackPointerIndex(uint16_t arch) {
+	switch (arch) {
+		case CRASH_RECORD_ARCH_X86_64: return 7; // rsp
+		case CRASH_RECORD_ARCH_AARCH64: return 31; // sp
+		default: return -1;
+	}
+}
+
+
+DBG_EXPORT size_t encodeCrashRecord(
+	char *buffer, size_t capacity, const CrashRecordInfo &info,
+	void *context, void *const *frames, size_t count
+) {
+	uint64_t registers[MAX_CONTEXT_REGISTERS];
+	uint16_t arch = CRASH_RECORD_ARCH_UNKNOWN;
+	size_t registerCount = readContextRegisters(context, registers, &arch);
+
+	if (count > MAX_RECORD_FRAMES) {
+		count = MAX_RECORD_FRAMES;
+	}
+
+	// Only the modules the frames point into are listed, in order of first use
+	static const ModuleInfo *modules[MAX_RECORD_MODULES];
+	static uint32_t frameModules[MAX_RECORD_FRAMES];
+	size_t moduleCount = 0;
+	for (size_t i = 0; i < count; i++) {
+		const ModuleInfo *module = findModule(reinterpret_cast<uintptr_t>(frames[i]));
+		size_t index = 0;
+		while (module && index < moduleCount && modules[index] != module) {
+			index++;
+		}
+		if (module && index == moduleCount && moduleCount < MAX_RECORD_MODULES) {
+			modules[moduleCount++] = module;
+		}
+		frameModules[i] = module && index < moduleCount ? static_cast<uint32_t>(index) : NO_MODULE;
+	}
+
+	size_t registersAt = CRASH_RECORD_HEADER_SIZE;
+	size_t framesAt = registersAt + registerCount * sizeof(uint64_t);
+	size_t modulesAt = framesAt + count * CRASH_RECORD_FRAME_SIZE;
+	size_t pathsAt = modulesAt + moduleCount * CRASH_RECORD_MODULE_SIZE;
+	if (pathsAt > capacity) {
+		return 0;
+	}
+
+	memset(buffer, 0, pathsAt);
+	_put<uint32_t>(buffer, CRASH_RECORD_MAGIC_AT, CRASH_RECORD_MAGIC);
+	_put<uint16_t>(buffer, CRASH_RECORD_VERSION_AT, CRASH_RECORD_VERSION);
+	_put<uint16_t>(buffer, CRASH_RECORD_HEADER_SIZE_AT, CRASH_RECORD_HEADER_SIZE);
+	_put<uint16_t>(buffer, CRASH_RECORD_ARCH_AT, arch);
+	_put<uint16_t>(buffer, CRASH_RECORD_REGISTER_COUNT_AT, static_cast<uint16_t>(registerCount));
+	_put<uint32_t>(buffer, CRASH_RECORD_SIGNAL_AT, info.signal);
+	_put<int32_t>(buffer, CRASH_RECORD_PID_AT, info.pid);
+	_put<int32_t>(buffer, CRASH_RECORD_TID_AT, info.tid);
+	_put<uint16_t>(buffer, CRASH_RECORD_FRAME_COUNT_AT, static_cast<uint16_t>(count));
+	_put<uint16_t>(buffer, CRASH_RECORD_MODULE_COUNT_AT, static_cast<uint16_t>(moduleCount));
+	_put<int64_t>(buffer, CRASH_RECORD_TIME_AT, info.time);
+	_put<uint64_t>(buffer, CRASH_RECORD_ADDRESS_AT, info.address);
+
+	memcpy(buffer + registersAt, registers, registerCount * sizeof(uint64_t));
+
+	for (size_t i = 0; i < count; i++) {
+		size_t at = framesAt + i * CRASH_RECORD_FRAME_SIZE;
+		_put<uint64_t>(buffer, at, reinterpret_cast<uintptr_t>(frames[i]));
+		_put<uint32_t>(buffer, at + 8, frameModules[i]);
+	}
+
+	uint32_t flags = 0;
+	size_t pathsUsed = 0;
+	for (size_t i = 0; i < moduleCount; i++) {
+		const ModuleInfo &module = *modules[i];
+		size_t at = modulesAt + i * CRASH_RECORD_MODULE_SIZE;
+		_put<uint64_t>(buffer, at, module.base);
+		_put<uint64_t>(buffer, at + 8, module.start);
+		_put<uint64_t>(buffer, at + 16, module.end);
+
+		size_t length = strlen(module.path);
+		if (pathsAt + pathsUsed + length > capacity) {
+			flags |= CRASH_RECORD_FLAG_TRUNCATED;
+			continue;
+		}
+		memcpy(buffer + pathsAt + pathsUsed, module.path, length);
+		_put<uint32_t>(buffer, at + 24, static_cast<uint32_t>(pathsUsed));
+		_put<uint32_t>(buffer, at + 28, static_cast<uint32_t>(length));
+		pathsUsed += length;
+	}
+
+	// Keep records 8-byte aligned, for readers that map a whole file of them
+	size_t length = pathsAt + pathsUsed;
+	while (length % 8 && length < capacity) {
+		buffer[length++] = '\0';
+	}
+
+	_put<uint32_t>(buffer, CRASH_RECORD_FLAGS_AT, flags);
+	_put<uint32_t>(buffer, CRASH_RECORD_LENGTH_AT, static_cast<uint32_t>(length));
+	return length;
+}
+
+} // namespace segfault
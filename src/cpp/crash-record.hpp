@@ -0,0 +1,59 @@
+#ifndef _CRASH_RECORD_HPP_
+#define _CRASH_RECORD_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#define DBG_EXPORT __declspec(dllexport)
+#else
+#define DBG_EXPORT
+#endif
+
+
+namespace segfault {
+	// Binary crash record, in native byte order (the magic tells which):
+	//
+	//   header     64 bytes, see `CRASH_RECORD_*` offsets in crash-record.cpp
+	//   registers  u64 x registerCount, order defined by the architecture id
+	//   frames     { u64 address; u32 module (UINT32_MAX if none); u32 reserved } x frameCount
+	//   modules    { u64 base; u64 start; u64 end; u32 pathOffset; u32 pathLength } x moduleCount
+	//   paths      module paths, not NUL-terminated, addressed from the start of this area
+	//
+	// `length` in the header covers the whole record, so records can be appended back to back.
+	// Readers must locate sections with `headerSize`: later versions only append header fields.
+	constexpr uint16_t CRASH_RECORD_VERSION = 1;
+
+	enum CrashRecordArch {
+		CRASH_RECORD_ARCH_UNKNOWN = 0,
+		CRASH_RECORD_ARCH_X86_64,
+		CRASH_RECORD_ARCH_AARCH64,
+	};
+
+	// Enough for every architecture `readContextRegisters()` knows
+	constexpr size_t MAX_CONTEXT_REGISTERS = 34;
+
+	struct CrashRecordInfo {
+		uint32_t signal;
+		int32_t pid;
+		int32_t tid;
+		int64_t time;
+		uint64_t address;
+	};
+
+	// Register values of a signal `context` (may be nullptr), in the order the decoders name
+	// them. Returns the count, 0 on unknown architectures. Signal-safe.
+	DBG_EXPORT size_t readContextRegisters(void *context, uint64_t *out, uint16_t *arch);
+
+	// Index of the stack pointer in `readContextRegisters()` output, or -1
+	DBG_EXPORT int getStackPointerIndex(uint16_t arch);
+
+	// Encode a crash into `buffer`, with registers from the signal `context` (may be nullptr)
+	// and only the modules `frames` point into. Returns the record size. Signal-safe.
+	DBG_EXPORT size_t encodeCrashRecord(
+		char *buffer, size_t capacity, const CrashRecordInfo &info,
+		void *context, void *const *frames, size_t count
+	);
+}
+
+#endif /* _CRASH_RECORD_HPP_ */
@@ -0,0 +1,234 @@
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <mutex>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#endif
+
+#include "crash-socket.hpp"
+
+
+namespace segfault {
+
+#ifndef _WIN32
+// Collector side: reports are a few KB, anything past this is cut off
+constexpr size_t MAX_MESSAGE_SIZE = 1024 * 1024;
+constexpr int LISTEN_BACKLOG = 64;
+
+#ifdef MSG_NOSIGNAL
+constexpr int SEND_FLAGS = MSG_DONTWAIT | MSG_NOSIGNAL;
+#else
+constexpr int SEND_FLAGS = MSG_DONTWAIT;
+#endif
+
+// Connected crashing processes, by listening socket
+static std::map<int, std::vector<int>> _clients;
+static std::mutex _clientsMutex;
+
+
+static inline void _setFlags(int fd) {
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+	fcntl(fd, F_SETFD, FD_CLOEXEC);
+#ifdef SO_NOSIGPIPE
+	int on = 1;
+	setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+}
+
+static inline int _setAddress(const char *path, struct sockaddr_un *address, socklen_t *length) {
+	size_t size = strlen(path);
+	if (!size || size >= sizeof(address->sun_path)) {
+		return ENAMETOOLONG;
+	}
+	memset(address, 0, sizeof(*address));
+	address->sun_family = AF_UNIX;
+	memcpy(address->sun_path, path, size);
+	*length = static_cast<socklen_t>(offsetof(struct sockaddr_un, sun_path) + size + 1);
+	return 0;
+}
+
+// Only syscalls, so the handler can reconnect with it
+static inline int _connect(CrashSocket *sink, int type) {
+	int fd = socket(AF_UNIX, type, 0);
+	if (fd < 0) {
+		return errno;
+	}
+	_setFlags(fd);
+	if (connect(fd, reinterpret_cast<const struct sockaddr*>(&sink->address), sink->addressLength) != 0) {
+		int error = errno;
+		close(fd);
+		return error;
+	}
+	sink->fd = fd;
+	sink->type = type;
+	return 0;
+}
+
+static inline bool _send(const CrashSocket *sink, const char *data, size_t size) {
+	struct iovec part;
+	part.iov_base = const_cast<char*>(data);
+	part.iov_len = size;
+	struct msghdr message;
+	memset(&message, 0, sizeof(message));
+	message.msg_iov = &part;
+	message.msg_iovlen = 1;
+
+	ssize_t sent;
+	do {
+		sent = sendmsg(sink->fd, &message, SEND_FLAGS);
+	} while (sent < 0 && errno == EINTR);
+	return sent == static_cast<ssize_t>(size);
+}
+#endif
+
+
+DBG_EXPORT int openCrashSocket(const char *path, CrashSocket *sink) {
+#ifndef _WIN32
+	sink->fd = -1;
+	int error = _setAddress(path, &sink->address, &sink->addressLength);
+	if (error) {
+		return error;
+	}
+	// A datagram collector refuses the connection type, not the connection
+	error = _connect(sink, SOCK_SEQPACKET);
+	if (error == EPROTOTYPE || error == EPROTONOSUPPORT || error == ESOCKTNOSUPPORT) {
+		error = _connect(sink, SOCK_DGRAM);
+	}
+	return error;
+#else
+	(void)path;
+	sink->fd = -1;
+	return ENOTSUP;
+#endif
+}
+
+DBG_EXPORT void closeCrashSocket(CrashSocket *sink) {
+#ifndef _WIN32
+	if (sink->fd >= 0) {
+		close(sink->fd);
+		sink->fd = -1;
+	}
+#else
+	(void)sink;
+#endif
+}
+
+
+DBG_EXPORT bool sendCrashSocket(CrashSocket *sink, const char *data, size_t size) {
+#ifndef _WIN32
+	if (sink->fd < 0) {
+		return false;
+	}
+	if (_send(sink, data, size)) {
+		return true;
+	}
+	// A full queue drops the report, a broken connection is given one more chance
+	int error = errno;
+	if (error != EPIPE && error != ENOTCONN && error != ECONNREFUSED && error != ECONNRESET) {
+		return false;
+	}
+	int fd = sink->fd;
+	if (_connect(sink, sink->type) != 0) {
+		return false;
+	}
+	close(fd);
+	return _send(sink, data, size);
+#else
+	(void)sink;
+	(void)data;
+	(void)size;
+	return false;
+#endif
+}
+
+
+DBG_EXPORT int listenCrashSocket(const char *path, int *fd) {
+#ifndef _WIN32
+	struct sockaddr_un address;
+	socklen_t length = 0;
+	int error = _setAddress(path, &address, &length);
+	if (error) {
+		return error;
+	}
+	int listener = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+	if (listener < 0) {
+		return errno;
+	}
+	_setFlags(listener);
+	unlink(path);
+	if (
+		bind(listener, reinterpret_cast<const struct sockaddr*>(&address), length) != 0 ||
+		listen(listener, LISTEN_BACKLOG) != 0
+	) {
+		error = errno;
+		close(listener);
+		return error;
+	}
+	std::lock_guard<std::mutex> lock(_clientsMutex);
+	_clients[listener].clear();
+	*fd = listener;
+	return 0;
+#else
+	(void)path;
+	(void)fd;
+	return ENOTSUP;
+#endif
+}
+
+
+DBG_EXPORT void receiveCrashSocket(int fd, std::vector<std::string> *messages) {
+#ifndef _WIN32
+	std::lock_guard<std::mutex> lock(_clientsMutex);
+	auto found = _clients.find(fd);
+	if (found == _clients.end()) {
+		return;
+	}
+	std::vector<int> &clients = found->second;
+	for (int client; (client = accept(fd, nullptr, nullptr)) >= 0;) {
+		_setFlags(client);
+		clients.push_back(client);
+	}
+
+	static std::vector<char> buffer(MAX_MESSAGE_SIZE);
+	for (size_t i = 0; i < clients.size();) {
+		ssize_t size = recv(clients[i], buffer.data(), buffer.size(), MSG_DONTWAIT);
+		if (size > 0) {
+			messages->emplace_back(buffer.data(), static_cast<size_t>(size));
+			continue;
+		}
+		if (size < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+			i++;
+			continue;
+		}
+		// The process is gone
+		close(clients[i]);
+		clients.erase(clients.begin() + i);
+	}
+#else
+	(void)fd;
+	(void)messages;
+#endif
+}
+
+DBG_EXPORT void closeCrashListener(int fd) {
+#ifndef _WIN32
+	std::lock_guard<std::mutex> lock(_clientsMutex);
+	auto found = _clients.find(fd);
+	if (found == _clients.end()) {
+		return;
+	}
+	for (int client : found->second) {
+		close(client);
+	}
+	_clients.erase(found);
+	close(fd);
+#else
+	(void)fd;
+#endif
+}
+
+} // namespace segfault
@@ -0,0 +1,53 @@
+#ifndef _CRASH_SOCKET_HPP_
+#define _CRASH_SOCKET_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
+#ifdef _WIN32
+#define DBG_EXPORT __declspec(dllexport)
+#else
+#define DBG_EXPORT
+#endif
+
+
+namespace segfault {
+	// Crash reports streamed to a collector over a local socket, one message per report.
+	// SOCK_SEQPACKET is preferred: the report arrives whole, and a collector that is gone
+	// shows as EPIPE. A collector bound with SOCK_DGRAM works as well.
+	struct CrashSocket {
+		int fd;
+#ifndef _WIN32
+		struct sockaddr_un address;
+		socklen_t addressLength;
+#endif
+		int type; // SOCK_SEQPACKET or SOCK_DGRAM
+	};
+
+	// Connect to the collector at `path`, non-blocking. Returns 0 or an errno value.
+	// Not signal-safe.
+	DBG_EXPORT int openCrashSocket(const char *path, CrashSocket *sink);
+	DBG_EXPORT void closeCrashSocket(CrashSocket *sink);
+
+	// Send `data` as one message. Never blocks: if the collector is gone or can't keep up,
+	// the report is dropped. A collector that restarted is reconnected once. Signal-safe.
+	DBG_EXPORT bool sendCrashSocket(CrashSocket *sink, const char *data, size_t size);
+
+	// Collector side: bind a SOCK_SEQPACKET socket at `path` (an old socket file there is
+	// replaced) and listen. Returns 0 or an errno value. Not signal-safe.
+	DBG_EXPORT int listenCrashSocket(const char *path, int *fd);
+
+	// Accept pending connections of a listening socket, and append every pending message
+	// to `messages`, without blocking. Not signal-safe.
+	DBG_EXPORT void receiveCrashSocket(int fd, std::vector<std::string> *messages);
+	DBG_EXPORT void closeCrashListener(int fd);
+}
+
+#endif /* _CRASH_SOCKET_HPP_ */
@@ -0,0 +1,383 @@
+#include <cstring>
+#include <errno.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#include <poll.h>
+#include <limits.h>
+#endif
+
+#include "emitter.hpp"
+#include "handler-stats.hpp"
+
+
+namespace segfault {
+
+#ifdef _WIN32
+	#define SEGMENT_BASE(S) (S).base
+	#define SEGMENT_LEN(S) (S).len
+#else
+	#define SEGMENT_BASE(S) (S).iov_base
+	#define SEGMENT_LEN(S) (S).iov_len
+	#ifndef IOV_MAX
+	#define IOV_MAX 1024
+	#endif
+#endif
+
+// Give up on a fd that stays non-writable (e.g. a full non-blocking pipe) this long
+constexpr int WRITE_POLL_MS = 100;
+constexpr int WRITE_MAX_RETRIES = 10;
+
+static const char hexDigits[] = "0123456789abcdef";
+static const char weekDays[][4] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+static const char monthNames[][4] = {
+	"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec",
+};
+
+
+Emitter::Emitter(char *buffer, size_t capacity):
+	_buffer(buffer), _capacity(capacity), _used(0), _size(0), _segmentStart(0),
+	_fdCount(0), _mirror(nullptr), _segmentCount(0), _writeNs(0), _flushedBytes(0) {
+}
+
+
+void Emitter::setFds(const int *fds, size_t count) {
+	_fdCount = 0;
+	for (size_t i = 0; i < count; i++) {
+		addFd(fds[i]);
+	}
+}
+
+void Emitter::addFd(int fd) {
+	if (fd < 0 || _fdCount >= MAX_FDS) {
+		return;
+	}
+	_fds[_fdCount++] = fd;
+}
+
+void Emitter::clearFds() {
+	_fdCount = 0;
+}
+
+
+// Close the currently open buffer span into a segment
+void Emitter::_commit() {
+	if (_used == _segmentStart) {
+		return;
+	}
+	if (_segmentCount >= MAX_SEGMENTS) {
+		_spill();
+		return;
+	}
+	SEGMENT_BASE(_segments[_segmentCount]) = _buffer + _segmentStart;
+	SEGMENT_LEN(_segments[_segmentCount]) = _used - _segmentStart;
+	_segmentCount++;
+	_segmentStart = _used;
+}
+
+// Out of buffer or segments mid-report: push what we have and start over
+void Emitter::_spill() {
+	// The segment table has one spare slot for exactly this
+	if (_used != _segmentStart) {
+		SEGMENT_BASE(_segments[_segmentCount]) = _buffer + _segmentStart;
+		SEGMENT_LEN(_segments[_segmentCount]) = _used - _segmentStart;
+		_segmentCount++;
+	}
+	_writeTargets();
+	_segmentCount = 0;
+	_used = 0;
+	_segmentStart = 0;
+}
+
+
+Emitter &Emitter::str(const char *text) {
+	return text ? str(text, strlen(text)) : *this;
+}
+
+Emitter &Emitter::str(const char *text, size_t length) {
+	_size += length;
+	while (length) {
+		if (_used == _capacity) {
+			_spill();
+		}
+		size_t chunk = _capacity - _used;
+		if (chunk > length) {
+			chunk = length;
+		}
+		memcpy(_buffer + _used, text, chunk);
+		_used += chunk;
+		text += chunk;
+		length -= chunk;
+	}
+	return *this;
+}
+
+Emitter &Emitter::ref(const char *text, size_t length) {
+	if (length < MIN_REF_SIZE) {
+		return str(text, length);
+	}
+	_commit();
+	if (_segmentCount >= MAX_SEGMENTS) {
+		_spill();
+	}
+	SEGMENT_BASE(_segments[_segmentCount]) = const_cast<char*>(text);
+	SEGMENT_LEN(_segments[_segmentCount]) = length;
+	_segmentCount++;
+	_size += length;
+	return *this;
+}
+
+Emitter &Emitter::chr(char c) {
+	if (_used == _capacity) {
+		_spill();
+	}
+	_buffer[_used++] = c;
+	_size++;
+	return *this;
+}
+
+Emitter &Emitter::dec(uint64_t value) {
+	char digits[24];
+	size_t pos = sizeof(digits);
+	do {
+		digits[--pos] = static_cast<char>('0' + value % 10);
+		value /= 10;
+	} while (value);
+	return str(digits + pos, sizeof(digits) - pos);
+}
+
+Emitter &Emitter::sdec(int64_t value) {
+	if (value < 0) {
+		chr('-');
+		return dec(static_cast<uint64_t>(-(value + 1)) + 1);
+	}
+	return dec(static_cast<uint64_t>(value));
+}
+
+Emitter &Emitter::padDec(uint64_t value, int width) {
+	int length = 1;
+	for (uint64_t rest = value / 10; rest; rest /= 10) {
+		length++;
+	}
+	for (; length < width; length++) {
+		chr(' ');
+	}
+	return dec(value);
+}
+
+Emitter &Emitter::zeroDec(uint64_t value, int width) {
+	int length = 1;
+	for (uint64_t rest = value / 10; rest; rest /= 10) {
+		length++;
+	}
+	for (; length < width; length++) {
+		chr('0');
+	}
+	return dec(value);
+}
+
+Emitter &Emitter::hex(uint64_t value) {
+	str("0x", 2);
+	return hex(value, 0);
+}
+
+Emitter &Emitter::hex(uint64_t value, int width) {
+	char digits[16];
+	size_t pos = sizeof(digits);
+	do {
+		digits[--pos] = hexDigits[value & 0xf];
+		value >>= 4;
+	} while (value);
+	while (static_cast<int>(sizeof(digits) - pos) < width && pos) {
+		digits[--pos] = '0';
+	}
+	return str(digits + pos, sizeof(digits) - pos);
+}
+
+Emitter &Emitter::json(const char *text, size_t maxLength) {
+	if (!text) {
+		return *this;
+	}
+	// Copy clean runs in one go, escape the rest byte by byte
+	const char *run = text;
+	size_t i = 0;
+	for (; i < maxLength && text[i]; i++) {
+		unsigned char c = static_cast<unsigned char>(text[i]);
+		if (c >= 0x20 && c != '"' && c != '\\') {
+			continue;
+		}
+		str(run, text + i - run);
+		run = text + i + 1;
+		chr('\\');
+		switch (c) {
+			case '"': chr('"'); break;
+			case '\\': chr('\\'); break;
+			case '\n': chr('n'); break;
+			case '\r': chr('r'); break;
+			case '\t': chr('t'); break;
+			default: str("u00", 3).hex(c, 2); break;
+		}
+	}
+	return str(run, text + i - run);
+}
+
+
+// Days since 1970-01-01 to a proleptic Gregorian date (H. Hinnant's algorithm)
+static inline void _civilFromDays(int64_t days, int64_t *year, int *month, int *day) {
+	days += 719468;
+	int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+	int64_t doe = days - era * 146097;
+	int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+	int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+	int64_t mp = (5 * doy + 2) / 153;
+	*day = static_cast<int>(doy - (153 * mp + 2) / 5 + 1);
+	*month = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+	*year = yoe + era * 400 + (*month <= 2);
+}
+
+static inline void _splitTime(int64_t seconds, int64_t *days, int *hh, int *mm, int *ss) {
+	*days = seconds / 86400;
+	int64_t rest = seconds % 86400;
+	if (rest < 0) {
+		rest += 86400;
+		(*days)--;
+	}
+	*hh = static_cast<int>(rest / 3600);
+	*mm = static_cast<int>(rest / 60 % 60);
+	*ss = static_cast<int>(rest % 60);
+}
+
+Emitter &Emitter::isoTime(int64_t seconds) {
+	int64_t days, year;
+	int hh, mm, ss, month, day;
+	_splitTime(seconds, &days, &hh, &mm, &ss);
+	_civilFromDays(days, &year, &month, &day);
+	sdec(year).chr('-');
+	zeroDec(month, 2).chr('-');
+	zeroDec(day, 2).chr('T');
+	zeroDec(hh, 2).chr(':');
+	zeroDec(mm, 2).chr(':');
+	return zeroDec(ss, 2).str(".000Z", 5);
+}
+
+Emitter &Emitter::ctimeStr(int64_t seconds, int64_t gmtOffset) {
+	int64_t days, year;
+	int hh, mm, ss, month, day;
+	_splitTime(seconds + gmtOffset, &days, &hh, &mm, &ss);
+	_civilFromDays(days, &year, &month, &day);
+	int weekDay = static_cast<int>(((days % 7) + 11) % 7); // 1970-01-01 was a Thursday
+	str(weekDays[weekDay], 3).chr(' ').str(monthNames[month - 1], 3);
+	padDec(day, 3).chr(' ');
+	zeroDec(hh, 2).chr(':');
+	zeroDec(mm, 2).chr(':');
+	return zeroDec(ss, 2).chr(' ').sdec(year);
+}
+
+
+void Emitter::_writeAll(int fd) {
+#ifdef _WIN32
+	for (size_t i = 0; i < _segmentCount; i++) {
+		const char *base = SEGMENT_BASE(_segments[i]);
+		size_t left = SEGMENT_LEN(_segments[i]);
+		while (left) {
+			int written = _write(fd, base, static_cast<unsigned>(left));
+			if (written <= 0) {
+				return;
+			}
+			base += written;
+			left -= written;
+		}
+	}
+#else
+	size_t index = 0;
+	size_t skip = 0;
+	int retries = 0;
+	while (index < _segmentCount) {
+		// Temporarily trim the partially written head segment, restore after the call
+		struct iovec saved = _segments[index];
+		_segments[index].iov_base = static_cast<char*>(saved.iov_base) + skip;
+		_segments[index].iov_len = saved.iov_len - skip;
+		size_t count = _segmentCount - index;
+		if (count > IOV_MAX) {
+			count = IOV_MAX;
+		}
+		ssize_t written = writev(fd, &_segments[index], static_cast<int>(count));
+		_segments[index] = saved;
+
+		if (written < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			if ((errno == EAGAIN || errno == EWOULDBLOCK) && retries++ < WRITE_MAX_RETRIES) {
+				struct pollfd pfd = { fd, POLLOUT, 0 };
+				poll(&pfd, 1, WRITE_POLL_MS);
+				continue;
+			}
+			return;
+		}
+		if (written == 0) {
+			return;
+		}
+
+		size_t left = static_cast<size_t>(written);
+		while (index < _segmentCount && left >= _segments[index].iov_len - skip) {
+			left -= _segments[index].iov_len - skip;
+			skip = 0;
+			index++;
+		}
+		skip += left;
+	}
+#endif
+}
+
+
+void Emitter::_writeTargets() {
+	uint64_t started = getMonotonicNs();
+	for (size_t i = 0; i < _fdCount; i++) {
+		_writeAll(_fds[i]);
+	}
+	_mirrorAll();
+	_writeNs += getMonotonicNs() - started;
+}
+
+
+void Emitter::_mirrorAll() {
+	if (!_mirror) {
+		return;
+	}
+	for (size_t i = 0; i < _segmentCount; i++) {
+		_mirror(static_cast<const char*>(SEGMENT_BASE(_segments[i])), SEGMENT_LEN(_segments[i]));
+	}
+}
+
+
+size_t Emitter::flush() {
+	_commit();
+	_writeTargets();
+	size_t total = _size;
+	_flushedBytes += total;
+	discard();
+	return total;
+}
+
+size_t Emitter::flushTo(int fd) {
+	_commit();
+	uint64_t started = getMonotonicNs();
+	_writeAll(fd);
+	_writeNs += getMonotonicNs() - started;
+	size_t total = _size;
+	_flushedBytes += total;
+	discard();
+	return total;
+}
+
+void Emitter::discard() {
+	_segmentCount = 0;
+	_used = 0;
+	_segmentStart = 0;
+	_size = 0;
+}
+
+} // namespace segfault
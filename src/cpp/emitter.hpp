@@ -0,0 +1,98 @@
+#ifndef _EMITTER_HPP_
+#define _EMITTER_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#define DBG_EXPORT __declspec(dllexport)
+#else
+#define DBG_EXPORT
+#include <sys/uio.h>
+#endif
+
+
+namespace segfault {
+	// Async-signal-safe report builder. Text is appended into a caller-owned fixed
+	// buffer (no heap), and flushed to every target fd with a single `writev()`
+	// per fd, unless the buffer overflows mid-report.
+	class DBG_EXPORT Emitter {
+	public:
+		static constexpr size_t MAX_FDS = 8;
+		static constexpr size_t MAX_SEGMENTS = 64;
+		// Referenced chunks shorter than this are cheaper to copy than to give an iovec
+		static constexpr size_t MIN_REF_SIZE = 32;
+
+		Emitter(char *buffer, size_t capacity);
+
+		// Target fds receive everything that is flushed
+		void setFds(const int *fds, size_t count);
+		void addFd(int fd);
+		void clearFds();
+		size_t getFdCount() const { return _fdCount; }
+
+		// Everything flushed to the fds is also passed here, e.g. to be copied into memory
+		typedef void (*Mirror)(const char *data, size_t size);
+		void setMirror(Mirror mirror) { _mirror = mirror; }
+
+		Emitter &str(const char *text);
+		Emitter &str(const char *text, size_t length);
+		// Zero-copy append: `text` must stay valid until the next flush
+		Emitter &ref(const char *text, size_t length);
+		Emitter &chr(char c);
+		Emitter &dec(uint64_t value);
+		Emitter &sdec(int64_t value);
+		// Lowercase hex with "0x" prefix, or zero-padded to `width` digits without one
+		Emitter &hex(uint64_t value);
+		Emitter &hex(uint64_t value, int width);
+		// Right-aligned decimal, as in "%2d"
+		Emitter &padDec(uint64_t value, int width);
+		// Zero-padded decimal, as in "%02d"
+		Emitter &zeroDec(uint64_t value, int width);
+		// String contents with JSON escaping, at most `maxLength` source bytes
+		Emitter &json(const char *text, size_t maxLength = SIZE_MAX);
+		// "2024-01-31T12:34:56.000Z"
+		Emitter &isoTime(int64_t seconds);
+		// ctime()-style "Wed Jan 31 12:34:56 2024", shifted by `gmtOffset` seconds
+		Emitter &ctimeStr(int64_t seconds, int64_t gmtOffset);
+
+		size_t getSize() const { return _size; }
+
+		// Time spent writing to the fds and the mirror, and bytes flushed, since the last reset
+		uint64_t getWriteNs() const { return _writeNs; }
+		uint64_t getFlushedBytes() const { return _flushedBytes; }
+		void resetCounters() { _writeNs = 0; _flushedBytes = 0; }
+
+		// Write everything pending to all fds (or just one) and reset. Returns bytes per fd.
+		size_t flush();
+		size_t flushTo(int fd);
+		void discard();
+
+	private:
+		void _commit();
+		void _spill();
+		void _writeTargets();
+		void _writeAll(int fd);
+		void _mirrorAll();
+
+		char *_buffer;
+		size_t _capacity;
+		size_t _used;
+		size_t _size;
+		size_t _segmentStart;
+		int _fds[MAX_FDS];
+		size_t _fdCount;
+		Mirror _mirror;
+#ifdef _WIN32
+		struct Segment { const char *base; size_t len; };
+		Segment _segments[MAX_SEGMENTS + 1];
+#else
+		struct iovec _segments[MAX_SEGMENTS + 1];
+#endif
+		size_t _segmentCount;
+		uint64_t _writeNs;
+		uint64_t _flushedBytes;
+	};
+}
+
+#endif /* _EMITTER_HPP_ */
@@ -0,0 +1,119 @@
+#include <atomic>
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "handler-stats.hpp"
+
+
+namespace segfault {
+
+struct AtomicPhase {
+	std::atomic<uint64_t> count;
+	std::atomic<uint64_t> totalNs;
+	std::atomic<uint64_t> maxNs;
+	std::atomic<uint64_t> buckets[PHASE_BUCKETS];
+};
+
+struct AtomicSignal {
+	std::atomic<uint32_t> signal; // 0 if free
+	std::atomic<uint64_t> count;
+};
+
+static AtomicSignal _signals[MAX_COUNTED_SIGNALS];
+static std::atomic<uint64_t> _reports(0);
+static std::atomic<uint64_t> _bytes(0);
+static std::atomic<uint64_t> _dropped(0);
+static AtomicPhase _phases[PHASE_COUNT];
+
+static const char *PHASE_NAMES[PHASE_COUNT] = { "unwind", "symbolize", "format", "write" };
+
+
+DBG_EXPORT uint64_t getMonotonicNs() {
+#ifdef _WIN32
+	static LARGE_INTEGER frequency = {};
+	if (!frequency.QuadPart) {
+		QueryPerformanceFrequency(&frequency);
+	}
+	LARGE_INTEGER now;
+	QueryPerformanceCounter(&now);
+	return static_cast<uint64_t>(now.QuadPart / frequency.QuadPart * 1000000000ULL +
+		now.QuadPart % frequency.QuadPart * 1000000000ULL / frequency.QuadPart);
+#else
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return static_cast<uint64_t>(now.tv_sec) * 1000000000ULL + static_cast<uint64_t>(now.tv_nsec);
+#endif
+}
+
+
+DBG_EXPORT void countSignal(uint32_t signal) {
+	// Signal numbers are claimed with a CAS, Windows exception codes are never 0 either
+	for (size_t i = 0; i < MAX_COUNTED_SIGNALS; i++) {
+		uint32_t current = _signals[i].signal.load();
+		if (!current && _signals[i].signal.compare_exchange_strong(current, signal)) {
+			current = signal;
+		}
+		if (current == signal) {
+			_signals[i].count.fetch_add(1);
+			return;
+		}
+	}
+}
+
+DBG_EXPORT void countReport(size_t bytes) {
+	_reports.fetch_add(1);
+	_bytes.fetch_add(bytes);
+}
+
+DBG_EXPORT void countDroppedReport() {
+	_dropped.fetch_add(1);
+}
+
+DBG_EXPORT void recordPhase(HandlerPhase phase, uint64_t ns) {
+	AtomicPhase &stats = _phases[phase];
+	stats.count.fetch_add(1);
+	stats.totalNs.fetch_add(ns);
+	uint64_t max = stats.maxNs.load();
+	while (ns > max && !stats.maxNs.compare_exchange_weak(max, ns)) {}
+
+	size_t bucket = 0;
+	for (uint64_t us = ns / 1000; us && bucket < PHASE_BUCKETS - 1; us >>= 1) {
+		bucket++;
+	}
+	stats.buckets[bucket].fetch_add(1);
+}
+
+
+DBG_EXPORT void getHandlerStats(HandlerStats *stats) {
+	memset(stats, 0, sizeof(*stats));
+	for (size_t i = 0; i < MAX_COUNTED_SIGNALS; i++) {
+		uint32_t signal = _signals[i].signal.load();
+		if (signal) {
+			stats->signals[stats->signalCount].signal = signal;
+			stats->signals[stats->signalCount].count = _signals[i].count.load();
+			stats->signalCount++;
+		}
+	}
+	stats->reports = _reports.load();
+	stats->bytes = _bytes.load();
+	stats->dropped = _dropped.load();
+	for (size_t p = 0; p < PHASE_COUNT; p++) {
+		stats->phases[p].count = _phases[p].count.load();
+		stats->phases[p].totalNs = _phases[p].totalNs.load();
+		stats->phases[p].maxNs = _phases[p].maxNs.load();
+		for (size_t b = 0; b < PHASE_BUCKETS; b++) {
+			stats->phases[p].buckets[b] = _phases[p].buckets[b].load();
+		}
+	}
+}
+
+DBG_EXPORT const char *getPhaseName(HandlerPhase phase) {
+	return phase < PHASE_COUNT ? PHASE_NAMES[phase] : "";
+}
+
+} // namespace segfault
@@ -0,0 +1,63 @@
+#ifndef _HANDLER_STATS_HPP_
+#define _HANDLER_STATS_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#define DBG_EXPORT __declspec(dllexport)
+#else
+#define DBG_EXPORT
+#endif
+
+
+namespace segfault {
+	// Phases of writing a crash report
+	enum HandlerPhase {
+		PHASE_UNWIND = 0,
+		PHASE_SYMBOLIZE,
+		PHASE_FORMAT,
+		PHASE_WRITE,
+		PHASE_COUNT,
+	};
+
+	// Bucket `i` counts durations under 2^i us, the last one counts the rest
+	constexpr size_t PHASE_BUCKETS = 16;
+	constexpr size_t MAX_COUNTED_SIGNALS = 32;
+
+	struct PhaseStats {
+		uint64_t count;
+		uint64_t totalNs;
+		uint64_t maxNs;
+		uint64_t buckets[PHASE_BUCKETS];
+	};
+
+	struct SignalCount {
+		uint32_t signal;
+		uint64_t count;
+	};
+
+	struct HandlerStats {
+		SignalCount signals[MAX_COUNTED_SIGNALS];
+		size_t signalCount;
+		uint64_t reports; // written in full
+		uint64_t bytes; // of reports and records, once per report, not per target
+		uint64_t dropped; // crashes not reported in full, e.g. deduplicated
+		PhaseStats phases[PHASE_COUNT];
+	};
+
+	// `CLOCK_MONOTONIC`, read through the vDSO where there is one. Signal-safe.
+	DBG_EXPORT uint64_t getMonotonicNs();
+
+	// Counters, all signal-safe and thread-safe
+	DBG_EXPORT void countSignal(uint32_t signal);
+	DBG_EXPORT void countReport(size_t bytes);
+	DBG_EXPORT void countDroppedReport();
+	DBG_EXPORT void recordPhase(HandlerPhase phase, uint64_t ns);
+
+	// A snapshot of the counters since the process started
+	DBG_EXPORT void getHandlerStats(HandlerStats *stats);
+	DBG_EXPORT const char *getPhaseName(HandlerPhase phase);
+}
+
+#endif /* _HANDLER_STATS_HPP_ */
@@ -0,0 +1,139 @@
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "journal.hpp"
+
+
+namespace segfault {
+
+static const char JOURNAL_MAGIC[8] = { 'S', 'F', 'J', 'O', 'U', 'R', 'N', 'L' };
+constexpr uint32_t JOURNAL_VERSION = 1;
+
+struct JournalHeader {
+	char magic[8];
+	uint32_t version;
+	uint32_t headerSize;
+	uint64_t capacity;
+	uint64_t head;
+	uint8_t reserved[JOURNAL_HEADER_SIZE - 32];
+};
+static_assert(sizeof(JournalHeader) == JOURNAL_HEADER_SIZE, "Journal header must be 64 bytes");
+
+static std::atomic<JournalHeader*> _journal(nullptr);
+static size_t _journalSize = 0;
+
+
+DBG_EXPORT int openJournal(const char *path, size_t size) {
+#ifdef _WIN32
+	(void)path;
+	(void)size;
+	return ENOTSUP;
+#else
+	if (size < MIN_JOURNAL_SIZE) {
+		return EINVAL;
+	}
+	int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+	if (fd < 0) {
+		return errno;
+	}
+
+	// Reserve the blocks now: a sparse file could fail to grow under a full disk at crash time
+	struct stat status;
+	int error = 0;
+	if (fstat(fd, &status) != 0) {
+		error = errno;
+	} else if (static_cast<size_t>(status.st_size) != size && ftruncate(fd, static_cast<off_t>(size)) != 0) {
+		error = errno;
+	}
+#ifdef __linux__
+	if (!error) {
+		error = posix_fallocate(fd, 0, static_cast<off_t>(size));
+	}
+#endif
+	void *mapped = MAP_FAILED;
+	if (!error) {
+		mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		error = mapped == MAP_FAILED ? errno : 0;
+	}
+	close(fd);
+	if (error) {
+		return error;
+	}
+
+	JournalHeader *header = static_cast<JournalHeader*>(mapped);
+	uint64_t capacity = size - JOURNAL_HEADER_SIZE;
+	bool isContinued = (
+		!memcmp(header->magic, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) &&
+		header->version == JOURNAL_VERSION && header->headerSize == JOURNAL_HEADER_SIZE &&
+		header->capacity == capacity
+	);
+	if (!isContinued) {
+		memset(mapped, 0, size);
+		memcpy(header->magic, JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+		header->version = JOURNAL_VERSION;
+		header->headerSize = JOURNAL_HEADER_SIZE;
+		header->capacity = capacity;
+	}
+
+	closeJournal();
+	_journalSize = size;
+	_journal.store(header, std::memory_order_release);
+	return 0;
+#endif
+}
+
+
+DBG_EXPORT void closeJournal() {
+	JournalHeader *header = _journal.exchange(nullptr, std::memory_order_acq_rel);
+#ifndef _WIN32
+	if (header) {
+		munmap(header, _journalSize);
+	}
+#endif
+	_journalSize = 0;
+}
+
+
+DBG_EXPORT bool isJournalOpen() {
+	return _journal.load(std::memory_order_acquire) != nullptr;
+}
+
+DBG_EXPORT size_t getJournalSize() {
+	return isJournalOpen() ? _journalSize : 0;
+}
+
+
+DBG_EXPORT void appendJournal(const char *data, size_t size) {
+#ifdef _WIN32
+	(void)data;
+	(void)size;
+#else
+	JournalHeader *header = _journal.load(std::memory_order_acquire);
+	if (!header || !size) {
+		return;
+	}
+	uint64_t capacity = header->capacity;
+	if (size > capacity) {
+		data += size - capacity;
+		size = capacity;
+	}
+
+	// Reserve the range first, so concurrent writers never share bytes
+	uint64_t position = __atomic_fetch_add(&header->head, size, __ATOMIC_ACQ_REL);
+	char *ring = reinterpret_cast<char*>(header) + JOURNAL_HEADER_SIZE;
+	size_t offset = static_cast<size_t>(position % capacity);
+	size_t first = capacity - offset < size ? capacity - offset : size;
+	memcpy(ring + offset, data, first);
+	memcpy(ring, data + first, size - first);
+#endif
+}
+
+} // namespace segfault
@@ -0,0 +1,38 @@
+#ifndef _JOURNAL_HPP_
+#define _JOURNAL_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#define DBG_EXPORT __declspec(dllexport)
+#else
+#define DBG_EXPORT
+#endif
+
+
+namespace segfault {
+	// Crash journal: a fixed-size file mapped with MAP_SHARED in advance. Reports are copied
+	// into the mapping, so they reach the page cache with no syscalls and no free fds at crash
+	// time, and survive the process dying mid-report.
+	//
+	// Layout: a 64-byte header ("SFJOURNL", u32 version, u32 header size, u64 capacity,
+	// u64 head), then a ring of `capacity` bytes. `head` counts every byte ever appended,
+	// byte N of the stream is at ring offset N % capacity.
+	constexpr size_t JOURNAL_HEADER_SIZE = 64;
+	constexpr size_t MIN_JOURNAL_SIZE = 16 * 1024;
+
+	// Map the journal at `path`, creating or resizing it to `size` bytes in total. A journal
+	// of the same size is continued. Returns 0 or an errno value. Not signal-safe.
+	DBG_EXPORT int openJournal(const char *path, size_t size);
+	DBG_EXPORT void closeJournal();
+
+	DBG_EXPORT bool isJournalOpen();
+	// Total file size of the open journal, 0 if none
+	DBG_EXPORT size_t getJournalSize();
+
+	// Append to the ring, the oldest data is overwritten. Signal-safe, thread-safe.
+	DBG_EXPORT void appendJournal(const char *data, size_t size);
+}
+
+#endif /* _JOURNAL_HPP_ */
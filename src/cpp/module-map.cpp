@@ -0,0 +1,281 @@
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+#include <shared_mutex>
+
+#ifdef __linux__
+#include <link.h>
+#include <unistd.h>
+#include <limits.h>
+#include <stddef.h>
+#elif !defined(_WIN32)
+#include <dlfcn.h>
+#endif
+
+#include "module-map.hpp"
+
+
+namespace segfault {
+
+constexpr size_t MAX_MODULES = 1024;
+constexpr size_t PATH_POOL_SIZE = 256 * 1024;
+
+// A complete, sorted snapshot. The handler only ever reads the published one.
+struct ModuleTable {
+	ModuleInfo modules[MAX_MODULES];
+	size_t count;
+	char pathPool[PATH_POOL_SIZE];
+	size_t pathPoolUsed;
+	// Loader state this snapshot reflects, see `dl_phdr_info::dlpi_adds`
+	unsigned long long adds;
+	unsigned long long subs;
+	size_t visited;
+};
+
+// Double buffering: updates fill the spare table, then publish it with one atomic store.
+// Updates hold the lock exclusively: after two of them, the spare is the table read before.
+static ModuleTable _tables[2];
+static std::atomic<ModuleTable*> _published(nullptr);
+static std::shared_mutex _updateMutex;
+static std::atomic<uint64_t> _generation(0);
+
+
+static inline const char *_storePath(ModuleTable &table, const char *path) {
+	size_t length = strlen(path) + 1;
+	if (table.pathPoolUsed + length > PATH_POOL_SIZE) {
+		return "";
+	}
+	char *stored = table.pathPool + table.pathPoolUsed;
+	memcpy(stored, path, length);
+	table.pathPoolUsed += length;
+	return stored;
+}
+
+
+#ifdef __linux__
+struct IterationState {
+	ModuleTable *table;
+	size_t skip; // modules already present in `table`
+	size_t index;
+};
+
+struct LoaderCounters {
+	unsigned long long adds;
+	unsigned long long subs;
+};
+
+static inline bool _hasLoaderCounters(size_t size) {
+	return size >= offsetof(struct dl_phdr_info, dlpi_subs) + sizeof(dl_phdr_info::dlpi_subs);
+}
+
+static int _readLoaderCounters(struct dl_phdr_info *info, size_t size, void *data) {
+	LoaderCounters *counters = static_cast<LoaderCounters*>(data);
+	if (_hasLoaderCounters(size)) {
+		counters->adds = info->dlpi_adds;
+		counters->subs = info->dlpi_subs;
+	}
+	return 1;
+}
+
+// Copy the NT_GNU_BUILD_ID of a loaded PT_NOTE segment, notes are in memory already
+static inline void _readBuildId(uintptr_t notes, size_t size, ModuleInfo *module) {
+	size_t offset = 0;
+	while (offset + sizeof(ElfW(Nhdr)) <= size) {
+		const ElfW(Nhdr) *note = reinterpret_cast<const ElfW(Nhdr)*>(notes + offset);
+		size_t nameAt = offset + sizeof(ElfW(Nhdr));
+		size_t descAt = nameAt + ((note->n_namesz + 3) & ~size_t(3));
+		offset = descAt + ((note->n_descsz + 3) & ~size_t(3));
+		if (offset > size) {
+			return;
+		}
+		const char *name = reinterpret_cast<const char*>(notes + nameAt);
+		if (
+			note->n_type == NT_GNU_BUILD_ID && note->n_namesz == 4 && !memcmp(name, "GNU", 4) &&
+			note->n_descsz <= MAX_BUILD_ID_SIZE
+		) {
+			memcpy(module->buildId, reinterpret_cast<const void*>(notes + descAt), note->n_descsz);
+			module->buildIdSize = static_cast<uint8_t>(note->n_descsz);
+			return;
+		}
+	}
+}
+
+static int _addModule(struct dl_phdr_info *info, size_t size, void *data) {
+	IterationState &state = *static_cast<IterationState*>(data);
+	ModuleTable &table = *state.table;
+
+	if (_hasLoaderCounters(size)) {
+		table.adds = info->dlpi_adds;
+		table.subs = info->dlpi_subs;
+	}
+	if (state.index++ < state.skip) {
+		return 0;
+	}
+	table.visited = state.index;
+	if (table.count >= MAX_MODULES) {
+		return 1;
+	}
+
+	uintptr_t start = UINTPTR_MAX;
+	uintptr_t end = 0;
+	uintptr_t ehFrameHeader = 0;
+	ModuleInfo &module = table.modules[table.count];
+	module.buildIdSize = 0;
+	for (int i = 0; i < info->dlpi_phnum; i++) {
+		const ElfW(Phdr) &header = info->dlpi_phdr[i];
+		if (header.p_type == PT_GNU_EH_FRAME) {
+			ehFrameHeader = info->dlpi_addr + header.p_vaddr;
+		}
+		if (header.p_type == PT_NOTE && !module.buildIdSize) {
+			_readBuildId(info->dlpi_addr + header.p_vaddr, header.p_memsz, &module);
+		}
+		if (header.p_type != PT_LOAD) {
+			continue;
+		}
+		uintptr_t from = info->dlpi_addr + header.p_vaddr;
+		uintptr_t to = from + header.p_memsz;
+		start = from < start ? from : start;
+		end = to > end ? to : end;
+	}
+	if (start >= end) {
+		return 0;
+	}
+
+	// The main executable comes with an empty name
+	const char *name = info->dlpi_name;
+	char exePath[PATH_MAX];
+	if (!name || !name[0]) {
+		ssize_t length = readlink("/proc/self/exe", exePath, sizeof(exePath) - 1);
+		exePath[length > 0 ? length : 0] = '\0';
+		name = exePath;
+	}
+
+	table.count++;
+	module.start = start;
+	module.end = end;
+	module.base = info->dlpi_addr;
+	module.path = _storePath(table, name);
+	module.symbols = nullptr;
+	readUnwindTable(ehFrameHeader, &module.unwind);
+	return 0;
+}
+#endif
+
+
+DBG_EXPORT void updateModules() {
+#ifdef __linux__
+	std::lock_guard<std::shared_mutex> lock(_updateMutex);
+
+	ModuleTable *current = _published.load(std::memory_order_acquire);
+
+	// Cheap check first: the loader counts every load and unload
+	LoaderCounters counters = { 0, 0 };
+	dl_iterate_phdr(_readLoaderCounters, &counters);
+	bool hasCounters = counters.adds || counters.subs;
+	if (current && hasCounters && counters.adds == current->adds && counters.subs == current->subs) {
+		return;
+	}
+
+	ModuleTable *next = current == &_tables[0] ? &_tables[1] : &_tables[0];
+	IterationState state = { next, 0, 0 };
+
+	if (current && hasCounters && counters.subs == current->subs) {
+		// Nothing was unloaded: the loader list only grew at the tail, append to a copy
+		next->count = current->count;
+		next->pathPoolUsed = 0;
+		for (size_t i = 0; i < current->count; i++) {
+			next->modules[i] = current->modules[i];
+			next->modules[i].path = _storePath(*next, current->modules[i].path);
+		}
+		next->visited = current->visited;
+		state.skip = current->visited;
+	} else {
+		next->count = 0;
+		next->pathPoolUsed = 0;
+		next->visited = 0;
+	}
+
+	size_t known = next->count;
+	dl_iterate_phdr(_addModule, &state);
+
+	// Symbol tables are indexed here, in normal context, so the handler only searches them
+	for (size_t i = known; i < next->count; i++) {
+		next->modules[i].symbols = loadSymbols(next->modules[i].path);
+	}
+
+	std::sort(
+		next->modules, next->modules + next->count,
+		[](const ModuleInfo &a, const ModuleInfo &b) { return a.start < b.start; }
+	);
+
+	_published.store(next, std::memory_order_release);
+	_generation.fetch_add(1, std::memory_order_release);
+#endif
+}
+
+
+DBG_EXPORT const ModuleInfo *findModule(uintptr_t address) {
+	const ModuleTable *table = _published.load(std::memory_order_acquire);
+	if (table && table->count) {
+		// Last module starting at or below `address`
+		size_t low = 0;
+		size_t high = table->count;
+		while (low < high) {
+			size_t mid = low + (high - low) / 2;
+			if (table->modules[mid].start <= address) {
+				low = mid + 1;
+			} else {
+				high = mid;
+			}
+		}
+		if (low && address < table->modules[low - 1].end) {
+			return &table->modules[low - 1];
+		}
+		return nullptr;
+	}
+
+#if !defined(__linux__) && !defined(_WIN32)
+	// No module table on this platform, ask the loader instead
+	static ModuleInfo lookup;
+	Dl_info info;
+	if (dladdr(reinterpret_cast<void*>(address), &info) && info.dli_fname) {
+		lookup.start = reinterpret_cast<uintptr_t>(info.dli_fbase);
+		lookup.end = address + 1;
+		lookup.base = lookup.start;
+		lookup.path = info.dli_fname;
+		lookup.symbols = nullptr;
+		lookup.unwind = {};
+		lookup.buildIdSize = 0;
+		return &lookup;
+	}
+#endif
+
+	return nullptr;
+}
+
+
+DBG_EXPORT void lockModules() {
+	_updateMutex.lock_shared();
+}
+
+DBG_EXPORT void unlockModules() {
+	_updateMutex.unlock_shared();
+}
+
+
+DBG_EXPORT uint64_t getModuleGeneration() {
+	return _generation.load(std::memory_order_acquire);
+}
+
+DBG_EXPORT size_t getModuleCount() {
+	const ModuleTable *table = _published.load(std::memory_order_acquire);
+	return table ? table->count : 0;
+}
+
+DBG_EXPORT const ModuleInfo *getModule(size_t index) {
+	const ModuleTable *table = _published.load(std::memory_order_acquire);
+	return table && index < table->count ? &table->modules[index] : nullptr;
+}
+
+} // namespace segfault
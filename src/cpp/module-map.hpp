@@ -0,0 +1,50 @@
+#ifndef _MODULE_MAP_HPP_
+#define _MODULE_MAP_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "symbol-index.hpp"
+#include "unwinder.hpp"
+
+#ifdef _WIN32
+#define DBG_EXPORT __declspec(dllexport)
+#else
+#define DBG_EXPORT
+#endif
+
+
+namespace segfault {
+	constexpr size_t MAX_BUILD_ID_SIZE = 32;
+
+	// A loaded executable or shared object
+	struct ModuleInfo {
+		uintptr_t start; // lowest mapped address
+		uintptr_t end; // one past the highest mapped address
+		uintptr_t base; // load bias: runtime address minus ELF virtual address
+		const char *path;
+		const SymbolTable *symbols; // nullptr if the file has no usable symbols
+		UnwindTable unwind; // `.eh_frame_hdr` search table, if any
+		uint8_t buildId[MAX_BUILD_ID_SIZE]; // from the GNU build-id note, if any
+		uint8_t buildIdSize;
+	};
+
+	// Snapshot the loaded modules. Not signal-safe, call in normal context.
+	DBG_EXPORT void updateModules();
+
+	// Find the module containing `address`, or nullptr. Signal-safe.
+	DBG_EXPORT const ModuleInfo *findModule(uintptr_t address);
+
+	// Keep `updateModules()` from rewriting the tables, while another thread reads what
+	// `findModule()` returned. Shared between readers. Not signal-safe.
+	DBG_EXPORT void lockModules();
+	DBG_EXPORT void unlockModules();
+
+	// Changes whenever `updateModules()` publishes a new snapshot
+	DBG_EXPORT uint64_t getModuleGeneration();
+
+	DBG_EXPORT size_t getModuleCount();
+	DBG_EXPORT const ModuleInfo *getModule(size_t index);
+}
+
+#endif /* _MODULE_MAP_HPP_ */
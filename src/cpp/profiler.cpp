@@ -0,0 +1,279 @@
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <new>
+
+#ifdef __linux__
+#include <signal.h>
+#include <time.h>
+#endif
+
+#include "profiler.hpp"
+#include "thread-registry.hpp"
+#include "unwinder.hpp"
+
+
+namespace segfault {
+
+#ifdef __linux__
+constexpr size_t MAX_PROFILED_THREADS = 1024;
+constexpr size_t MAX_SAMPLE_FRAMES = 256;
+// `stopProfiler()` waits this many spins at most for a sample on another thread
+constexpr int STOP_MAX_SPINS = 1000000;
+
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid
+#endif
+
+// CPU-time clock of any thread in the process, encoded as `pthread_getcpuclockid()` does:
+// ~tid << 3, then CPUCLOCK_PERTHREAD_MASK | CPUCLOCK_SCHED
+static inline clockid_t _getThreadCpuClock(int tid) {
+	return static_cast<clockid_t>((~static_cast<unsigned>(tid) << 3) | 4 | 2);
+}
+
+static inline uint64_t _getRealtimeNs() {
+	struct timespec now;
+	clock_gettime(CLOCK_REALTIME, &now);
+	return uint64_t(now.tv_sec) * 1000000000 + uint64_t(now.tv_nsec);
+}
+
+
+static timer_t _timers[MAX_PROFILED_THREADS];
+static size_t _timerCount = 0;
+static size_t _profiledThreads = 0;
+
+// Installed once and kept: a tick may still be pending when the profiler stops
+static bool _isHandlerInstalled = false;
+static struct sigaction _previousAction;
+
+// Ring of words, a sample is a header word (tid << 32 | frame count), then its frames.
+// Samples are taken holding the unwinder lock, so the ring has a single producer, and
+// a single reader in normal context.
+static uint64_t *_ring = nullptr;
+static size_t _ringSize = 0;
+static std::atomic<size_t> _writeIndex(0);
+static std::atomic<size_t> _readIndex(0);
+
+static std::atomic<bool> _isRunning(false);
+static std::atomic<uint64_t> _samples(0);
+static std::atomic<uint64_t> _dropped(0);
+static ProfilerOptions _options;
+static void *_sampleFrames[MAX_SAMPLE_FRAMES];
+static uint64_t _startNs = 0;
+static uint64_t _stopNs = 0;
+
+
+static inline void _storeSample(int tid, size_t count) {
+	size_t write = _writeIndex.load(std::memory_order_relaxed);
+	size_t read = _readIndex.load(std::memory_order_acquire);
+	if (_ringSize - (write - read) < count + 1) {
+		_dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+	_ring[write % _ringSize] = (uint64_t(uint32_t(tid)) << 32) | count;
+	for (size_t i = 0; i < count; i++) {
+		_ring[(write + 1 + i) % _ringSize] = reinterpret_cast<uintptr_t>(_sampleFrames[i]);
+	}
+	_writeIndex.store(write + 1 + count, std::memory_order_release);
+	_samples.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+static void _handleProfileSignal(int signalId, siginfo_t *info, void *context) {
+	int savedErrno = errno;
+
+	if (!_isRunning.load()) {
+		// Not our tick: e.g. V8's own profiler also samples with SIGPROF
+		if ((_previousAction.sa_flags & SA_SIGINFO) && _previousAction.sa_sigaction) {
+			_previousAction.sa_sigaction(signalId, info, context);
+		} else if (
+			!(_previousAction.sa_flags & SA_SIGINFO) &&
+			_previousAction.sa_handler != SIG_DFL && _previousAction.sa_handler != SIG_IGN
+		) {
+			_previousAction.sa_handler(signalId);
+		}
+		errno = savedErrno;
+		return;
+	}
+
+	// Another thread is sampling, or reporting: this tick is skipped, not queued
+	if (!lockUnwinder(0)) {
+		_dropped.fetch_add(1, std::memory_order_relaxed);
+		errno = savedErrno;
+		return;
+	}
+	// Checked again: `pauseProfiler()` may have run in between
+	if (_isRunning.load()) {
+		size_t count = unwindStack(
+			context, _sampleFrames, _options.maxFrames, static_cast<UnwindMethod>(_options.unwindMethod)
+		);
+		_storeSample(getCurrentThreadId(), count);
+	}
+	unlockUnwinder();
+	errno = savedErrno;
+}
+#endif
+
+
+DBG_EXPORT int startProfiler(const ProfilerOptions &options, const int *tids, size_t tidCount) {
+#ifdef __linux__
+	if (_isRunning.load()) {
+		return EBUSY;
+	}
+	if (!options.hz || !options.maxFrames || options.maxFrames > MAX_SAMPLE_FRAMES) {
+		return EINVAL;
+	}
+
+	size_t ringSize = options.bufferSize / sizeof(uint64_t);
+	if (ringSize <= MAX_SAMPLE_FRAMES) {
+		return EINVAL;
+	}
+	if (ringSize != _ringSize) {
+		delete[] _ring;
+		_ring = new (std::nothrow) uint64_t[ringSize];
+		_ringSize = _ring ? ringSize : 0;
+		if (!_ring) {
+			return ENOMEM;
+		}
+	}
+	// Fault the pages in now, not in the signal handler
+	memset(_ring, 0, _ringSize * sizeof(uint64_t));
+	_writeIndex.store(0);
+	_readIndex.store(0);
+	_samples.store(0);
+	_dropped.store(0);
+	_options = options;
+
+	if (!_isHandlerInstalled) {
+		struct sigaction action;
+		memset(&action, 0, sizeof(action));
+		sigemptyset(&action.sa_mask);
+		action.sa_sigaction = _handleProfileSignal;
+		action.sa_flags = SA_SIGINFO | SA_RESTART;
+		if (sigaction(SIGPROF, &action, &_previousAction) != 0) {
+			return errno;
+		}
+		_isHandlerInstalled = true;
+	}
+
+	_startNs = _getRealtimeNs();
+	_stopNs = 0;
+	_isRunning.store(true);
+
+	long interval = 1000000000L / options.hz;
+	struct itimerspec period;
+	period.it_interval.tv_sec = interval / 1000000000L;
+	period.it_interval.tv_nsec = interval % 1000000000L;
+	period.it_value = period.it_interval;
+
+	_timerCount = 0;
+	for (size_t i = 0; i < tidCount && _timerCount < MAX_PROFILED_THREADS; i++) {
+		struct sigevent event;
+		memset(&event, 0, sizeof(event));
+		event.sigev_notify = SIGEV_THREAD_ID;
+		event.sigev_signo = SIGPROF;
+		event.sigev_notify_thread_id = tids[i];
+		timer_t timer;
+		// The thread may be gone already, it is just skipped
+		if (timer_create(_getThreadCpuClock(tids[i]), &event, &timer) != 0) {
+			continue;
+		}
+		if (timer_settime(timer, 0, &period, nullptr) != 0) {
+			timer_delete(timer);
+			continue;
+		}
+		_timers[_timerCount++] = timer;
+	}
+
+	_profiledThreads = _timerCount;
+	if (!_timerCount) {
+		stopProfiler();
+		return ESRCH;
+	}
+	return 0;
+#else
+	(void)options;
+	(void)tids;
+	(void)tidCount;
+	return ENOTSUP;
+#endif
+}
+
+
+DBG_EXPORT void stopProfiler() {
+#ifdef __linux__
+	if (!_isRunning.load()) {
+		return;
+	}
+	for (size_t i = 0; i < _timerCount; i++) {
+		timer_delete(_timers[i]);
+	}
+	_timerCount = 0;
+	_isRunning.store(false);
+	// Let an in-flight sample finish before the ring is read
+	if (lockUnwinder(STOP_MAX_SPINS)) {
+		unlockUnwinder();
+	}
+	_stopNs = _getRealtimeNs();
+#endif
+}
+
+
+DBG_EXPORT bool isProfilerRunning() {
+#ifdef __linux__
+	return _isRunning.load();
+#else
+	return false;
+#endif
+}
+
+
+DBG_EXPORT void pauseProfiler() {
+#ifdef __linux__
+	_isRunning.store(false);
+#endif
+}
+
+
+DBG_EXPORT void readProfile(SampleVisitor visit, void *data) {
+#ifdef __linux__
+	if (!_ring) {
+		return;
+	}
+	void *frames[MAX_SAMPLE_FRAMES];
+	size_t read = _readIndex.load(std::memory_order_relaxed);
+	size_t write = _writeIndex.load(std::memory_order_acquire);
+	while (read < write) {
+		uint64_t header = _ring[read % _ringSize];
+		int tid = static_cast<int>(header >> 32);
+		size_t count = static_cast<size_t>(header & 0xffffffff);
+		for (size_t i = 0; i < count && i < MAX_SAMPLE_FRAMES; i++) {
+			frames[i] = reinterpret_cast<void*>(static_cast<uintptr_t>(_ring[(read + 1 + i) % _ringSize]));
+		}
+		read += 1 + count;
+		visit(tid, frames, count < MAX_SAMPLE_FRAMES ? count : MAX_SAMPLE_FRAMES, data);
+	}
+	_readIndex.store(read, std::memory_order_release);
+#else
+	(void)visit;
+	(void)data;
+#endif
+}
+
+
+DBG_EXPORT ProfilerStats getProfilerStats() {
+	ProfilerStats stats = {};
+#ifdef __linux__
+	stats.samples = _samples.load();
+	stats.dropped = _dropped.load();
+	stats.threads = _profiledThreads;
+	stats.hz = _options.hz;
+	stats.startNs = _startNs;
+	if (_startNs) {
+		stats.durationNs = (_stopNs ? _stopNs : _getRealtimeNs()) - _startNs;
+	}
+#endif
+	return stats;
+}
+
+} // namespace segfault
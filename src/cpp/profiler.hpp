@@ -0,0 +1,51 @@
+#ifndef _PROFILER_HPP_
+#define _PROFILER_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#define DBG_EXPORT __declspec(dllexport)
+#else
+#define DBG_EXPORT
+#endif
+
+
+namespace segfault {
+	struct ProfilerOptions {
+		uint32_t hz; // samples per second of CPU time, per thread
+		uint32_t maxFrames;
+		size_t bufferSize; // bytes of the sample ring
+		int unwindMethod; // see `UnwindMethod`
+	};
+
+	// Sample the given threads (kernel TIDs) with per-thread CPU-time timers delivering
+	// SIGPROF. Stacks go to a preallocated ring until `stopProfiler()`. Returns 0 or an
+	// errno value. Linux only, call in normal context.
+	DBG_EXPORT int startProfiler(const ProfilerOptions &options, const int *tids, size_t tidCount);
+
+	// Disarm the timers and wait for an in-flight sample. Samples stay readable.
+	DBG_EXPORT void stopProfiler();
+
+	DBG_EXPORT bool isProfilerRunning();
+
+	// Called by the crash handler: no new samples are taken. A sample in flight may still
+	// hold the unwinder, see `lockUnwinder()`. Signal-safe.
+	DBG_EXPORT void pauseProfiler();
+
+	// Consume the collected samples, innermost frame first. Call after `stopProfiler()`.
+	typedef void (*SampleVisitor)(int tid, void *const *frames, size_t count, void *data);
+	DBG_EXPORT void readProfile(SampleVisitor visit, void *data);
+
+	struct ProfilerStats {
+		uint64_t samples; // taken and stored
+		uint64_t dropped; // ring full, or another thread was sampling
+		uint64_t threads; // threads with an armed timer
+		uint32_t hz;
+		uint64_t startNs; // CLOCK_REALTIME at start
+		uint64_t durationNs; // wall time until stop, or until now while running
+	};
+	DBG_EXPORT ProfilerStats getProfilerStats();
+}
+
+#endif /* _PROFILER_HPP_ */
@@ -0,0 +1,306 @@
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+
+#ifdef _WIN32
+#include <direct.h>
+#include <process.h>
+#include <windows.h>
+#else
+#include <limits.h>
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#include "report-prologue.hpp"
+#include "crash-guard.hpp"
+#include "module-map.hpp"
+
+
+namespace segfault {
+
+constexpr size_t PROLOGUE_SIZE = 32 * 1024;
+// Arguments and variables longer than this are cut
+constexpr size_t MAX_VALUE_SIZE = 1024;
+
+struct Prologue {
+	char json[PROLOGUE_SIZE];
+	size_t jsonSize;
+	char text[PROLOGUE_SIZE];
+	size_t textSize;
+};
+
+// Rendered into the one not in use, then published
+static Prologue _prologues[2];
+static std::atomic<Prologue*> _current(nullptr);
+static std::mutex _renderMutex;
+static std::atomic<int> _pid(0);
+
+// Short, and only rewritten in a forked child, before it has other threads
+struct PidParts {
+	char jsonMessage[64];
+	size_t jsonMessageSize;
+	char jsonPid[32];
+	size_t jsonPidSize;
+	char textMessage[64];
+	size_t textMessageSize;
+};
+static PidParts _pidParts;
+
+
+static inline int _readPid() {
+#ifdef _WIN32
+	return _getpid();
+#else
+	return getpid();
+#endif
+}
+
+static inline size_t _print(char *buffer, size_t size, const char *format, int pid) {
+	int printed = snprintf(buffer, size, format, pid);
+	return printed < 0 ? 0 : static_cast<size_t>(printed);
+}
+
+static void _renderPidParts() {
+	int pid = _readPid();
+	_pid.store(pid);
+	PidParts &parts = _pidParts;
+	parts.jsonMessageSize = _print(parts.jsonMessage, sizeof(parts.jsonMessage), "Process %d received ", pid);
+	parts.jsonPidSize = _print(parts.jsonPid, sizeof(parts.jsonPid), ",\"pid\":%d", pid);
+	parts.textMessageSize = _print(parts.textMessage, sizeof(parts.textMessage), "\nPID %d received ", pid);
+}
+
+// At load, so that they are there for any crash
+static const bool _isPidRendered = [] {
+	_renderPidParts();
+#ifndef _WIN32
+	pthread_atfork(nullptr, nullptr, _renderPidParts);
+#endif
+	return true;
+}();
+
+static inline std::string _getHostname() {
+#ifdef _WIN32
+	char name[MAX_COMPUTERNAME_LENGTH + 1];
+	DWORD size = sizeof(name);
+	return GetComputerNameA(name, &size) ? std::string(name, size) : std::string();
+#else
+	char name[256];
+	if (gethostname(name, sizeof(name)) != 0) {
+		return std::string();
+	}
+	name[sizeof(name) - 1] = '\0';
+	return name;
+#endif
+}
+
+static inline std::string _getWorkingDirectory() {
+#ifdef _WIN32
+	char *path = _getcwd(nullptr, 0);
+#else
+	char *path = getcwd(nullptr, 0);
+#endif
+	std::string result = path ? path : "";
+	free(path);
+	return result;
+}
+
+
+static inline std::string _cut(const std::string &value) {
+	return value.size() > MAX_VALUE_SIZE ? value.substr(0, MAX_VALUE_SIZE) : value;
+}
+
+static inline void _appendJson(std::string &out, const std::string &value) {
+	static const char hexDigits[] = "0123456789abcdef";
+	out += '"';
+	for (unsigned char c : value) {
+		if (c == '"' || c == '\\') {
+			out += '\\';
+			out += static_cast<char>(c);
+		} else if (c < 0x20) {
+			out += "\\u00";
+			out += hexDigits[c >> 4];
+			out += hexDigits[c & 0xf];
+		} else {
+			out += static_cast<char>(c);
+		}
+	}
+	out += '"';
+}
+
+// Text reports are read line by line
+static inline void _appendText(std::string &out, const std::string &value) {
+	for (unsigned char c : value) {
+		out += c < 0x20 ? ' ' : static_cast<char>(c);
+	}
+}
+
+static inline std::string _formatBuildId(const ModuleInfo &module) {
+	static const char hexDigits[] = "0123456789abcdef";
+	std::string result;
+	for (size_t i = 0; i < module.buildIdSize; i++) {
+		result += hexDigits[module.buildId[i] >> 4];
+		result += hexDigits[module.buildId[i] & 0xf];
+	}
+	return result;
+}
+
+static inline std::string _getFileName(const char *path) {
+	const char *slash = strrchr(path, '/');
+	return slash ? slash + 1 : path;
+}
+
+
+// Both formats, with the first `argCount` arguments and `envCount` variables
+static void _render(
+	const ProcessFacts &facts, const std::string &hostname, const std::string &cwd,
+	const std::vector<std::string> &envValues, size_t argCount, size_t envCount,
+	std::string &json, std::string &text
+) {
+	json += ",\"hostname\":";
+	_appendJson(json, hostname);
+	json += ",\"node\":";
+	_appendJson(json, facts.nodeVersion);
+	json += ",\"argv\":[";
+	for (size_t i = 0; i < argCount; i++) {
+		json += i ? "," : "";
+		_appendJson(json, _cut(facts.argv[i]));
+	}
+	json += "],\"cwd\":";
+	_appendJson(json, cwd);
+
+	text += "Host: ";
+	_appendText(text, hostname);
+	text += ", Node.js ";
+	_appendText(text, facts.nodeVersion);
+	text += "\nCommand line:";
+	for (size_t i = 0; i < argCount; i++) {
+		text += ' ';
+		_appendText(text, _cut(facts.argv[i]));
+	}
+	text += "\nWorking directory: ";
+	_appendText(text, cwd);
+	text += '\n';
+
+	if (envCount) {
+		json += ",\"env\":{";
+		text += "Environment:";
+		for (size_t i = 0; i < envCount; i++) {
+			json += i ? "," : "";
+			_appendJson(json, facts.envNames[i]);
+			json += ':';
+			_appendJson(json, _cut(envValues[i]));
+			text += ' ';
+			_appendText(text, facts.envNames[i]);
+			text += '=';
+			_appendText(text, _cut(envValues[i]));
+		}
+		json += '}';
+		text += '\n';
+	}
+
+	std::string buildIds;
+	std::string buildIdLines;
+	for (uintptr_t address : facts.modules) {
+		const ModuleInfo *module = findModule(address);
+		if (!module || !module->buildIdSize) {
+			continue;
+		}
+		std::string name = _getFileName(module->path);
+		buildIds += buildIds.empty() ? "" : ",";
+		_appendJson(buildIds, name);
+		buildIds += ':';
+		_appendJson(buildIds, _formatBuildId(*module));
+		buildIdLines += buildIdLines.empty() ? "Build-ids: " : ", ";
+		_appendText(buildIdLines, name);
+		buildIdLines += ' ';
+		buildIdLines += _formatBuildId(*module);
+	}
+	if (!buildIds.empty()) {
+		json += ",\"build_ids\":{" + buildIds + '}';
+		text += buildIdLines + '\n';
+	}
+}
+
+
+DBG_EXPORT void renderReportPrologue(const ProcessFacts &facts) {
+	std::lock_guard<std::mutex> lock(_renderMutex);
+
+	// Unset variables are left out
+	ProcessFacts present = facts;
+	present.envNames.clear();
+	std::vector<std::string> envValues;
+	for (const std::string &name : facts.envNames) {
+		const char *value = getenv(name.c_str());
+		if (value) {
+			present.envNames.push_back(name);
+			envValues.push_back(value);
+		}
+	}
+
+	std::string hostname = _getHostname();
+	std::string cwd = _getWorkingDirectory();
+	size_t argCount = facts.argv.size();
+	size_t envCount = envValues.size();
+	std::string json;
+	std::string text;
+	for (;;) {
+		json.clear();
+		text.clear();
+		_render(present, hostname, cwd, envValues, argCount, envCount, json, text);
+		if (json.size() <= PROLOGUE_SIZE && text.size() <= PROLOGUE_SIZE) {
+			break;
+		}
+		if (argCount) {
+			argCount--;
+		} else if (envCount) {
+			envCount--;
+		} else {
+			json.clear();
+			text.clear();
+			break;
+		}
+	}
+
+	// A report in progress reads the current prologue at flush time, maybe seconds later,
+	// and a second render would write over it. The process is going down anyway.
+	if (isCrashInProgress()) {
+		return;
+	}
+	Prologue *current = _current.load();
+	Prologue *next = current == &_prologues[0] ? &_prologues[1] : &_prologues[0];
+	memcpy(next->json, json.data(), json.size());
+	next->jsonSize = json.size();
+	memcpy(next->text, text.data(), text.size());
+	next->textSize = text.size();
+	_current.store(next);
+}
+
+
+DBG_EXPORT const char *getReportPrologue(ProloguePart part, size_t *size) {
+	const PidParts &parts = _pidParts;
+	switch (part) {
+		case PROLOGUE_JSON_MESSAGE: *size = parts.jsonMessageSize; return parts.jsonMessage;
+		case PROLOGUE_JSON_PID: *size = parts.jsonPidSize; return parts.jsonPid;
+		case PROLOGUE_TEXT_MESSAGE: *size = parts.textMessageSize; return parts.textMessage;
+		default: break;
+	}
+	Prologue *current = _current.load();
+	if (!current) {
+		*size = 0;
+		return "";
+	}
+	bool json = part == PROLOGUE_JSON;
+	*size = json ? current->jsonSize : current->textSize;
+	return json ? current->json : current->text;
+}
+
+
+DBG_EXPORT int getReportPid() {
+	int pid = _pid.load();
+	return pid ? pid : _readPid();
+}
+
+} // namespace segfault
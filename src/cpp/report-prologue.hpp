@@ -0,0 +1,47 @@
+#ifndef _REPORT_PROLOGUE_HPP_
+#define _REPORT_PROLOGUE_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#define DBG_EXPORT __declspec(dllexport)
+#else
+#define DBG_EXPORT
+#endif
+
+
+namespace segfault {
+	// Facts about the process that stay the same from crash to crash, rendered ahead of time
+	// in both report formats, so that the handler only copies them
+	struct ProcessFacts {
+		std::string nodeVersion;
+		std::vector<std::string> argv; // as the process was started, Node.js options included
+		std::vector<std::string> envNames; // variables to report, their values are read now
+		std::vector<uintptr_t> modules; // build-ids of the modules at these addresses
+	};
+
+	// Render the prologue of `facts`, the hostname and the working directory. Longer values
+	// are cut, and arguments, then variables, are left out if it gets too long. Nothing is
+	// rendered once a crash is being reported, its report keeps the prologue. Not signal-safe.
+	DBG_EXPORT void renderReportPrologue(const ProcessFacts &facts);
+
+	enum ProloguePart : int {
+		PROLOGUE_JSON, // fields that follow "pid", each starting with a comma
+		PROLOGUE_TEXT, // whole lines, after the first one
+		// The parts with the pid, rendered at load and again in forked children
+		PROLOGUE_JSON_MESSAGE, // "Process <pid> received ", the signal name follows
+		PROLOGUE_JSON_PID, // ,"pid":<pid>
+		PROLOGUE_TEXT_MESSAGE, // "\nPID <pid> received ", the signal name follows
+	};
+
+	// A rendered part of the report. The prologue itself is empty until rendered. Signal-safe.
+	DBG_EXPORT const char *getReportPrologue(ProloguePart part, size_t *size);
+
+	// The pid, cached, and updated in forked children. Signal-safe.
+	DBG_EXPORT int getReportPid();
+}
+
+#endif /* _REPORT_PROLOGUE_HPP_ */
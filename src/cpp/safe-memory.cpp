@@ -0,0 +1,76 @@
+#include <cstring>
+#include <errno.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+#include "safe-memory.hpp"
+
+
+namespace segfault {
+
+#ifndef _WIN32
+// The kernel validates the source of `write()`, and fails with EFAULT instead of
+// raising SIGSEGV. Bytes that made it into the pipe are read back as the result.
+static int _probe[2] = { -1, -1 };
+
+static inline void _drain() {
+	char scratch[64];
+	while (read(_probe[0], scratch, sizeof(scratch)) > 0) {}
+}
+#endif
+
+
+DBG_EXPORT void initSafeMemory() {
+#ifndef _WIN32
+	if (_probe[0] >= 0 || pipe(_probe) != 0) {
+		return;
+	}
+	for (int fd : _probe) {
+		fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+		fcntl(fd, F_SETFD, FD_CLOEXEC);
+	}
+#endif
+}
+
+
+DBG_EXPORT bool readMemory(uintptr_t address, void *out, size_t size) {
+#ifdef _WIN32
+	(void)address;
+	(void)out;
+	(void)size;
+	return false;
+#else
+	if (_probe[1] < 0 || !address) {
+		return false;
+	}
+
+	ssize_t written;
+	do {
+		written = write(_probe[1], reinterpret_cast<const void*>(address), size);
+	} while (written < 0 && errno == EINTR);
+
+	if (written != static_cast<ssize_t>(size)) {
+		// Partially readable, or a pipe left dirty by an earlier failure
+		if (written > 0) {
+			_drain();
+		}
+		return false;
+	}
+
+	ssize_t got;
+	do {
+		got = read(_probe[0], out, size);
+	} while (got < 0 && errno == EINTR);
+
+	if (got != static_cast<ssize_t>(size)) {
+		_drain();
+		return false;
+	}
+	return true;
+#endif
+}
+
+} // namespace segfault
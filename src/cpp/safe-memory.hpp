@@ -0,0 +1,28 @@
+#ifndef _SAFE_MEMORY_HPP_
+#define _SAFE_MEMORY_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#define DBG_EXPORT __declspec(dllexport)
+#else
+#define DBG_EXPORT
+#endif
+
+
+namespace segfault {
+	// Open the probe pipe used by `readMemory()`. Not signal-safe, call in normal context.
+	DBG_EXPORT void initSafeMemory();
+
+	// Copy `size` bytes (at most `PIPE_BUF`) from a possibly unmapped `address`.
+	// Returns false instead of faulting if the memory is not readable. Signal-safe.
+	DBG_EXPORT bool readMemory(uintptr_t address, void *out, size_t size);
+
+	template <typename T>
+	inline bool readMemory(uintptr_t address, T *out) {
+		return readMemory(address, out, sizeof(T));
+	}
+}
+
+#endif /* _SAFE_MEMORY_HPP_ */
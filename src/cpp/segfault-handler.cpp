@@ -1,15 +1,19 @@
+#include <chrono>
 #include <map>
 #include <string>
-#include <filesystem>
-#include <fstream>
+#include <thread>
+#include <vector>
 #include <iostream>
 #include <stdio.h>
 #include <time.h>
 #include <fcntl.h>
 #include <cstring>
+#include <cerrno>
 #include <inttypes.h>
 
 #ifdef _WIN32
+#include <filesystem>
+#include <fstream>
 #include <io.h>
 #include <windows.h>
 #include "stack-windows.hpp"
@@ -17,6 +21,7 @@
 #include <signal.h>
 #include <unistd.h>
 #include <dlfcn.h>
+#include <limits.h>
 #if defined(__linux__)
 #define _XOPEN_SOURCE 700
 #include <ucontext.h>
@@ -42,7 +47,28 @@
 #endif
 #endif
 
+#include <uv.h>
+
 #include "segfault-handler.hpp"
+#include "alt-stack.hpp"
+#include "crash-dedup.hpp"
+#include "crash-dump.hpp"
+#include "crash-file.hpp"
+#include "crash-guard.hpp"
+#include "crash-socket.hpp"
+#include "emitter.hpp"
+#include "handler-stats.hpp"
+#include "crash-record.hpp"
+#include "journal.hpp"
+#include "module-map.hpp"
+#include "profiler.hpp"
+#include "report-prologue.hpp"
+#include "safe-memory.hpp"
+#include "symbol-cache.hpp"
+#include "unwinder.hpp"
+#include "thread-dump.hpp"
+#include "thread-registry.hpp"
+#include "watchdog.hpp"
 
 
 namespace segfault {
@@ -50,44 +76,207 @@ namespace segfault {
 // Configuration: true for JSON output, false for plain text output
 bool useJsonOutput = false;
 
-// Signal handler recursion protection
-#ifdef _WIN32
-static volatile int in_signal_handler = 0;  // Windows doesn't have sig_atomic_t
+// Configuration: true to report raw PCs with module base and path, symbolized offline
+bool useRawAddresses = false;
+
+// Configuration: how the built-in unwinder walks the stack.
+// Diagnostic builds keep frame pointers everywhere, so the fast walk is the default there.
+#ifdef SEGFAULT_FRAME_POINTERS
+UnwindMethod unwindMethod = UNWIND_FRAME_POINTERS;
 #else
-static volatile sig_atomic_t in_signal_handler = 0;  // Unix/POSIX platforms
+UnwindMethod unwindMethod = UNWIND_CFI;
 #endif
 
+constexpr auto GETPID = getReportPid;
+
 #ifdef _WIN32
-	constexpr auto GETPID = _getpid;
 	#define SEGFAULT_HANDLER LONG CALLBACK handleSignal(PEXCEPTION_POINTERS info)
 	#define NO_INLINE __declspec(noinline)
 	#define HANDLER_CANCEL return EXCEPTION_CONTINUE_SEARCH
 	#define HANDLER_DONE return EXCEPTION_EXECUTE_HANDLER
 #else
-	constexpr auto GETPID = getpid;
-	#define SEGFAULT_HANDLER static void handleSignal(int sig, siginfo_t *info, void *unused)
+	#define SEGFAULT_HANDLER static void handleSignal(int sig, siginfo_t *info, void *context)
 	#define NO_INLINE __attribute__ ((noinline))
 	#define HANDLER_CANCEL return
 	#define HANDLER_DONE return
-	
-	size_t stackBytes = SIGSTKSZ;
-	char* _altStackBytes = new char[stackBytes];
-
-#ifdef __clang__
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Wc++11-narrowing"
-#endif
-	stack_t _altStack = {
-		_altStackBytes,
-		0,
-		stackBytes
-	};
-#ifdef __clang__
-#pragma clang diagnostic pop
-#endif
 #endif
 
+#ifdef _WIN32
 time_t timeInfo;
+#endif
+
+constexpr int STDERR_FD = 2;
+constexpr size_t MAX_FRAMES = 32;
+constexpr size_t MAX_CAPTURE_FRAMES = 256;
+// Handler and trampoline frames a fallback unwinder may report above the crash
+constexpr size_t HANDLER_FRAMES = 8;
+constexpr size_t MAX_SIGNAL_CAPTURE_OPTIONS = 32;
+constexpr uint32_t INHERIT_OPTION = UINT32_MAX;
+// The crash handler waits this many spins at most for other threads to leave the unwinder
+constexpr int CRASH_UNWINDER_SPINS = 1000000;
+// How long the crash report waits for other crashing threads to unwind their stacks
+constexpr uint32_t SECONDARY_CRASH_TIMEOUT_MS = 200;
+
+// Configuration: stack capture depth, and how many innermost frames of the crashed code to skip
+struct CaptureOptions {
+	uint32_t maxFrames;
+	uint32_t skipFrames;
+};
+CaptureOptions captureOptions = { MAX_FRAMES, 0 };
+
+// Configuration: per-signal overrides, `INHERIT_OPTION` fields come from `captureOptions`
+struct SignalCaptureOptions {
+	uint32_t signalId;
+	CaptureOptions options;
+};
+static SignalCaptureOptions signalCaptureOptions[MAX_SIGNAL_CAPTURE_OPTIONS];
+static size_t signalCaptureCount = 0;
+
+// Crash reports are composed here, so the handler never touches the heap
+constexpr size_t REPORT_BUFFER_SIZE = 64 * 1024;
+static char _reportBuffer[REPORT_BUFFER_SIZE];
+static Emitter _report(_reportBuffer, REPORT_BUFFER_SIZE);
+// Time spent looking up modules and symbols for `_report`, phases of the crash report
+static uint64_t _symbolizeNs = 0;
+static uint64_t _phaseNs[PHASE_COUNT];
+
+// Configuration: reports are also copied into this pre-mapped file, see `openJournal()`
+constexpr size_t DEFAULT_JOURNAL_SIZE = 1024 * 1024;
+static std::string journalPath;
+
+// Configuration: past `dedupLimit` reports of the same stack signature in a window of
+// `dedupWindow` seconds, a crash only gets a one-line record, see `openCrashDedup()`
+constexpr uint32_t DEFAULT_DEDUP_LIMIT = 3;
+constexpr uint32_t MAX_DEDUP_LIMIT = 1000000;
+constexpr uint32_t DEFAULT_DEDUP_WINDOW = 3600;
+constexpr uint32_t MAX_DEDUP_WINDOW = 30 * 24 * 3600;
+static std::string dedupPath;
+static uint32_t dedupLimit = DEFAULT_DEDUP_LIMIT;
+static uint32_t dedupWindow = DEFAULT_DEDUP_WINDOW;
+// Signature of the crash being reported, and its count in the window, 0 without dedup
+static uint64_t _crashSignature = 0;
+static uint32_t _crashSeen = 0;
+
+// Configuration: a crash dump is written into `dumpPath` for every reported crash, see
+// `openCrashDump()`. The name of the file written for this crash, empty if none.
+static std::string dumpPath;
+static CrashDumpOptions dumpOptions = { DEFAULT_DUMP_STACK_SIZE, DEFAULT_DUMP_WINDOW_SIZE };
+static char _dumpName[64] = "";
+
+// Configuration: profiler defaults, see `startProfiler()`
+constexpr uint32_t DEFAULT_PROFILER_HZ = 99;
+constexpr uint32_t MAX_PROFILER_HZ = 1000;
+constexpr uint32_t DEFAULT_PROFILER_FRAMES = 64;
+constexpr uint32_t DEFAULT_PROFILER_BUFFER = 8 * 1024 * 1024;
+constexpr uint32_t MIN_PROFILER_BUFFER = 64 * 1024;
+constexpr uint32_t MAX_PROFILER_BUFFER = 1024 * 1024 * 1024;
+constexpr size_t MAX_LISTED_THREADS = 4096;
+
+// Configuration: event loop watchdog, see `startWatchdog()`. Thresholds are in ms.
+constexpr uint32_t DEFAULT_WATCHDOG_THRESHOLD = 1000;
+constexpr uint32_t MIN_WATCHDOG_THRESHOLD = 10;
+constexpr uint32_t MAX_WATCHDOG_THRESHOLD = 3600 * 1000;
+constexpr uint32_t MAX_WATCHDOG_FRAMES = 256;
+static uv_timer_t *_heartbeat = nullptr;
+static napi_env _watchdogEnv = nullptr;
+
+// Stall reports are composed on the watchdog thread, apart from crash reports
+constexpr size_t STALL_BUFFER_SIZE = 16 * 1024;
+static char _stallBuffer[STALL_BUFFER_SIZE];
+static Emitter _stallReport(_stallBuffer, STALL_BUFFER_SIZE);
+
+// Configuration: on a crash, wait this long for the stacks of all other threads, 0 to skip
+constexpr uint32_t DEFAULT_THREAD_DUMP_TIMEOUT = 500;
+constexpr uint32_t MAX_THREAD_DUMP_TIMEOUT = 10000;
+static uint32_t threadDumpTimeout = 0;
+
+// On-demand captures wait this many spins at most for a profiler sample on another thread
+constexpr int CAPTURE_UNWINDER_SPINS = 100000;
+
+// Local time offset for the log file timestamp, `localtime()` is not signal-safe
+static int64_t gmtOffset = 0;
+
+#ifndef _WIN32
+// Acquired in `init()`: the handler must not open files or grow the stack much
+static int logFd = -1;
+static void *_frames[MAX_CAPTURE_FRAMES + HANDLER_FRAMES];
+
+// Configuration: binary crash records are appended here, one `write()` each
+static int recordFd = -1;
+static std::string recordPath;
+constexpr size_t RECORD_BUFFER_SIZE = 64 * 1024;
+static char _recordBuffer[RECORD_BUFFER_SIZE];
+
+// Configuration: where crash reports go, and in which format. The stack is unwound and
+// symbolized once, then composed once per format and written to every sink of it.
+enum CrashSinkType : int {
+	SINK_STDERR = 0,
+	SINK_FILE, // `path`, or "segfault.log" if it existed at init
+	SINK_JOURNAL, // see `setCrashJournal()`
+	SINK_SOCKET, // a collector listening at `path`, see `openCrashSocket()`
+	SINK_DIRECTORY, // a file per crash in the `path` directory, see `CrashFile`
+};
+enum CrashSinkFormat : int {
+	FORMAT_TEXT = 0,
+	FORMAT_JSON,
+	FORMAT_SUMMARY, // one JSON line of at most `SUMMARY_SIZE` bytes, see `_writeSummary()`
+};
+constexpr size_t SINK_FORMAT_COUNT = 3;
+struct CrashSink {
+	int type;
+	int format;
+	int fd; // opened for a file sink with a path, -1 for the log file, or the directory
+	CrashSocket socket; // connected for a socket sink
+};
+constexpr size_t MAX_CRASH_SINKS = 8;
+static CrashSink crashSinks[MAX_CRASH_SINKS];
+static size_t crashSinkCount = 0;
+static std::string crashSinkPaths[MAX_CRASH_SINKS];
+// Without configured sinks, text reports go everywhere, JSON reports skip the log file
+static bool hasCrashSinks = false;
+static const CrashSink DEFAULT_TEXT_SINKS[] = {
+	{ SINK_STDERR, FORMAT_TEXT, -1, {} },
+	{ SINK_FILE, FORMAT_TEXT, -1, {} },
+	{ SINK_JOURNAL, FORMAT_TEXT, -1, {} },
+};
+static const CrashSink DEFAULT_JSON_SINKS[] = {
+	{ SINK_STDERR, FORMAT_JSON, -1, {} },
+	{ SINK_JOURNAL, FORMAT_JSON, -1, {} },
+};
+
+// Module and symbol of a frame, looked up once per crash however many sinks format it
+struct FrameSymbol {
+	uintptr_t pc;
+	const ModuleInfo *module;
+	const char *name;
+	uintptr_t symbolAddress;
+};
+constexpr size_t FRAME_SYMBOL_SLOTS = 2048;
+static FrameSymbol _frameSymbols[FRAME_SYMBOL_SLOTS];
+
+// A report for socket sinks is collected here per format, then sent as one message
+constexpr size_t SOCKET_REPORT_SIZE = 64 * 1024;
+static char _socketReports[SINK_FORMAT_COUNT][SOCKET_REPORT_SIZE];
+static size_t _socketReportSizes[SINK_FORMAT_COUNT] = { 0, 0, 0 };
+
+// The summary is composed here within its budget, every piece of it in `_summaryPart`
+// first. A single write of at most PIPE_BUF bytes to a pipe is never interleaved.
+constexpr size_t SUMMARY_SIZE = PIPE_BUF < 4096 ? PIPE_BUF : 4096;
+constexpr size_t SUMMARY_PART_SIZE = 2048;
+constexpr size_t SUMMARY_FRAMES = 16;
+// Longer module and symbol names are cut, the rest of a frame is under 64 bytes
+constexpr size_t SUMMARY_NAME_SIZE = 256;
+static char _summaryBuffer[SUMMARY_SIZE];
+static Emitter _summary(_summaryBuffer, SUMMARY_SIZE);
+static char _summaryPartBuffer[SUMMARY_PART_SIZE];
+static Emitter _summaryPart(_summaryPartBuffer, SUMMARY_PART_SIZE);
+// Files of directory sinks for the current crash, by sink index, and their time
+static CrashFile _crashFiles[MAX_CRASH_SINKS];
+static time_t _crashFileTime = 0;
+// What the `_report` mirror copies to, as chosen by `_selectSinks()`
+static bool _isJournalMirrored = false;
+static int _socketMirrorFormat = -1;
+#endif
 
 const std::map<uint32_t, std::string> signalNames = {
 #ifdef _WIN32
@@ -149,6 +338,17 @@ const std::map<uint32_t, std::string> signalNames = {
 };
 
 
+#ifndef _WIN32
+// Names by signal number, filled at init, so the handler needs no map lookup
+constexpr size_t SIGNAL_NAME_SLOTS = 65;
+static const char *_signalNameTable[SIGNAL_NAME_SLOTS];
+#endif
+
+// Configuration: environment variables whose values go into reports, see `renderPrologue()`
+constexpr size_t MAX_REPORT_ENV = 64;
+static std::vector<std::string> reportEnvNames;
+
+
 std::map<uint32_t, bool> signalActivity = {
 #ifdef _WIN32
 	{ EXCEPTION_ALL, false },
@@ -231,533 +431,459 @@ static inline std::pair<uint32_t, uint64_t> _getSignalAndAddress(siginfo_t *info
 #endif
 
 
-// Write JSON stack trace to stderr
-static inline void _writeJsonStackTrace(uint32_t signalId, uint64_t address, void* context = nullptr) {
-	constexpr int STDERR_FD = 2;
-
-	// Get current time in ISO format
-	time_t now = time(0);
-	struct tm *utc_tm = gmtime(&now);
-	char timestamp[32];
-	strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%S.000Z", utc_tm);
-
-	// Start JSON object with timestamp and level
-	const char* json_start = "{\"time\":\"";
-	write(STDERR_FD, json_start, strlen(json_start));
-	write(STDERR_FD, timestamp, strlen(timestamp));
-
-	const char* level_part = "\",\"level\":\"ERROR\",\"type\":\"segfault\",\"signal\":";
-	write(STDERR_FD, level_part, strlen(level_part));
+static inline const char *_getSignalName(uint32_t signalId) {
+#ifdef _WIN32
+	auto it = signalNames.find(signalId);
+	return it == signalNames.end() ? nullptr : it->second.c_str();
+#else
+	return signalId < SIGNAL_NAME_SLOTS ? _signalNameTable[signalId] : nullptr;
+#endif
+}
 
-	// Write signal ID
-	char signal_str[32];
-	int signal_len = snprintf(signal_str, sizeof(signal_str), "%u", signalId);
-	write(STDERR_FD, signal_str, signal_len);
+static inline Emitter &_writeSignalName(Emitter &out, uint32_t signalId) {
+	const char *name = _getSignalName(signalId);
+	return name ? out.str(name) : out.dec(signalId);
+}
 
-	// Write signal name
-	const char* signal_name_prefix = ",\"signal_name\":\"";
-	write(STDERR_FD, signal_name_prefix, strlen(signal_name_prefix));
 
-	std::string signalName;
-	if (signalNames.count(signalId)) {
-		signalName = signalNames.at(signalId);
-	} else {
-		signalName = std::to_string(signalId);
+#ifndef _WIN32
+// Collect return addresses of the crashed thread, innermost first
+static inline size_t _captureStack(void **frames, size_t maxFrames, void *context, bool unwindAll) {
+	// The built-in CFI unwinder starts right at the interrupted code, and is signal-safe
+	size_t unwound = unwindStack(context, frames, maxFrames, unwindMethod);
+	if (unwound > 1) {
+		return unwound;
 	}
-	write(STDERR_FD, signalName.c_str(), signalName.length());
-
-	// Write human-readable message
-	const char* msg_prefix = "\",\"message\":\"Process ";
-	write(STDERR_FD, msg_prefix, strlen(msg_prefix));
-
-	int pid = GETPID();
-	char pid_msg[16];
-	int pid_msg_len = snprintf(pid_msg, sizeof(pid_msg), "%d", pid);
-	write(STDERR_FD, pid_msg, pid_msg_len);
-
-	const char* msg_middle = " received ";
-	write(STDERR_FD, msg_middle, strlen(msg_middle));
-	write(STDERR_FD, signalName.c_str(), signalName.length());
-	const char* msg_end = " signal";
-	write(STDERR_FD, msg_end, strlen(msg_end));
-
-	// Write address
-	const char* addr_prefix = "\",\"address\":\"0x";
-	write(STDERR_FD, addr_prefix, strlen(addr_prefix));
-
-	char addr_str[32];
-	int addr_len = snprintf(addr_str, sizeof(addr_str), "%" PRIx64, address);
-	write(STDERR_FD, addr_str, addr_len);
-
-	// Write PID
-	const char* pid_prefix = "\",\"pid\":";
-	write(STDERR_FD, pid_prefix, strlen(pid_prefix));
-	write(STDERR_FD, pid_msg, pid_msg_len);
-
-	// Start stack trace array
-	const char* stack_prefix = ",\"stack\":[";
-	write(STDERR_FD, stack_prefix, strlen(stack_prefix));
 
-#ifdef _WIN32
-	// TODO: Implement Windows JSON stack trace
-	const char* placeholder = "{\"frame\":0,\"address\":\"0x0\",\"symbol\":\"<windows_stack_not_implemented>\"}";
-	write(STDERR_FD, placeholder, strlen(placeholder));
-#else
 #if HAVE_EXECINFO_H
-	void *array[32];
-	size_t size = backtrace(array, 32);
-	char **symbols = backtrace_symbols(array, size);
-
-	for (size_t i = 0; i < size; i++) {
-		if (i > 0) {
-			const char* comma = ",";
-			write(STDERR_FD, comma, 1);
+	return static_cast<size_t>(backtrace(frames, static_cast<int>(maxFrames)));
+#elif HAVE_LIBUNWIND_H
+	size_t count = 0;
+	#if defined(__aarch64__)
+	if (unwindAll) {
+		unw_cursor_t cursor;
+		unw_context_t unwContext;
+		if (unw_getcontext(&unwContext) != 0 || unw_init_local(&cursor, &unwContext) != 0) {
+			return 0;
 		}
-
-		const char* frame_start = "{\"frame\":";
-		write(STDERR_FD, frame_start, strlen(frame_start));
-
-		char frame_num[16];
-		int frame_len = snprintf(frame_num, sizeof(frame_num), "%zu", i);
-		write(STDERR_FD, frame_num, frame_len);
-
-		const char* addr_start = ",\"address\":\"";
-		write(STDERR_FD, addr_start, strlen(addr_start));
-
-		char addr_hex[32];
-		int hex_len = snprintf(addr_hex, sizeof(addr_hex), "%p", array[i]);
-		write(STDERR_FD, addr_hex, hex_len);
-
-		const char* symbol_start = "\",\"symbol\":\"";
-		write(STDERR_FD, symbol_start, strlen(symbol_start));
-
-		if (symbols && symbols[i]) {
-			// Escape any quotes in the symbol name
-			const char* symbol = symbols[i];
-			while (*symbol) {
-				if (*symbol == '"' || *symbol == '\\') {
-					const char* escape = "\\";
-					write(STDERR_FD, escape, 1);
-				}
-				write(STDERR_FD, symbol, 1);
-				symbol++;
+		while (count < maxFrames && unw_step(&cursor) > 0) {
+			unw_word_t ip = 0;
+			if (unw_get_reg(&cursor, UNW_REG_IP, &ip) == 0) {
+				frames[count++] = reinterpret_cast<void*>(ip);
 			}
-		} else {
-			const char* unknown = "<unknown>";
-			write(STDERR_FD, unknown, strlen(unknown));
 		}
-
-		const char* frame_end = "\"}";
-		write(STDERR_FD, frame_end, strlen(frame_end));
-	}
-
-	if (symbols) {
-		free(symbols);
+		return count;
 	}
 
-#elif HAVE_LIBUNWIND_H
-	// Libunwind-based stack unwinding for Alpine/musl (ARM64 and x86_64)
-	// Use simplified, signal-safe approach to avoid recursive crashes
-
-	bool wrote_any_frame = false;
-
-	#ifdef __aarch64__
-	// ARM64-specific implementation with signal context and assembly
-	// First, try to resolve the crash address directly
-	void* crash_ip = nullptr;
-
-	// Try to get the actual crash location from signal context
+	// Signal-safe approach: the crash PC, plus the caller found through the frame pointer
+	void *crashIp = nullptr;
+	void *framePointer = nullptr;
 	#if defined(__linux__)
 	if (context) {
-		ucontext_t* uctx = (ucontext_t*)context;
-		// On ARM64, PC (program counter) is in uc_mcontext.pc
-		crash_ip = (void*)uctx->uc_mcontext.pc;
+		ucontext_t *uctx = static_cast<ucontext_t*>(context);
+		crashIp = reinterpret_cast<void*>(uctx->uc_mcontext.pc);
+		framePointer = reinterpret_cast<void*>(uctx->uc_mcontext.regs[29]);
 	}
 	#endif
+	if (!crashIp) {
+		__asm__ volatile ("mov %0, x30" : "=r" (crashIp));
+	}
+	if (!framePointer) {
+		__asm__ volatile ("mov %0, x29" : "=r" (framePointer));
+	}
+	if (crashIp && count < maxFrames) {
+		frames[count++] = crashIp;
+	}
 
-	// Fallback: Get the link register (return address) if no context available
-	if (!crash_ip) {
-		void* lr_addr;
-		__asm__ volatile ("mov %0, x30" : "=r" (lr_addr));
-		crash_ip = lr_addr;
-	}
-
-	if (crash_ip) {
-		Dl_info dlinfo;
-		if (dladdr(crash_ip, &dlinfo)) {
-			wrote_any_frame = true;
-
-			write(STDERR_FD, "{\"frame\":0,\"address\":\"", strlen("{\"frame\":0,\"address\":\""));
-
-			char addr_hex[32];
-			int hex_len = snprintf(addr_hex, sizeof(addr_hex), "0x%lx", (uintptr_t)crash_ip);
-			write(STDERR_FD, addr_hex, hex_len);
-
-			write(STDERR_FD, "\",\"symbol\":\"", strlen("\",\"symbol\":\""));
-
-			if (dlinfo.dli_sname && dlinfo.dli_sname[0] != '\0') {
-				// Write function name
-				const char* symbol_ptr = dlinfo.dli_sname;
-				int symbol_len = 0;
-				while (*symbol_ptr && symbol_len < 100) {
-					if (*symbol_ptr == '"' || *symbol_ptr == '\\') {
-						write(STDERR_FD, "\\", 1);
-					}
-					write(STDERR_FD, symbol_ptr, 1);
-					symbol_ptr++;
-					symbol_len++;
-				}
-
-				// Add offset if available
-				if (dlinfo.dli_saddr && (uintptr_t)dlinfo.dli_saddr <= (uintptr_t)crash_ip) {
-					uintptr_t offset = (uintptr_t)crash_ip - (uintptr_t)dlinfo.dli_saddr;
-					if (offset > 0 && offset < 0x100000) {
-						char offset_buffer[32];
-						int offset_len = snprintf(offset_buffer, sizeof(offset_buffer), " + %zu", offset);
-						write(STDERR_FD, offset_buffer, offset_len);
-					}
-				}
-			} else if (dlinfo.dli_fname && dlinfo.dli_fname[0] != '\0') {
-				// No function name, use module name
-				write(STDERR_FD, "<", 1);
-				const char* filename = strrchr(dlinfo.dli_fname, '/');
-				const char* basename = filename ? filename + 1 : dlinfo.dli_fname;
-
-				int name_len = 0;
-				while (*basename && name_len < 50) {
-					write(STDERR_FD, basename, 1);
-					basename++;
-					name_len++;
-				}
-				write(STDERR_FD, ">", 1);
-			} else {
-				write(STDERR_FD, "unknown", strlen("unknown"));
-			}
-
-			write(STDERR_FD, "\"}", strlen("\"}"));
+	uintptr_t fp = reinterpret_cast<uintptr_t>(framePointer);
+	if (fp > 0x1000 && fp < 0x7ffffffffff0 && (fp & 0x7) == 0 && count < maxFrames) {
+		struct StackFrame {
+			void *fp;
+			void *lr;
+		};
+		void *callerIp = reinterpret_cast<StackFrame*>(fp)->lr;
+		if (callerIp && reinterpret_cast<uintptr_t>(callerIp) > 0x1000) {
+			frames[count++] = callerIp;
 		}
 	}
-	#endif
-
-	// Try to get additional frame from frame pointer if possible
-	#ifdef __aarch64__
-	void* frame_fp = nullptr;
-
-	// Try to get frame pointer from signal context
-	#if defined(__linux__)
+	#elif defined(__x86_64__) || defined(_M_X64)
+	// Avoid libunwind API calls on x86_64: they cause recursive segfaults in signal handlers
+	(void)unwindAll;
+	void *crashIp = nullptr;
+	#if defined(__linux__) && defined(REG_RIP)
 	if (context) {
-		ucontext_t* uctx = (ucontext_t*)context;
-		// On ARM64, x29 is the frame pointer
-		frame_fp = (void*)uctx->uc_mcontext.regs[29];
+		crashIp = reinterpret_cast<void*>(static_cast<ucontext_t*>(context)->uc_mcontext.gregs[REG_RIP]);
 	}
 	#endif
-
-	// Fallback: Get current frame pointer if no context available
-	if (!frame_fp) {
-		__asm__ volatile ("mov %0, x29" : "=r" (frame_fp));
+	if (!crashIp) {
+		crashIp = __builtin_return_address(0);
 	}
+	if (crashIp && count < maxFrames) {
+		frames[count++] = crashIp;
+	}
+	#endif
+	return count;
+#else
+	return 0;
+#endif
+}
 
-	if (frame_fp && (uintptr_t)frame_fp > 0x1000 &&
-	    (uintptr_t)frame_fp < 0x7ffffffffff0 &&
-	    ((uintptr_t)frame_fp & 0x7) == 0) {
-
-		// Try to read the caller's return address from the frame
-		struct StackFrame {
-			void* fp;
-			void* lr;
-		};
-
-		StackFrame* frame = (StackFrame*)frame_fp;
-		void* caller_ip = frame->lr;
 
-		if (caller_ip && (uintptr_t)caller_ip > 0x1000) {
-			Dl_info caller_dlinfo;
-			if (dladdr(caller_ip, &caller_dlinfo) &&
-			    caller_dlinfo.dli_sname && caller_dlinfo.dli_sname[0] != '\0') {
+static inline CaptureOptions _getCaptureOptions(uint32_t signalId) {
+	CaptureOptions options = captureOptions;
+	for (size_t i = 0; i < signalCaptureCount; i++) {
+		if (signalCaptureOptions[i].signalId != signalId) {
+			continue;
+		}
+		const CaptureOptions &custom = signalCaptureOptions[i].options;
+		if (custom.maxFrames != INHERIT_OPTION) {
+			options.maxFrames = custom.maxFrames;
+		}
+		if (custom.skipFrames != INHERIT_OPTION) {
+			options.skipFrames = custom.skipFrames;
+		}
+		break;
+	}
+	return options;
+}
 
-				if (wrote_any_frame) {
-					write(STDERR_FD, ",", 1);
-				}
-				wrote_any_frame = true;
+// PC of the interrupted instruction, 0 if unknown
+static inline uintptr_t _getContextPc(void *context) {
+#if defined(__linux__) && defined(__x86_64__) && defined(REG_RIP)
+	return context ? static_cast<uintptr_t>(static_cast<ucontext_t*>(context)->uc_mcontext.gregs[REG_RIP]) : 0;
+#elif defined(__linux__) && defined(__aarch64__)
+	return context ? static_cast<uintptr_t>(static_cast<ucontext_t*>(context)->uc_mcontext.pc) : 0;
+#else
+	(void)context;
+	return 0;
+#endif
+}
 
-				write(STDERR_FD, "{\"frame\":1,\"address\":\"", strlen("{\"frame\":1,\"address\":\""));
+// Capture the crashed stack into `_frames` as configured for the signal. Frames of the
+// handler itself and the signal trampoline are dropped, the crash PC comes first.
+static inline size_t _captureCrashStack(uint32_t signalId, void *context, bool unwindAll) {
+	CaptureOptions options = _getCaptureOptions(signalId);
+	size_t wanted = options.maxFrames + options.skipFrames + HANDLER_FRAMES;
+	if (wanted > MAX_CAPTURE_FRAMES + HANDLER_FRAMES) {
+		wanted = MAX_CAPTURE_FRAMES + HANDLER_FRAMES;
+	}
+	size_t count = _captureStack(_frames, wanted, context, unwindAll);
+
+	size_t first = 0;
+	uintptr_t pc = _getContextPc(context);
+	for (size_t i = 0; pc && i < count && i < HANDLER_FRAMES; i++) {
+		if (reinterpret_cast<uintptr_t>(_frames[i]) == pc) {
+			first = i;
+			break;
+		}
+	}
+	first += options.skipFrames;
+	if (first >= count) {
+		return 0;
+	}
 
-				char addr_hex[32];
-				int hex_len = snprintf(addr_hex, sizeof(addr_hex), "0x%lx", (uintptr_t)caller_ip);
-				write(STDERR_FD, addr_hex, hex_len);
+	count -= first;
+	if (count > options.maxFrames) {
+		count = options.maxFrames;
+	}
+	if (first) {
+		memmove(_frames, _frames + first, count * sizeof(void*));
+	}
+	return count;
+}
 
-				write(STDERR_FD, "\",\"symbol\":\"", strlen("\",\"symbol\":\""));
 
-				const char* symbol_ptr = caller_dlinfo.dli_sname;
-				int symbol_len = 0;
-				while (*symbol_ptr && symbol_len < 100) {
-					if (*symbol_ptr == '"' || *symbol_ptr == '\\') {
-						write(STDERR_FD, "\\", 1);
-					}
-					write(STDERR_FD, symbol_ptr, 1);
-					symbol_ptr++;
-					symbol_len++;
-				}
+static inline FrameSymbol _lookupFrameSymbol(uintptr_t pc) {
+	FrameSymbol result = { pc, findModule(pc), nullptr, 0 };
+	if (!result.module) {
+		return result;
+	}
+#ifdef __linux__
+	// Full `.symtab` lookup in the table indexed at load time, static functions included
+	if (result.module->symbols) {
+		result.name = findSymbol(result.module->symbols, pc - result.module->base, &result.symbolAddress);
+		result.symbolAddress += result.module->base;
+	}
+#else
+	Dl_info info;
+	if (dladdr(reinterpret_cast<void*>(pc), &info) && info.dli_sname) {
+		result.name = info.dli_sname;
+		result.symbolAddress = reinterpret_cast<uintptr_t>(info.dli_saddr);
+	}
+#endif
+	return result;
+}
 
-				write(STDERR_FD, "\"}", strlen("\"}"));
-			}
+// Lookups for the crash report are kept in `_frameSymbols`, only the owner of the crash
+// writes there. Should it fill up, the rest is looked up every time.
+static inline FrameSymbol _findCrashFrameSymbol(uintptr_t pc) {
+	size_t slot = (pc >> 2) % FRAME_SYMBOL_SLOTS;
+	for (size_t probe = 0; probe < FRAME_SYMBOL_SLOTS; probe++) {
+		FrameSymbol &entry = _frameSymbols[(slot + probe) % FRAME_SYMBOL_SLOTS];
+		if (entry.pc == pc) {
+			return entry;
+		}
+		if (!entry.pc) {
+			uint64_t started = getMonotonicNs();
+			entry = _lookupFrameSymbol(pc);
+			_symbolizeNs += getMonotonicNs() - started;
+			return entry;
 		}
 	}
-	#elif defined(__x86_64__) || defined(_M_X64)
-	// x86_64-specific implementation: Use signal-safe approach with minimal libunwind
-	// Avoid complex libunwind API calls that cause recursive segfaults in signal handlers
+	uint64_t started = getMonotonicNs();
+	FrameSymbol result = _lookupFrameSymbol(pc);
+	_symbolizeNs += getMonotonicNs() - started;
+	return result;
+}
 
-	void* crash_ip = nullptr;
+// Same layout as `backtrace_symbols()`: "module(symbol+0x1f) [0x7f0012345678]"
+static inline void _writeFrameSymbol(Emitter &out, void *address, bool escape) {
+	// Stall reports are composed on another thread, and not cached
+	uintptr_t pc = reinterpret_cast<uintptr_t>(address);
+	FrameSymbol symbol = &out == &_report ? _findCrashFrameSymbol(pc) : _lookupFrameSymbol(pc);
+	const ModuleInfo *module = symbol.module;
+	if (!module) {
+		out.chr('[').hex(pc).chr(']');
+		return;
+	}
 
-	// Try to get the crash location from signal context
-	#if defined(__linux__)
-	if (context) {
-		ucontext_t* uctx = (ucontext_t*)context;
-		// On x86_64, RIP (instruction pointer) is in uc_mcontext.gregs[REG_RIP]
-		#ifdef REG_RIP
-		crash_ip = (void*)uctx->uc_mcontext.gregs[REG_RIP];
-		#endif
+	if (escape) {
+		out.json(module->path);
+	} else {
+		out.ref(module->path, strlen(module->path));
 	}
-	#endif
+	out.chr('(');
 
-	// Fallback: Skip dangerous assembly in signal handler on x86_64
-	// The frame pointer operations can cause secondary segfaults
-	if (!crash_ip) {
-		// Use a safe fallback address instead of risky frame pointer access
-		crash_ip = __builtin_return_address(0);
-	}
-
-	if (crash_ip) {
-		Dl_info dlinfo;
-		if (dladdr(crash_ip, &dlinfo)) {
-			wrote_any_frame = true;
-
-			write(STDERR_FD, "{\"frame\":0,\"address\":\"", strlen("{\"frame\":0,\"address\":\""));
-
-			char addr_hex[32];
-			int hex_len = snprintf(addr_hex, sizeof(addr_hex), "0x%lx", (uintptr_t)crash_ip);
-			write(STDERR_FD, addr_hex, hex_len);
-
-			write(STDERR_FD, "\",\"symbol\":\"", strlen("\",\"symbol\":\""));
-
-			if (dlinfo.dli_sname && dlinfo.dli_sname[0] != '\0') {
-				// Write function name
-				const char* symbol_ptr = dlinfo.dli_sname;
-				int symbol_len = 0;
-				while (*symbol_ptr && symbol_len < 100) {
-					if (*symbol_ptr == '"' || *symbol_ptr == '\\') {
-						write(STDERR_FD, "\\", 1);
-					}
-					write(STDERR_FD, symbol_ptr, 1);
-					symbol_ptr++;
-					symbol_len++;
-				}
+	const char *name = symbol.name;
+	uintptr_t symbolAddress = symbol.symbolAddress;
+	if (name && name[0] != '\0') {
+		if (escape) {
+			out.json(name);
+		} else {
+			out.ref(name, strlen(name));
+		}
+		if (symbolAddress <= pc) {
+			out.chr('+').hex(pc - symbolAddress);
+		} else {
+			out.chr('-').hex(symbolAddress - pc);
+		}
+	} else {
+		out.chr('+').hex(pc - module->base);
+	}
+	out.str(") [", 3).hex(pc).chr(']');
+}
+#endif
 
-				// Add offset if available
-				if (dlinfo.dli_saddr && (uintptr_t)dlinfo.dli_saddr <= (uintptr_t)crash_ip) {
-					uintptr_t offset = (uintptr_t)crash_ip - (uintptr_t)dlinfo.dli_saddr;
-					if (offset > 0 && offset < 0x100000) {
-						char offset_buffer[32];
-						int offset_len = snprintf(offset_buffer, sizeof(offset_buffer), " + %zu", offset);
-						write(STDERR_FD, offset_buffer, offset_len);
-					}
-				}
-			} else if (dlinfo.dli_fname && dlinfo.dli_fname[0] != '\0') {
-				// No function name, use module name
-				write(STDERR_FD, "<", 1);
-				const char* filename = strrchr(dlinfo.dli_fname, '/');
-				const char* basename = filename ? filename + 1 : dlinfo.dli_fname;
-
-				int name_len = 0;
-				while (*basename && name_len < 50) {
-					write(STDERR_FD, basename, 1);
-					basename++;
-					name_len++;
-				}
-				write(STDERR_FD, ">", 1);
-			} else {
-				write(STDERR_FD, "unknown", strlen("unknown"));
-			}
 
-			write(STDERR_FD, "\"}", strlen("\"}"));
+// Raw frame, no symbolization. JSON: `"address":..,"module":..,"base":..,"offset":..`,
+// text: "#3 0x7f0012345678 /path/to/module.so+0x1f00 (base 0x7f0012343000)"
+static inline void _writeRawFrame(Emitter &out, size_t index, void *address, bool json) {
+	uintptr_t pc = reinterpret_cast<uintptr_t>(address);
+	const ModuleInfo *module = findModule(pc);
+
+	if (json) {
+		out.str("{\"frame\":").dec(index).str(",\"address\":\"").hex(pc).chr('"');
+		if (module) {
+			out.str(",\"module\":\"").json(module->path);
+			out.str("\",\"base\":\"").hex(module->base);
+			out.str("\",\"offset\":\"").hex(pc - module->base).chr('"');
 		}
+		out.chr('}');
+		return;
 	}
-	#endif
 
-	// Fallback if no frames were obtained
-	if (!wrote_any_frame) {
-		#ifdef __aarch64__
-		const char* fallback = "{\"frame\":0,\"address\":\"0x0\",\"symbol\":\"<arm64_simple_fallback>\"}";
-		#elif defined(__x86_64__) || defined(_M_X64)
-		const char* fallback = "{\"frame\":0,\"address\":\"0x0\",\"symbol\":\"<x86_64_simple_fallback>\"}";
-		#else
-		const char* fallback = "{\"frame\":0,\"address\":\"0x0\",\"symbol\":\"<libunwind_fallback>\"}";
-		#endif
-		write(STDERR_FD, fallback, strlen(fallback));
+	out.chr('#').dec(index).chr(' ').hex(pc);
+	if (module) {
+		out.chr(' ').ref(module->path, strlen(module->path)).chr('+').hex(pc - module->base);
+		out.str(" (base ").hex(module->base).chr(')');
 	}
-#else
-	const char* no_stack = "{\"frame\":0,\"address\":\"0x0\",\"symbol\":\"<no_stack_trace_available>\"}";
-	write(STDERR_FD, no_stack, strlen(no_stack));
-#endif
-#endif
-
-	// Close JSON object
-	const char* json_end = "]}\n";
-	write(STDERR_FD, json_end, strlen(json_end));
+	out.chr('\n');
 }
 
-// Write stack trace to outfile and cerr
-static inline void _writeStackTrace(std::ofstream &outfile, uint32_t signalId) {
-#ifdef _WIN32
-	showCallstack(outfile);
-#else
-	outfile.close();
 
-#if HAVE_EXECINFO_H
-	void *array[32];
-	size_t size = backtrace(array, 32);
+#ifndef _WIN32
+// Elements of the JSON "stack" array
+static inline void _writeJsonFrames(Emitter &out, void *const *frames, size_t count) {
+	for (size_t i = 0; i < count; i++) {
+		if (i > 0) {
+			out.chr(',');
+		}
+		if (useRawAddresses) {
+			_writeRawFrame(out, i, frames[i], true);
+			continue;
+		}
+		out.str("{\"frame\":").dec(i);
+		out.str(",\"address\":\"").hex(reinterpret_cast<uintptr_t>(frames[i]));
+		out.str("\",\"symbol\":\"");
+		_writeFrameSymbol(out, frames[i], true);
+		out.str("\"}");
+	}
+}
+#endif
 
-	constexpr int STDERR_FD = 2;
-	backtrace_symbols_fd(array, size, STDERR_FD);
+#ifndef _WIN32
+// Stacks of the other threads, as collected by `dumpThreads()`. JSON: the fields after
+// "stack", starting with a comma.
+static inline void _writeThreadDump(Emitter &out, size_t threadCount, bool json) {
+	char name[THREAD_NAME_SIZE];
+	readThreadName(name);
+	if (json) {
+		out.str(",\"tid\":").sdec(getCurrentThreadId()).str(",\"thread_name\":\"").json(name);
+		out.str("\",\"threads\":[");
+	} else {
+		out.str("Crashed thread: ").sdec(getCurrentThreadId()).str(" (").str(name).str(")\n");
+	}
+
+	for (size_t i = 0; i < threadCount; i++) {
+		const DumpedThread *thread = getDumpedThread(i);
+		if (json) {
+			out.str(i ? ",{\"tid\":" : "{\"tid\":").sdec(thread->tid);
+			out.str(",\"name\":\"").json(thread->name).str("\",\"captured\":");
+			out.str(thread->isCaptured ? "true" : "false").str(",\"stack\":[");
+			_writeJsonFrames(out, thread->frames, thread->isCaptured ? thread->count : 0);
+			out.str("]}");
+			continue;
+		}
 
-	int fd = open("segfault.log", O_CREAT | O_APPEND | O_WRONLY, S_IRUSR | S_IRGRP | S_IROTH);
-	if (fd > 0) {
-		backtrace_symbols_fd(array, size, fd);
-		close(fd);
+		out.str("\nThread ").sdec(thread->tid).str(" (").str(thread->name).chr(')');
+		if (!thread->isCaptured) {
+			out.str(": no response\n");
+			continue;
+		}
+		out.str(":\n");
+		for (size_t j = 0; j < thread->count; j++) {
+			if (useRawAddresses) {
+				_writeRawFrame(out, j, thread->frames[j], false);
+				continue;
+			}
+			_writeFrameSymbol(out, thread->frames[j], false);
+			out.chr('\n');
+		}
 	}
-#elif HAVE_LIBUNWIND_H
-	// Use libunwind for stack unwinding (better for Alpine/musl) with platform-specific safety
-	constexpr int STDERR_FD = 2;
-	const char* header = "Stack trace (libunwind):\n";
-	write(STDERR_FD, header, strlen(header));
 
-	int fd = open("segfault.log", O_CREAT | O_APPEND | O_WRONLY, S_IRUSR | S_IRGRP | S_IROTH);
-	if (fd > 0) {
-		write(fd, header, strlen(header));
+	if (json) {
+		out.chr(']');
 	}
+}
 
-	#if defined(__x86_64__) && !defined(__aarch64__)
-	// On x86_64, avoid full libunwind API in signal handlers due to async-signal-safety issues
-	// Use simplified approach similar to backtrace
-	const char* safety_msg = " 0: <x86_64_signal_safe_fallback> (libunwind disabled in signal handler)\n";
-	write(STDERR_FD, safety_msg, strlen(safety_msg));
-	if (fd > 0) {
-		write(fd, safety_msg, strlen(safety_msg));
+// Crashes of other threads while the report was written, as collected by
+// `collectSecondaryCrashes()`. JSON: a field after "stack", starting with a comma.
+static inline void _writeSecondaryCrashes(Emitter &out, size_t secondaryCount, bool json) {
+	if (json) {
+		out.str(",\"concurrent\":[");
 	}
-	#else
-	// On ARM64 and other platforms, attempt to use libunwind with error checking
-	unw_cursor_t cursor;
-	unw_context_t context;
-	unw_word_t ip, sp, off;
-	char symbol[256];
-	int frame = 0;
-
-	// Initialize libunwind with error checking
-	int getcontext_ret = unw_getcontext(&context);
-	if (getcontext_ret != 0) {
-		const char* error_msg = "Error: Failed to get libunwind context\n";
-		write(STDERR_FD, error_msg, strlen(error_msg));
-		if (fd > 0) {
-			write(fd, error_msg, strlen(error_msg));
+
+	for (size_t i = 0; i < secondaryCount; i++) {
+		const SecondaryCrash *crash = getSecondaryCrash(i);
+		if (json) {
+			out.str(i ? ",{\"tid\":" : "{\"tid\":").sdec(crash->tid);
+			out.str(",\"thread_name\":\"").json(crash->name).str("\",\"signal\":").dec(crash->signal);
+			out.str(",\"signal_name\":\"");
+			_writeSignalName(out, crash->signal);
+			out.str("\",\"address\":\"").hex(crash->address).str("\",\"stack\":[");
+			_writeJsonFrames(out, crash->frames, crash->count);
+			out.str("]}");
+			continue;
 		}
-	} else {
-		int init_ret = unw_init_local(&cursor, &context);
-		if (init_ret != 0) {
-			const char* error_msg = "Error: Failed to initialize libunwind cursor\n";
-			write(STDERR_FD, error_msg, strlen(error_msg));
-			if (fd > 0) {
-				write(fd, error_msg, strlen(error_msg));
-			}
-		} else {
-			// Successfully initialized - unwind the stack
-			int step_ret;
-			bool frames_written = false;
-
-			while ((step_ret = unw_step(&cursor)) > 0 && frame < 32) {
-				frames_written = true;
-
-				// Get registers with error handling
-				ip = 0;
-				sp = 0;
-				int ip_ret = unw_get_reg(&cursor, UNW_REG_IP, &ip);
-				unw_get_reg(&cursor, UNW_REG_SP, &sp);
-
-				symbol[0] = '\0';
-				int symbol_ret = unw_get_proc_name(&cursor, symbol, sizeof(symbol), &off);
-
-				if (symbol_ret == 0 && symbol[0] != '\0') {
-					char buffer[512];
-					int len = snprintf(buffer, sizeof(buffer), "%2d: 0x%lx <%s+0x%lx>\n",
-						frame, ip, symbol, off);
-					write(STDERR_FD, buffer, len);
-					if (fd > 0) {
-						write(fd, buffer, len);
-					}
-				} else {
-					char buffer[256];
-					int len;
-					if (ip_ret == 0) {
-						len = snprintf(buffer, sizeof(buffer), "%2d: 0x%lx <unknown>\n", frame, ip);
-					} else {
-						len = snprintf(buffer, sizeof(buffer), "%2d: <no_address> <unknown>\n", frame);
-					}
-					write(STDERR_FD, buffer, len);
-					if (fd > 0) {
-						write(fd, buffer, len);
-					}
-				}
-				frame++;
-			}
 
-			// Check if we failed to get any frames or if step failed
-			if (!frames_written) {
-				const char* no_frames_msg = "Warning: No stack frames could be unwound\n";
-				write(STDERR_FD, no_frames_msg, strlen(no_frames_msg));
-				if (fd > 0) {
-					write(fd, no_frames_msg, strlen(no_frames_msg));
-				}
-			} else if (step_ret < 0) {
-				const char* step_error_msg = "Warning: Stack unwinding terminated due to error\n";
-				write(STDERR_FD, step_error_msg, strlen(step_error_msg));
-				if (fd > 0) {
-					write(fd, step_error_msg, strlen(step_error_msg));
-				}
+		out.str("\nThread ").sdec(crash->tid).str(" (").str(crash->name).str(") also received ");
+		_writeSignalName(out, crash->signal);
+		out.str(" for address: ").hex(crash->address).chr('\n');
+		for (size_t j = 0; j < crash->count; j++) {
+			if (useRawAddresses) {
+				_writeRawFrame(out, j, crash->frames[j], false);
+				continue;
 			}
+			_writeFrameSymbol(out, crash->frames[j], false);
+			out.chr('\n');
 		}
 	}
-	#endif  // End of ARM64 libunwind section
 
-	if (fd > 0) {
-		close(fd);
+	if (json) {
+		out.chr(']');
 	}
-#else
-	// Neither execinfo nor libunwind available
-	constexpr int STDERR_FD = 2;
-	const char* msg = "Stack trace not available (no unwinding library found)\n";
-	write(STDERR_FD, msg, strlen(msg));
+}
+#endif
+
+// Rendered ahead of time, see `renderPrologue()`. It stays valid while a crash is reported.
+static inline void _writePrologue(Emitter &out, ProloguePart part) {
+	size_t size = 0;
+	const char *prologue = getReportPrologue(part, &size);
+	out.ref(prologue, size);
+}
+
+// Compose the JSON report for stderr, from the `count` frames captured into `_frames`,
+// `threadCount` other threads if they were dumped, and `secondaryCount` concurrent crashes.
+// The object is left open, for the phases.
+static inline void _writeJsonStackTrace(
+	Emitter &out, uint32_t signalId, uint64_t address, size_t count, size_t threadCount, size_t secondaryCount
+) {
+	out.str("{\"time\":\"").isoTime(time(nullptr));
+	out.str("\",\"level\":\"ERROR\",\"type\":\"segfault\",\"signal\":").dec(signalId);
+	out.str(",\"signal_name\":\"");
+	_writeSignalName(out, signalId);
+	out.str("\",\"message\":\"");
+	_writePrologue(out, PROLOGUE_JSON_MESSAGE);
+	_writeSignalName(out, signalId);
+	out.str(" signal\",\"address\":\"").hex(address).chr('"');
+	_writePrologue(out, PROLOGUE_JSON_PID);
+	_writePrologue(out, PROLOGUE_JSON);
+	if (_crashSeen) {
+		out.str(",\"signature\":\"").hex(_crashSignature).str("\",\"seen\":").dec(_crashSeen);
+	}
+	if (_dumpName[0]) {
+		out.str(",\"dump\":\"").json(dumpPath.c_str()).chr('/').json(_dumpName).chr('"');
+	}
+	out.str(",\"stack\":[");
 
-	int fd = open("segfault.log", O_CREAT | O_APPEND | O_WRONLY, S_IRUSR | S_IRGRP | S_IROTH);
-	if (fd > 0) {
-		write(fd, msg, strlen(msg));
-		close(fd);
+#ifdef _WIN32
+	// TODO: Implement Windows JSON stack trace
+	(void)count;
+	out.str("{\"frame\":0,\"address\":\"0x0\",\"symbol\":\"<windows_stack_not_implemented>\"}");
+#else
+	_writeJsonFrames(out, _frames, count);
+
+	if (!count) {
+	#if HAVE_LIBUNWIND_H && defined(__aarch64__)
+		out.str("{\"frame\":0,\"address\":\"0x0\",\"symbol\":\"<arm64_simple_fallback>\"}");
+	#elif HAVE_LIBUNWIND_H && (defined(__x86_64__) || defined(_M_X64))
+		out.str("{\"frame\":0,\"address\":\"0x0\",\"symbol\":\"<x86_64_simple_fallback>\"}");
+	#elif HAVE_LIBUNWIND_H
+		out.str("{\"frame\":0,\"address\":\"0x0\",\"symbol\":\"<libunwind_fallback>\"}");
+	#else
+		out.str("{\"frame\":0,\"address\":\"0x0\",\"symbol\":\"<no_stack_trace_available>\"}");
+	#endif
 	}
 #endif
+
+	out.chr(']');
+#ifdef _WIN32
+	(void)threadCount;
+	(void)secondaryCount;
+#else
+	if (threadCount) {
+		_writeThreadDump(out, threadCount, true);
+	}
+	if (secondaryCount) {
+		_writeSecondaryCrashes(out, secondaryCount, true);
+	}
 #endif
 }
 
 
+#ifdef _WIN32
 static inline std::ofstream _openLogFile() {
 	std::ofstream outfile;
-	
+
 	if (!std::filesystem::exists("segfault.log")) {
 		std::cerr
 			<< "SegfaultHandler: The exception won't be logged into a file"
 			<< ", unless 'segfault.log' exists." << std::endl;
 		return outfile;
 	}
-	
+
 	outfile.open("segfault.log", std::ofstream::app);
-	
+
 	return outfile;
 }
 
@@ -765,87 +891,631 @@ static inline void _writeTimeToFile(std::ofstream &outfile) {
 	if (!outfile.is_open()) {
 		return;
 	}
-	
+
 	time(&timeInfo);
-	
+
 	outfile << "\n\nAt " << ctime(&timeInfo) << std::endl; // NOLINT
 	if (outfile.bad()) {
 		std::cerr << "SegfaultHandler: Error writing to file." << std::endl;
 	}
 }
 
-static inline void _writeHeaderToOstream(std::ostream &stream, int pid, uint32_t signalId, uint64_t address) {
-	std::string signalName;
-	if (signalNames.count(signalId)) {
-		signalName = signalNames.at(signalId);
-	} else {
-		signalName = std::to_string(signalId);
+static inline void _writeLogHeader(std::ofstream &outfile, uint32_t signalId, uint64_t address) {
+	size_t messageSize = 0;
+	const char *message = getReportPrologue(PROLOGUE_TEXT_MESSAGE, &messageSize);
+	_report.str(message, messageSize);
+	_writeSignalName(_report, signalId);
+	_report.str(" for address: ").hex(address).chr('\n');
+
+	if (outfile.is_open()) {
+		// The header is short and fully copied, so it sits contiguously at the buffer start
+		outfile.write(_reportBuffer, _report.getSize());
+		if (outfile.bad()) {
+			std::cerr << "SegfaultHandler: Error writing to file." << std::endl;
+		}
 	}
-	stream
-		<< "\nPID " << pid << " received " << signalName
-		<< " for address: 0x" << std::hex << address << std::endl;
+
+	_report.flush();
 }
 
+static inline void _writeTextStackTrace(uint32_t signalId, uint64_t address, size_t, size_t, size_t) {
+	std::ofstream outfile = _openLogFile();
 
-static inline void _writeLogHeader(std::ofstream &outfile, uint32_t signalId, uint64_t address) {
-	int pid = GETPID();
-	_writeHeaderToOstream(std::cerr, pid, signalId, address);
-	
-	if (!outfile.is_open()) {
-		return;
-	}
-	
-	_writeHeaderToOstream(outfile, pid, signalId, address);
-	if (outfile.bad()) {
-		std::cerr << "SegfaultHandler: Error writing to file." << std::endl;
-	}
-}
+	_writeTimeToFile(outfile);
+	_writeLogHeader(outfile, signalId, address);
+	showCallstack(outfile);
 
-static inline void _closeLogFile(std::ofstream &outfile) {
 	if (outfile.is_open()) {
 		outfile.close();
 	}
 }
-
-
-DBG_EXPORT SEGFAULT_HANDLER {
-	// Prevent recursive signal handling
-	if (in_signal_handler) {
-		// Already in signal handler - avoid infinite recursion
-		HANDLER_DONE;
-	}
-	in_signal_handler = 1;
-
-	auto signalAndAdress = _getSignalAndAddress(info);
-	uint32_t signalId = signalAndAdress.first;
-	uint64_t address = signalAndAdress.second;
-
-	if (!_isSignalEnabled(signalId)) {
-		in_signal_handler = 0;
-		HANDLER_CANCEL;
+#else
+static inline const CrashSink *_getCrashSinks(size_t *count) {
+	if (hasCrashSinks) {
+		*count = crashSinkCount;
+		return crashSinks;
 	}
-
 	if (useJsonOutput) {
-		// Write JSON stack trace to stderr
-		#ifdef _WIN32
-		_writeJsonStackTrace(signalId, address);
-		#else
-		_writeJsonStackTrace(signalId, address, unused);
-		#endif
-	} else {
-		// Write traditional output
-		std::ofstream outfile = _openLogFile();
+		*count = sizeof(DEFAULT_JSON_SINKS) / sizeof(DEFAULT_JSON_SINKS[0]);
+		return DEFAULT_JSON_SINKS;
+	}
+	*count = sizeof(DEFAULT_TEXT_SINKS) / sizeof(DEFAULT_TEXT_SINKS[0]);
+	return DEFAULT_TEXT_SINKS;
+}
 
-		_writeTimeToFile(outfile);
-		_writeLogHeader(outfile, signalId, address);
-		_writeStackTrace(outfile, signalId);
+static void _mirrorReport(const char *data, size_t size) {
+	if (_isJournalMirrored) {
+		appendJournal(data, size);
+	}
+	if (_socketMirrorFormat >= 0) {
+		size_t &used = _socketReportSizes[_socketMirrorFormat];
+		size_t copied = size < SOCKET_REPORT_SIZE - used ? size : SOCKET_REPORT_SIZE - used;
+		memcpy(_socketReports[_socketMirrorFormat] + used, data, copied);
+		used += copied;
+	}
+}
 
-		_closeLogFile(outfile);
+// Point `_report` at the sinks of `format`, or only the files and the journal, which get
+// timestamps. Returns false if there is nowhere to write.
+static inline bool _selectSinks(int format, bool isFileOnly) {
+	size_t count = 0;
+	const CrashSink *sinks = _getCrashSinks(&count);
+	_isJournalMirrored = false;
+	_socketMirrorFormat = -1;
+	_report.clearFds();
+	for (size_t i = 0; i < count; i++) {
+		if (sinks[i].format != format) {
+			continue;
+		}
+		switch (sinks[i].type) {
+			case SINK_STDERR: _report.addFd(isFileOnly ? -1 : STDERR_FD); break;
+			case SINK_FILE: _report.addFd(sinks[i].fd >= 0 ? sinks[i].fd : logFd); break;
+			case SINK_JOURNAL: _isJournalMirrored = _isJournalMirrored || isJournalOpen(); break;
+			case SINK_SOCKET: _socketMirrorFormat = isFileOnly ? -1 : format; break;
+			case SINK_DIRECTORY: _report.addFd(_crashFiles[i].fd); break;
+			default: break;
+		}
 	}
+	bool hasMirror = _isJournalMirrored || _socketMirrorFormat >= 0;
+	_report.setMirror(hasMirror ? _mirrorReport : nullptr);
+	return _report.getFdCount() || hasMirror;
+}
 
-	// Don't reset the flag - let the process terminate to avoid any chance of recursion
-	// in_signal_handler = 0;  // Keep the flag set to prevent any future signal handling
-	HANDLER_DONE;
+// Send what was composed in `format` to its socket sinks, in one message each
+static inline void _sendSocketReports(int format) {
+	for (size_t i = 0; hasCrashSinks && i < crashSinkCount; i++) {
+		if (crashSinks[i].type == SINK_SOCKET && crashSinks[i].format == format) {
+			sendCrashSocket(&crashSinks[i].socket, _socketReports[format], _socketReportSizes[format]);
+		}
+	}
+	_socketReportSizes[format] = 0;
+}
+
+// Directory sinks write to new files, named once the reports are complete
+static inline void _openCrashFiles() {
+	_crashFileTime = time(nullptr);
+	for (size_t i = 0; hasCrashSinks && i < crashSinkCount; i++) {
+		_crashFiles[i].fd = -1;
+		if (crashSinks[i].type == SINK_DIRECTORY) {
+			openCrashFile(crashSinks[i].fd, &_crashFiles[i]);
+		}
+	}
+}
+
+static inline void _commitCrashFiles() {
+	for (size_t i = 0; hasCrashSinks && i < crashSinkCount; i++) {
+		if (crashSinks[i].type == SINK_DIRECTORY) {
+			const char *extension = crashSinks[i].format == FORMAT_SUMMARY ? ".summary.json" :
+				crashSinks[i].format == FORMAT_JSON ? ".json" : ".log";
+			commitCrashFile(
+				&_crashFiles[i], "crash-", static_cast<uint64_t>(GETPID()),
+				static_cast<uint64_t>(_crashFileTime), extension, nullptr, 0
+			);
+		}
+	}
+}
+
+static inline bool _hasSinks(int format) {
+	size_t count = 0;
+	const CrashSink *sinks = _getCrashSinks(&count);
+	for (size_t i = 0; i < count; i++) {
+		if (sinks[i].format == format) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static inline bool _hasSink(int type, int format) {
+	size_t count = 0;
+	const CrashSink *sinks = _getCrashSinks(&count);
+	for (size_t i = 0; i < count; i++) {
+		if (sinks[i].type == type && sinks[i].format == format) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// A text sink wants "segfault.log", but there was none at init
+static inline bool _isLogFileMissing() {
+	size_t count = 0;
+	const CrashSink *sinks = _getCrashSinks(&count);
+	for (size_t i = 0; i < count; i++) {
+		if (sinks[i].type == SINK_FILE && sinks[i].format == FORMAT_TEXT && sinks[i].fd < 0) {
+			return logFd < 0;
+		}
+	}
+	return false;
+}
+
+static inline void _resetSinks() {
+	_report.clearFds();
+	_report.addFd(STDERR_FD);
+	_isJournalMirrored = true;
+	_socketMirrorFormat = -1;
+	_report.setMirror(_mirrorReport);
+}
+
+// Compose the plain text report for the text sinks, from the frames in `_frames`,
+// `threadCount` other threads if they were dumped, and `secondaryCount` concurrent crashes.
+// The report is left unflushed, with its sinks selected, for the phase line.
+static inline void _writeTextStackTrace(
+	uint32_t signalId, uint64_t address, size_t count, size_t threadCount, size_t secondaryCount
+) {
+	// Only into text, other formats on stderr are finished by now
+	if (_isLogFileMissing() && _hasSink(SINK_STDERR, FORMAT_TEXT)) {
+		_report.str(
+			"SegfaultHandler: The exception won't be logged into a file, unless 'segfault.log' exists.\n"
+		);
+		_report.flushTo(STDERR_FD);
+	}
+	// The timestamp only goes to the files and the journal, all sinks get the report
+	if (_selectSinks(FORMAT_TEXT, true)) {
+		_report.str("\n\nAt ").ctimeStr(time(nullptr), gmtOffset).str("\n\n");
+		_report.flush();
+	}
+	_selectSinks(FORMAT_TEXT, false);
+
+	_writePrologue(_report, PROLOGUE_TEXT_MESSAGE);
+	_writeSignalName(_report, signalId);
+	_report.str(" for address: ").hex(address).chr('\n');
+	_writePrologue(_report, PROLOGUE_TEXT);
+	if (_crashSeen) {
+		_report.str("Signature ").hex(_crashSignature).str(", seen ").dec(_crashSeen);
+		_report.str(" times in ").dec(dedupWindow).str(" s\n");
+	}
+	if (_dumpName[0]) {
+		_report.str("Crash dump: ").str(dumpPath.c_str()).chr('/').str(_dumpName).chr('\n');
+	}
+
+	if (useRawAddresses) {
+		_report.str("Stack trace (raw addresses):\n");
+		for (size_t i = 0; i < count; i++) {
+			_writeRawFrame(_report, i, _frames[i], false);
+		}
+		if (threadCount) {
+			_writeThreadDump(_report, threadCount, false);
+		}
+		if (secondaryCount) {
+			_writeSecondaryCrashes(_report, secondaryCount, false);
+		}
+		return;
+	}
+
+#if HAVE_EXECINFO_H
+	for (size_t i = 0; i < count; i++) {
+		_writeFrameSymbol(_report, _frames[i], false);
+		_report.chr('\n');
+	}
+#elif HAVE_LIBUNWIND_H
+	_report.str("Stack trace (libunwind):\n");
+
+	for (size_t i = 0; i < count; i++) {
+		_report.padDec(i, 2).str(": ");
+		_writeFrameSymbol(_report, _frames[i], false);
+		_report.chr('\n');
+	}
+	if (!count) {
+	#if defined(__x86_64__) && !defined(__aarch64__)
+		// On x86_64, avoid full libunwind API in signal handlers due to async-signal-safety issues
+		_report.str(" 0: <x86_64_signal_safe_fallback> (libunwind disabled in signal handler)\n");
+	#else
+		_report.str("Warning: No stack frames could be unwound\n");
+	#endif
+	}
+#else
+	(void)count;
+	_report.str("Stack trace not available (no unwinding library found)\n");
+#endif
+
+	if (threadCount) {
+		_writeThreadDump(_report, threadCount, false);
+	}
+	if (secondaryCount) {
+		_writeSecondaryCrashes(_report, secondaryCount, false);
+	}
+}
+
+#ifndef _WIN32
+// Split the time since `started` into phases, the crash record having taken `recordNs` to write.
+// Composing includes lookups and writes, the rest is formatting.
+static inline void _measurePhases(uint64_t started, uint64_t recordNs) {
+	uint64_t composed = getMonotonicNs() - started;
+	uint64_t flushedNs = _report.getWriteNs();
+	_phaseNs[PHASE_SYMBOLIZE] = _symbolizeNs;
+	_phaseNs[PHASE_WRITE] = recordNs + flushedNs;
+	_phaseNs[PHASE_FORMAT] = composed - _symbolizeNs - flushedNs;
+}
+
+// Close the report with the time each phase took so far, and write it out in one flush.
+// That last flush is not counted. JSON: the closing field of the report.
+static inline void _writePhases(bool json, uint64_t started, uint64_t recordNs) {
+	_measurePhases(started, recordNs);
+	if (json) {
+		_report.str(",\"phases_us\":{");
+		for (size_t i = 0; i < PHASE_COUNT; i++) {
+			_report.str(i ? ",\"" : "\"").str(getPhaseName(static_cast<HandlerPhase>(i)));
+			_report.str("\":").dec(_phaseNs[i] / 1000);
+		}
+		_report.str("}}\n");
+		_report.flush();
+		return;
+	}
+
+	_report.str("Handler phases:");
+	for (size_t i = 0; i < PHASE_COUNT; i++) {
+		_report.str(i ? ", " : " ").str(getPhaseName(static_cast<HandlerPhase>(i)));
+		_report.chr(' ').dec(_phaseNs[i] / 1000).str(" us");
+	}
+	_report.chr('\n');
+	_report.flush();
+}
+
+// A summary frame: "module(symbol+0x1f) [0x7f0012345678]", the module without its directory
+static inline void _writeSummaryFrame(Emitter &out, void *address) {
+	uintptr_t pc = reinterpret_cast<uintptr_t>(address);
+	FrameSymbol symbol = _findCrashFrameSymbol(pc);
+	const ModuleInfo *module = symbol.module;
+	out.chr('"');
+	if (module) {
+		const char *slash = strrchr(module->path, '/');
+		out.json(slash ? slash + 1 : module->path, SUMMARY_NAME_SIZE).chr('(');
+		if (symbol.name && symbol.name[0] != '\0' && symbol.symbolAddress <= pc) {
+			out.json(symbol.name, SUMMARY_NAME_SIZE).chr('+').hex(pc - symbol.symbolAddress);
+		} else {
+			out.chr('+').hex(pc - module->base);
+		}
+		out.str(") ", 2);
+	}
+	out.chr('[').hex(pc).str("]\"", 2);
+}
+
+// Move `_summaryPart` into the summary, if `reserve` bytes of the budget are left after it
+static inline bool _appendSummaryPart(size_t reserve) {
+	size_t size = _summaryPart.getSize();
+	bool fits = size <= SUMMARY_PART_SIZE && _summary.getSize() + size + reserve <= SUMMARY_SIZE;
+	if (fits) {
+		_summary.str(_summaryPartBuffer, size);
+	}
+	_summaryPart.discard();
+	return fits;
+}
+
+// Compose the summary for the summary sinks: signal, address, signature and the top
+// frames of `_frames`, in one line flushed with a single `write()` per sink. Frames that
+// don't fit the budget are left out, "frames" tells how many there were.
+static inline void _writeSummary(uint32_t signalId, uint64_t address, size_t count) {
+	_summary.str("{\"time\":\"").isoTime(time(nullptr));
+	_summary.str("\",\"level\":\"ERROR\",\"type\":\"segfault_summary\",\"signal\":").dec(signalId);
+	_summary.str(",\"signal_name\":\"");
+	_writeSignalName(_summary, signalId);
+	_summary.str("\",\"address\":\"").hex(address);
+	_summary.str("\",\"pid\":").sdec(GETPID()).str(",\"tid\":").sdec(getCurrentThreadId());
+	_summary.str(",\"signature\":\"").hex(computeCrashSignature(signalId, _frames, count));
+	_summary.str("\",\"frames\":").dec(count);
+	if (_dumpName[0]) {
+		_summaryPart.str(",\"dump\":\"").json(dumpPath.c_str()).chr('/').json(_dumpName).chr('"');
+		_appendSummaryPart(sizeof(",\"stack\":[]}\n") - 1);
+	}
+	_summary.str(",\"stack\":[");
+	for (size_t i = 0; i < count && i < SUMMARY_FRAMES; i++) {
+		if (i) {
+			_summaryPart.chr(',');
+		}
+		_writeSummaryFrame(_summaryPart, _frames[i]);
+		if (!_appendSummaryPart(sizeof("]}\n") - 1)) {
+			break;
+		}
+	}
+	_summary.str("]}\n");
+
+	// The selected sinks may only get it in one piece
+	_report.str(_summaryBuffer, _summary.getSize());
+	_report.flush();
+	_summary.discard();
+}
+#endif
+
+// The one-line record of a crash seen too often, instead of the full report
+static inline void _writeRepeatedCrash(uint32_t signalId, bool json) {
+	if (json) {
+		_report.str("{\"time\":\"").isoTime(time(nullptr));
+		_report.str("\",\"level\":\"ERROR\",\"type\":\"segfault_repeat\",\"signal\":").dec(signalId);
+		_report.str(",\"signal_name\":\"");
+		_writeSignalName(_report, signalId);
+		_report.str("\",\"message\":\"");
+		_writePrologue(_report, PROLOGUE_JSON_MESSAGE);
+		_writeSignalName(_report, signalId);
+		_report.str(" signal again\"");
+		_writePrologue(_report, PROLOGUE_JSON_PID);
+		_report.str(",\"signature\":\"").hex(_crashSignature).str("\",\"seen\":").dec(_crashSeen);
+		_report.str(",\"window_s\":").dec(dedupWindow).str("}\n");
+		_report.flush();
+		return;
+	}
+
+	_writePrologue(_report, PROLOGUE_TEXT_MESSAGE);
+	_writeSignalName(_report, signalId);
+	_report.str(" again, signature ").hex(_crashSignature).str(" seen ").dec(_crashSeen);
+	_report.str(" times in ").dec(dedupWindow).str(" s\n");
+	_report.flush();
+}
+
+static inline CrashRecordInfo _getCrashInfo(uint32_t signalId, uint64_t address) {
+	CrashRecordInfo info;
+	info.signal = signalId;
+	info.pid = GETPID();
+	info.tid = getCurrentThreadId();
+	info.time = time(nullptr);
+	info.address = address;
+	return info;
+}
+
+// Append the binary record of this crash, in a single `write()`
+static inline void _writeCrashRecord(uint32_t signalId, uint64_t address, void *context, size_t count) {
+	CrashRecordInfo info = _getCrashInfo(signalId, address);
+	size_t size = encodeCrashRecord(_recordBuffer, RECORD_BUFFER_SIZE, info, context, _frames, count);
+	if (size) {
+		ssize_t written = write(recordFd, _recordBuffer, size);
+		(void)written;
+	}
+}
+
+#ifdef __linux__
+// Point `out` at the stderr, file and journal sinks of `format`, or only the files and the
+// journal. Socket and directory sinks only take crash reports. False if there are none.
+static inline bool _selectStallSinks(Emitter &out, int format, bool isFileOnly) {
+	size_t count = 0;
+	const CrashSink *sinks = _getCrashSinks(&count);
+	bool isJournaled = false;
+	out.clearFds();
+	for (size_t i = 0; i < count; i++) {
+		if (sinks[i].format != format) {
+			continue;
+		}
+		switch (sinks[i].type) {
+			case SINK_STDERR: out.addFd(isFileOnly ? -1 : STDERR_FD); break;
+			case SINK_FILE: out.addFd(sinks[i].fd >= 0 ? sinks[i].fd : logFd); break;
+			case SINK_JOURNAL: isJournaled = isJournaled || isJournalOpen(); break;
+			default: break;
+		}
+	}
+	out.setMirror(isJournaled ? appendJournal : nullptr);
+	return out.getFdCount() || isJournaled;
+}
+
+// Called on the watchdog thread while the loop thread is stalled. This is normal context,
+// but the report goes to the stderr, file and journal sinks of crash reports, per format.
+static void _reportStall(int tid, uint64_t stalledNs, void *const *frames, size_t count) {
+	// A crash report is being written, and the process is going down
+	if (isCrashInProgress()) {
+		return;
+	}
+
+	Emitter &out = _stallReport;
+	int pid = GETPID();
+	uint64_t stalledMs = stalledNs / 1000000;
+
+	if (_selectStallSinks(out, FORMAT_JSON, false)) {
+		out.str("{\"time\":\"").isoTime(time(nullptr));
+		out.str("\",\"level\":\"WARN\",\"type\":\"stall\",\"message\":\"Event loop of process ").sdec(pid);
+		out.str(" blocked for ").dec(stalledMs).str(" ms\",\"duration_ms\":").dec(stalledMs);
+		out.str(",\"pid\":").sdec(pid).str(",\"tid\":").sdec(tid);
+		out.str(",\"stack\":[");
+		_writeJsonFrames(out, frames, count);
+		out.str("]}\n");
+		out.flush();
+	}
+
+	if (_selectStallSinks(out, FORMAT_TEXT, true)) {
+		out.str("\n\nAt ").ctimeStr(time(nullptr), gmtOffset).str("\n\n");
+		out.flush();
+	}
+	if (!_selectStallSinks(out, FORMAT_TEXT, false)) {
+		return;
+	}
+	out.str("\nPID ").sdec(pid).str(" event loop blocked for ").dec(stalledMs);
+	out.str(" ms, thread ").sdec(tid).str(" is at:\n");
+	for (size_t i = 0; i < count; i++) {
+		if (useRawAddresses) {
+			_writeRawFrame(out, i, frames[i], false);
+			continue;
+		}
+		_writeFrameSymbol(out, frames[i], false);
+		out.chr('\n');
+	}
+	if (!count) {
+		out.str("Stack trace not available\n");
+	}
+	out.flush();
+}
+#endif
+#endif
+
+
+// The next fault of this thread takes the default action: the handler returns, and a
+// synchronous signal is raised again by the faulting instruction
+static inline void _restoreDefaultAction(uint32_t signalId) {
+	#ifdef _WIN32
+		(void)signalId;
+	#else
+		signal(signalId, SIG_DFL);
+	#endif
+}
+
+DBG_EXPORT SEGFAULT_HANDLER {
+	auto signalAndAdress = _getSignalAndAddress(info);
+	uint32_t signalId = signalAndAdress.first;
+	uint64_t address = signalAndAdress.second;
+
+	if (!_isSignalEnabled(signalId)) {
+		HANDLER_CANCEL;
+	}
+	countSignal(signalId);
+
+	// The first crashing thread owns the report. Threads crashing meanwhile are appended
+	// to it, and wait for it to complete before they go down.
+	CrashRole role = enterCrash();
+	if (role == CRASH_RECURSIVE) {
+		_restoreDefaultAction(signalId);
+		HANDLER_DONE;
+	}
+	if (role == CRASH_SECONDARY) {
+		#ifdef _WIN32
+		bool isRecorded = recordSecondaryCrash(signalId, address, nullptr, 0, unwindMethod);
+		#else
+		bool isRecorded = recordSecondaryCrash(
+			signalId, address, context, _getCaptureOptions(signalId).maxFrames, unwindMethod
+		);
+		#endif
+		if (!isRecorded) {
+			countDroppedReport();
+		}
+		_restoreDefaultAction(signalId);
+		HANDLER_DONE;
+	}
+
+	// Samples and stall captures on other threads share the unwinder, let them finish
+	// and take no more. If it is still busy, or held by this thread, go ahead regardless.
+	pauseProfiler();
+	bool hasUnwinder = lockUnwinder(CRASH_UNWINDER_SPINS);
+
+	// The stack is walked once, every output is composed from `_frames`
+	bool isRepeated = false;
+	#ifdef _WIN32
+	(void)hasUnwinder;
+	size_t count = 0;
+	size_t threadCount = 0;
+	#else
+	uint64_t started = getMonotonicNs();
+	size_t count = _captureCrashStack(signalId, context, _hasSinks(FORMAT_TEXT));
+	_phaseNs[PHASE_UNWIND] = getMonotonicNs() - started;
+	_phaseNs[PHASE_WRITE] = 0;
+	_report.resetCounters();
+	if (recordFd >= 0) {
+		started = getMonotonicNs();
+		_writeCrashRecord(signalId, address, context, count);
+		_phaseNs[PHASE_WRITE] = getMonotonicNs() - started;
+	}
+
+	// The table is shared with other processes, and across restarts
+	if (isCrashDedupOpen()) {
+		_crashSignature = computeCrashSignature(signalId, _frames, count);
+		_crashSeen = countCrashSignature(_crashSignature, dedupWindow);
+		isRepeated = _crashSeen > dedupLimit;
+	}
+
+	// Other threads, dumped or crashing, take turns on the unwinder in their own handlers
+	if (hasUnwinder) {
+		unlockUnwinder();
+	}
+	size_t threadCount = 0;
+	bool isDumping = !isRepeated && isCrashDumpOpen();
+	if (!isRepeated && threadDumpTimeout && isThreadDumpReady()) {
+		threadCount = dumpThreads(
+			threadDumpTimeout, _getCaptureOptions(signalId).maxFrames, unwindMethod, isDumping
+		);
+	}
+
+	// The dumped threads stay in their handlers until their stacks are copied
+	if (isDumping) {
+		started = getMonotonicNs();
+		if (!writeCrashDump(
+			_getCrashInfo(signalId, address), dumpOptions, context, _frames, count, threadCount,
+			_dumpName, sizeof(_dumpName)
+		)) {
+			_dumpName[0] = '\0';
+		}
+		_phaseNs[PHASE_WRITE] += getMonotonicNs() - started;
+		releaseThreads();
+	}
+	#endif
+	size_t secondaryCount = collectSecondaryCrashes(SECONDARY_CRASH_TIMEOUT_MS);
+
+	#ifdef _WIN32
+	(void)isRepeated;
+	if (useJsonOutput) {
+		_writeJsonStackTrace(_report, signalId, address, count, threadCount, secondaryCount);
+		_report.str("}\n");
+		_report.flush();
+	} else {
+		_writeTextStackTrace(signalId, address, count, threadCount, secondaryCount);
+	}
+	#else
+	// Each format is composed once, for all of its sinks. Symbols are looked up on first use.
+	_openCrashFiles();
+	if (isRepeated) {
+		// The one-line record is well within the summary budget
+		if (_selectSinks(FORMAT_SUMMARY, false)) {
+			_writeRepeatedCrash(signalId, true);
+			_sendSocketReports(FORMAT_SUMMARY);
+		}
+		if (_selectSinks(FORMAT_JSON, false)) {
+			_writeRepeatedCrash(signalId, true);
+			_sendSocketReports(FORMAT_JSON);
+		}
+		if (_selectSinks(FORMAT_TEXT, false)) {
+			_writeRepeatedCrash(signalId, false);
+			_sendSocketReports(FORMAT_TEXT);
+		}
+		countDroppedReport();
+	} else {
+		_symbolizeNs = 0;
+		uint64_t recordNs = _phaseNs[PHASE_WRITE];
+		started = getMonotonicNs();
+		// The summary goes first, in case the full reports take long
+		if (_selectSinks(FORMAT_SUMMARY, false)) {
+			_writeSummary(signalId, address, count);
+			_sendSocketReports(FORMAT_SUMMARY);
+		}
+		// Each report is finished, phases included, before the next format starts
+		if (_selectSinks(FORMAT_JSON, false)) {
+			_writeJsonStackTrace(_report, signalId, address, count, threadCount, secondaryCount);
+			_writePhases(true, started, recordNs);
+			_sendSocketReports(FORMAT_JSON);
+		}
+		if (_hasSinks(FORMAT_TEXT)) {
+			_writeTextStackTrace(signalId, address, count, threadCount, secondaryCount);
+			_writePhases(false, started, recordNs);
+			_sendSocketReports(FORMAT_TEXT);
+		}
+
+		// The stats also count the last flushes
+		_measurePhases(started, recordNs);
+		for (size_t i = 0; i < PHASE_COUNT; i++) {
+			recordPhase(static_cast<HandlerPhase>(i), _phaseNs[i]);
+		}
+		countReport(_report.getFlushedBytes());
+	}
+	_commitCrashFiles();
+	_resetSinks();
+	#endif
+
+	// Ownership is never released, later faults of any thread are not reported
+	finishCrash();
+	_restoreDefaultAction(signalId);
+	HANDLER_DONE;
 }
 
 
@@ -857,6 +1527,22 @@ DBG_EXPORT bool getJsonOutputMode() {
 	return useJsonOutput;
 }
 
+DBG_EXPORT void setRawAddressesMode(bool rawAddresses) {
+	useRawAddresses = rawAddresses;
+}
+
+DBG_EXPORT bool getRawAddressesMode() {
+	return useRawAddresses;
+}
+
+DBG_EXPORT void setUnwindMethod(int method) {
+	unwindMethod = static_cast<UnwindMethod>(method);
+}
+
+DBG_EXPORT int getUnwindMethod() {
+	return unwindMethod;
+}
+
 
 // create some stack frames to inspect from CauseSegfault
 DBG_EXPORT NO_INLINE void _segfaultStackFrame1() {
@@ -908,6 +1594,15 @@ DBG_EXPORT NO_INLINE void _overflowStack() {
 }
 
 DBG_EXPORT JS_METHOD(causeOverflow) { NAPI_ENV;
+	// On a thread the addon never ran on, like those of libuv or other addons. It waits a
+	// little, for its stack to be covered, e.g. by `captureStack()`.
+	if (!IS_ARG_EMPTY(0) && info[0].ToBoolean().Value()) {
+		std::thread([] {
+			std::this_thread::sleep_for(std::chrono::milliseconds(200));
+			_overflowStack();
+		}).detach();
+		RET_UNDEFINED;
+	}
 	std::cout << "SegfaultHandler: about to overflow the stack..." << std::endl;
 	_overflowStack();
 	RET_UNDEFINED;
@@ -932,10 +1627,12 @@ static inline void _enableSignal(uint32_t signalId) {
 		sigemptyset(&action.sa_mask);
 		action.sa_sigaction = handleSignal;
 
+		// No `SA_RESETHAND`: a thread that crashes while another one writes the report
+		// must reach the handler too. The handler restores the default action itself.
 		if (signalId == SIGSEGV) {
-			action.sa_flags = SA_SIGINFO | SA_ONSTACK | SA_RESETHAND;
+			action.sa_flags = SA_SIGINFO | SA_ONSTACK;
 		} else {
-			action.sa_flags = SA_SIGINFO | SA_RESETHAND;
+			action.sa_flags = SA_SIGINFO;
 		}
 
 		sigaction(signalId, &action, NULL);
@@ -968,6 +1665,10 @@ DBG_EXPORT JS_METHOD(setSignal) { NAPI_ENV;
 	
 	signalActivity[signalId] = value;
 	if (value) {
+		// Threads started since init need stacks to report overflows
+		#ifndef _WIN32
+			updateAltStacks();
+		#endif
 		_enableSignal(signalId);
 	} else {
 		_disableSignal(signalId);
@@ -977,19 +1678,78 @@ DBG_EXPORT JS_METHOD(setSignal) { NAPI_ENV;
 }
 
 
+#ifndef _WIN32
+// Everything the handler may need is acquired here, so that a crash with a corrupted
+// heap or a held malloc/loader lock can still be reported
+static inline void _reserveCrashResources() {
+	time_t now = time(nullptr);
+	struct tm local;
+	if (localtime_r(&now, &local)) {
+		gmtOffset = local.tm_gmtoff;
+	}
+
+	// The log file is only used if it exists at this point
+	if (logFd < 0) {
+		logFd = open("segfault.log", O_WRONLY | O_APPEND | O_CLOEXEC);
+	}
+
+	// The unwinder reads stack memory through a probe pipe, or directly within known bounds
+	initSafeMemory();
+	registerCurrentThread();
+
+	// Fault in the scratch pages now, not under memory pressure at crash time
+	memset(_reportBuffer, 0, REPORT_BUFFER_SIZE);
+	memset(_frames, 0, sizeof(_frames));
+
+	// The first unwind lazily loads libgcc_s and allocates, get it over with
+#if HAVE_EXECINFO_H
+	backtrace(_frames, MAX_FRAMES);
+#elif HAVE_LIBUNWIND_H
+	unw_cursor_t cursor;
+	unw_context_t unwContext;
+	if (unw_getcontext(&unwContext) == 0 && unw_init_local(&cursor, &unwContext) == 0) {
+		unw_step(&cursor);
+	}
+#endif
+	Dl_info info;
+	dladdr(reinterpret_cast<void*>(&_reserveCrashResources), &info);
+
+	for (const auto &pair : signalNames) {
+		if (pair.first < SIGNAL_NAME_SLOTS) {
+			_signalNameTable[pair.first] = pair.second.c_str();
+		}
+	}
+
+	updateModules();
+}
+#endif
+
+
 DBG_EXPORT void init() {
+	#ifdef _WIN32
+	_report.clearFds();
+	_report.addFd(STDERR_FD);
+	_report.setMirror(appendJournal);
+	#else
+	_resetSinks();
+	#endif
+
+	#ifndef _WIN32
+		_reserveCrashResources();
+	#endif
+
 	// On Windows, a single handler is set on startup.
 	// On Unix, handlers for every signal are set on-demand.
 	#ifdef _WIN32
 		SetUnhandledExceptionFilter(handleSignal);
 	#endif
 
-	// `SetThreadStackGuarantee` and `sigaltstack` help in handling stack overflows on their platforms.
+	// `SetThreadStackGuarantee` and alternate stacks help in handling stack overflows on their platforms.
 	#ifdef _WIN32
 		ULONG size = 32 * 1024;
 		SetThreadStackGuarantee(&size);
 	#else
-		sigaltstack(&_altStack, nullptr);
+		updateAltStacks();
 	#endif
 
 	for (auto pair : signalActivity) {
@@ -999,6 +1759,36 @@ DBG_EXPORT void init() {
 	}
 }
 
+static inline std::vector<std::string> _readStrings(Napi::Value value) {
+	std::vector<std::string> result;
+	if (!value.IsArray()) {
+		return result;
+	}
+	Napi::Array list = value.As<Napi::Array>();
+	for (uint32_t i = 0; i < list.Length(); i++) {
+		result.push_back(list.Get(i).ToString().Utf8Value());
+	}
+	return result;
+}
+
+DBG_EXPORT void renderPrologue(Napi::Env env) {
+	Napi::Object process = env.Global().Get("process").ToObject();
+	ProcessFacts facts;
+	facts.nodeVersion = process.Get("version").ToString().Utf8Value();
+	// As started: the executable, Node.js options, then the script and its arguments
+	std::vector<std::string> argv = _readStrings(process.Get("argv"));
+	std::vector<std::string> execArgv = _readStrings(process.Get("execArgv"));
+	if (!argv.empty()) {
+		argv.insert(argv.begin() + 1, execArgv.begin(), execArgv.end());
+	}
+	facts.argv = argv;
+	facts.envNames = reportEnvNames;
+	// Node.js itself, and this addon
+	facts.modules.push_back(reinterpret_cast<uintptr_t>(&napi_create_object));
+	facts.modules.push_back(reinterpret_cast<uintptr_t>(&renderPrologue));
+	renderReportPrologue(facts);
+}
+
 DBG_EXPORT JS_METHOD(setOutputFormat) { NAPI_ENV;
 	if (IS_ARG_EMPTY(0)) {
 		RET_UNDEFINED;
@@ -1014,4 +1804,1084 @@ DBG_EXPORT JS_METHOD(getOutputFormat) { NAPI_ENV;
 	RET_BOOL(getJsonOutputMode());
 }
 
+DBG_EXPORT JS_METHOD(setRawAddresses) { NAPI_ENV;
+	if (IS_ARG_EMPTY(0)) {
+		RET_UNDEFINED;
+	}
+
+	LET_BOOL_ARG(0, rawAddresses);
+	setRawAddressesMode(rawAddresses);
+
+	RET_UNDEFINED;
+}
+
+DBG_EXPORT JS_METHOD(getRawAddresses) { NAPI_ENV;
+	RET_BOOL(getRawAddressesMode());
+}
+
+DBG_EXPORT JS_METHOD(setCrashRecordFile) { NAPI_ENV;
+	LET_STR_ARG(0, path);
+#ifdef _WIN32
+	if (!path.empty()) {
+		Napi::Error::New(env, "Crash records are not supported on Windows").ThrowAsJavaScriptException();
+	}
+#else
+	// Opened here, the handler only appends
+	int fd = -1;
+	if (!path.empty()) {
+		fd = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+		if (fd < 0) {
+			std::string message = "Can't open crash record file '" + path + "': " + strerror(errno);
+			Napi::Error::New(env, message).ThrowAsJavaScriptException();
+			RET_UNDEFINED;
+		}
+	}
+
+	int previous = recordFd;
+	recordFd = fd;
+	recordPath = path;
+	if (previous >= 0) {
+		close(previous);
+	}
+#endif
+	RET_UNDEFINED;
+}
+
+static const char *const SINK_TYPE_NAMES[] = { "stderr", "file", "journal", "socket", "directory" };
+static const char *const SINK_FORMAT_NAMES[] = { "text", "json", "summary" };
+
+// Index of `value` in `names`, or -1
+static inline int _findName(const std::string &value, const char *const *names, size_t count) {
+	for (size_t i = 0; i < count; i++) {
+		if (value == names[i]) {
+			return static_cast<int>(i);
+		}
+	}
+	return -1;
+}
+
+DBG_EXPORT JS_METHOD(setCrashSinks) { NAPI_ENV;
+#ifdef _WIN32
+	if (!IS_ARG_EMPTY(0)) {
+		Napi::Error::New(env, "Crash sinks are not supported on Windows").ThrowAsJavaScriptException();
+	}
+#else
+	CHECK_LET_ARG(0, IsArray(), "Array");
+	CrashSink parsed[MAX_CRASH_SINKS];
+	std::string paths[MAX_CRASH_SINKS];
+	size_t parsedCount = 0;
+	bool hasSinks = !IS_ARG_EMPTY(0);
+
+	// Files and sockets are opened before anything changes, and closed again on errors
+	auto fail = [&](const std::string &message) {
+		for (size_t i = 0; i < parsedCount; i++) {
+			if (parsed[i].fd >= 0) {
+				close(parsed[i].fd);
+			}
+			closeCrashSocket(&parsed[i].socket);
+		}
+		Napi::Error::New(env, message).ThrowAsJavaScriptException();
+	};
+
+	if (hasSinks) {
+		Napi::Array list = info[0].As<Napi::Array>();
+		if (list.Length() > MAX_CRASH_SINKS) {
+			Napi::Error::New(env, "At most 8 crash sinks are supported").ThrowAsJavaScriptException();
+			RET_UNDEFINED;
+		}
+		for (uint32_t i = 0; i < list.Length(); i++) {
+			Napi::Value entry = list.Get(i);
+			if (!entry.IsObject()) {
+				fail("Crash sinks must be objects");
+				RET_UNDEFINED;
+			}
+			Napi::Object sink = entry.ToObject();
+			Napi::Value type = sink.Get("type");
+			Napi::Value format = sink.Get("format");
+			Napi::Value path = sink.Get("path");
+			int typeId = type.IsString() ? _findName(
+				type.As<Napi::String>().Utf8Value(), SINK_TYPE_NAMES, sizeof(SINK_TYPE_NAMES) / sizeof(char*)
+			) : -1;
+			int formatId = IS_EMPTY(format) ? FORMAT_TEXT : format.IsString() ? _findName(
+				format.As<Napi::String>().Utf8Value(), SINK_FORMAT_NAMES, sizeof(SINK_FORMAT_NAMES) / sizeof(char*)
+			) : -1;
+			if (typeId < 0) {
+				fail("`type` must be one of 'stderr', 'file', 'journal', 'socket', 'directory'");
+				RET_UNDEFINED;
+			}
+			if (formatId < 0) {
+				fail("`format` must be one of 'text', 'json', 'summary'");
+				RET_UNDEFINED;
+			}
+			bool hasPath = typeId == SINK_FILE || typeId == SINK_SOCKET || typeId == SINK_DIRECTORY;
+			bool needsPath = typeId == SINK_SOCKET || typeId == SINK_DIRECTORY;
+			if ((!IS_EMPTY(path) && (!hasPath || !path.IsString())) || (needsPath && IS_EMPTY(path))) {
+				fail(
+					"`path` must be a string, given for 'file' sinks and required for 'socket' and 'directory' sinks"
+				);
+				RET_UNDEFINED;
+			}
+
+			CrashSink &item = parsed[parsedCount];
+			item.type = typeId;
+			item.format = formatId;
+			item.fd = -1;
+			item.socket.fd = -1;
+			paths[parsedCount] = IS_EMPTY(path) ? "" : path.As<Napi::String>().Utf8Value();
+			// A directory takes both formats, their files differ by extension
+			for (size_t j = 0; j < parsedCount; j++) {
+				bool isSame = parsed[j].type == typeId && paths[j] == paths[parsedCount];
+				if (isSame && (typeId != SINK_DIRECTORY || parsed[j].format == formatId)) {
+					fail("Crash sinks must not repeat");
+					RET_UNDEFINED;
+				}
+			}
+			if (typeId == SINK_SOCKET) {
+				int error = openCrashSocket(paths[parsedCount].c_str(), &item.socket);
+				if (error) {
+					fail("Can't connect to crash collector '" + paths[parsedCount] + "': " + strerror(error));
+					RET_UNDEFINED;
+				}
+			} else if (typeId == SINK_DIRECTORY) {
+				item.fd = open(paths[parsedCount].c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+				if (item.fd < 0) {
+					fail("Can't open crash sink directory '" + paths[parsedCount] + "': " + strerror(errno));
+					RET_UNDEFINED;
+				}
+			} else if (!paths[parsedCount].empty()) {
+				item.fd = open(paths[parsedCount].c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+				if (item.fd < 0) {
+					fail("Can't open crash sink file '" + paths[parsedCount] + "': " + strerror(errno));
+					RET_UNDEFINED;
+				}
+			}
+			parsedCount++;
+		}
+	}
+
+	// Shrink first, so the handler never reads an entry being rewritten
+	CrashSink previous[MAX_CRASH_SINKS];
+	size_t previousCount = crashSinkCount;
+	memcpy(static_cast<void*>(previous), crashSinks, previousCount * sizeof(CrashSink));
+	hasCrashSinks = false;
+	crashSinkCount = 0;
+	memcpy(static_cast<void*>(crashSinks), parsed, parsedCount * sizeof(CrashSink));
+	for (size_t i = 0; i < MAX_CRASH_SINKS; i++) {
+		crashSinkPaths[i] = i < parsedCount ? paths[i] : "";
+	}
+	crashSinkCount = parsedCount;
+	hasCrashSinks = hasSinks;
+
+	// Warn now, the reports on stderr may not be text
+	for (size_t i = 0; i < crashSinkCount; i++) {
+		if (crashSinks[i].type == SINK_FILE && crashSinks[i].fd < 0 && logFd < 0) {
+			std::cerr
+				<< "SegfaultHandler: The exception won't be logged into a file"
+				<< ", unless 'segfault.log' exists." << std::endl;
+			break;
+		}
+	}
+	for (size_t i = 0; i < previousCount; i++) {
+		if (previous[i].fd >= 0) {
+			close(previous[i].fd);
+		}
+		closeCrashSocket(&previous[i].socket);
+	}
+#endif
+	RET_UNDEFINED;
+}
+
+DBG_EXPORT JS_METHOD(getCrashSinks) { NAPI_ENV;
+#ifdef _WIN32
+	return env.Null();
+#else
+	if (!hasCrashSinks) {
+		return env.Null();
+	}
+	Napi::Array result = Napi::Array::New(env, crashSinkCount);
+	for (size_t i = 0; i < crashSinkCount; i++) {
+		Napi::Object sink = Napi::Object::New(env);
+		sink.Set("type", SINK_TYPE_NAMES[crashSinks[i].type]);
+		sink.Set("format", SINK_FORMAT_NAMES[crashSinks[i].format]);
+		if (!crashSinkPaths[i].empty()) {
+			sink.Set("path", crashSinkPaths[i]);
+		}
+		result.Set(static_cast<uint32_t>(i), sink);
+	}
+	return result;
+#endif
+}
+
+DBG_EXPORT JS_METHOD(openCrashCollector) { NAPI_ENV;
+	LET_STR_ARG(0, path);
+	int fd = -1;
+	int error = listenCrashSocket(path.c_str(), &fd);
+	if (error) {
+		std::string message = "Can't listen for crash reports at '" + path + "': " + strerror(error);
+		Napi::Error::New(env, message).ThrowAsJavaScriptException();
+		RET_UNDEFINED;
+	}
+	return Napi::Number::New(env, fd);
+}
+
+DBG_EXPORT JS_METHOD(readCrashCollector) { NAPI_ENV;
+	USE_INT32_ARG(0, fd, -1);
+	std::vector<std::string> messages;
+	receiveCrashSocket(fd, &messages);
+	Napi::Array result = Napi::Array::New(env, messages.size());
+	for (size_t i = 0; i < messages.size(); i++) {
+		result.Set(static_cast<uint32_t>(i), Napi::String::New(env, messages[i]));
+	}
+	return result;
+}
+
+DBG_EXPORT JS_METHOD(closeCrashCollector) { NAPI_ENV;
+	USE_INT32_ARG(0, fd, -1);
+	closeCrashListener(fd);
+	RET_UNDEFINED;
+}
+
+DBG_EXPORT JS_METHOD(setCrashJournal) { NAPI_ENV;
+	LET_STR_ARG(0, path);
+	USE_INT32_ARG(1, size, static_cast<int>(DEFAULT_JOURNAL_SIZE));
+
+	if (path.empty()) {
+		closeJournal();
+		journalPath.clear();
+		RET_UNDEFINED;
+	}
+	if (size < static_cast<int>(MIN_JOURNAL_SIZE)) {
+		std::string message = "Journal size must be at least " + std::to_string(MIN_JOURNAL_SIZE) + " bytes";
+		Napi::Error::New(env, message).ThrowAsJavaScriptException();
+		RET_UNDEFINED;
+	}
+
+	int error = openJournal(path.c_str(), static_cast<size_t>(size));
+	if (error) {
+		std::string message = "Can't map crash journal '" + path + "': " + strerror(error);
+		Napi::Error::New(env, message).ThrowAsJavaScriptException();
+		RET_UNDEFINED;
+	}
+	journalPath = path;
+	RET_UNDEFINED;
+}
+
+DBG_EXPORT JS_METHOD(getCrashJournal) { NAPI_ENV;
+	if (!isJournalOpen()) {
+		return env.Null();
+	}
+	Napi::Object result = Napi::Object::New(env);
+	result.Set("path", journalPath);
+	result.Set("size", static_cast<double>(getJournalSize()));
+	return result;
+}
+
+DBG_EXPORT JS_METHOD(getCrashRecordFile) { NAPI_ENV;
+#ifndef _WIN32
+	if (recordFd >= 0) {
+		RET_STR(recordPath);
+	}
+#endif
+	return env.Null();
+}
+
+DBG_EXPORT JS_METHOD(setThreadDump) { NAPI_ENV;
+	LET_BOOL_ARG(0, enabled);
+	USE_INT32_ARG(1, timeout, static_cast<int>(DEFAULT_THREAD_DUMP_TIMEOUT));
+
+	if (!enabled) {
+		threadDumpTimeout = 0;
+		RET_UNDEFINED;
+	}
+	if (timeout < 1 || timeout > static_cast<int>(MAX_THREAD_DUMP_TIMEOUT)) {
+		std::string message = "Thread dump timeout must be from 1 to " + std::to_string(MAX_THREAD_DUMP_TIMEOUT) + " ms";
+		Napi::Error::New(env, message).ThrowAsJavaScriptException();
+		RET_UNDEFINED;
+	}
+
+	int error = initThreadDump();
+	if (error) {
+		std::string message = std::string("Can't prepare thread dumps: ") + strerror(error);
+		Napi::Error::New(env, message).ThrowAsJavaScriptException();
+		RET_UNDEFINED;
+	}
+	threadDumpTimeout = static_cast<uint32_t>(timeout);
+	RET_UNDEFINED;
+}
+
+DBG_EXPORT JS_METHOD(getThreadDump) { NAPI_ENV;
+	if (!threadDumpTimeout) {
+		return env.Null();
+	}
+	Napi::Object result = Napi::Object::New(env);
+	result.Set("timeout", static_cast<double>(threadDumpTimeout));
+	return result;
+}
+
+DBG_EXPORT JS_METHOD(getHandlerStats) { NAPI_ENV;
+	HandlerStats stats;
+	getHandlerStats(&stats);
+
+	Napi::Object result = Napi::Object::New(env);
+	Napi::Object signals = Napi::Object::New(env);
+	for (size_t i = 0; i < stats.signalCount; i++) {
+		signals.Set(stats.signals[i].signal, Napi::Number::New(env, static_cast<double>(stats.signals[i].count)));
+	}
+	result.Set("signals", signals);
+	result.Set("reports", static_cast<double>(stats.reports));
+	result.Set("bytes", static_cast<double>(stats.bytes));
+	result.Set("dropped", static_cast<double>(stats.dropped));
+
+	Napi::Object phases = Napi::Object::New(env);
+	for (size_t p = 0; p < PHASE_COUNT; p++) {
+		const PhaseStats &phase = stats.phases[p];
+		Napi::Object entry = Napi::Object::New(env);
+		entry.Set("count", static_cast<double>(phase.count));
+		entry.Set("avgUs", phase.count ? static_cast<double>(phase.totalNs) / phase.count / 1000 : 0.0);
+		entry.Set("maxUs", static_cast<double>(phase.maxNs) / 1000);
+		Napi::Array histogram = Napi::Array::New(env, PHASE_BUCKETS);
+		for (size_t b = 0; b < PHASE_BUCKETS; b++) {
+			histogram.Set(static_cast<uint32_t>(b), Napi::Number::New(env, static_cast<double>(phase.buckets[b])));
+		}
+		entry.Set("histogram", histogram);
+		phases.Set(getPhaseName(static_cast<HandlerPhase>(p)), entry);
+	}
+	result.Set("phases", phases);
+	return result;
+}
+
+DBG_EXPORT JS_METHOD(setAltStackSize) { NAPI_ENV;
+	double size = IS_ARG_EMPTY(0) || !info[0].IsNumber() ? -1 : info[0].ToNumber().DoubleValue();
+	if (!(size >= MIN_ALT_STACK_SIZE && size <= MAX_ALT_STACK_SIZE) || size != static_cast<size_t>(size)) {
+		std::string message = "Alternate stack size must be an integer from " +
+			std::to_string(MIN_ALT_STACK_SIZE) + " to " + std::to_string(MAX_ALT_STACK_SIZE);
+		Napi::Error::New(env, message).ThrowAsJavaScriptException();
+		RET_UNDEFINED;
+	}
+	setAltStackSize(static_cast<size_t>(size));
+	RET_UNDEFINED;
+}
+
+DBG_EXPORT JS_METHOD(updateAltStacks) { NAPI_ENV;
+#ifdef _WIN32
+	return Napi::Number::New(env, 0);
+#else
+	return Napi::Number::New(env, static_cast<double>(updateAltStacks()));
+#endif
+}
+
+DBG_EXPORT JS_METHOD(getAltStacks) { NAPI_ENV;
+#ifdef _WIN32
+	return env.Null();
+#else
+	Napi::Object result = Napi::Object::New(env);
+	result.Set("size", static_cast<double>(getAltStackSize()));
+	result.Set("threads", static_cast<double>(getAltStackCount()));
+	return result;
+#endif
+}
+
+// Read an integer field of `source` into `value`, an absent one is left as is.
+// Returns false, with a pending JS exception, if it is out of range.
+static inline bool _readIntegerOption(
+	Napi::Env env, const Napi::Object &source, const char *name, uint32_t min, uint32_t max, uint32_t *value
+) {
+	Napi::Value field = source.Get(name);
+	if (IS_EMPTY(field)) {
+		return true;
+	}
+	double number = field.IsNumber() ? field.ToNumber().DoubleValue() : -1;
+	if (!(number >= min && number <= max) || number != static_cast<uint32_t>(number)) {
+		std::string message = std::string("`") + name + "` must be an integer from " +
+			std::to_string(min) + " to " + std::to_string(max);
+		Napi::Error::New(env, message).ThrowAsJavaScriptException();
+		return false;
+	}
+	*value = static_cast<uint32_t>(number);
+	return true;
+}
+
+DBG_EXPORT JS_METHOD(setCrashDedup) { NAPI_ENV;
+	LET_STR_ARG(0, path);
+	CHECK_LET_ARG(1, IsObject(), "Object");
+	Napi::Object options = IS_ARG_EMPTY(1) ? Napi::Object::New(env) : info[1].ToObject();
+
+	if (path.empty()) {
+		closeCrashDedup();
+		dedupPath.clear();
+		RET_UNDEFINED;
+	}
+	uint32_t limit = DEFAULT_DEDUP_LIMIT;
+	uint32_t window = DEFAULT_DEDUP_WINDOW;
+	if (
+		!_readIntegerOption(env, options, "limit", 0, MAX_DEDUP_LIMIT, &limit) ||
+		!_readIntegerOption(env, options, "window", 1, MAX_DEDUP_WINDOW, &window)
+	) {
+		RET_UNDEFINED;
+	}
+
+	int error = openCrashDedup(path.c_str());
+	if (error) {
+		std::string message = "Can't map crash dedup table '" + path + "': " + strerror(error);
+		Napi::Error::New(env, message).ThrowAsJavaScriptException();
+		RET_UNDEFINED;
+	}
+	dedupPath = path;
+	dedupLimit = limit;
+	dedupWindow = window;
+	RET_UNDEFINED;
+}
+
+DBG_EXPORT JS_METHOD(getCrashDedup) { NAPI_ENV;
+	if (!isCrashDedupOpen()) {
+		return env.Null();
+	}
+	Napi::Object result = Napi::Object::New(env);
+	result.Set("path", dedupPath);
+	result.Set("limit", static_cast<double>(dedupLimit));
+	result.Set("window", static_cast<double>(dedupWindow));
+	return result;
+}
+
+DBG_EXPORT JS_METHOD(setReportEnv) { NAPI_ENV;
+	CHECK_LET_ARG(0, IsArray(), "Array");
+	std::vector<std::string> names;
+	if (!IS_ARG_EMPTY(0)) {
+		Napi::Array list = info[0].As<Napi::Array>();
+		if (list.Length() > MAX_REPORT_ENV) {
+			Napi::Error::New(env, "At most 64 variables can be reported").ThrowAsJavaScriptException();
+			RET_UNDEFINED;
+		}
+		for (uint32_t i = 0; i < list.Length(); i++) {
+			Napi::Value name = list.Get(i);
+			if (!name.IsString() || name.As<Napi::String>().Utf8Value().empty()) {
+				Napi::Error::New(env, "Variable names must be non-empty strings").ThrowAsJavaScriptException();
+				RET_UNDEFINED;
+			}
+			names.push_back(name.As<Napi::String>().Utf8Value());
+		}
+	}
+	reportEnvNames = names;
+	renderPrologue(env);
+	RET_UNDEFINED;
+}
+
+DBG_EXPORT JS_METHOD(getReportEnv) { NAPI_ENV;
+	Napi::Array result = Napi::Array::New(env, reportEnvNames.size());
+	for (size_t i = 0; i < reportEnvNames.size(); i++) {
+		result.Set(static_cast<uint32_t>(i), Napi::String::New(env, reportEnvNames[i]));
+	}
+	return result;
+}
+
+DBG_EXPORT JS_METHOD(setCrashDump) { NAPI_ENV;
+	LET_STR_ARG(0, directory);
+	CHECK_LET_ARG(1, IsObject(), "Object");
+	Napi::Object options = IS_ARG_EMPTY(1) ? Napi::Object::New(env) : info[1].ToObject();
+
+	if (directory.empty()) {
+		closeCrashDump();
+		dumpPath.clear();
+		RET_UNDEFINED;
+	}
+	CrashDumpOptions parsed = { DEFAULT_DUMP_STACK_SIZE, DEFAULT_DUMP_WINDOW_SIZE };
+	if (
+		!_readIntegerOption(env, options, "stackSize", 0, MAX_DUMP_STACK_SIZE, &parsed.stackSize) ||
+		!_readIntegerOption(env, options, "windowSize", 0, MAX_DUMP_WINDOW_SIZE, &parsed.windowSize)
+	) {
+		RET_UNDEFINED;
+	}
+
+	int error = openCrashDump(directory.c_str());
+	if (error) {
+		std::string message = "Can't open crash dump directory '" + directory + "': " + strerror(error);
+		Napi::Error::New(env, message).ThrowAsJavaScriptException();
+		RET_UNDEFINED;
+	}
+	// Without a trailing slash, the report joins it with the file name
+	while (directory.size() > 1 && directory.back() == '/') {
+		directory.pop_back();
+	}
+	dumpPath = directory;
+	dumpOptions = parsed;
+	RET_UNDEFINED;
+}
+
+DBG_EXPORT JS_METHOD(getCrashDump) { NAPI_ENV;
+	if (!isCrashDumpOpen()) {
+		return env.Null();
+	}
+	Napi::Object result = Napi::Object::New(env);
+	result.Set("directory", dumpPath);
+	result.Set("stackSize", static_cast<double>(dumpOptions.stackSize));
+	result.Set("windowSize", static_cast<double>(dumpOptions.windowSize));
+	return result;
+}
+
+// Read `maxFrames` and `skipFrames` of `source` into `options`, absent ones are left as is.
+// Returns false, with a pending JS exception, on invalid values.
+static inline bool _readCaptureOptions(Napi::Env env, const Napi::Object &source, CaptureOptions *options) {
+	static const struct {
+		const char *name;
+		uint32_t CaptureOptions::*field;
+		uint32_t min;
+		uint32_t max;
+	} fields[] = {
+		{ "maxFrames", &CaptureOptions::maxFrames, 1, MAX_CAPTURE_FRAMES },
+		{ "skipFrames", &CaptureOptions::skipFrames, 0, MAX_CAPTURE_FRAMES - 1 },
+	};
+
+	for (const auto &field : fields) {
+		if (!_readIntegerOption(env, source, field.name, field.min, field.max, &(options->*field.field))) {
+			return false;
+		}
+	}
+	return true;
+}
+
+DBG_EXPORT JS_METHOD(setCaptureOptions) { NAPI_ENV;
+	if (IS_ARG_EMPTY(0)) {
+		RET_UNDEFINED;
+	}
+	CHECK_LET_ARG(0, IsObject(), "Object");
+	Napi::Object options = info[0].ToObject();
+
+	CaptureOptions common = captureOptions;
+	if (!_readCaptureOptions(env, options, &common)) {
+		RET_UNDEFINED;
+	}
+
+	// `perSignal` replaces all overrides, `null` removes them
+	Napi::Value perSignal = options.Get("perSignal");
+	SignalCaptureOptions parsed[MAX_SIGNAL_CAPTURE_OPTIONS];
+	size_t parsedCount = 0;
+	if (!perSignal.IsUndefined() && !perSignal.IsNull()) {
+		if (!perSignal.IsObject()) {
+			Napi::Error::New(env, "`perSignal` must be an object").ThrowAsJavaScriptException();
+			RET_UNDEFINED;
+		}
+		Napi::Object table = perSignal.ToObject();
+		for (const auto &pair : signalNames) {
+			Napi::Value entry = table.Get(std::to_string(pair.first).c_str());
+			if (IS_EMPTY(entry)) {
+				continue;
+			}
+			if (!entry.IsObject()) {
+				Napi::Error::New(env, "`perSignal` values must be objects").ThrowAsJavaScriptException();
+				RET_UNDEFINED;
+			}
+			if (parsedCount >= MAX_SIGNAL_CAPTURE_OPTIONS) {
+				break;
+			}
+			SignalCaptureOptions &item = parsed[parsedCount++];
+			item.signalId = pair.first;
+			item.options = { INHERIT_OPTION, INHERIT_OPTION };
+			if (!_readCaptureOptions(env, entry.ToObject(), &item.options)) {
+				RET_UNDEFINED;
+			}
+		}
+	}
+
+	captureOptions = common;
+	if (!perSignal.IsUndefined()) {
+		// Shrink first, so the handler never reads an entry being rewritten
+		signalCaptureCount = 0;
+		memcpy(signalCaptureOptions, parsed, parsedCount * sizeof(SignalCaptureOptions));
+		signalCaptureCount = parsedCount;
+	}
+
+	RET_UNDEFINED;
+}
+
+DBG_EXPORT JS_METHOD(getCaptureOptions) { NAPI_ENV;
+	Napi::Object result = Napi::Object::New(env);
+	result.Set("maxFrames", static_cast<double>(captureOptions.maxFrames));
+	result.Set("skipFrames", static_cast<double>(captureOptions.skipFrames));
+
+	Napi::Object perSignal = Napi::Object::New(env);
+	for (size_t i = 0; i < signalCaptureCount; i++) {
+		const CaptureOptions &custom = signalCaptureOptions[i].options;
+		Napi::Object entry = Napi::Object::New(env);
+		if (custom.maxFrames != INHERIT_OPTION) {
+			entry.Set("maxFrames", static_cast<double>(custom.maxFrames));
+		}
+		if (custom.skipFrames != INHERIT_OPTION) {
+			entry.Set("skipFrames", static_cast<double>(custom.skipFrames));
+		}
+		perSignal.Set(std::to_string(signalCaptureOptions[i].signalId).c_str(), entry);
+	}
+	result.Set("perSignal", perSignal);
+
+	return result;
+}
+
+DBG_EXPORT JS_METHOD(setUnwinder) { NAPI_ENV;
+	if (IS_ARG_EMPTY(0)) {
+		RET_UNDEFINED;
+	}
+
+	LET_STR_ARG(0, name);
+	if (name == "cfi") {
+		setUnwindMethod(UNWIND_CFI);
+	} else if (name == "fp") {
+		setUnwindMethod(UNWIND_FRAME_POINTERS);
+	} else {
+		Napi::Error::New(env, "Unwinder must be 'cfi' or 'fp'").ThrowAsJavaScriptException();
+	}
+
+	RET_UNDEFINED;
+}
+
+DBG_EXPORT JS_METHOD(getUnwinder) { NAPI_ENV;
+	RET_STR(getUnwindMethod() == UNWIND_FRAME_POINTERS ? "fp" : "cfi");
+}
+
+DBG_EXPORT JS_METHOD(updateModules) { NAPI_ENV;
+	segfault::updateModules();
+	RET_UNDEFINED;
+}
+
+DBG_EXPORT JS_METHOD(getModules) { NAPI_ENV;
+	size_t count = getModuleCount();
+	Napi::Array modules = Napi::Array::New(env, count);
+	for (size_t i = 0; i < count; i++) {
+		const ModuleInfo *module = getModule(i);
+		Napi::Object entry = Napi::Object::New(env);
+		entry.Set("path", module->path);
+		entry.Set("start", static_cast<double>(module->start));
+		entry.Set("end", static_cast<double>(module->end));
+		entry.Set("base", static_cast<double>(module->base));
+		entry.Set("symbols", static_cast<double>(getSymbolCount(module->symbols)));
+		modules.Set(static_cast<uint32_t>(i), entry);
+	}
+	return modules;
+}
+
+
+#ifdef __linux__
+// Kernel TIDs of all the threads of the process
+static inline std::vector<int> _listThreads() {
+	std::vector<int> tids(MAX_LISTED_THREADS);
+	tids.resize(listThreads(tids.data(), tids.size()));
+	return tids;
+}
+
+struct ProfileStacks {
+	// By TID, then frames innermost first
+	std::map<std::pair<int, std::vector<uintptr_t>>, uint64_t> counts;
+};
+
+static void _countSample(int tid, void *const *frames, size_t count, void *data) {
+	std::vector<uintptr_t> stack(count);
+	for (size_t i = 0; i < count; i++) {
+		// Callers hold return addresses: attribute them to the call instruction
+		stack[i] = reinterpret_cast<uintptr_t>(frames[i]) - (i > 0 ? 1 : 0);
+	}
+	static_cast<ProfileStacks*>(data)->counts[{ tid, stack }]++;
+}
+
+#endif
+
+DBG_EXPORT JS_METHOD(startProfiler) { NAPI_ENV;
+	CHECK_LET_ARG(0, IsObject(), "Object");
+#ifdef __linux__
+	Napi::Object options = IS_ARG_EMPTY(0) ? Napi::Object::New(env) : info[0].ToObject();
+	ProfilerOptions settings = {
+		DEFAULT_PROFILER_HZ, DEFAULT_PROFILER_FRAMES, DEFAULT_PROFILER_BUFFER, unwindMethod,
+	};
+	uint32_t bufferSize = static_cast<uint32_t>(settings.bufferSize);
+	if (
+		!_readIntegerOption(env, options, "hz", 1, MAX_PROFILER_HZ, &settings.hz) ||
+		!_readIntegerOption(env, options, "maxFrames", 1, MAX_CAPTURE_FRAMES, &settings.maxFrames) ||
+		!_readIntegerOption(env, options, "bufferSize", MIN_PROFILER_BUFFER, MAX_PROFILER_BUFFER, &bufferSize)
+	) {
+		RET_UNDEFINED;
+	}
+	settings.bufferSize = bufferSize;
+
+	// 'all' threads running now (default), the 'current' one, or a list of TIDs
+	std::vector<int> tids;
+	Napi::Value threads = options.Get("threads");
+	if (IS_EMPTY(threads) || (threads.IsString() && threads.ToString().Utf8Value() == "all")) {
+		tids = _listThreads();
+	} else if (threads.IsString() && threads.ToString().Utf8Value() == "current") {
+		tids.push_back(getCurrentThreadId());
+	} else if (threads.IsArray()) {
+		Napi::Array list = threads.As<Napi::Array>();
+		for (uint32_t i = 0; i < list.Length(); i++) {
+			Napi::Value tid = list.Get(i);
+			if (!tid.IsNumber()) {
+				Napi::Error::New(env, "`threads` must only contain TIDs").ThrowAsJavaScriptException();
+				RET_UNDEFINED;
+			}
+			tids.push_back(tid.ToNumber().Int32Value());
+		}
+	} else {
+		Napi::Error::New(env, "`threads` must be 'all', 'current' or an array of TIDs").ThrowAsJavaScriptException();
+		RET_UNDEFINED;
+	}
+
+	int error = segfault::startProfiler(settings, tids.data(), tids.size());
+	if (error) {
+		std::string message = std::string("Can't start the profiler: ") + strerror(error);
+		Napi::Error::New(env, message).ThrowAsJavaScriptException();
+	}
+#else
+	Napi::Error::New(env, "The profiler is only supported on Linux").ThrowAsJavaScriptException();
+#endif
+	RET_UNDEFINED;
+}
+
+DBG_EXPORT JS_METHOD(stopProfiler) { NAPI_ENV;
+	segfault::stopProfiler();
+
+	ProfilerStats stats = getProfilerStats();
+	Napi::Object profile = Napi::Object::New(env);
+	profile.Set("hz", static_cast<double>(stats.hz));
+	profile.Set("startTime", static_cast<double>(stats.startNs / 1000000));
+	profile.Set("duration", static_cast<double>(stats.durationNs));
+	profile.Set("samples", static_cast<double>(stats.samples));
+	profile.Set("dropped", static_cast<double>(stats.dropped));
+	profile.Set("threads", static_cast<double>(stats.threads));
+
+	Napi::Array modules = Napi::Array::New(env);
+	Napi::Array locations = Napi::Array::New(env);
+	Napi::Array stacks = Napi::Array::New(env);
+#ifdef __linux__
+	ProfileStacks collected;
+	readProfile(_countSample, &collected);
+
+	// Symbolized once per distinct address, in normal context
+	std::map<uintptr_t, uint32_t> locationIndex;
+	std::map<const ModuleInfo*, uint32_t> moduleIndex;
+	auto addLocation = [&](uintptr_t address) {
+		auto found = locationIndex.find(address);
+		if (found != locationIndex.end()) {
+			return found->second;
+		}
+		Napi::Object location = Napi::Object::New(env);
+		location.Set("address", static_cast<double>(address));
+		const ModuleInfo *module = findModule(address);
+		if (module) {
+			auto known = moduleIndex.find(module);
+			uint32_t index = known == moduleIndex.end() ? modules.Length() : known->second;
+			if (known == moduleIndex.end()) {
+				Napi::Object entry = Napi::Object::New(env);
+				entry.Set("path", module->path);
+				entry.Set("start", static_cast<double>(module->start));
+				entry.Set("end", static_cast<double>(module->end));
+				entry.Set("base", static_cast<double>(module->base));
+				modules.Set(index, entry);
+				moduleIndex[module] = index;
+			}
+			location.Set("module", static_cast<double>(index));
+
+			uintptr_t symbolAddress = 0;
+			const char *name = findSymbol(module->symbols, address - module->base, &symbolAddress);
+			if (name && name[0]) {
+				location.Set("symbol", demangleSymbol(name));
+				location.Set("symbolOffset", static_cast<double>(address - module->base - symbolAddress));
+			}
+		}
+		uint32_t index = locations.Length();
+		locations.Set(index, location);
+		locationIndex[address] = index;
+		return index;
+	};
+
+	for (const auto &item : collected.counts) {
+		const std::vector<uintptr_t> &frames = item.first.second;
+		Napi::Array stackLocations = Napi::Array::New(env, frames.size());
+		for (size_t i = 0; i < frames.size(); i++) {
+			stackLocations.Set(static_cast<uint32_t>(i), Napi::Number::New(env, addLocation(frames[i])));
+		}
+		Napi::Object stack = Napi::Object::New(env);
+		stack.Set("tid", static_cast<double>(item.first.first));
+		stack.Set("count", static_cast<double>(item.second));
+		stack.Set("locations", stackLocations);
+		stacks.Set(stacks.Length(), stack);
+	}
+#endif
+
+	profile.Set("modules", modules);
+	profile.Set("locations", locations);
+	profile.Set("stacks", stacks);
+	return profile;
+}
+
+
+#ifdef __linux__
+static void _beatWatchdog(uv_timer_t*) {
+	beatWatchdog();
+}
+
+static void _stopHeartbeat() {
+	if (!_heartbeat) {
+		return;
+	}
+	uv_timer_stop(_heartbeat);
+	uv_close(reinterpret_cast<uv_handle_t*>(_heartbeat), [](uv_handle_t *handle) {
+		delete reinterpret_cast<uv_timer_t*>(handle);
+	});
+	_heartbeat = nullptr;
+}
+
+// The watched loop is going away, e.g. a worker thread exits
+static void _stopWatchdogAtExit(void*) {
+	segfault::stopWatchdog();
+	_stopHeartbeat();
+	_watchdogEnv = nullptr;
+}
+#endif
+
+DBG_EXPORT JS_METHOD(startWatchdog) { NAPI_ENV;
+	CHECK_LET_ARG(0, IsObject(), "Object");
+	Napi::Object options = IS_ARG_EMPTY(0) ? Napi::Object::New(env) : info[0].ToObject();
+	WatchdogOptions settings = { DEFAULT_WATCHDOG_THRESHOLD, captureOptions.maxFrames, unwindMethod };
+	if (
+		!_readIntegerOption(
+			env, options, "threshold", MIN_WATCHDOG_THRESHOLD, MAX_WATCHDOG_THRESHOLD, &settings.thresholdMs
+		) ||
+		!_readIntegerOption(env, options, "maxFrames", 1, MAX_WATCHDOG_FRAMES, &settings.maxFrames)
+	) {
+		RET_UNDEFINED;
+	}
+#ifdef __linux__
+	if (isWatchdogRunning()) {
+		Napi::Error::New(env, "The watchdog is already running").ThrowAsJavaScriptException();
+		RET_UNDEFINED;
+	}
+
+	// The heartbeat comes from the loop of the calling thread, and doesn't keep it alive.
+	// The watchdog checks it 4 times per threshold, a healthy loop costs nothing else.
+	uv_loop_t *loop = nullptr;
+	if (napi_get_uv_event_loop(env, &loop) != napi_ok || !loop) {
+		Napi::Error::New(env, "Can't get the event loop").ThrowAsJavaScriptException();
+		RET_UNDEFINED;
+	}
+	uint64_t interval = settings.thresholdMs / 4 ? settings.thresholdMs / 4 : 1;
+	_heartbeat = new uv_timer_t;
+	uv_timer_init(loop, _heartbeat);
+	uv_timer_start(_heartbeat, _beatWatchdog, interval, interval);
+	uv_unref(reinterpret_cast<uv_handle_t*>(_heartbeat));
+
+	int error = segfault::startWatchdog(settings, getCurrentThreadId(), _reportStall);
+	if (error) {
+		_stopHeartbeat();
+		std::string message = std::string("Can't start the watchdog: ") + strerror(error);
+		Napi::Error::New(env, message).ThrowAsJavaScriptException();
+		RET_UNDEFINED;
+	}
+	_watchdogEnv = env;
+	napi_add_env_cleanup_hook(env, _stopWatchdogAtExit, nullptr);
+#else
+	Napi::Error::New(env, "The watchdog is only supported on Linux").ThrowAsJavaScriptException();
+#endif
+	RET_UNDEFINED;
+}
+
+DBG_EXPORT JS_METHOD(stopWatchdog) { NAPI_ENV;
+#ifdef __linux__
+	if (!isWatchdogRunning()) {
+		RET_UNDEFINED;
+	}
+	if (env != _watchdogEnv) {
+		Napi::Error::New(env, "The watchdog was started by another thread").ThrowAsJavaScriptException();
+		RET_UNDEFINED;
+	}
+	napi_remove_env_cleanup_hook(env, _stopWatchdogAtExit, nullptr);
+	_stopWatchdogAtExit(nullptr);
+#endif
+	RET_UNDEFINED;
+}
+
+DBG_EXPORT JS_METHOD(getWatchdog) { NAPI_ENV;
+	if (!isWatchdogRunning()) {
+		return env.Null();
+	}
+	Napi::Object result = Napi::Object::New(env);
+	result.Set("stalls", static_cast<double>(getStallCount()));
+	return result;
+}
+
+
+#ifndef _WIN32
+// Return addresses of the calling thread, innermost first, from the first frame outside
+// of this addon. Normal context.
+static NO_INLINE size_t _captureCurrentStack(void **frames, size_t maxFrames) {
+	void *raw[MAX_CAPTURE_FRAMES + HANDLER_FRAMES];
+	size_t wanted = maxFrames + HANDLER_FRAMES;
+	size_t count = 0;
+#if defined(__linux__) && defined(__GLIBC__)
+	// The unwinder starts from a context, the current one will do
+	ucontext_t context;
+	if (getcontext(&context) == 0 && lockUnwinder(CAPTURE_UNWINDER_SPINS)) {
+		count = unwindStack(&context, raw, wanted, unwindMethod);
+		unlockUnwinder();
+	}
+#endif
+#if HAVE_EXECINFO_H
+	if (count <= 1) {
+		count = static_cast<size_t>(backtrace(raw, static_cast<int>(wanted)));
+	}
+#endif
+
+	const ModuleInfo *self = findModule(reinterpret_cast<uintptr_t>(&_captureCurrentStack));
+	size_t first = 0;
+	while (self && first < count) {
+		const ModuleInfo *module = findModule(reinterpret_cast<uintptr_t>(raw[first]));
+		if (!module || module->start != self->start) {
+			break;
+		}
+		first++;
+	}
+	count = count - first < maxFrames ? count - first : maxFrames;
+	memcpy(frames, raw + first, count * sizeof(void*));
+	return count;
+}
+#endif
+
+// `{ address, module, base, offset, symbol, symbolOffset }` of a return address, as far as known
+static inline Napi::Object _resolveFrame(Napi::Env env, uintptr_t address, const ResolvedAddress &resolved) {
+	Napi::Object frame = Napi::Object::New(env);
+	frame.Set("address", static_cast<double>(address));
+	if (resolved.hasModule) {
+		frame.Set("module", resolved.module);
+		frame.Set("base", static_cast<double>(resolved.base));
+		frame.Set("offset", static_cast<double>(address - resolved.base));
+	}
+	if (resolved.hasSymbol) {
+		frame.Set("symbol", resolved.symbol);
+		// Resolved at the call instruction, one byte back
+		frame.Set("symbolOffset", static_cast<double>(resolved.symbolOffset + 1));
+	}
+	return frame;
+}
+
+DBG_EXPORT JS_METHOD(captureStack) { NAPI_ENV;
+	CHECK_LET_ARG(0, IsObject(), "Object");
+	Napi::Object options = IS_ARG_EMPTY(0) ? Napi::Object::New(env) : info[0].ToObject();
+	uint32_t maxFrames = captureOptions.maxFrames;
+	if (!_readIntegerOption(env, options, "maxFrames", 1, MAX_CAPTURE_FRAMES, &maxFrames)) {
+		RET_UNDEFINED;
+	}
+	Napi::Value format = options.Get("format");
+	bool isBuffer = format.IsString() && format.ToString().Utf8Value() == "buffer";
+	if (!IS_EMPTY(format) && !isBuffer && !(format.IsString() && format.ToString().Utf8Value() == "array")) {
+		Napi::Error::New(env, "`format` must be 'array' or 'buffer'").ThrowAsJavaScriptException();
+		RET_UNDEFINED;
+	}
+	Napi::Value symbolize = options.Get("symbolize");
+	bool isSymbolized = IS_EMPTY(symbolize) || symbolize.ToBoolean().Value();
+
+#ifdef _WIN32
+	(void)maxFrames;
+	(void)isBuffer;
+	(void)isSymbolized;
+	Napi::Error::New(env, "Stack capture is not supported on Windows").ThrowAsJavaScriptException();
+	RET_UNDEFINED;
+#else
+	void *frames[MAX_CAPTURE_FRAMES];
+	size_t count = _captureCurrentStack(frames, maxFrames);
+	// Threads started since, e.g. by libuv or other addons, need stacks to report overflows
+	refreshAltStacks();
+
+	// Compact form: native-endian 64-bit addresses, e.g. for `symbolizeStack()` later
+	if (isBuffer) {
+		uint64_t addresses[MAX_CAPTURE_FRAMES];
+		for (size_t i = 0; i < count; i++) {
+			addresses[i] = reinterpret_cast<uintptr_t>(frames[i]);
+		}
+		return Napi::Buffer<uint8_t>::Copy(
+			env, reinterpret_cast<const uint8_t*>(addresses), count * sizeof(uint64_t)
+		);
+	}
+
+	if (isSymbolized) {
+		// Modules loaded since the last capture, if any
+		updateModules();
+	}
+	Napi::Array result = Napi::Array::New(env, count);
+	for (size_t i = 0; i < count; i++) {
+		uintptr_t address = reinterpret_cast<uintptr_t>(frames[i]);
+		if (!isSymbolized) {
+			result.Set(static_cast<uint32_t>(i), Napi::Number::New(env, static_cast<double>(address)));
+			continue;
+		}
+		result.Set(static_cast<uint32_t>(i), _resolveFrame(env, address, resolveAddress(address - 1)));
+	}
+	return result;
+#endif
+}
+
+
+// Resolves return addresses on the libuv threadpool, through the shared symbol cache
+class SymbolizeWorker : public Napi::AsyncWorker {
+public:
+	SymbolizeWorker(Napi::Env env, std::vector<uintptr_t> &&addresses):
+	Napi::AsyncWorker(env, "SegfaultSymbolize"),
+	_deferred(Napi::Promise::Deferred::New(env)),
+	_addresses(std::move(addresses)) {}
+
+	Napi::Promise getPromise() const { return _deferred.Promise(); }
+
+protected:
+	void Execute() override {
+		// The results are copies, only the lookups need the tables to stay put
+		_resolved.reserve(_addresses.size());
+		lockModules();
+		for (uintptr_t address : _addresses) {
+			_resolved.push_back(resolveAddress(address - 1));
+		}
+		unlockModules();
+	}
+
+	void OnOK() override {
+		Napi::Env env = Env();
+		Napi::Array result = Napi::Array::New(env, _addresses.size());
+		for (size_t i = 0; i < _addresses.size(); i++) {
+			result.Set(static_cast<uint32_t>(i), _resolveFrame(env, _addresses[i], _resolved[i]));
+		}
+		_deferred.Resolve(result);
+	}
+
+private:
+	Napi::Promise::Deferred _deferred;
+	std::vector<uintptr_t> _addresses;
+	std::vector<ResolvedAddress> _resolved;
+};
+
+DBG_EXPORT JS_METHOD(symbolizeStack) { NAPI_ENV;
+	std::vector<uintptr_t> addresses;
+	if (info[0].IsBuffer()) {
+		Napi::Buffer<uint8_t> buffer = info[0].As<Napi::Buffer<uint8_t>>();
+		addresses.resize(buffer.Length() / sizeof(uint64_t));
+		for (size_t i = 0; i < addresses.size(); i++) {
+			uint64_t address;
+			memcpy(&address, buffer.Data() + i * sizeof(uint64_t), sizeof(address));
+			addresses[i] = static_cast<uintptr_t>(address);
+		}
+	} else if (info[0].IsArray()) {
+		Napi::Array list = info[0].As<Napi::Array>();
+		for (uint32_t i = 0; i < list.Length(); i++) {
+			Napi::Value address = list.Get(i);
+			if (!address.IsNumber()) {
+				Napi::Error::New(env, "Frames must be addresses").ThrowAsJavaScriptException();
+				RET_UNDEFINED;
+			}
+			addresses.push_back(static_cast<uintptr_t>(address.ToNumber().DoubleValue()));
+		}
+	} else {
+		Napi::Error::New(env, "Argument 0 must be a Buffer or an array of addresses").ThrowAsJavaScriptException();
+		RET_UNDEFINED;
+	}
+
+	// Updates wait for the worker to finish its lookups
+	updateModules();
+	SymbolizeWorker *worker = new SymbolizeWorker(env, std::move(addresses));
+	Napi::Promise promise = worker->getPromise();
+	worker->Queue();
+	return promise;
+}
+
 } // namespace segfault
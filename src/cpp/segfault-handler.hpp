@@ -38,14 +38,32 @@
 
 #define LET_BOOL_ARG(I, VAR) USE_BOOL_ARG(I, VAR, false)
 
+#define USE_STR_ARG(I, VAR, DEF) \
+	CHECK_LET_ARG(I, IsString(), "String"); \
+	std::string VAR = IS_ARG_EMPTY(I) ? (DEF) : info[I].ToString().Utf8Value();
+
+#define LET_STR_ARG(I, VAR) USE_STR_ARG(I, VAR, "")
+
+#define RET_STR(VAL) return Napi::String::New(env, VAL)
+
 
 namespace segfault {
 	DBG_EXPORT void init();
+	// Render what reports say about the process, see `renderReportPrologue()`. Call at load
+	// and whenever it changes.
+	DBG_EXPORT void renderPrologue(Napi::Env env);
 	DBG_EXPORT void registerHandler();
 
 	DBG_EXPORT void setJsonOutputMode(bool jsonOutput);
 	DBG_EXPORT bool getJsonOutputMode();
 
+	DBG_EXPORT void setRawAddressesMode(bool rawAddresses);
+	DBG_EXPORT bool getRawAddressesMode();
+
+	// Stack walking method of the built-in unwinder, see `UnwindMethod`
+	DBG_EXPORT void setUnwindMethod(int method);
+	DBG_EXPORT int getUnwindMethod();
+
 	DBG_EXPORT JS_METHOD(causeSegfault);
 	DBG_EXPORT JS_METHOD(causeDivisionInt);
 	DBG_EXPORT JS_METHOD(causeOverflow);
@@ -53,6 +71,42 @@ namespace segfault {
 	DBG_EXPORT JS_METHOD(setSignal);
 	DBG_EXPORT JS_METHOD(setOutputFormat);
 	DBG_EXPORT JS_METHOD(getOutputFormat);
+	DBG_EXPORT JS_METHOD(setRawAddresses);
+	DBG_EXPORT JS_METHOD(getRawAddresses);
+	DBG_EXPORT JS_METHOD(setCrashRecordFile);
+	DBG_EXPORT JS_METHOD(getCrashRecordFile);
+	DBG_EXPORT JS_METHOD(setCrashJournal);
+	DBG_EXPORT JS_METHOD(getCrashJournal);
+	DBG_EXPORT JS_METHOD(setCrashDedup);
+	DBG_EXPORT JS_METHOD(getCrashDedup);
+	DBG_EXPORT JS_METHOD(setCrashSinks);
+	DBG_EXPORT JS_METHOD(getCrashSinks);
+	DBG_EXPORT JS_METHOD(openCrashCollector);
+	DBG_EXPORT JS_METHOD(readCrashCollector);
+	DBG_EXPORT JS_METHOD(closeCrashCollector);
+	DBG_EXPORT JS_METHOD(setReportEnv);
+	DBG_EXPORT JS_METHOD(getReportEnv);
+	DBG_EXPORT JS_METHOD(setCrashDump);
+	DBG_EXPORT JS_METHOD(getCrashDump);
+	DBG_EXPORT JS_METHOD(setThreadDump);
+	DBG_EXPORT JS_METHOD(getThreadDump);
+	DBG_EXPORT JS_METHOD(getHandlerStats);
+	DBG_EXPORT JS_METHOD(setAltStackSize);
+	DBG_EXPORT JS_METHOD(updateAltStacks);
+	DBG_EXPORT JS_METHOD(getAltStacks);
+	DBG_EXPORT JS_METHOD(startProfiler);
+	DBG_EXPORT JS_METHOD(stopProfiler);
+	DBG_EXPORT JS_METHOD(startWatchdog);
+	DBG_EXPORT JS_METHOD(stopWatchdog);
+	DBG_EXPORT JS_METHOD(getWatchdog);
+	DBG_EXPORT JS_METHOD(captureStack);
+	DBG_EXPORT JS_METHOD(symbolizeStack);
+	DBG_EXPORT JS_METHOD(updateModules);
+	DBG_EXPORT JS_METHOD(getModules);
+	DBG_EXPORT JS_METHOD(setCaptureOptions);
+	DBG_EXPORT JS_METHOD(getCaptureOptions);
+	DBG_EXPORT JS_METHOD(setUnwinder);
+	DBG_EXPORT JS_METHOD(getUnwinder);
 }
 
 
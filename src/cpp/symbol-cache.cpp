@@ -0,0 +1,101 @@
+#include <cstdlib>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+#ifndef _WIN32
+#include <cxxabi.h>
+#include <dlfcn.h>
+#endif
+
+#include "symbol-cache.hpp"
+#include "module-map.hpp"
+
+
+namespace segfault {
+
+constexpr size_t SYMBOL_CACHE_CAPACITY = 4096;
+
+// Most recently used first, the map points into the list
+typedef std::list<std::pair<uintptr_t, ResolvedAddress>> CacheList;
+static CacheList _recent;
+static std::unordered_map<uintptr_t, CacheList::iterator> _cache;
+static uint64_t _cacheGeneration = 0;
+static std::mutex _cacheMutex;
+
+
+static inline ResolvedAddress _resolve(uintptr_t address) {
+	ResolvedAddress result = { false, std::string(), 0, false, std::string(), 0 };
+	const ModuleInfo *module = findModule(address);
+	if (!module) {
+		return result;
+	}
+	result.hasModule = true;
+	result.module = module->path;
+	result.base = module->base;
+
+	const char *name = nullptr;
+	uintptr_t symbolAddress = 0;
+#ifdef __linux__
+	if (module->symbols) {
+		name = findSymbol(module->symbols, address - module->base, &symbolAddress);
+		symbolAddress += module->base;
+	}
+#elif !defined(_WIN32)
+	Dl_info info;
+	if (dladdr(reinterpret_cast<void*>(address), &info) && info.dli_sname) {
+		name = info.dli_sname;
+		symbolAddress = reinterpret_cast<uintptr_t>(info.dli_saddr);
+	}
+#endif
+	if (name && name[0] && symbolAddress <= address) {
+		result.hasSymbol = true;
+		result.symbol = demangleSymbol(name);
+		result.symbolOffset = address - symbolAddress;
+	}
+	return result;
+}
+
+
+DBG_EXPORT ResolvedAddress resolveAddress(uintptr_t address) {
+	std::lock_guard<std::mutex> lock(_cacheMutex);
+
+	// Addresses may belong to other modules after a reload
+	uint64_t generation = getModuleGeneration();
+	if (generation != _cacheGeneration) {
+		_cache.clear();
+		_recent.clear();
+		_cacheGeneration = generation;
+	}
+
+	auto found = _cache.find(address);
+	if (found != _cache.end()) {
+		_recent.splice(_recent.begin(), _recent, found->second);
+		return found->second->second;
+	}
+
+	_recent.emplace_front(address, _resolve(address));
+	_cache[address] = _recent.begin();
+	if (_recent.size() > SYMBOL_CACHE_CAPACITY) {
+		_cache.erase(_recent.back().first);
+		_recent.pop_back();
+	}
+	return _recent.front().second;
+}
+
+
+DBG_EXPORT std::string demangleSymbol(const char *name) {
+#ifndef _WIN32
+	int status = 0;
+	char *demangled = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+	if (demangled) {
+		std::string result = demangled;
+		free(demangled);
+		return result;
+	}
+#endif
+	return name;
+}
+
+} // namespace segfault
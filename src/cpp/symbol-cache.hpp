@@ -0,0 +1,35 @@
+#ifndef _SYMBOL_CACHE_HPP_
+#define _SYMBOL_CACHE_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+#ifdef _WIN32
+#define DBG_EXPORT __declspec(dllexport)
+#else
+#define DBG_EXPORT
+#endif
+
+
+namespace segfault {
+	// Module and function of a code address, names are copies
+	struct ResolvedAddress {
+		bool hasModule;
+		std::string module;
+		uintptr_t base;
+		bool hasSymbol;
+		std::string symbol; // demangled
+		uintptr_t symbolOffset;
+	};
+
+	// Resolve `address` through the module map and symbol tables. Recent results are kept
+	// in an LRU cache, which is dropped when the module map changes. Thread-safe, not
+	// signal-safe.
+	DBG_EXPORT ResolvedAddress resolveAddress(uintptr_t address);
+
+	// Demangled C++ name, or `name` itself
+	DBG_EXPORT std::string demangleSymbol(const char *name);
+}
+
+#endif /* _SYMBOL_CACHE_HPP_ */
@@ -0,0 +1,262 @@
+#include <algorithm>
+#include <cstring>
+
+#ifdef __linux__
+#include <elf.h>
+#include <link.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "symbol-index.hpp"
+
+
+namespace segfault {
+
+// Compact entry, names stay in the mapped string table of the file
+struct SymbolEntry {
+	uint64_t address;
+	uint32_t size;
+	uint32_t name;
+};
+
+struct SymbolTable {
+	const SymbolEntry *entries;
+	size_t count;
+	const char *names;
+	size_t namesSize;
+};
+
+
+#ifdef __linux__
+constexpr size_t MAX_CACHED_FILES = 1024;
+
+struct CachedFile {
+	char *path;
+	dev_t device;
+	ino_t inode;
+	const SymbolTable *table;
+};
+
+static CachedFile _cache[MAX_CACHED_FILES];
+static size_t _cacheCount = 0;
+
+
+struct ElfImage {
+	const uint8_t *data;
+	size_t size;
+	const ElfW(Shdr) *sections;
+	size_t sectionCount;
+};
+
+static inline bool _inBounds(const ElfImage &image, uint64_t offset, uint64_t size) {
+	return offset <= image.size && size <= image.size - offset;
+}
+
+static bool _readImage(ElfImage &image) {
+	if (image.size < sizeof(ElfW(Ehdr))) {
+		return false;
+	}
+	const ElfW(Ehdr) *header = reinterpret_cast<const ElfW(Ehdr)*>(image.data);
+	// Only the native class and byte order can be loaded into this process anyway
+	if (
+		memcmp(header->e_ident, ELFMAG, SELFMAG) != 0 ||
+		header->e_ident[EI_CLASS] != (sizeof(void*) == 8 ? ELFCLASS64 : ELFCLASS32) ||
+		header->e_shentsize != sizeof(ElfW(Shdr)) ||
+		!_inBounds(image, header->e_shoff, uint64_t(header->e_shnum) * sizeof(ElfW(Shdr)))
+	) {
+		return false;
+	}
+	image.sections = reinterpret_cast<const ElfW(Shdr)*>(image.data + header->e_shoff);
+	image.sectionCount = header->e_shnum;
+	return true;
+}
+
+// `st_info` is encoded the same way in both ELF classes
+static inline bool _isFunction(const ElfW(Sym) &symbol) {
+	unsigned char type = ELF64_ST_TYPE(symbol.st_info);
+	return (
+		(type == STT_FUNC || type == STT_GNU_IFUNC) &&
+		symbol.st_shndx != SHN_UNDEF && symbol.st_value != 0
+	);
+}
+
+// Aliases share an address, the preferred binding is kept
+static inline int _bindingRank(const ElfW(Sym) &symbol) {
+	switch (ELF64_ST_BIND(symbol.st_info)) {
+		case STB_GLOBAL: return 0;
+		case STB_WEAK: return 1;
+		default: return 2;
+	}
+}
+
+// Function symbols of a SHT_SYMTAB or SHT_DYNSYM section, sorted and deduplicated
+static SymbolTable *_indexSymbols(const ElfImage &image, uint32_t sectionType) {
+	for (size_t s = 0; s < image.sectionCount; s++) {
+		const ElfW(Shdr) &section = image.sections[s];
+		if (section.sh_type != sectionType || section.sh_link >= image.sectionCount) {
+			continue;
+		}
+		const ElfW(Shdr) &strings = image.sections[section.sh_link];
+		if (
+			!_inBounds(image, section.sh_offset, section.sh_size) ||
+			!_inBounds(image, strings.sh_offset, strings.sh_size) ||
+			strings.sh_size > UINT32_MAX
+		) {
+			return nullptr;
+		}
+
+		const ElfW(Sym) *symbols = reinterpret_cast<const ElfW(Sym)*>(image.data + section.sh_offset);
+		size_t symbolCount = section.sh_size / sizeof(ElfW(Sym));
+		size_t count = 0;
+		for (size_t i = 0; i < symbolCount; i++) {
+			count += _isFunction(symbols[i]) && symbols[i].st_name < strings.sh_size;
+		}
+		if (!count) {
+			return nullptr;
+		}
+
+		SymbolEntry *entries = new SymbolEntry[count];
+		size_t used = 0;
+		for (int rank = 0; rank < 3; rank++) {
+			for (size_t i = 0; i < symbolCount; i++) {
+				const ElfW(Sym) &symbol = symbols[i];
+				if (!_isFunction(symbol) || symbol.st_name >= strings.sh_size || _bindingRank(symbol) != rank) {
+					continue;
+				}
+				SymbolEntry &entry = entries[used++];
+				entry.address = symbol.st_value;
+				entry.size = symbol.st_size > UINT32_MAX ? UINT32_MAX : static_cast<uint32_t>(symbol.st_size);
+				entry.name = symbol.st_name;
+			}
+		}
+
+		std::stable_sort(
+			entries, entries + used,
+			[](const SymbolEntry &a, const SymbolEntry &b) { return a.address < b.address; }
+		);
+		used = std::unique(
+			entries, entries + used,
+			[](const SymbolEntry &a, const SymbolEntry &b) { return a.address == b.address; }
+		) - entries;
+
+		SymbolTable *table = new SymbolTable();
+		table->entries = entries;
+		table->count = used;
+		table->names = reinterpret_cast<const char*>(image.data + strings.sh_offset);
+		table->namesSize = strings.sh_size;
+		return table;
+	}
+	return nullptr;
+}
+
+static const SymbolTable *_loadFile(int fd, size_t size) {
+	void *mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (mapped == MAP_FAILED) {
+		return nullptr;
+	}
+
+	ElfImage image = { static_cast<const uint8_t*>(mapped), size, nullptr, 0 };
+	SymbolTable *table = nullptr;
+	if (_readImage(image)) {
+		table = _indexSymbols(image, SHT_SYMTAB);
+		if (!table) {
+			table = _indexSymbols(image, SHT_DYNSYM);
+		}
+	}
+	if (!table) {
+		munmap(mapped, size);
+		return nullptr;
+	}
+
+	// Only the string table has to stay mapped, remap it alone and let go of the rest
+	long pageSize = sysconf(_SC_PAGESIZE);
+	size_t namesOffset = table->names - static_cast<const char*>(mapped);
+	size_t mapOffset = namesOffset - namesOffset % pageSize;
+	void *names = mmap(nullptr, table->namesSize + namesOffset - mapOffset, PROT_READ, MAP_PRIVATE, fd, mapOffset);
+	munmap(mapped, size);
+	if (names == MAP_FAILED) {
+		delete[] table->entries;
+		delete table;
+		return nullptr;
+	}
+	table->names = static_cast<const char*>(names) + (namesOffset - mapOffset);
+	return table;
+}
+#endif
+
+
+DBG_EXPORT const SymbolTable *loadSymbols(const char *path) {
+#ifdef __linux__
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return nullptr;
+	}
+	struct stat status;
+	if (fstat(fd, &status) != 0 || !S_ISREG(status.st_mode)) {
+		close(fd);
+		return nullptr;
+	}
+
+	// The same file is indexed once, even if it is loaded again or under another table
+	for (size_t i = 0; i < _cacheCount; i++) {
+		const CachedFile &cached = _cache[i];
+		if (cached.device == status.st_dev && cached.inode == status.st_ino && !strcmp(cached.path, path)) {
+			close(fd);
+			return cached.table;
+		}
+	}
+
+	const SymbolTable *table = _loadFile(fd, static_cast<size_t>(status.st_size));
+	close(fd);
+
+	if (_cacheCount < MAX_CACHED_FILES) {
+		_cache[_cacheCount++] = { strdup(path), status.st_dev, status.st_ino, table };
+	}
+	return table;
+#else
+	(void)path;
+	return nullptr;
+#endif
+}
+
+
+DBG_EXPORT const char *findSymbol(
+	const SymbolTable *table, uintptr_t address, uintptr_t *symbolAddress
+) {
+	if (!table || !table->count) {
+		return nullptr;
+	}
+
+	// Last symbol starting at or below `address`
+	size_t low = 0;
+	size_t high = table->count;
+	while (low < high) {
+		size_t mid = low + (high - low) / 2;
+		if (table->entries[mid].address <= address) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+	if (!low) {
+		return nullptr;
+	}
+
+	const SymbolEntry &entry = table->entries[low - 1];
+	// Sizeless symbols (e.g. from assembly) extend up to the next one
+	if (entry.size && address - entry.address >= entry.size) {
+		return nullptr;
+	}
+	*symbolAddress = static_cast<uintptr_t>(entry.address);
+	return table->names + entry.name;
+}
+
+
+DBG_EXPORT size_t getSymbolCount(const SymbolTable *table) {
+	return table ? table->count : 0;
+}
+
+} // namespace segfault
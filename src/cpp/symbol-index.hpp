@@ -0,0 +1,32 @@
+#ifndef _SYMBOL_INDEX_HPP_
+#define _SYMBOL_INDEX_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#define DBG_EXPORT __declspec(dllexport)
+#else
+#define DBG_EXPORT
+#endif
+
+
+namespace segfault {
+	// Function symbols of an ELF file, sorted by address
+	struct SymbolTable;
+
+	// Index `.symtab` (or `.dynsym`, if stripped) of the ELF file at `path`.
+	// Returns nullptr for non-ELF files and files without function symbols.
+	// Tables are cached by path and never freed. Not signal-safe, call in normal context.
+	DBG_EXPORT const SymbolTable *loadSymbols(const char *path);
+
+	// Find the function containing `address` (an ELF virtual address, i.e. PC minus
+	// load bias). Returns its name and sets `symbolAddress`, or returns nullptr. Signal-safe.
+	DBG_EXPORT const char *findSymbol(
+		const SymbolTable *table, uintptr_t address, uintptr_t *symbolAddress
+	);
+
+	DBG_EXPORT size_t getSymbolCount(const SymbolTable *table);
+}
+
+#endif /* _SYMBOL_INDEX_HPP_ */
@@ -0,0 +1,288 @@
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#endif
+
+#include "thread-dump.hpp"
+#include "handler-stats.hpp"
+#include "thread-registry.hpp"
+#include "unwinder.hpp"
+
+
+namespace segfault {
+
+#ifdef __linux__
+constexpr size_t MAX_DUMPED_THREADS = 256;
+constexpr size_t MAX_DUMPED_FRAMES = 64;
+// Real-time signal that asks a thread for its stack, next to the watchdog's
+constexpr int DUMP_SIGNAL_OFFSET = 5;
+// Threads unwind one at a time: a handler waits this many spins at most for its turn
+constexpr int UNWINDER_MAX_SPINS = 100000;
+// A held thread goes on by itself after this long, should the dumping one never release it
+constexpr uint64_t MAX_HOLD_MS = 10000;
+
+enum SlotState : int {
+	SLOT_FREE = 0,
+	SLOT_REQUESTED,
+	SLOT_CAPTURING,
+	SLOT_DONE,
+};
+
+struct Slot {
+	std::atomic<int> state;
+	DumpedThread thread;
+	void *frames[MAX_DUMPED_FRAMES];
+};
+
+static Slot _slots[MAX_DUMPED_THREADS];
+static size_t _slotCount = 0;
+static uint32_t _maxFrames = MAX_DUMPED_FRAMES;
+static UnwindMethod _unwindMethod = UNWIND_CFI;
+static std::atomic<bool> _isHolding(false);
+
+// Opened in advance, the crashed process may have no fds to spare
+static int _taskFd = -1;
+static int _dumpSignal = 0;
+static char _direntBuffer[4096];
+
+// As returned by `getdents64`, which has no glibc wrapper on older systems
+struct LinuxDirent64 {
+	uint64_t d_ino;
+	int64_t d_off;
+	unsigned short d_reclen;
+	unsigned char d_type;
+	char d_name[];
+};
+
+
+static void _handleDumpSignal(int, siginfo_t *info, void *context) {
+	int savedErrno = errno;
+	if (info->si_code != SI_TKILL || info->si_pid != getpid()) {
+		errno = savedErrno;
+		return;
+	}
+
+	int tid = getCurrentThreadId();
+	for (size_t i = 0; i < _slotCount; i++) {
+		Slot &slot = _slots[i];
+		int expected = SLOT_REQUESTED;
+		if (slot.thread.tid != tid || !slot.state.compare_exchange_strong(expected, SLOT_CAPTURING)) {
+			continue;
+		}
+		readThreadName(slot.thread.name);
+		slot.thread.count = 0;
+		slot.thread.registerCount = static_cast<uint16_t>(
+			readContextRegisters(context, slot.thread.registers, &slot.thread.arch)
+		);
+		if (lockUnwinder(UNWINDER_MAX_SPINS)) {
+			slot.thread.count = unwindStack(context, slot.frames, _maxFrames, _unwindMethod);
+			unlockUnwinder();
+		}
+		slot.state.store(SLOT_DONE);
+
+		uint64_t deadline = getMonotonicNs() + MAX_HOLD_MS * 1000000;
+		struct timespec pause = { 0, 1000000 };
+		while (_isHolding.load() && getMonotonicNs() < deadline) {
+			nanosleep(&pause, nullptr);
+		}
+		break;
+	}
+	errno = savedErrno;
+}
+
+static inline int _parseTid(const char *name) {
+	int tid = 0;
+	for (; *name; name++) {
+		if (*name < '0' || *name > '9') {
+			return 0;
+		}
+		tid = tid * 10 + (*name - '0');
+	}
+	return tid;
+}
+
+// Name of a thread that didn't answer, from "<tid>/comm" under the task directory
+static inline void _readTaskName(int tid, char name[THREAD_NAME_SIZE]) {
+	char path[24];
+	size_t length = 0;
+	char digits[12];
+	size_t digitCount = 0;
+	for (unsigned value = static_cast<unsigned>(tid); value || !digitCount; value /= 10) {
+		digits[digitCount++] = static_cast<char>('0' + value % 10);
+	}
+	while (digitCount) {
+		path[length++] = digits[--digitCount];
+	}
+	memcpy(path + length, "/comm", 6);
+
+	name[0] = '\0';
+	int fd = openat(_taskFd, path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return;
+	}
+	ssize_t size = read(fd, name, THREAD_NAME_SIZE - 1);
+	close(fd);
+	size = size > 0 ? size : 0;
+	// The kernel ends it with a newline
+	if (size && name[size - 1] == '\n') {
+		size--;
+	}
+	name[size] = '\0';
+}
+
+// Fill the slots with the TIDs of every other thread, `readdir()` is not signal-safe
+static inline void _listOtherThreads(int selfTid) {
+	_slotCount = 0;
+	if (lseek(_taskFd, 0, SEEK_SET) != 0) {
+		return;
+	}
+	while (_slotCount < MAX_DUMPED_THREADS) {
+		long size = syscall(SYS_getdents64, _taskFd, _direntBuffer, sizeof(_direntBuffer));
+		if (size <= 0) {
+			return;
+		}
+		for (long offset = 0; offset < size && _slotCount < MAX_DUMPED_THREADS;) {
+			const LinuxDirent64 *entry = reinterpret_cast<const LinuxDirent64*>(_direntBuffer + offset);
+			offset += entry->d_reclen;
+			int tid = _parseTid(entry->d_name);
+			if (tid <= 0 || tid == selfTid) {
+				continue;
+			}
+			Slot &slot = _slots[_slotCount++];
+			slot.state.store(SLOT_FREE);
+			slot.thread.tid = tid;
+			slot.thread.isCaptured = false;
+			slot.thread.name[0] = '\0';
+			slot.thread.frames = slot.frames;
+			slot.thread.count = 0;
+			slot.thread.registerCount = 0;
+		}
+	}
+}
+#endif
+
+
+DBG_EXPORT int initThreadDump() {
+#ifdef __linux__
+	if (_taskFd >= 0) {
+		return 0;
+	}
+	_dumpSignal = SIGRTMIN + DUMP_SIGNAL_OFFSET;
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	sigemptyset(&action.sa_mask);
+	action.sa_sigaction = _handleDumpSignal;
+	action.sa_flags = SA_SIGINFO | SA_RESTART;
+	if (sigaction(_dumpSignal, &action, nullptr) != 0) {
+		return errno;
+	}
+
+	int fd = open("/proc/self/task", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (fd < 0) {
+		return errno;
+	}
+	// Fault the slots in now, not at crash time
+	memset(static_cast<void*>(_slots), 0, sizeof(_slots));
+	_taskFd = fd;
+	return 0;
+#else
+	return ENOTSUP;
+#endif
+}
+
+
+DBG_EXPORT bool isThreadDumpReady() {
+#ifdef __linux__
+	return _taskFd >= 0;
+#else
+	return false;
+#endif
+}
+
+
+DBG_EXPORT size_t dumpThreads(uint32_t timeoutMs, uint32_t maxFrames, int unwindMethod, bool hold) {
+#ifdef __linux__
+	if (_taskFd < 0) {
+		return 0;
+	}
+	_isHolding.store(hold);
+	_maxFrames = maxFrames < MAX_DUMPED_FRAMES ? maxFrames : MAX_DUMPED_FRAMES;
+	_unwindMethod = static_cast<UnwindMethod>(unwindMethod);
+	_listOtherThreads(getCurrentThreadId());
+
+	int pid = getpid();
+	for (size_t i = 0; i < _slotCount; i++) {
+		_slots[i].state.store(SLOT_REQUESTED);
+		// The thread may be gone already, it is reported as not answering
+		syscall(SYS_tgkill, pid, _slots[i].thread.tid, _dumpSignal);
+	}
+
+	uint64_t deadline = getMonotonicNs() + uint64_t(timeoutMs) * 1000000;
+	struct timespec pause = { 0, 1000000 };
+	for (;;) {
+		size_t pending = 0;
+		for (size_t i = 0; i < _slotCount; i++) {
+			pending += _slots[i].state.load() != SLOT_DONE;
+		}
+		if (!pending || getMonotonicNs() >= deadline) {
+			break;
+		}
+		nanosleep(&pause, nullptr);
+	}
+
+	// Late handlers find no request, and a capture in progress is not reported
+	for (size_t i = 0; i < _slotCount; i++) {
+		int expected = SLOT_REQUESTED;
+		_slots[i].state.compare_exchange_strong(expected, SLOT_FREE);
+		_slots[i].thread.isCaptured = _slots[i].state.load() == SLOT_DONE;
+		if (!_slots[i].thread.isCaptured) {
+			_readTaskName(_slots[i].thread.tid, _slots[i].thread.name);
+		}
+	}
+	return _slotCount;
+#else
+	(void)timeoutMs;
+	(void)maxFrames;
+	(void)unwindMethod;
+	(void)hold;
+	return 0;
+#endif
+}
+
+
+DBG_EXPORT const DumpedThread *getDumpedThread(size_t index) {
+#ifdef __linux__
+	return index < _slotCount ? &_slots[index].thread : nullptr;
+#else
+	(void)index;
+	return nullptr;
+#endif
+}
+
+
+DBG_EXPORT void releaseThreads() {
+#ifdef __linux__
+	_isHolding.store(false);
+#endif
+}
+
+
+DBG_EXPORT void readThreadName(char name[THREAD_NAME_SIZE]) {
+	name[0] = '\0';
+#ifdef __linux__
+	if (prctl(PR_GET_NAME, name, 0, 0, 0) != 0) {
+		name[0] = '\0';
+	}
+	name[THREAD_NAME_SIZE - 1] = '\0';
+#endif
+}
+
+} // namespace segfault
@@ -0,0 +1,49 @@
+#ifndef _THREAD_DUMP_HPP_
+#define _THREAD_DUMP_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "crash-record.hpp"
+
+#ifdef _WIN32
+#define DBG_EXPORT __declspec(dllexport)
+#else
+#define DBG_EXPORT
+#endif
+
+
+namespace segfault {
+	constexpr size_t THREAD_NAME_SIZE = 16;
+
+	// Stack of another thread, collected by `dumpThreads()`
+	struct DumpedThread {
+		int tid;
+		bool isCaptured; // false if the thread didn't answer in time
+		char name[THREAD_NAME_SIZE];
+		void *const *frames; // innermost first
+		size_t count;
+		uint64_t registers[MAX_CONTEXT_REGISTERS]; // see `readContextRegisters()`
+		uint16_t registerCount;
+		uint16_t arch;
+	};
+
+	// Open `/proc/self/task` and install the handler of the dump signal, so that nothing
+	// has to be acquired at crash time. Returns 0 or an errno value. Linux only, call in
+	// normal context.
+	DBG_EXPORT int initThreadDump();
+	DBG_EXPORT bool isThreadDumpReady();
+
+	// Interrupt every other thread of the process with a real-time signal, and wait at most
+	// `timeoutMs` for all of them to unwind their stacks into preallocated slots. Returns
+	// the number of threads found, see `getDumpedThread()`. With `hold`, the threads then
+	// stay in their handlers, their stacks unchanged, until `releaseThreads()`. Signal-safe.
+	DBG_EXPORT size_t dumpThreads(uint32_t timeoutMs, uint32_t maxFrames, int unwindMethod, bool hold);
+	DBG_EXPORT const DumpedThread *getDumpedThread(size_t index);
+	DBG_EXPORT void releaseThreads();
+
+	// Name of the calling thread, as in `/proc/self/task/<tid>/comm`. Signal-safe.
+	DBG_EXPORT void readThreadName(char name[THREAD_NAME_SIZE]);
+}
+
+#endif /* _THREAD_DUMP_HPP_ */
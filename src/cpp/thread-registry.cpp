@@ -0,0 +1,218 @@
+#include <atomic>
+#include <mutex>
+
+#ifdef __linux__
+#include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+#include "thread-registry.hpp"
+
+
+namespace segfault {
+
+constexpr size_t MAX_THREADS = 256;
+
+// Entries are never rewritten while published: a new one takes a free slot, and is
+// published with its thread ID before the one it replaces is freed
+struct ThreadSlot {
+	std::atomic<int> tid; // 0 if free
+	std::atomic<uintptr_t> stackLow;
+	std::atomic<uintptr_t> stackHigh;
+};
+
+static ThreadSlot _threads[MAX_THREADS];
+static std::atomic<size_t> _threadCount(0);
+static std::mutex _registerMutex;
+
+
+DBG_EXPORT int getCurrentThreadId() {
+#ifdef __linux__
+	return static_cast<int>(syscall(SYS_gettid));
+#else
+	return 0;
+#endif
+}
+
+
+DBG_EXPORT size_t listThreads(int *tids, size_t capacity) {
+	size_t count = 0;
+#ifdef __linux__
+	DIR *tasks = opendir("/proc/self/task");
+	if (!tasks) {
+		return 0;
+	}
+	while (struct dirent *entry = readdir(tasks)) {
+		int tid = atoi(entry->d_name);
+		if (tid > 0 && count < capacity) {
+			tids[count++] = tid;
+		}
+	}
+	closedir(tasks);
+#else
+	(void)tids;
+	(void)capacity;
+#endif
+	return count;
+}
+
+
+DBG_EXPORT uint64_t getThreadStartTime(int tid) {
+#ifdef __linux__
+	char path[64];
+	snprintf(path, sizeof(path), "/proc/self/task/%d/stat", tid);
+	int fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return 0;
+	}
+	char stat[1024];
+	ssize_t size = read(fd, stat, sizeof(stat) - 1);
+	close(fd);
+	if (size <= 0) {
+		return 0;
+	}
+	stat[size] = '\0';
+
+	// The name may hold anything, fields resume after its last ')': state is the 3rd field,
+	// the start time the 22nd
+	const char *field = strrchr(stat, ')');
+	for (int index = 2; field && index < 22; index++) {
+		field = strchr(field + 1, ' ');
+	}
+	return field ? strtoull(field + 1, nullptr, 10) : 0;
+#else
+	(void)tid;
+	return 0;
+#endif
+}
+
+
+DBG_EXPORT void registerThread(int tid, uintptr_t stackLow, uintptr_t stackHigh) {
+	if (!tid) {
+		return;
+	}
+	std::lock_guard<std::mutex> lock(_registerMutex);
+	size_t count = _threadCount.load(std::memory_order_relaxed);
+	ThreadSlot *previous = nullptr;
+	ThreadSlot *slot = nullptr;
+	for (size_t i = 0; i < count; i++) {
+		int current = _threads[i].tid.load(std::memory_order_relaxed);
+		if (current == tid) {
+			previous = &_threads[i];
+		} else if (!current && !slot) {
+			slot = &_threads[i];
+		}
+	}
+	if (!slot) {
+		if (count >= MAX_THREADS) {
+			return;
+		}
+		slot = &_threads[count];
+	}
+
+	slot->stackLow.store(stackLow, std::memory_order_relaxed);
+	slot->stackHigh.store(stackHigh, std::memory_order_relaxed);
+	slot->tid.store(tid, std::memory_order_release);
+	if (slot == &_threads[count]) {
+		_threadCount.store(count + 1, std::memory_order_release);
+	}
+	// Thread IDs get reused, the latest registration wins
+	if (previous) {
+		previous->tid.store(0, std::memory_order_release);
+	}
+}
+
+
+DBG_EXPORT void registerCurrentThread() {
+#ifdef __linux__
+	pthread_attr_t attributes;
+	if (pthread_getattr_np(pthread_self(), &attributes) != 0) {
+		return;
+	}
+	void *stackAddress = nullptr;
+	size_t stackSize = 0;
+	int status = pthread_attr_getstack(&attributes, &stackAddress, &stackSize);
+	pthread_attr_destroy(&attributes);
+	if (status != 0) {
+		return;
+	}
+
+	uintptr_t stackLow = reinterpret_cast<uintptr_t>(stackAddress);
+	registerThread(getCurrentThreadId(), stackLow, stackLow + stackSize);
+#endif
+}
+
+
+DBG_EXPORT void forgetExitedThreads() {
+#ifdef __linux__
+	std::lock_guard<std::mutex> lock(_registerMutex);
+	size_t count = _threadCount.load(std::memory_order_relaxed);
+	for (size_t i = 0; i < count; i++) {
+		int tid = _threads[i].tid.load(std::memory_order_relaxed);
+		char path[64];
+		snprintf(path, sizeof(path), "/proc/self/task/%d", tid);
+		if (tid && access(path, F_OK) != 0) {
+			_threads[i].tid.store(0, std::memory_order_release);
+		}
+	}
+#endif
+}
+
+
+DBG_EXPORT bool findStackMapping(uintptr_t address, uintptr_t *low, uintptr_t *high) {
+#ifdef __linux__
+	FILE *maps = fopen("/proc/self/maps", "re");
+	if (!maps) {
+		return false;
+	}
+	char line[512];
+	bool isFound = false;
+	while (!isFound && fgets(line, sizeof(line), maps)) {
+		unsigned long start = 0;
+		unsigned long end = 0;
+		if (sscanf(line, "%lx-%lx", &start, &end) == 2 && address >= start && address < end) {
+			*low = start;
+			*high = end;
+			isFound = true;
+		}
+		// The rest of a long line, e.g. a long path
+		while (!strchr(line, '\n') && fgets(line, sizeof(line), maps)) {}
+	}
+	fclose(maps);
+	return isFound;
+#else
+	(void)address;
+	(void)low;
+	(void)high;
+	return false;
+#endif
+}
+
+
+DBG_EXPORT bool findCurrentThread(ThreadInfo *thread) {
+	int tid = getCurrentThreadId();
+	size_t count = _threadCount.load(std::memory_order_acquire);
+	for (size_t i = 0; tid && i < count; i++) {
+		ThreadSlot &slot = _threads[i];
+		if (slot.tid.load(std::memory_order_acquire) != tid) {
+			continue;
+		}
+		thread->tid = tid;
+		thread->stackLow = slot.stackLow.load(std::memory_order_relaxed);
+		thread->stackHigh = slot.stackHigh.load(std::memory_order_relaxed);
+		// Freed meanwhile, and maybe taken: the replacement is published in another slot
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (slot.tid.load(std::memory_order_relaxed) == tid) {
+			return true;
+		}
+	}
+	return false;
+}
+
+} // namespace segfault
@@ -0,0 +1,51 @@
+#ifndef _THREAD_REGISTRY_HPP_
+#define _THREAD_REGISTRY_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#define DBG_EXPORT __declspec(dllexport)
+#else
+#define DBG_EXPORT
+#endif
+
+
+namespace segfault {
+	// A thread with its stack bounds
+	struct ThreadInfo {
+		int tid;
+		uintptr_t stackLow;
+		uintptr_t stackHigh; // one past the top of the stack
+	};
+
+	// Record thread `tid` and its stack bounds, replacing an earlier record of the ID.
+	// Call in normal context.
+	DBG_EXPORT void registerThread(int tid, uintptr_t stackLow, uintptr_t stackHigh);
+
+	// Record the calling thread and its stack bounds. Call in normal context.
+	DBG_EXPORT void registerCurrentThread();
+
+	// Drop the records of threads that have exited. Call in normal context.
+	DBG_EXPORT void forgetExitedThreads();
+
+	// Bounds of the mapping that contains `address`, e.g. a stack pointer of a thread that
+	// didn't register itself. Linux only, call in normal context.
+	DBG_EXPORT bool findStackMapping(uintptr_t address, uintptr_t *low, uintptr_t *high);
+
+	// Copy the record of the calling thread into `thread`, false if there is none. Signal-safe.
+	DBG_EXPORT bool findCurrentThread(ThreadInfo *thread);
+
+	// Kernel thread ID of the calling thread, 0 if unsupported. Signal-safe.
+	DBG_EXPORT int getCurrentThreadId();
+
+	// Kernel thread IDs of all the threads of the process, at most `capacity` of them.
+	// Returns their count, 0 if unsupported. Call in normal context.
+	DBG_EXPORT size_t listThreads(int *tids, size_t capacity);
+
+	// When thread `tid` started, in clock ticks since boot, 0 if unknown. Thread IDs get
+	// reused, the ID and the start time together identify a thread. Call in normal context.
+	DBG_EXPORT uint64_t getThreadStartTime(int tid);
+}
+
+#endif /* _THREAD_REGISTRY_HPP_ */
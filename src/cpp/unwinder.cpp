@@ -0,0 +1,1040 @@
+#include <atomic>
+#include <cstring>
+
+#if defined(__linux__)
+#include <sched.h>
+#include <ucontext.h>
+#endif
+
+#include "unwinder.hpp"
+#include "module-map.hpp"
+#include "safe-memory.hpp"
+#include "thread-registry.hpp"
+
+
+namespace segfault {
+
+// Pointer encodings, see the LSB "Exception Frames" chapter
+enum : uint8_t {
+	DW_EH_PE_absptr = 0x00,
+	DW_EH_PE_uleb128 = 0x01,
+	DW_EH_PE_udata2 = 0x02,
+	DW_EH_PE_udata4 = 0x03,
+	DW_EH_PE_udata8 = 0x04,
+	DW_EH_PE_sleb128 = 0x09,
+	DW_EH_PE_sdata2 = 0x0a,
+	DW_EH_PE_sdata4 = 0x0b,
+	DW_EH_PE_sdata8 = 0x0c,
+	DW_EH_PE_pcrel = 0x10,
+	DW_EH_PE_datarel = 0x30,
+	DW_EH_PE_indirect = 0x80,
+	DW_EH_PE_omit = 0xff,
+};
+
+
+// Bounds-checked little reader over mapped `.eh_frame` data
+struct Cursor {
+	const uint8_t *at;
+	const uint8_t *end;
+
+	bool has(size_t size) const { return at && size <= static_cast<size_t>(end - at); }
+
+	template <typename T>
+	bool read(T *out) {
+		if (!has(sizeof(T))) {
+			return false;
+		}
+		memcpy(out, at, sizeof(T));
+		at += sizeof(T);
+		return true;
+	}
+
+	bool uleb(uint64_t *out) {
+		uint64_t value = 0;
+		for (int shift = 0; at < end && shift < 64; shift += 7) {
+			uint8_t byte = *at++;
+			value |= uint64_t(byte & 0x7f) << shift;
+			if (!(byte & 0x80)) {
+				*out = value;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool sleb(int64_t *out) {
+		uint64_t value = 0;
+		int shift = 0;
+		uint8_t byte = 0x80;
+		while (at < end && shift < 64 && (byte & 0x80)) {
+			byte = *at++;
+			value |= uint64_t(byte & 0x7f) << shift;
+			shift += 7;
+		}
+		if (byte & 0x80) {
+			return false;
+		}
+		if (shift < 64 && (byte & 0x40)) {
+			value |= ~uint64_t(0) << shift;
+		}
+		*out = static_cast<int64_t>(value);
+		return true;
+	}
+
+	bool encoded(uint8_t encoding, uintptr_t dataBase, uintptr_t *out) {
+		if (encoding == DW_EH_PE_omit) {
+			return false;
+		}
+		uintptr_t start = reinterpret_cast<uintptr_t>(at);
+		uintptr_t value = 0;
+		bool ok = false;
+		switch (encoding & 0x0f) {
+			case DW_EH_PE_absptr: { ok = read(&value); break; }
+			case DW_EH_PE_uleb128: { uint64_t v; ok = uleb(&v); value = v; break; }
+			case DW_EH_PE_udata2: { uint16_t v; ok = read(&v); value = v; break; }
+			case DW_EH_PE_udata4: { uint32_t v; ok = read(&v); value = v; break; }
+			case DW_EH_PE_udata8: { uint64_t v; ok = read(&v); value = v; break; }
+			case DW_EH_PE_sleb128: { int64_t v; ok = sleb(&v); value = v; break; }
+			case DW_EH_PE_sdata2: { int16_t v; ok = read(&v); value = v; break; }
+			case DW_EH_PE_sdata4: { int32_t v; ok = read(&v); value = v; break; }
+			case DW_EH_PE_sdata8: { int64_t v; ok = read(&v); value = v; break; }
+			default: return false;
+		}
+		if (!ok) {
+			return false;
+		}
+		switch (encoding & 0x70) {
+			case 0: break;
+			case DW_EH_PE_pcrel: { value += start; break; }
+			case DW_EH_PE_datarel: { value += dataBase; break; }
+			default: return false;
+		}
+		if (encoding & DW_EH_PE_indirect) {
+			return readMemory(value, out);
+		}
+		*out = value;
+		return true;
+	}
+};
+
+
+DBG_EXPORT bool readUnwindTable(uintptr_t header, UnwindTable *table) {
+	table->header = header;
+	table->entries = nullptr;
+	table->count = 0;
+	if (!header) {
+		return false;
+	}
+
+	// version, eh_frame_ptr_enc, fde_count_enc, table_enc
+	const uint8_t *bytes = reinterpret_cast<const uint8_t*>(header);
+	if (bytes[0] != 1) {
+		return false;
+	}
+	// Only the search table layout every toolchain emits is supported
+	if (bytes[3] != (DW_EH_PE_datarel | DW_EH_PE_sdata4)) {
+		return false;
+	}
+
+	Cursor cursor = { bytes + 4, bytes + 4 + 2 * sizeof(uint64_t) };
+	uintptr_t ehFrame = 0;
+	uintptr_t count = 0;
+	if (
+		!cursor.encoded(bytes[1], header, &ehFrame) ||
+		!cursor.encoded(bytes[2], header, &count) || !count
+	) {
+		return false;
+	}
+
+	table->entries = reinterpret_cast<const int32_t*>(cursor.at);
+	table->count = count;
+	return true;
+}
+
+
+#if defined(__linux__) && (defined(__x86_64__) || defined(__aarch64__))
+
+// DWARF register numbers
+#if defined(__x86_64__)
+constexpr size_t REG_COUNT = 17; // rax..r15, then the return address column
+constexpr size_t SP_REG = 7;
+constexpr size_t FP_REG = 6;
+#else
+constexpr size_t REG_COUNT = 32; // x0..x30, sp
+constexpr size_t SP_REG = 31;
+constexpr size_t FP_REG = 29;
+#endif
+
+// Keep the walk bounded even on corrupt unwind data
+constexpr size_t MAX_CFA_INSTRUCTIONS = 1024;
+constexpr size_t MAX_EXPRESSION_STEPS = 64;
+constexpr size_t EXPRESSION_STACK_SIZE = 16;
+constexpr size_t STATE_STACK_SIZE = 8;
+
+enum RuleType : uint8_t {
+	RULE_SAME = 0,
+	RULE_UNDEFINED,
+	RULE_OFFSET,
+	RULE_VAL_OFFSET,
+	RULE_REGISTER,
+	RULE_EXPRESSION,
+	RULE_VAL_EXPRESSION,
+};
+
+struct Rule {
+	RuleType type;
+	int64_t value; // offset, register number or expression address
+};
+
+struct Row {
+	Rule rules[REG_COUNT + 1]; // the extra slot is the return address column, if separate
+	uint64_t cfaRegister;
+	int64_t cfaOffset;
+	const uint8_t *cfaExpression;
+	bool raSigned; // aarch64 pointer authentication
+};
+
+struct Registers {
+	uintptr_t values[REG_COUNT + 1];
+	uint64_t valid;
+	uintptr_t pc;
+};
+
+struct Cie {
+	uint64_t codeAlign;
+	int64_t dataAlign;
+	uint64_t raRegister;
+	uint8_t fdeEncoding;
+	bool hasAugmentation;
+	bool isSignalFrame;
+	const uint8_t *instructions;
+	const uint8_t *end;
+};
+
+struct StackBounds {
+	uintptr_t low; // the interrupted SP
+	uintptr_t high; // top of the registered thread stack, 0 if unknown
+};
+
+// Working memory lives here, not on the (small) alternate signal stack
+static struct {
+	Row row;
+	Row initial;
+	Row saved[STATE_STACK_SIZE];
+	Registers next;
+	StackBounds bounds;
+} _scratch;
+
+
+// Stack memory between the interrupted SP and the stack top is mapped, and read directly.
+// Anything else goes through the probe.
+static inline bool _readStack(uintptr_t address, void *out, size_t size) {
+	const StackBounds &bounds = _scratch.bounds;
+	if (bounds.high && address >= bounds.low && address <= bounds.high - size) {
+		memcpy(out, reinterpret_cast<const void*>(address), size);
+		return true;
+	}
+	return readMemory(address, out, size);
+}
+
+template <typename T>
+static inline bool _readStack(uintptr_t address, T *out) {
+	return _readStack(address, out, sizeof(T));
+}
+
+
+static inline size_t _column(uint64_t reg, const Cie &cie) {
+	// The return address may be a real register (aarch64 x30) or a separate column (x86_64)
+	if (reg == cie.raRegister && reg >= REG_COUNT) {
+		return REG_COUNT;
+	}
+	return reg < REG_COUNT ? static_cast<size_t>(reg) : SIZE_MAX;
+}
+
+
+static bool _evaluate(
+	const uint8_t *expression, const Registers &regs, bool pushCfa, uintptr_t cfa, uintptr_t *out
+) {
+	Cursor cursor = { expression, expression + 16 };
+	uint64_t length = 0;
+	if (!cursor.uleb(&length)) {
+		return false;
+	}
+	cursor.end = cursor.at + length;
+
+	uintptr_t stack[EXPRESSION_STACK_SIZE];
+	size_t depth = 0;
+	if (pushCfa) {
+		stack[depth++] = cfa;
+	}
+
+	#define NEED(N) if (depth < (N)) { return false; }
+	#define PUSH(V) { \
+		uintptr_t pushed = (V); \
+		if (depth >= EXPRESSION_STACK_SIZE) { return false; } \
+		stack[depth++] = pushed; \
+	}
+	#define BINARY(EXPR) { NEED(2); uintptr_t b = stack[--depth]; uintptr_t a = stack[--depth]; PUSH(EXPR); break; }
+
+	for (size_t steps = 0; cursor.at < cursor.end; steps++) {
+		if (steps >= MAX_EXPRESSION_STEPS) {
+			return false;
+		}
+		uint8_t op = *cursor.at++;
+		if (op >= 0x30 && op <= 0x4f) { // DW_OP_lit*
+			PUSH(op - 0x30);
+			continue;
+		}
+		if (op >= 0x50 && op <= 0x6f) { // DW_OP_reg*
+			size_t reg = op - 0x50;
+			if (reg >= REG_COUNT || !(regs.valid & (uint64_t(1) << reg))) {
+				return false;
+			}
+			PUSH(regs.values[reg]);
+			continue;
+		}
+		if ((op >= 0x70 && op <= 0x8f) || op == 0x92) { // DW_OP_breg*, DW_OP_bregx
+			uint64_t reg = op - 0x70;
+			int64_t offset = 0;
+			if ((op == 0x92 && !cursor.uleb(&reg)) || !cursor.sleb(&offset)) {
+				return false;
+			}
+			if (reg >= REG_COUNT || !(regs.valid & (uint64_t(1) << reg))) {
+				return false;
+			}
+			PUSH(regs.values[reg] + offset);
+			continue;
+		}
+
+		switch (op) {
+			case 0x06: { // DW_OP_deref
+				NEED(1);
+				if (!_readStack(stack[depth - 1], &stack[depth - 1])) {
+					return false;
+				}
+				break;
+			}
+			case 0x08: { uint8_t v; if (!cursor.read(&v)) { return false; } PUSH(v); break; }
+			case 0x09: { int8_t v; if (!cursor.read(&v)) { return false; } PUSH(v); break; }
+			case 0x0a: { uint16_t v; if (!cursor.read(&v)) { return false; } PUSH(v); break; }
+			case 0x0b: { int16_t v; if (!cursor.read(&v)) { return false; } PUSH(v); break; }
+			case 0x0c: { uint32_t v; if (!cursor.read(&v)) { return false; } PUSH(v); break; }
+			case 0x0d: { int32_t v; if (!cursor.read(&v)) { return false; } PUSH(v); break; }
+			case 0x0e: { uint64_t v; if (!cursor.read(&v)) { return false; } PUSH(v); break; }
+			case 0x0f: { int64_t v; if (!cursor.read(&v)) { return false; } PUSH(v); break; }
+			case 0x10: { uint64_t v; if (!cursor.uleb(&v)) { return false; } PUSH(v); break; }
+			case 0x11: { int64_t v; if (!cursor.sleb(&v)) { return false; } PUSH(v); break; }
+			case 0x12: { NEED(1); PUSH(stack[depth - 1]); break; } // DW_OP_dup
+			case 0x13: { NEED(1); depth--; break; } // DW_OP_drop
+			case 0x14: { NEED(2); PUSH(stack[depth - 2]); break; } // DW_OP_over
+			case 0x16: { // DW_OP_swap
+				NEED(2);
+				uintptr_t top = stack[depth - 1];
+				stack[depth - 1] = stack[depth - 2];
+				stack[depth - 2] = top;
+				break;
+			}
+			case 0x1a: BINARY(a & b) // DW_OP_and
+			case 0x1c: BINARY(a - b) // DW_OP_minus
+			case 0x1e: BINARY(a * b) // DW_OP_mul
+			case 0x21: BINARY(a | b) // DW_OP_or
+			case 0x22: BINARY(a + b) // DW_OP_plus
+			case 0x24: BINARY(a << b) // DW_OP_shl
+			case 0x25: BINARY(a >> b) // DW_OP_shr
+			case 0x27: BINARY(a ^ b) // DW_OP_xor
+			case 0x29: BINARY(a == b) // DW_OP_eq
+			case 0x2a: BINARY(intptr_t(a) >= intptr_t(b)) // DW_OP_ge
+			case 0x2b: BINARY(intptr_t(a) > intptr_t(b)) // DW_OP_gt
+			case 0x2c: BINARY(intptr_t(a) <= intptr_t(b)) // DW_OP_le
+			case 0x2d: BINARY(intptr_t(a) < intptr_t(b)) // DW_OP_lt
+			case 0x2e: BINARY(a != b) // DW_OP_ne
+			case 0x23: { // DW_OP_plus_uconst
+				uint64_t v;
+				NEED(1);
+				if (!cursor.uleb(&v)) {
+					return false;
+				}
+				stack[depth - 1] += v;
+				break;
+			}
+			case 0x28: // DW_OP_bra
+			case 0x2f: { // DW_OP_skip
+				int16_t skip;
+				if (!cursor.read(&skip)) {
+					return false;
+				}
+				bool jump = true;
+				if (op == 0x28) {
+					NEED(1);
+					jump = stack[--depth] != 0;
+				}
+				if (jump) {
+					if (skip < -(cursor.at - expression) || skip > cursor.end - cursor.at) {
+						return false;
+					}
+					cursor.at += skip;
+				}
+				break;
+			}
+			case 0x96: break; // DW_OP_nop
+			default: return false;
+		}
+	}
+
+	#undef NEED
+	#undef PUSH
+	#undef BINARY
+
+	if (!depth) {
+		return false;
+	}
+	*out = stack[depth - 1];
+	return true;
+}
+
+
+// Parse the CIE at `address` (`.eh_frame` data is mapped, it is read directly)
+static bool _readCie(uintptr_t address, Cie *cie) {
+	Cursor cursor = { reinterpret_cast<const uint8_t*>(address), reinterpret_cast<const uint8_t*>(UINTPTR_MAX) };
+	uint32_t length32 = 0;
+	uint64_t length = 0;
+	if (!cursor.read(&length32) || !length32) {
+		return false;
+	}
+	length = length32;
+	if (length32 == 0xffffffff && !cursor.read(&length)) {
+		return false;
+	}
+	cursor.end = cursor.at + length;
+
+	uint32_t id = 0;
+	uint8_t version = 0;
+	if (!cursor.read(&id) || id != 0 || !cursor.read(&version)) {
+		return false;
+	}
+
+	const char *augmentation = reinterpret_cast<const char*>(cursor.at);
+	size_t augmentationLength = strnlen(augmentation, cursor.end - cursor.at);
+	cursor.at += augmentationLength + 1;
+
+	if (augmentation[0] == 'e' && augmentation[1] == 'h') {
+		uintptr_t ignored;
+		if (!cursor.read(&ignored)) {
+			return false;
+		}
+	}
+
+	cie->fdeEncoding = DW_EH_PE_absptr;
+	cie->hasAugmentation = false;
+	cie->isSignalFrame = false;
+	if (!cursor.uleb(&cie->codeAlign) || !cursor.sleb(&cie->dataAlign)) {
+		return false;
+	}
+	if (version == 1) {
+		uint8_t reg;
+		if (!cursor.read(&reg)) {
+			return false;
+		}
+		cie->raRegister = reg;
+	} else if (!cursor.uleb(&cie->raRegister)) {
+		return false;
+	}
+
+	const uint8_t *instructions = nullptr;
+	for (size_t i = 0; i < augmentationLength; i++) {
+		switch (augmentation[i]) {
+			case 'z': {
+				uint64_t dataLength;
+				if (!cursor.uleb(&dataLength) || !cursor.has(dataLength)) {
+					return false;
+				}
+				cie->hasAugmentation = true;
+				instructions = cursor.at + dataLength;
+				break;
+			}
+			case 'R': {
+				if (!cursor.read(&cie->fdeEncoding)) {
+					return false;
+				}
+				break;
+			}
+			case 'L': {
+				uint8_t ignored;
+				if (!cursor.read(&ignored)) {
+					return false;
+				}
+				break;
+			}
+			case 'P': {
+				uint8_t encoding;
+				uintptr_t ignored;
+				if (!cursor.read(&encoding) || !cursor.encoded(encoding & 0x7f, 0, &ignored)) {
+					return false;
+				}
+				break;
+			}
+			case 'S': { cie->isSignalFrame = true; break; }
+			default: break;
+		}
+	}
+
+	cie->instructions = instructions ? instructions : cursor.at;
+	cie->end = cursor.end;
+	return true;
+}
+
+
+// Run CFA instructions until the row covering `target` is built
+static bool _runCfa(
+	const uint8_t *instructions, const uint8_t *end, const Cie &cie,
+	uintptr_t location, uintptr_t target, Row &row
+) {
+	Cursor cursor = { instructions, end };
+	size_t savedCount = 0;
+
+	for (size_t steps = 0; cursor.at < cursor.end && location <= target; steps++) {
+		if (steps >= MAX_CFA_INSTRUCTIONS) {
+			return false;
+		}
+		uint8_t op = *cursor.at++;
+		uint8_t low = op & 0x3f;
+		uint64_t reg = 0;
+		uint64_t operand = 0;
+		int64_t signedOperand = 0;
+
+		switch (op & 0xc0) {
+			case 0x40: { // DW_CFA_advance_loc
+				location += low * cie.codeAlign;
+				continue;
+			}
+			case 0x80: { // DW_CFA_offset
+				if (!cursor.uleb(&operand)) {
+					return false;
+				}
+				size_t column = _column(low, cie);
+				if (column != SIZE_MAX) {
+					row.rules[column] = { RULE_OFFSET, static_cast<int64_t>(operand) * cie.dataAlign };
+				}
+				continue;
+			}
+			case 0xc0: { // DW_CFA_restore
+				size_t column = _column(low, cie);
+				if (column != SIZE_MAX) {
+					row.rules[column] = _scratch.initial.rules[column];
+				}
+				continue;
+			}
+			default: break;
+		}
+
+		switch (op) {
+			case 0x00: break; // DW_CFA_nop
+			case 0x01: { // DW_CFA_set_loc
+				uintptr_t value;
+				if (!cursor.encoded(cie.fdeEncoding, 0, &value)) {
+					return false;
+				}
+				location = value;
+				break;
+			}
+			case 0x02: { uint8_t d; if (!cursor.read(&d)) { return false; } location += d * cie.codeAlign; break; }
+			case 0x03: { uint16_t d; if (!cursor.read(&d)) { return false; } location += d * cie.codeAlign; break; }
+			case 0x04: { uint32_t d; if (!cursor.read(&d)) { return false; } location += d * cie.codeAlign; break; }
+			case 0x05: // DW_CFA_offset_extended
+			case 0x11: // DW_CFA_offset_extended_sf
+			case 0x14: // DW_CFA_val_offset
+			case 0x15: // DW_CFA_val_offset_sf
+			case 0x2f: { // DW_CFA_GNU_negative_offset_extended
+				if (!cursor.uleb(&reg)) {
+					return false;
+				}
+				if (op == 0x11 || op == 0x15) {
+					if (!cursor.sleb(&signedOperand)) {
+						return false;
+					}
+				} else {
+					if (!cursor.uleb(&operand)) {
+						return false;
+					}
+					signedOperand = static_cast<int64_t>(operand);
+				}
+				signedOperand = op == 0x2f ? -signedOperand * cie.dataAlign : signedOperand * cie.dataAlign;
+				size_t column = _column(reg, cie);
+				if (column != SIZE_MAX) {
+					RuleType type = (op == 0x14 || op == 0x15) ? RULE_VAL_OFFSET : RULE_OFFSET;
+					row.rules[column] = { type, signedOperand };
+				}
+				break;
+			}
+			case 0x06: // DW_CFA_restore_extended
+			case 0x07: // DW_CFA_undefined
+			case 0x08: { // DW_CFA_same_value
+				if (!cursor.uleb(&reg)) {
+					return false;
+				}
+				size_t column = _column(reg, cie);
+				if (column == SIZE_MAX) {
+					break;
+				}
+				if (op == 0x06) {
+					row.rules[column] = _scratch.initial.rules[column];
+				} else {
+					row.rules[column] = { op == 0x07 ? RULE_UNDEFINED : RULE_SAME, 0 };
+				}
+				break;
+			}
+			case 0x09: { // DW_CFA_register
+				if (!cursor.uleb(&reg) || !cursor.uleb(&operand)) {
+					return false;
+				}
+				size_t column = _column(reg, cie);
+				if (column != SIZE_MAX) {
+					row.rules[column] = { RULE_REGISTER, static_cast<int64_t>(operand) };
+				}
+				break;
+			}
+			case 0x0a: { // DW_CFA_remember_state
+				if (savedCount >= STATE_STACK_SIZE) {
+					return false;
+				}
+				_scratch.saved[savedCount++] = row;
+				break;
+			}
+			case 0x0b: { // DW_CFA_restore_state
+				if (!savedCount) {
+					return false;
+				}
+				row = _scratch.saved[--savedCount];
+				break;
+			}
+			case 0x0c: // DW_CFA_def_cfa
+			case 0x12: { // DW_CFA_def_cfa_sf
+				if (!cursor.uleb(&reg)) {
+					return false;
+				}
+				if (op == 0x12) {
+					if (!cursor.sleb(&signedOperand)) {
+						return false;
+					}
+					signedOperand *= cie.dataAlign;
+				} else {
+					if (!cursor.uleb(&operand)) {
+						return false;
+					}
+					signedOperand = static_cast<int64_t>(operand);
+				}
+				row.cfaRegister = reg;
+				row.cfaOffset = signedOperand;
+				row.cfaExpression = nullptr;
+				break;
+			}
+			case 0x0d: { // DW_CFA_def_cfa_register
+				if (!cursor.uleb(&reg)) {
+					return false;
+				}
+				row.cfaRegister = reg;
+				row.cfaExpression = nullptr;
+				break;
+			}
+			case 0x0e: { // DW_CFA_def_cfa_offset
+				if (!cursor.uleb(&operand)) {
+					return false;
+				}
+				row.cfaOffset = static_cast<int64_t>(operand);
+				break;
+			}
+			case 0x13: { // DW_CFA_def_cfa_offset_sf
+				if (!cursor.sleb(&signedOperand)) {
+					return false;
+				}
+				row.cfaOffset = signedOperand * cie.dataAlign;
+				break;
+			}
+			case 0x0f: { // DW_CFA_def_cfa_expression
+				row.cfaExpression = cursor.at;
+				if (!cursor.uleb(&operand) || !cursor.has(operand)) {
+					return false;
+				}
+				cursor.at += operand;
+				break;
+			}
+			case 0x10: // DW_CFA_expression
+			case 0x16: { // DW_CFA_val_expression
+				if (!cursor.uleb(&reg)) {
+					return false;
+				}
+				const uint8_t *expression = cursor.at;
+				if (!cursor.uleb(&operand) || !cursor.has(operand)) {
+					return false;
+				}
+				cursor.at += operand;
+				size_t column = _column(reg, cie);
+				if (column != SIZE_MAX) {
+					RuleType type = op == 0x10 ? RULE_EXPRESSION : RULE_VAL_EXPRESSION;
+					row.rules[column] = { type, static_cast<int64_t>(reinterpret_cast<uintptr_t>(expression)) };
+				}
+				break;
+			}
+			case 0x2d: { // DW_CFA_AARCH64_negate_ra_state (DW_CFA_GNU_window_save elsewhere)
+				row.raSigned = !row.raSigned;
+				break;
+			}
+			case 0x2e: { // DW_CFA_GNU_args_size
+				if (!cursor.uleb(&operand)) {
+					return false;
+				}
+				break;
+			}
+			default: return false;
+		}
+	}
+	return true;
+}
+
+
+// Find the FDE covering `target` through the module's search table
+static bool _findFde(
+	const UnwindTable &table, uintptr_t target, Cie *cie, const uint8_t **instructions,
+	const uint8_t **end, uintptr_t *start
+) {
+	if (!table.entries || !table.count) {
+		return false;
+	}
+
+	size_t low = 0;
+	size_t high = table.count;
+	while (low < high) {
+		size_t mid = low + (high - low) / 2;
+		if (table.header + table.entries[mid * 2] <= target) {
+			low = mid + 1;
+		} else {
+			high = mid;
+		}
+	}
+	if (!low) {
+		return false;
+	}
+
+	uintptr_t fde = table.header + table.entries[(low - 1) * 2 + 1];
+	Cursor cursor = { reinterpret_cast<const uint8_t*>(fde), reinterpret_cast<const uint8_t*>(UINTPTR_MAX) };
+	uint32_t length32 = 0;
+	uint64_t length = 0;
+	if (!cursor.read(&length32) || !length32) {
+		return false;
+	}
+	length = length32;
+	if (length32 == 0xffffffff && !cursor.read(&length)) {
+		return false;
+	}
+	cursor.end = cursor.at + length;
+
+	uintptr_t cieField = reinterpret_cast<uintptr_t>(cursor.at);
+	uint32_t cieOffset = 0;
+	if (!cursor.read(&cieOffset) || !cieOffset || !_readCie(cieField - cieOffset, cie)) {
+		return false;
+	}
+
+	uintptr_t range = 0;
+	if (
+		!cursor.encoded(cie->fdeEncoding, 0, start) ||
+		!cursor.encoded(cie->fdeEncoding & 0x0f, 0, &range) ||
+		target < *start || target - *start >= range
+	) {
+		return false;
+	}
+
+	if (cie->hasAugmentation) {
+		uint64_t dataLength;
+		if (!cursor.uleb(&dataLength) || !cursor.has(dataLength)) {
+			return false;
+		}
+		cursor.at += dataLength;
+	}
+
+	*instructions = cursor.at;
+	*end = cursor.end;
+	return true;
+}
+
+
+static inline bool _isValid(const Registers &regs, size_t reg) {
+	return reg <= REG_COUNT && (regs.valid & (uint64_t(1) << reg));
+}
+
+
+// One CFI step: compute the caller's registers from the current frame's row
+static bool _stepCfi(const Registers &regs, bool isCaller, Registers &next, bool *isLast) {
+	const ModuleInfo *module = findModule(isCaller ? regs.pc - 1 : regs.pc);
+	if (!module) {
+		return false;
+	}
+
+	Cie cie;
+	const uint8_t *instructions = nullptr;
+	const uint8_t *end = nullptr;
+	uintptr_t start = 0;
+	uintptr_t target = isCaller ? regs.pc - 1 : regs.pc;
+	if (!_findFde(module->unwind, target, &cie, &instructions, &end, &start)) {
+		return false;
+	}
+	if (cie.isSignalFrame && isCaller) {
+		// Signal trampolines hold the exact interrupted PC
+		target = regs.pc;
+	}
+
+	Row &row = _scratch.row;
+	memset(&row, 0, sizeof(row));
+	if (!_runCfa(cie.instructions, cie.end, cie, start, UINTPTR_MAX, row)) {
+		return false;
+	}
+	_scratch.initial = row;
+	if (!_runCfa(instructions, end, cie, start, target, row)) {
+		return false;
+	}
+
+	uintptr_t cfa = 0;
+	if (row.cfaExpression) {
+		if (!_evaluate(row.cfaExpression, regs, false, 0, &cfa)) {
+			return false;
+		}
+	} else {
+		if (!_isValid(regs, row.cfaRegister)) {
+			return false;
+		}
+		cfa = regs.values[row.cfaRegister] + row.cfaOffset;
+	}
+	if (_scratch.bounds.high && cfa > _scratch.bounds.high) {
+		return false;
+	}
+
+	next = regs;
+	size_t raColumn = _column(cie.raRegister, cie);
+	if (raColumn == SIZE_MAX) {
+		return false;
+	}
+
+	for (size_t reg = 0; reg <= REG_COUNT; reg++) {
+		const Rule &rule = row.rules[reg];
+		uintptr_t value = 0;
+		switch (rule.type) {
+			case RULE_SAME: continue;
+			case RULE_UNDEFINED: {
+				next.valid &= ~(uint64_t(1) << reg);
+				continue;
+			}
+			case RULE_OFFSET: {
+				if (!_readStack(cfa + rule.value, &value)) {
+					return false;
+				}
+				break;
+			}
+			case RULE_VAL_OFFSET: { value = cfa + rule.value; break; }
+			case RULE_REGISTER: {
+				if (!_isValid(regs, static_cast<size_t>(rule.value))) {
+					return false;
+				}
+				value = regs.values[rule.value];
+				break;
+			}
+			case RULE_EXPRESSION:
+			case RULE_VAL_EXPRESSION: {
+				const uint8_t *expression = reinterpret_cast<const uint8_t*>(rule.value);
+				if (!_evaluate(expression, regs, true, cfa, &value)) {
+					return false;
+				}
+				if (rule.type == RULE_EXPRESSION && !_readStack(value, &value)) {
+					return false;
+				}
+				break;
+			}
+		}
+		next.values[reg] = value;
+		next.valid |= uint64_t(1) << reg;
+	}
+
+	// The outermost frame marks its return address undefined
+	if (!_isValid(next, raColumn)) {
+		*isLast = true;
+		return true;
+	}
+
+	next.pc = next.values[raColumn];
+#if defined(__aarch64__)
+	if (row.raSigned) {
+		// Strip the pointer authentication code, user space addresses fit in 48 bits
+		next.pc &= (uintptr_t(1) << 48) - 1;
+	}
+#endif
+	next.values[SP_REG] = cfa;
+	next.valid |= uint64_t(1) << SP_REG;
+	return true;
+}
+
+
+// Frame pointer step: [fp] is the caller's fp, [fp + 8] the return address
+static bool _stepFramePointer(const Registers &regs, Registers &next) {
+	if (!_isValid(regs, FP_REG) || !_isValid(regs, SP_REG)) {
+		return false;
+	}
+	uintptr_t record[2];
+	uintptr_t fp = regs.values[FP_REG];
+	if (fp < regs.values[SP_REG] || (fp & (sizeof(uintptr_t) - 1))) {
+		return false;
+	}
+	// With known bounds, a frame pointer off the stack means there is no chain here
+	const StackBounds &bounds = _scratch.bounds;
+	if (bounds.high && fp > bounds.high - sizeof(record)) {
+		return false;
+	}
+	if (!_readStack(fp, record, sizeof(record)) || !record[1]) {
+		return false;
+	}
+	next = regs;
+	next.values[FP_REG] = record[0];
+	next.values[SP_REG] = fp + sizeof(record);
+	next.pc = record[1];
+#if defined(__aarch64__)
+	next.values[30] = record[1];
+#endif
+	return true;
+}
+
+
+// A call through a bad pointer faults before the callee sets up anything
+static bool _stepBadCall(const Registers &regs, Registers &next) {
+	uint8_t probe;
+	if (readMemory(regs.pc, &probe)) {
+		return false;
+	}
+	next = regs;
+#if defined(__x86_64__)
+	// The return address was just pushed
+	if (!_readStack(regs.values[SP_REG], &next.pc)) {
+		return false;
+	}
+	next.values[SP_REG] += sizeof(uintptr_t);
+#else
+	// The return address is still in the link register
+	if (!_isValid(regs, 30)) {
+		return false;
+	}
+	next.pc = regs.values[30];
+#endif
+	return true;
+}
+
+
+static bool _loadContext(void *context, Registers &regs) {
+	if (!context) {
+		return false;
+	}
+	const ucontext_t *uc = static_cast<const ucontext_t*>(context);
+	memset(&regs, 0, sizeof(regs));
+
+#if defined(__x86_64__)
+	static const int gregs[REG_COUNT - 1] = {
+		REG_RAX, REG_RDX, REG_RCX, REG_RBX, REG_RSI, REG_RDI, REG_RBP, REG_RSP,
+		REG_R8, REG_R9, REG_R10, REG_R11, REG_R12, REG_R13, REG_R14, REG_R15,
+	};
+	for (size_t i = 0; i < REG_COUNT - 1; i++) {
+		regs.values[i] = static_cast<uintptr_t>(uc->uc_mcontext.gregs[gregs[i]]);
+	}
+	regs.pc = static_cast<uintptr_t>(uc->uc_mcontext.gregs[REG_RIP]);
+	regs.values[REG_COUNT - 1] = regs.pc;
+	regs.valid = (uint64_t(1) << REG_COUNT) - 1;
+#else
+	for (size_t i = 0; i < 31; i++) {
+		regs.values[i] = static_cast<uintptr_t>(uc->uc_mcontext.regs[i]);
+	}
+	regs.values[SP_REG] = static_cast<uintptr_t>(uc->uc_mcontext.sp);
+	regs.pc = static_cast<uintptr_t>(uc->uc_mcontext.pc);
+	regs.valid = (uint64_t(1) << REG_COUNT) - 1;
+#endif
+	return true;
+}
+
+
+DBG_EXPORT size_t unwindStack(void *context, void **frames, size_t maxFrames, UnwindMethod method) {
+	Registers regs;
+	if (!_loadContext(context, regs)) {
+		return 0;
+	}
+
+	uintptr_t sp = regs.values[SP_REG];
+	_scratch.bounds = { sp, 0 };
+	ThreadInfo thread;
+	if (findCurrentThread(&thread) && sp >= thread.stackLow && sp < thread.stackHigh) {
+		_scratch.bounds.high = thread.stackHigh;
+	}
+
+	size_t count = 0;
+	while (count < maxFrames && regs.pc) {
+		frames[count++] = reinterpret_cast<void*>(regs.pc);
+
+		Registers &next = _scratch.next;
+		bool isCaller = count > 1;
+		bool isLast = false;
+		bool stepped = false;
+		// The interrupted frame may be in a prologue, or a leaf with no frame record:
+		// it is always unwound with CFI, if there is any
+		if (method == UNWIND_FRAME_POINTERS && isCaller) {
+			stepped = _stepFramePointer(regs, next);
+		}
+		if (!stepped) {
+			stepped = _stepCfi(regs, isCaller, next, &isLast);
+			if (isLast) {
+				break;
+			}
+		}
+		if (!stepped) {
+			stepped = (
+				(!isCaller && _stepBadCall(regs, next)) ||
+				(method == UNWIND_CFI && _stepFramePointer(regs, next))
+			);
+		}
+		// The stack grows down: callers never sit below their callees
+		if (
+			!stepped || next.values[SP_REG] < regs.values[SP_REG] ||
+			(next.values[SP_REG] == regs.values[SP_REG] && next.pc == regs.pc)
+		) {
+			break;
+		}
+		regs = next;
+	}
+	return count;
+}
+
+#else
+
+DBG_EXPORT size_t unwindStack(void*, void**, size_t, UnwindMethod) {
+	return 0;
+}
+
+#endif
+
+
+// TID of the thread using the unwinder, 0 if free
+static std::atomic<int> _unwinderOwner(0);
+
+DBG_EXPORT bool lockUnwinder(int maxSpins) {
+	int tid = getCurrentThreadId();
+	for (int spins = 0; ; spins++) {
+		int expected = 0;
+		if (_unwinderOwner.compare_exchange_strong(expected, tid)) {
+			return true;
+		}
+		// Held further up this very stack: waiting would never end
+		if (expected == tid || spins >= maxSpins) {
+			return false;
+		}
+#if defined(__linux__)
+		sched_yield();
+#endif
+	}
+}
+
+DBG_EXPORT void unlockUnwinder() {
+	_unwinderOwner.store(0);
+}
+
+} // namespace segfault
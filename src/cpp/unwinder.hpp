@@ -0,0 +1,50 @@
+#ifndef _UNWINDER_HPP_
+#define _UNWINDER_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#define DBG_EXPORT __declspec(dllexport)
+#else
+#define DBG_EXPORT
+#endif
+
+
+namespace segfault {
+	// Binary search table of a module's `.eh_frame_hdr`: FDE start and FDE address
+	// pairs, both relative to `header`
+	struct UnwindTable {
+		uintptr_t header;
+		const int32_t *entries;
+		size_t count;
+	};
+
+	// Parse the `.eh_frame_hdr` mapped at `header`. Returns false if there is no
+	// usable search table. Call in normal context.
+	DBG_EXPORT bool readUnwindTable(uintptr_t header, UnwindTable *table);
+
+	enum UnwindMethod {
+		// DWARF CFI, and the frame pointer chain where there is none (e.g. JIT code)
+		UNWIND_CFI = 0,
+		// Frame pointer chain, validated against the thread's stack bounds, and
+		// DWARF CFI where the chain is broken. Fast, but needs `-fno-omit-frame-pointer`.
+		UNWIND_FRAME_POINTERS,
+	};
+
+	// Walk the stack of the interrupted code, starting from the `ucontext_t` registers.
+	// Fills return addresses, crash PC first, and returns their count; 0 if unsupported
+	// on this platform. Signal-safe, no allocation.
+	DBG_EXPORT size_t unwindStack(
+		void *context, void **frames, size_t maxFrames, UnwindMethod method
+	);
+
+	// The unwinder has static scratch memory and reads through a shared probe pipe, so
+	// signal handlers on different threads take turns. Waits at most `maxSpins` yields,
+	// returns false if the unwinder is still busy, or held by the calling thread itself.
+	// Signal-safe.
+	DBG_EXPORT bool lockUnwinder(int maxSpins);
+	DBG_EXPORT void unlockUnwinder();
+}
+
+#endif /* _UNWINDER_HPP_ */
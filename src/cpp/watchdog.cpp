@@ -0,0 +1,207 @@
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#ifdef __linux__
+#include <signal.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+#include "watchdog.hpp"
+#include "handler-stats.hpp"
+#include "unwinder.hpp"
+
+
+namespace segfault {
+
+#ifdef __linux__
+constexpr size_t MAX_STALL_FRAMES = 256;
+// Real-time signal that asks the stalled thread for its stack. glibc keeps the first
+// few to itself, and SIGRTMIN accounts for that.
+constexpr int STALL_SIGNAL_OFFSET = 4;
+// The stalled thread may block the signal, then the stall is reported without a stack
+constexpr auto CAPTURE_TIMEOUT = std::chrono::milliseconds(500);
+constexpr auto MIN_CHECK_INTERVAL = std::chrono::milliseconds(10);
+// The handler waits this many spins at most for a profiler sample on another thread
+constexpr int UNWINDER_MAX_SPINS = 10000;
+
+
+static std::thread _thread;
+static std::mutex _mutex;
+static std::condition_variable _wake;
+static bool _isStopping = false;
+
+static std::atomic<bool> _isRunning(false);
+static std::atomic<uint64_t> _lastBeatNs(0);
+static std::atomic<uint64_t> _stalls(0);
+static WatchdogOptions _options;
+static StallReporter _report = nullptr;
+static int _tid = 0;
+
+// Installed once and kept: a capture request may still be pending when the watchdog stops
+static bool _isHandlerInstalled = false;
+static int _stallSignal = 0;
+
+// Set by the watchdog, taken by the handler: a capture is only run when requested, so
+// a late signal can't overwrite the frames while they are reported
+static std::atomic<bool> _isCaptureRequested(false);
+static std::atomic<bool> _isCaptureDone(false);
+static void *_stallFrames[MAX_STALL_FRAMES];
+static size_t _stallFrameCount = 0;
+
+
+static void _handleStallSignal(int, siginfo_t *info, void *context) {
+	int savedErrno = errno;
+	// Only our own `tgkill()`, and only once per request
+	if (info->si_code != SI_TKILL || info->si_pid != getpid() || !_isCaptureRequested.exchange(false)) {
+		errno = savedErrno;
+		return;
+	}
+	size_t count = 0;
+	if (lockUnwinder(UNWINDER_MAX_SPINS)) {
+		count = unwindStack(
+			context, _stallFrames, _options.maxFrames, static_cast<UnwindMethod>(_options.unwindMethod)
+		);
+		unlockUnwinder();
+	}
+	_stallFrameCount = count;
+	_isCaptureDone.store(true);
+	errno = savedErrno;
+}
+
+
+// Interrupt the stalled thread and wait for its stack. Returns the frame count.
+static size_t _captureStalledStack() {
+	_isCaptureDone.store(false);
+	_isCaptureRequested.store(true);
+	if (syscall(SYS_tgkill, getpid(), _tid, _stallSignal) != 0) {
+		_isCaptureRequested.store(false);
+		return 0;
+	}
+
+	auto deadline = std::chrono::steady_clock::now() + CAPTURE_TIMEOUT;
+	while (!_isCaptureDone.load()) {
+		// Withdraw the request, unless the handler has already taken it
+		if (std::chrono::steady_clock::now() > deadline && _isCaptureRequested.exchange(false)) {
+			return 0;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	return _stallFrameCount;
+}
+
+
+static void _watch() {
+	auto interval = std::chrono::milliseconds(_options.thresholdMs / 4);
+	if (interval < MIN_CHECK_INTERVAL) {
+		interval = MIN_CHECK_INTERVAL;
+	}
+	uint64_t thresholdNs = uint64_t(_options.thresholdMs) * 1000000;
+	uint64_t reportedBeat = 0;
+
+	std::unique_lock<std::mutex> lock(_mutex);
+	while (!_wake.wait_for(lock, interval, [] { return _isStopping; })) {
+		uint64_t lastBeat = _lastBeatNs.load(std::memory_order_relaxed);
+		uint64_t now = getMonotonicNs();
+		// One report per stall: the next one needs a new heartbeat first
+		if (now - lastBeat < thresholdNs || lastBeat == reportedBeat) {
+			continue;
+		}
+		reportedBeat = lastBeat;
+
+		lock.unlock();
+		size_t count = _captureStalledStack();
+		_stalls.fetch_add(1, std::memory_order_relaxed);
+		_report(_tid, now - lastBeat, _stallFrames, count);
+		lock.lock();
+	}
+}
+#endif
+
+
+DBG_EXPORT int startWatchdog(const WatchdogOptions &options, int tid, StallReporter report) {
+#ifdef __linux__
+	if (_isRunning.load()) {
+		return EBUSY;
+	}
+	if (!options.thresholdMs || !options.maxFrames || options.maxFrames > MAX_STALL_FRAMES || !report) {
+		return EINVAL;
+	}
+
+	if (!_isHandlerInstalled) {
+		_stallSignal = SIGRTMIN + STALL_SIGNAL_OFFSET;
+		struct sigaction action;
+		memset(&action, 0, sizeof(action));
+		sigemptyset(&action.sa_mask);
+		action.sa_sigaction = _handleStallSignal;
+		action.sa_flags = SA_SIGINFO | SA_RESTART;
+		if (sigaction(_stallSignal, &action, nullptr) != 0) {
+			return errno;
+		}
+		_isHandlerInstalled = true;
+	}
+
+	_options = options;
+	_report = report;
+	_tid = tid;
+	_stalls.store(0);
+	_isStopping = false;
+	beatWatchdog();
+	_isRunning.store(true);
+	_thread = std::thread(_watch);
+	return 0;
+#else
+	(void)options;
+	(void)tid;
+	(void)report;
+	return ENOTSUP;
+#endif
+}
+
+
+DBG_EXPORT void stopWatchdog() {
+#ifdef __linux__
+	if (!_isRunning.load()) {
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_isStopping = true;
+	}
+	_wake.notify_all();
+	_thread.join();
+	_isRunning.store(false);
+#endif
+}
+
+
+DBG_EXPORT bool isWatchdogRunning() {
+#ifdef __linux__
+	return _isRunning.load();
+#else
+	return false;
+#endif
+}
+
+
+DBG_EXPORT void beatWatchdog() {
+#ifdef __linux__
+	_lastBeatNs.store(getMonotonicNs(), std::memory_order_relaxed);
+#endif
+}
+
+
+DBG_EXPORT uint64_t getStallCount() {
+#ifdef __linux__
+	return _stalls.load();
+#else
+	return 0;
+#endif
+}
+
+} // namespace segfault
@@ -0,0 +1,43 @@
+#ifndef _WATCHDOG_HPP_
+#define _WATCHDOG_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#define DBG_EXPORT __declspec(dllexport)
+#else
+#define DBG_EXPORT
+#endif
+
+
+namespace segfault {
+	struct WatchdogOptions {
+		uint32_t thresholdMs; // heartbeat age that counts as a stall
+		uint32_t maxFrames;
+		int unwindMethod; // see `UnwindMethod`
+	};
+
+	// Called on the watchdog thread, once per stall, with the stack of the stalled thread
+	// (innermost first, none if it could not be captured in time)
+	typedef void (*StallReporter)(int tid, uint64_t stalledNs, void *const *frames, size_t count);
+
+	// Watch the heartbeat of thread `tid` (kernel TID) from a separate thread. When it is
+	// older than the threshold, the thread is interrupted with a real-time signal, its
+	// stack is captured by the signal handler, and passed to `report`. Returns 0 or an
+	// errno value. Linux only, call in normal context.
+	DBG_EXPORT int startWatchdog(const WatchdogOptions &options, int tid, StallReporter report);
+
+	// Join the watchdog thread. Call in normal context.
+	DBG_EXPORT void stopWatchdog();
+
+	DBG_EXPORT bool isWatchdogRunning();
+
+	// The watched thread is alive: a clock read and an atomic store, call as often as needed
+	DBG_EXPORT void beatWatchdog();
+
+	// Stalls reported since `startWatchdog()`
+	DBG_EXPORT uint64_t getStallCount();
+}
+
+#endif /* _WATCHDOG_HPP_ */
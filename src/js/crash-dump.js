@@ -0,0 +1,157 @@
+'use strict';
+
+const { createReader, hex, registerNames, signalNames } = require('./crash-record');
+
+// Crash dumps, as written with `setCrashDump()`. See src/cpp/crash-dump.hpp.
+const MAGIC = 0x44434653;
+const MIN_HEADER_SIZE = 64;
+const STREAM_SIZE = 16;
+const THREAD_SIZE = 32;
+const MODULE_SIZE = 32;
+const STREAM_THREAD = 1;
+const STREAM_MEMORY = 2;
+const STREAM_MODULE = 3;
+const THREAD_CRASHED = 1;
+
+
+const decodeThread = (buffer, read, at, size, arch) => {
+	const registerCount = read.u16(at + 6);
+	const frameCount = read.u32(at + 24);
+	if (THREAD_SIZE + (registerCount + frameCount) * 8 > size) {
+		throw new Error('Crash dump thread exceeds its stream');
+	}
+	const nameEnd = buffer.indexOf(0, at + 8);
+	const name = buffer.toString('utf8', at + 8, nameEnd >= 0 && nameEnd < at + 24 ? nameEnd : at + 24);
+
+	const names = registerNames[arch] || [];
+	const registers = {};
+	const registersAt = at + THREAD_SIZE;
+	for (let i = 0; i < registerCount; i++) {
+		registers[names[i] || `r${i}`] = hex(read.u64(registersAt + i * 8));
+	}
+	const stack = [];
+	const framesAt = registersAt + registerCount * 8;
+	for (let i = 0; i < frameCount; i++) {
+		stack.push(hex(read.u64(framesAt + i * 8)));
+	}
+	return {
+		tid: read.i32(at),
+		name,
+		crashed: Boolean(read.u16(at + 4) & THREAD_CRASHED),
+		registers,
+		stack,
+	};
+};
+
+const decodeModule = (buffer, read, at, size) => {
+	const pathLength = read.u16(at + 24);
+	const buildIdLength = buffer[at + 26];
+	if (MODULE_SIZE + pathLength + buildIdLength > size) {
+		throw new Error('Crash dump module exceeds its stream');
+	}
+	const pathAt = at + MODULE_SIZE;
+	const buildIdAt = pathAt + pathLength;
+	return {
+		path: buffer.toString('utf8', pathAt, buildIdAt),
+		base: hex(read.u64(at)),
+		start: hex(read.u64(at + 8)),
+		end: hex(read.u64(at + 16)),
+		buildId: buffer.toString('hex', buildIdAt, buildIdAt + buildIdLength),
+	};
+};
+
+
+/**
+ * Decode a crash dump file: its threads, memory regions and modules.
+ * @param {Buffer} buffer holds the whole dump
+ * @returns {object} `{ time, signal, signal_name, address, pid, tid, threads, memory, modules, ... }`
+ */
+const decodeCrashDump = (buffer) => {
+	if (buffer.length < MIN_HEADER_SIZE) {
+		throw new Error('Not a crash dump');
+	}
+	const isLittle = buffer.readUInt32LE(0) === MAGIC;
+	if (!isLittle && buffer.readUInt32BE(0) !== MAGIC) {
+		throw new Error('Not a crash dump');
+	}
+	const read = createReader(buffer, 0, isLittle);
+
+	const version = read.u16(4);
+	const headerSize = read.u16(6);
+	if (version < 1 || headerSize < MIN_HEADER_SIZE) {
+		throw new Error(`Unsupported crash dump version ${version}`);
+	}
+	const arch = read.u16(8);
+	const signal = read.u32(12);
+
+	const threads = [];
+	const memory = [];
+	const modules = [];
+	let truncated = false;
+	for (let at = headerSize; at < buffer.length;) {
+		if (at + STREAM_SIZE > buffer.length) {
+			truncated = true;
+			break;
+		}
+		const type = read.u32(at);
+		const size = Number(read.u64(at + 8));
+		const payloadAt = at + STREAM_SIZE;
+		if (payloadAt + size > buffer.length) {
+			truncated = true;
+			break;
+		}
+		if (type === STREAM_THREAD) {
+			threads.push(decodeThread(buffer, read, payloadAt, size, arch));
+		} else if (type === STREAM_MEMORY) {
+			memory.push({
+				address: hex(read.u64(payloadAt)),
+				size: size - 8,
+				data: buffer.subarray(payloadAt + 8, payloadAt + size),
+			});
+		} else if (type === STREAM_MODULE) {
+			modules.push(decodeModule(buffer, read, payloadAt, size));
+		}
+		at = payloadAt + Math.ceil(size / 8) * 8;
+	}
+
+	const dump = {
+		time: new Date(read.i64(24) * 1000).toISOString(),
+		signal,
+		signal_name: signalNames[signal] || String(signal),
+		address: hex(read.u64(32)),
+		pid: read.i32(16),
+		tid: read.i32(20),
+		stackSize: read.u32(40),
+		windowSize: read.u32(44),
+		threads,
+		memory,
+		modules,
+	};
+	if (truncated) {
+		dump.truncated = true;
+	}
+	return dump;
+};
+
+
+/**
+ * Bytes of a decoded dump at `address`, if a memory region holds all of them.
+ * @param {object} dump as returned by `decodeCrashDump()`
+ * @param {string | bigint} address where to read
+ * @param {number} size how many bytes
+ * @returns {Buffer | null} a view into the dump, or `null`
+ */
+const readCrashDumpMemory = (dump, address, size) => {
+	const from = BigInt(address);
+	for (const region of dump.memory) {
+		const start = BigInt(region.address);
+		if (from >= start && from + BigInt(size) <= start + BigInt(region.size)) {
+			const offset = Number(from - start);
+			return region.data.subarray(offset, offset + size);
+		}
+	}
+	return null;
+};
+
+
+module.exports = { decodeCrashDump, readCrashDumpMemory };
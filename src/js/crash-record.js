@@ -0,0 +1,161 @@
+'use strict';
+
+const os = require('node:os');
+
+// Binary crash records, as written with `setCrashRecordFile()`. See src/cpp/crash-record.hpp.
+const MAGIC = 0x52434653;
+const MIN_HEADER_SIZE = 64;
+const FRAME_SIZE = 16;
+const MODULE_SIZE = 32;
+const NO_MODULE = 0xffffffff;
+const FLAG_TRUNCATED = 1;
+
+const registerNames = {
+	1: [
+		'rax', 'rbx', 'rcx', 'rdx', 'rsi', 'rdi', 'rbp', 'rsp',
+		'r8', 'r9', 'r10', 'r11', 'r12', 'r13', 'r14', 'r15', 'rip', 'eflags',
+	],
+	2: [...Array.from({ length: 31 }, (_, i) => `x${i}`), 'sp', 'pc', 'pstate'],
+};
+
+const signalNames = Object.fromEntries(
+	Object.entries(os.constants.signals).map(([name, id]) => [id, name])
+);
+
+
+const createReader = (buffer, offset, isLittle) => ({
+	u16: (at) => (isLittle ? buffer.readUInt16LE(offset + at) : buffer.readUInt16BE(offset + at)),
+	u32: (at) => (isLittle ? buffer.readUInt32LE(offset + at) : buffer.readUInt32BE(offset + at)),
+	i32: (at) => (isLittle ? buffer.readInt32LE(offset + at) : buffer.readInt32BE(offset + at)),
+	i64: (at) => Number(isLittle ? buffer.readBigInt64LE(offset + at) : buffer.readBigInt64BE(offset + at)),
+	u64: (at) => (isLittle ? buffer.readBigUInt64LE(offset + at) : buffer.readBigUInt64BE(offset + at)),
+});
+
+const hex = (value) => `0x${value.toString(16)}`;
+
+
+/**
+ * Length of the record at `offset`, or 0 if there is no complete record there.
+ * Lets a stream of appended records be split without decoding them.
+ */
+const getCrashRecordLength = (buffer, offset = 0) => {
+	if (offset + MIN_HEADER_SIZE > buffer.length) {
+		return 0;
+	}
+	const isLittle = buffer.readUInt32LE(offset) === MAGIC;
+	if (!isLittle && buffer.readUInt32BE(offset) !== MAGIC) {
+		return 0;
+	}
+	const length = createReader(buffer, offset, isLittle).u32(8);
+	return length >= MIN_HEADER_SIZE && offset + length <= buffer.length ? length : 0;
+};
+
+
+/**
+ * Decode a binary crash record into the JSON report shape of raw address mode.
+ * @param {Buffer} buffer holds the record
+ * @param {number} [offset] where the record starts
+ * @returns {object} `{ time, signal, signal_name, address, pid, tid, registers, stack, ... }`
+ */
+const decodeCrashRecord = (buffer, offset = 0) => {
+	const length = getCrashRecordLength(buffer, offset);
+	if (!length) {
+		throw new Error(`No complete crash record at offset ${offset}`);
+	}
+	const isLittle = buffer.readUInt32LE(offset) === MAGIC;
+	const read = createReader(buffer, offset, isLittle);
+
+	const version = read.u16(4);
+	const headerSize = read.u16(6);
+	if (version < 1 || headerSize < MIN_HEADER_SIZE) {
+		throw new Error(`Unsupported crash record version ${version}`);
+	}
+	const arch = read.u16(12);
+	const registerCount = read.u16(14);
+	const frameCount = read.u16(28);
+	const moduleCount = read.u16(30);
+
+	const registersAt = headerSize;
+	const framesAt = registersAt + registerCount * 8;
+	const modulesAt = framesAt + frameCount * FRAME_SIZE;
+	const pathsAt = modulesAt + moduleCount * MODULE_SIZE;
+	if (pathsAt > length) {
+		throw new Error('Crash record sections exceed its length');
+	}
+
+	const names = registerNames[arch] || [];
+	const registers = {};
+	for (let i = 0; i < registerCount; i++) {
+		registers[names[i] || `r${i}`] = hex(read.u64(registersAt + i * 8));
+	}
+
+	const modules = [];
+	for (let i = 0; i < moduleCount; i++) {
+		const at = modulesAt + i * MODULE_SIZE;
+		const pathOffset = read.u32(at + 24);
+		const pathLength = read.u32(at + 28);
+		if (pathsAt + pathOffset + pathLength > length) {
+			throw new Error('Crash record module path exceeds its length');
+		}
+		const from = offset + pathsAt + pathOffset;
+		modules.push({
+			base: read.u64(at),
+			path: buffer.toString('utf8', from, from + pathLength),
+		});
+	}
+
+	const stack = [];
+	for (let i = 0; i < frameCount; i++) {
+		const at = framesAt + i * FRAME_SIZE;
+		const address = read.u64(at);
+		const frame = { frame: i, address: hex(address) };
+		const moduleIndex = read.u32(at + 8);
+		const module = moduleIndex !== NO_MODULE && modules[moduleIndex];
+		if (module) {
+			frame.module = module.path;
+			frame.base = hex(module.base);
+			frame.offset = hex(address - module.base);
+		}
+		stack.push(frame);
+	}
+
+	const signal = read.u32(16);
+	const signalName = signalNames[signal] || String(signal);
+	const pid = read.i32(20);
+	const report = {
+		time: new Date(read.i64(32) * 1000).toISOString(),
+		level: 'ERROR',
+		type: 'segfault',
+		signal,
+		signal_name: signalName,
+		message: `Process ${pid} received ${signalName} signal`,
+		address: hex(read.u64(40)),
+		pid,
+		tid: read.i32(24),
+		registers,
+		stack,
+	};
+	if (read.u32(48) & FLAG_TRUNCATED) {
+		report.truncated = true;
+	}
+	return report;
+};
+
+
+/**
+ * Decode all records stored back to back, e.g. a whole crash record file.
+ * Stops at the first incomplete or unrecognized record.
+ */
+const decodeCrashRecords = (buffer) => {
+	const reports = [];
+	for (let offset = 0, length; (length = getCrashRecordLength(buffer, offset)); offset += length) {
+		reports.push(decodeCrashRecord(buffer, offset));
+	}
+	return reports;
+};
+
+
+module.exports = {
+	decodeCrashRecord, decodeCrashRecords, getCrashRecordLength,
+	createReader, hex, registerNames, signalNames,
+};
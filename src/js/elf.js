@@ -0,0 +1,146 @@
+'use strict';
+
+const fs = require('node:fs');
+
+const SHT_SYMTAB = 2;
+const SHT_DYNSYM = 11;
+const STT_FUNC = 2;
+const STT_GNU_IFUNC = 10;
+
+
+const createReader = (buffer, is64, isLittle) => ({
+	u8: (offset) => buffer.readUInt8(offset),
+	u16: (offset) => (isLittle ? buffer.readUInt16LE(offset) : buffer.readUInt16BE(offset)),
+	u32: (offset) => (isLittle ? buffer.readUInt32LE(offset) : buffer.readUInt32BE(offset)),
+	word: (offset) => {
+		if (!is64) {
+			return isLittle ? buffer.readUInt32LE(offset) : buffer.readUInt32BE(offset);
+		}
+		return Number(isLittle ? buffer.readBigUInt64LE(offset) : buffer.readBigUInt64BE(offset));
+	},
+});
+
+
+const readSections = (buffer, read, is64) => {
+	const shoff = read.word(is64 ? 0x28 : 0x20);
+	const shentsize = read.u16(is64 ? 0x3a : 0x2e);
+	const shnum = read.u16(is64 ? 0x3c : 0x30);
+	const sections = [];
+
+	for (let i = 0; i < shnum; i++) {
+		const at = shoff + i * shentsize;
+		if (at + shentsize > buffer.length) {
+			break;
+		}
+		sections.push(is64 ? {
+			type: read.u32(at + 0x04),
+			addr: read.word(at + 0x10),
+			offset: read.word(at + 0x18),
+			size: read.word(at + 0x20),
+			link: read.u32(at + 0x28),
+			entsize: read.word(at + 0x38),
+		} : {
+			type: read.u32(at + 0x04),
+			addr: read.u32(at + 0x0c),
+			offset: read.u32(at + 0x10),
+			size: read.u32(at + 0x14),
+			link: read.u32(at + 0x18),
+			entsize: read.u32(at + 0x24),
+		});
+	}
+
+	return sections;
+};
+
+
+const readCString = (buffer, offset) => {
+	const end = buffer.indexOf(0, offset);
+	return buffer.toString('latin1', offset, end < 0 ? buffer.length : end);
+};
+
+
+const readSymbols = (buffer, read, is64, sections, table) => {
+	const strings = sections[table.link];
+	if (!strings) {
+		return [];
+	}
+	const entsize = table.entsize || (is64 ? 24 : 16);
+	const symbols = [];
+
+	for (let at = table.offset; at + entsize <= table.offset + table.size; at += entsize) {
+		const info = read.u8(at + (is64 ? 4 : 12));
+		const type = info & 0xf;
+		const shndx = read.u16(at + (is64 ? 6 : 14));
+		if ((type !== STT_FUNC && type !== STT_GNU_IFUNC) || !shndx) {
+			continue;
+		}
+		const addr = read.word(at + (is64 ? 8 : 4));
+		if (!addr) {
+			continue;
+		}
+		symbols.push({
+			addr,
+			size: read.word(at + (is64 ? 16 : 8)),
+			name: readCString(buffer, strings.offset + read.u32(at)),
+		});
+	}
+
+	return symbols;
+};
+
+
+/**
+ * Load function symbols of an ELF file, sorted by address.
+ * Uses `.symtab` when present (includes static functions), `.dynsym` otherwise.
+ */
+const loadElfSymbols = (path) => {
+	const buffer = fs.readFileSync(path);
+	if (buffer.length < 0x40 || buffer.readUInt32BE(0) !== 0x7f454c46) {
+		throw new Error(`Not an ELF file: ${path}`);
+	}
+	const is64 = buffer[4] === 2;
+	const isLittle = buffer[5] === 1;
+	const read = createReader(buffer, is64, isLittle);
+	const sections = readSections(buffer, read, is64);
+
+	const symtab = sections.find((s) => s.type === SHT_SYMTAB);
+	const dynsym = sections.find((s) => s.type === SHT_DYNSYM);
+	let symbols = symtab ? readSymbols(buffer, read, is64, sections, symtab) : [];
+	if (!symbols.length && dynsym) {
+		symbols = readSymbols(buffer, read, is64, sections, dynsym);
+	}
+
+	symbols.sort((a, b) => a.addr - b.addr);
+	return symbols;
+};
+
+
+/**
+ * Find the symbol covering a module-relative address, via binary search.
+ * Returns `{ name, offset }` or `null`.
+ */
+const findElfSymbol = (symbols, address) => {
+	let low = 0;
+	let high = symbols.length - 1;
+	let found = -1;
+	while (low <= high) {
+		const mid = (low + high) >> 1;
+		if (symbols[mid].addr <= address) {
+			found = mid;
+			low = mid + 1;
+		} else {
+			high = mid - 1;
+		}
+	}
+	if (found < 0) {
+		return null;
+	}
+	const symbol = symbols[found];
+	if (symbol.size && address >= symbol.addr + symbol.size) {
+		return null;
+	}
+	return { name: symbol.name, offset: address - symbol.addr };
+};
+
+
+module.exports = { loadElfSymbols, findElfSymbol };
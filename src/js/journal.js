@@ -0,0 +1,40 @@
+'use strict';
+
+const fs = require('node:fs');
+
+// Crash journal files, as mapped with `setCrashJournal()`. See src/cpp/journal.hpp.
+const MAGIC = 'SFJOURNL';
+const HEADER_SIZE = 64;
+
+
+/**
+ * Read the reports kept in a crash journal, oldest first.
+ * Once the ring has wrapped, the oldest report may start mid-way.
+ * @param {string | Buffer} journal path or contents of the journal file
+ * @returns {string} the retained report text
+ */
+const readCrashJournal = (journal) => {
+	const buffer = Buffer.isBuffer(journal) ? journal : fs.readFileSync(journal);
+	if (buffer.length < HEADER_SIZE || buffer.toString('latin1', 0, 8) !== MAGIC) {
+		throw new Error('Not a crash journal');
+	}
+	// The journal is native-endian, and the version field tells which
+	const isLittle = buffer.readUInt32LE(8) === 1;
+	const read64 = (at) => Number(isLittle ? buffer.readBigUInt64LE(at) : buffer.readBigUInt64BE(at));
+	const headerSize = isLittle ? buffer.readUInt32LE(12) : buffer.readUInt32BE(12);
+	const capacity = read64(16);
+	const head = read64(24);
+	if (headerSize + capacity > buffer.length) {
+		throw new Error('Crash journal is truncated');
+	}
+
+	const ring = buffer.subarray(headerSize, headerSize + capacity);
+	if (head <= capacity) {
+		return ring.toString('utf8', 0, head);
+	}
+	const start = head % capacity;
+	return Buffer.concat([ring.subarray(start), ring.subarray(0, start)]).toString('utf8');
+};
+
+
+module.exports = { readCrashJournal };
@@ -0,0 +1,159 @@
+'use strict';
+
+const path = require('node:path');
+const zlib = require('node:zlib');
+
+
+// Display name of a profile location: function, module+offset, or the bare address
+const getLocationName = (profile, location) => {
+	if (location.symbol) {
+		return location.symbol;
+	}
+	const module = profile.modules[location.module];
+	if (module) {
+		return `${path.basename(module.path)}+0x${(location.address - module.base).toString(16)}`;
+	}
+	return `[0x${location.address.toString(16)}]`;
+};
+
+
+/**
+ * Format a profile from `stopProfiler()` as folded stacks, for flame graph tools.
+ * One line per distinct stack: frames outermost first, joined with ";", then the sample count.
+ * @param {object} profile result of `stopProfiler()`
+ * @returns {string} folded stacks
+ */
+const profileToFolded = (profile) => {
+	const counts = new Map();
+	profile.stacks.forEach((stack) => {
+		const names = stack.locations.map((index) => getLocationName(profile, profile.locations[index]));
+		const key = names.reverse().join(';');
+		counts.set(key, (counts.get(key) || 0) + stack.count);
+	});
+	return [...counts].map(([key, count]) => `${key} ${count}\n`).join('');
+};
+
+
+// Minimal protobuf writer: fields are appended in order, messages nest as byte strings
+const encodeVarint = (value) => {
+	const bytes = [];
+	let rest = value;
+	while (rest >= 0x80) {
+		bytes.push((rest % 0x80) | 0x80);
+		rest = Math.floor(rest / 0x80);
+	}
+	bytes.push(rest);
+	return Buffer.from(bytes);
+};
+
+const createMessage = () => {
+	const parts = [];
+	const message = {
+		uint: (field, value) => {
+			if (value) {
+				parts.push(encodeVarint(field * 8), encodeVarint(value));
+			}
+			return message;
+		},
+		bytes: (field, value) => {
+			const data = Buffer.isBuffer(value) ? value : Buffer.from(value);
+			parts.push(encodeVarint(field * 8 + 2), encodeVarint(data.length), data);
+			return message;
+		},
+		packed: (field, values) => {
+			if (values.length) {
+				message.bytes(field, Buffer.concat(values.map(encodeVarint)));
+			}
+			return message;
+		},
+		toBuffer: () => Buffer.concat(parts),
+	};
+	return message;
+};
+
+
+/**
+ * Format a profile from `stopProfiler()` as a gzipped pprof protobuf (profile.proto).
+ * Samples carry a sample count and CPU nanoseconds, and a `thread_id` label.
+ * @param {object} profile result of `stopProfiler()`
+ * @returns {Buffer} contents of a `.pb.gz` file
+ */
+const profileToPprof = (profile) => {
+	const strings = [''];
+	const stringIds = new Map([['', 0]]);
+	const getString = (text) => {
+		if (!stringIds.has(text)) {
+			stringIds.set(text, strings.length);
+			strings.push(text);
+		}
+		return stringIds.get(text);
+	};
+	const valueType = (type, unit) => createMessage().uint(1, getString(type)).uint(2, getString(unit)).toBuffer();
+
+	const period = Math.round(1e9 / (profile.hz || 1));
+	const result = createMessage();
+	result.bytes(1, valueType('samples', 'count'));
+	result.bytes(1, valueType('cpu', 'nanoseconds'));
+
+	const threadKey = getString('thread_id');
+	profile.stacks.forEach((stack) => {
+		const label = createMessage().uint(1, threadKey).uint(3, stack.tid).toBuffer();
+		result.bytes(2, createMessage()
+			.packed(1, stack.locations.map((index) => index + 1))
+			.packed(2, [stack.count, stack.count * period])
+			.bytes(3, label)
+			.toBuffer());
+	});
+
+	const symbolized = new Set();
+	profile.locations.forEach((location) => {
+		if (location.symbol && location.module !== undefined) {
+			symbolized.add(location.module);
+		}
+	});
+	profile.modules.forEach((module, index) => {
+		result.bytes(3, createMessage()
+			.uint(1, index + 1)
+			.uint(2, module.start)
+			.uint(3, module.end)
+			.uint(5, getString(module.path))
+			.uint(7, symbolized.has(index) ? 1 : 0)
+			.toBuffer());
+	});
+
+	const functionIds = new Map();
+	const functions = [];
+	profile.locations.forEach((location, index) => {
+		const message = createMessage()
+			.uint(1, index + 1)
+			.uint(2, location.module === undefined ? 0 : location.module + 1)
+			.uint(3, location.address);
+		if (location.symbol) {
+			if (!functionIds.has(location.symbol)) {
+				functionIds.set(location.symbol, functions.length + 1);
+				const module = profile.modules[location.module];
+				functions.push(createMessage()
+					.uint(1, functions.length + 1)
+					.uint(2, getString(location.symbol))
+					.uint(3, getString(location.symbol))
+					.uint(4, getString(module ? module.path : ''))
+					.toBuffer());
+			}
+			message.bytes(4, createMessage().uint(1, functionIds.get(location.symbol)).toBuffer());
+		}
+		result.bytes(4, message.toBuffer());
+	});
+	functions.forEach((message) => result.bytes(5, message));
+
+	// Strings last: every other field has registered its own by now
+	strings.forEach((text) => result.bytes(6, text));
+	result.uint(9, profile.startTime * 1e6);
+	result.uint(10, profile.duration);
+	result.bytes(11, valueType('cpu', 'nanoseconds'));
+	result.uint(12, period);
+
+	return zlib.gzipSync(result.toBuffer());
+};
+
+
+module.exports = { profileToFolded, profileToPprof };
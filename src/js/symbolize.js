@@ -0,0 +1,158 @@
+'use strict';
+
+const { execFileSync } = require('node:child_process');
+const { loadElfSymbols, findElfSymbol } = require('./elf');
+
+// "#3 0x7f0012345678 /path/to/module.so+0x1f00 (base 0x7f0012343000)"
+const rawTextFrame = /^#(\d+) (0x[0-9a-f]+) (.+)\+(0x[0-9a-f]+) \(base (0x[0-9a-f]+)\)$/;
+
+
+// Run a helper tool, or return null if it is missing or fails
+const runTool = (tool, args, input) => {
+	try {
+		return execFileSync(tool, args, {
+			input, encoding: 'utf8', stdio: ['pipe', 'pipe', 'ignore'], maxBuffer: 64 * 1024 * 1024,
+		});
+	} catch (_e) {
+		return null;
+	}
+};
+
+
+// Frames above the innermost hold return addresses: look up the call instruction instead
+const lookupAddress = (frame) => (frame.index > 0 ? frame.offset - 1 : frame.offset);
+
+
+const resolveModule = (path, frames, options) => {
+	let symbols = [];
+	try {
+		symbols = loadElfSymbols(path);
+	} catch (_e) {
+		// Unreadable module: leave its frames raw
+	}
+
+	frames.forEach((frame) => {
+		let found = findElfSymbol(symbols, lookupAddress(frame));
+		if (found) {
+			found.offset += frame.offset - lookupAddress(frame);
+		} else {
+			// A frame right above a signal trampoline holds the exact faulting PC, so retry as is
+			found = findElfSymbol(symbols, frame.offset);
+		}
+		if (found) {
+			frame.function = found.name;
+			frame.functionOffset = found.offset;
+		}
+	});
+
+	if (options.lines === false) {
+		return;
+	}
+	const addresses = frames.map((frame) => `0x${lookupAddress(frame).toString(16)}`);
+	const output = runTool(options.addr2line || 'addr2line', ['-e', path, ...addresses]);
+	if (!output) {
+		return;
+	}
+	output.split('\n').slice(0, frames.length).forEach((line, i) => {
+		if (line && !line.startsWith('??')) {
+			frames[i].source = line.replace(/ \(discriminator \d+\)$/, '');
+		}
+	});
+};
+
+
+const demangle = (frames, options) => {
+	const named = frames.filter((frame) => frame.function);
+	if (options.demangle === false || !named.length) {
+		return;
+	}
+	const output = runTool(options.cxxfilt || 'c++filt', [], named.map((frame) => frame.function).join('\n'));
+	if (!output) {
+		return;
+	}
+	output.split('\n').slice(0, named.length).forEach((name, i) => {
+		if (name) {
+			named[i].function = name;
+		}
+	});
+};
+
+
+const formatSymbol = (frame) => (
+	frame.function ? `${frame.function}+0x${frame.functionOffset.toString(16)}` : null
+);
+
+
+/**
+ * Symbolize a report produced with `setRawAddresses(true)`, in JSON or plain text.
+ * Frames gain function+offset (from the ELF symbol tables) and file:line (from `addr2line`).
+ * @param {string} report contents of the crash log
+ * @param {object} [options] `{ lines, demangle, addr2line, cxxfilt }`
+ * @returns {string} the same report, with symbols
+ */
+const symbolizeReport = (report, options = {}) => {
+	const lines = report.split('\n');
+	const frames = [];
+	const parsed = lines.map((line) => {
+		const text = line.match(rawTextFrame);
+		if (text) {
+			const frame = { index: Number(text[1]), module: text[3], offset: parseInt(text[4], 16) };
+			frames.push(frame);
+			return { line, frames: [frame] };
+		}
+		if (!line.startsWith('{')) {
+			return { line };
+		}
+		let json = null;
+		try {
+			json = JSON.parse(line);
+		} catch (_e) {
+			return { line };
+		}
+		if (!Array.isArray(json?.stack)) {
+			return { line };
+		}
+		const jsonFrames = json.stack.filter((entry) => entry.module && entry.offset).map((entry) => {
+			const frame = {
+				index: entry.frame, module: entry.module, offset: parseInt(entry.offset, 16), entry,
+			};
+			frames.push(frame);
+			return frame;
+		});
+		return { line, json, frames: jsonFrames };
+	});
+
+	const byModule = new Map();
+	frames.forEach((frame) => {
+		if (!byModule.has(frame.module)) {
+			byModule.set(frame.module, []);
+		}
+		byModule.get(frame.module).push(frame);
+	});
+	byModule.forEach((moduleFrames, path) => resolveModule(path, moduleFrames, options));
+	demangle(frames, options);
+
+	return parsed.map((item) => {
+		if (item.json) {
+			item.frames.forEach((frame) => {
+				const symbol = formatSymbol(frame);
+				if (symbol) {
+					frame.entry.symbol = symbol;
+				}
+				if (frame.source) {
+					frame.entry.source = frame.source;
+				}
+			});
+			return JSON.stringify(item.json);
+		}
+		if (!item.frames) {
+			return item.line;
+		}
+		const frame = item.frames[0];
+		const symbol = formatSymbol(frame);
+		return [item.line, symbol, frame.source && `at ${frame.source}`].filter(Boolean).join(' ');
+	}).join('\n');
+};
+
+
+module.exports = { symbolizeReport };
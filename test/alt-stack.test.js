@@ -0,0 +1,61 @@
+'use strict';
+
+const assert = require('node:assert').strict;
+const { describe, it } = require('node:test');
+const util = require('node:util');
+const exec = util.promisify(require('node:child_process').exec);
+
+const Segfault = require('..');
+
+
+describe('Alternate Stacks', () => {
+	it('rejects an invalid size', () => {
+		assert.throws(() => Segfault.setAltStackSize(1024), /size must be an integer from 16384 to 16777216/);
+		assert.throws(() => Segfault.setAltStackSize('big'), /size must be an integer/);
+	});
+
+	if (process.platform !== 'win32') {
+		it('rounds the size up to pages', () => {
+			const { size } = Segfault.getAltStacks();
+			Segfault.setAltStackSize(100000);
+			assert.ok(Segfault.getAltStacks().size >= 100000);
+			assert.strictEqual(Segfault.getAltStacks().size % 4096, 0);
+			Segfault.setAltStackSize(size);
+		});
+	}
+
+	if (process.platform === 'linux') {
+		it('covers every thread', async () => {
+			assert.ok(Segfault.updateAltStacks() > 1, 'Node always has helper threads');
+			await new Promise((resolve) => setTimeout(resolve, 100));
+			assert.ok(Segfault.getAltStacks().threads > 1, 'Helper threads should take their stacks');
+		});
+
+		it('reports a stack overflow on a worker thread', async () => {
+			let stderr = '';
+			try {
+				await exec(
+					'node -e "const { Worker } = require(\'node:worker_threads\'); const sf = require(\'.\'); ' +
+					'const worker = new Worker(\'require(\\\'.\\\').causeOverflow()\', { eval: true }); ' +
+					'setTimeout(() => {}, 5000)"'
+				);
+			} catch (error) {
+				stderr = error.stderr;
+			}
+			assert.ok(stderr.includes('PID'), 'The crash should be reported');
+		});
+
+		it('reports a stack overflow on a thread that never loaded the addon', async () => {
+			let stderr = '';
+			try {
+				await exec(
+					'node -e "const sf = require(\'.\'); sf.causeOverflow(true); ' +
+					'sf.captureStack({ symbolize: false }); setTimeout(() => {}, 5000)"'
+				);
+			} catch (error) {
+				stderr = error.stderr;
+			}
+			assert.match(stderr, /PID \d+ received SIGSEGV/, 'The crash should be reported');
+		});
+	}
+});
@@ -0,0 +1,65 @@
+'use strict';
+
+const assert = require('node:assert').strict;
+const { describe, it } = require('node:test');
+const util = require('node:util');
+const exec = util.promisify(require('node:child_process').exec);
+
+const Segfault = require('..');
+
+
+const getJsonStack = async (options) => {
+	let response = '';
+	try {
+		await exec(
+			'node -e "const sf = require(\'.\'); sf.setOutputFormat(true); ' +
+			`sf.setCaptureOptions(${options}); sf.causeSegfault()"`
+		);
+	} catch (error) {
+		response = error.stderr;
+	}
+	const line = response.split('\n').find((l) => l.includes('"type":"segfault"'));
+	return JSON.parse(line).stack;
+};
+
+
+describe('Capture Options', () => {
+	it('can get and set capture options', async () => {
+		const { stdout } = await exec(
+			'node -e "const sf = require(\'.\'); const a = sf.getCaptureOptions(); ' +
+			'sf.setCaptureOptions({ maxFrames: 100, perSignal: { [sf.SIGABRT]: { maxFrames: 8 } } }); ' +
+			'console.log(JSON.stringify([a, sf.getCaptureOptions()]))"'
+		);
+		const [before, after] = JSON.parse(stdout);
+		const abort = String(Segfault.SIGABRT);
+		
+		assert.deepStrictEqual(before, { maxFrames: 32, skipFrames: 0, perSignal: {} });
+		assert.deepStrictEqual(
+			after, { maxFrames: 100, skipFrames: 0, perSignal: { [abort]: { maxFrames: 8 } } }
+		);
+	});
+	
+	it('rejects invalid capture options', () => {
+		assert.throws(() => Segfault.setCaptureOptions({ maxFrames: 0 }), /maxFrames/);
+		assert.throws(() => Segfault.setCaptureOptions({ maxFrames: 257 }), /maxFrames/);
+		assert.throws(() => Segfault.setCaptureOptions({ skipFrames: 1.5 }), /skipFrames/);
+		assert.throws(() => Segfault.setCaptureOptions({ perSignal: 1 }), /perSignal/);
+	});
+	
+	// The crash PC is taken from the signal context on Linux
+	if (process.platform !== 'linux') {
+		return;
+	}
+	
+	it('limits the stack depth', async () => {
+		const stack = await getJsonStack('{ maxFrames: 3 }');
+		assert.strictEqual(stack.length, 3);
+		assert.match(stack[0].symbol, /_segfaultStackFrame1/, 'Should start at the crash');
+	});
+	
+	it('applies per-signal options', async () => {
+		const stack = await getJsonStack('{ maxFrames: 2, perSignal: { [sf.SIGSEGV]: { skipFrames: 1 } } }');
+		assert.strictEqual(stack.length, 2);
+		assert.match(stack[0].symbol, /causeSegfault/, 'Should skip the innermost frame');
+	});
+});
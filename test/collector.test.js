@@ -0,0 +1,112 @@
+'use strict';
+
+const assert = require('node:assert').strict;
+const { describe, it } = require('node:test');
+const fs = require('node:fs');
+const os = require('node:os');
+const path = require('node:path');
+const { spawn, execFile } = require('node:child_process');
+const util = require('node:util');
+
+const Segfault = require('..');
+
+const collectorPath = path.join(__dirname, '..', 'bin', 'segfault-collector.js');
+
+
+const waitFor = (stream, pattern) => new Promise((resolve) => {
+	let data = '';
+	const onData = (chunk) => {
+		data += chunk;
+		if (pattern.test(data)) {
+			stream.off('data', onData);
+			resolve(data);
+		}
+	};
+	stream.on('data', onData);
+});
+
+const crashWithSocket = async (socketPath, format) => {
+	const sinks = [{ type: 'socket', format, path: socketPath }];
+	const script = `const sf = require('.'); sf.setCrashSinks(${JSON.stringify(sinks)}); sf.causeSegfault()`;
+	try {
+		await util.promisify(execFile)('node', ['-e', script]);
+	} catch (error) {
+		return error;
+	}
+	return null;
+};
+
+
+describe('Crash Collector', () => {
+	if (process.platform !== 'win32') {
+		it('throws for a socket nobody listens at', () => {
+			const socketPath = path.join(os.tmpdir(), `segfault-collector-${process.pid}-none.sock`);
+			assert.throws(
+				() => Segfault.setCrashSinks([{ type: 'socket', path: socketPath }]),
+				/Can't connect to crash collector/
+			);
+			assert.throws(
+				() => Segfault.setCrashSinks([{ type: 'socket' }]),
+				/required for 'socket' and 'directory' sinks/
+			);
+			assert.strictEqual(Segfault.getCrashSinks(), null);
+		});
+	}
+
+	if (process.platform === 'linux') {
+		it('streams whole reports to the reference collector', { timeout: 30000 }, async () => {
+			const socketPath = path.join(os.tmpdir(), `segfault-collector-${process.pid}-ref.sock`);
+			const collector = spawn('node', [collectorPath, socketPath]);
+			await waitFor(collector.stderr, /Listening/);
+
+			const received = waitFor(collector.stdout, /"type":"segfault"[^]*Handler phases/);
+			let jsonCrash = null;
+			let textCrash = null;
+			let output = '';
+			try {
+				jsonCrash = await crashWithSocket(socketPath, 'json');
+				textCrash = await crashWithSocket(socketPath, 'text');
+				output = await received;
+			} finally {
+				collector.kill('SIGTERM');
+			}
+
+			// Nothing went to stderr, the collector got one message per report
+			assert.ok(!jsonCrash.stderr.includes('SIGSEGV'));
+			assert.ok(!textCrash.stderr.includes('SIGSEGV'));
+			const lines = output.split('\n');
+			const report = JSON.parse(lines[0]);
+			assert.strictEqual(report.signal_name, 'SIGSEGV');
+			assert.ok(report.phases_us);
+			assert.match(output, /PID \d+ received SIGSEGV for address/);
+		});
+
+		it('drops the report at once if the collector is gone', { timeout: 30000 }, async () => {
+			const socketPath = path.join(os.tmpdir(), `segfault-collector-${process.pid}-gone.sock`);
+			const fd = Segfault.openCrashCollector(socketPath);
+			const sinks = [
+				{ type: 'socket', format: 'json', path: socketPath },
+				{ type: 'stderr', format: 'json' },
+			];
+			const child = spawn('node', ['-e', `
+				const sf = require('.');
+				sf.setCrashSinks(${JSON.stringify(sinks)});
+				console.log('ready');
+				process.stdin.once('data', () => sf.causeSegfault());
+			`]);
+			try {
+				await waitFor(child.stdout, /ready/);
+				Segfault.closeCrashCollector(fd);
+				fs.rmSync(socketPath, { force: true });
+
+				const started = Date.now();
+				const stderr = waitFor(child.stderr, /"type":"segfault"/);
+				child.stdin.write('\n');
+				await stderr;
+				assert.ok(Date.now() - started < 5000);
+			} finally {
+				child.kill('SIGKILL');
+			}
+		});
+	}
+});
@@ -0,0 +1,55 @@
+'use strict';
+
+const assert = require('node:assert').strict;
+const { describe, it } = require('node:test');
+const util = require('node:util');
+const execFile = util.promisify(require('node:child_process').execFile);
+
+
+// Three workers and the main thread crash at once
+const crashAll = `
+const { Worker } = require('node:worker_threads');
+const sf = require(process.cwd());
+sf.setOutputFormat(true);
+sf.setThreadDump(true, 1000);
+const flag = new Int32Array(new SharedArrayBuffer(4));
+const code = \`
+const { workerData } = require('node:worker_threads');
+const sf = require('\${process.cwd()}');
+Atomics.add(workerData, 0, 1);
+while (Atomics.load(workerData, 0) < 4);
+sf.causeSegfault();
+\`;
+for (let i = 0; i < 3; i++) new Worker(code, { eval: true, workerData: flag });
+while (Atomics.load(flag, 0) < 3);
+Atomics.add(flag, 0, 1);
+sf.causeSegfault();
+`;
+
+
+describe('Concurrent Crashes', () => {
+	if (process.platform === 'linux') {
+		it('reports crashes of other threads in one report', async () => {
+			let stderr = '';
+			let signal = null;
+			try {
+				await execFile('node', ['-e', crashAll]);
+			} catch (error) {
+				stderr = error.stderr;
+				signal = error.signal;
+			}
+
+			assert.strictEqual(signal, 'SIGSEGV', 'The process should still go down');
+			const reports = stderr.split('\n').filter((line) => line.startsWith('{'));
+			assert.strictEqual(reports.length, 1, 'Only the first crash writes a report');
+
+			const report = JSON.parse(reports[0]);
+			assert.ok(report.concurrent.length > 0, 'Workers crash while the threads are dumped');
+			for (const crash of report.concurrent) {
+				assert.notStrictEqual(crash.tid, report.tid);
+				assert.strictEqual(crash.signal_name, 'SIGSEGV');
+				assert.ok(crash.stack.some((frame) => frame.symbol.includes('causeSegfault')));
+			}
+		});
+	}
+});
@@ -0,0 +1,105 @@
+'use strict';
+
+const assert = require('node:assert').strict;
+const { describe, it } = require('node:test');
+const fs = require('node:fs');
+const os = require('node:os');
+const path = require('node:path');
+const util = require('node:util');
+const execFile = util.promisify(require('node:child_process').execFile);
+
+const Segfault = require('..');
+
+
+// A worker thread waits in a loop, so there is another thread to dump
+const crashWithDump = async (directory) => {
+	const script = `
+		const sf = require('.');
+		const { Worker } = require('node:worker_threads');
+		sf.setOutputFormat(true);
+		sf.setThreadDump(true, 1000);
+		sf.setCrashDump(${JSON.stringify(directory)}, { stackSize: 16384, windowSize: 128 });
+		const worker = new Worker('for (;;) {}', { eval: true });
+		worker.on('online', () => setTimeout(() => sf.causeSegfault(), 100));
+	`;
+	try {
+		await execFile('node', ['-e', script]);
+	} catch (error) {
+		return JSON.parse(error.stderr.split('\n').find((line) => line.startsWith('{')));
+	}
+	return null;
+};
+
+
+describe('Crash Dump', () => {
+	it('rejects invalid options', () => {
+		assert.throws(
+			() => Segfault.setCrashDump(os.tmpdir(), { stackSize: -1 }), /`stackSize` must be an integer/
+		);
+		assert.throws(
+			() => Segfault.setCrashDump(os.tmpdir(), { windowSize: 1e6 }), /`windowSize` must be an integer/
+		);
+		assert.strictEqual(Segfault.getCrashDump(), null);
+	});
+
+	it('rejects invalid dumps', () => {
+		assert.throws(() => Segfault.decodeCrashDump(Buffer.alloc(64)), /Not a crash dump/);
+	});
+
+	if (process.platform !== 'win32') {
+		it('can get and set the directory', () => {
+			Segfault.setCrashDump(os.tmpdir(), { windowSize: 0 });
+			assert.deepStrictEqual(
+				Segfault.getCrashDump(),
+				{ directory: os.tmpdir(), stackSize: 32768, windowSize: 0 }
+			);
+			Segfault.setCrashDump(null);
+			assert.strictEqual(Segfault.getCrashDump(), null);
+		});
+
+		it('throws for a missing directory', () => {
+			assert.throws(
+				() => Segfault.setCrashDump(path.join(os.tmpdir(), 'segfault-no-such-directory')),
+				/Can't open crash dump directory/
+			);
+		});
+	}
+
+	if (process.platform === 'linux') {
+		it('dumps registers, stacks and modules of the crash', async () => {
+			const directory = fs.mkdtempSync(path.join(os.tmpdir(), 'segfault-dump-'));
+			const report = await crashWithDump(directory);
+			const files = fs.readdirSync(directory);
+			const buffer = files.length === 1 ? fs.readFileSync(path.join(directory, files[0])) : null;
+			fs.rmSync(directory, { recursive: true, force: true });
+
+			assert.strictEqual(files.length, 1);
+			assert.match(files[0], /^segfault-\d+-\d+\.sfdump$/);
+			assert.strictEqual(report.dump, path.join(directory, files[0]));
+
+			const dump = Segfault.decodeCrashDump(buffer);
+			assert.strictEqual(dump.pid, report.pid);
+			assert.strictEqual(dump.signal_name, 'SIGSEGV');
+			assert.strictEqual(dump.address, report.address);
+			assert.strictEqual(dump.truncated, undefined);
+
+			const crashed = dump.threads.find((thread) => thread.crashed);
+			assert.strictEqual(crashed.tid, dump.tid);
+			assert.ok(crashed.stack.length > 0);
+			const stackPointer = crashed.registers.rsp || crashed.registers.sp;
+			assert.ok(stackPointer);
+			assert.ok(Segfault.readCrashDumpMemory(dump, stackPointer, 64));
+
+			// The worker answered the thread dump, its stack is in as well
+			const others = dump.threads.filter((thread) => !thread.crashed && thread.stack.length);
+			assert.ok(others.length > 0);
+			for (const thread of others) {
+				const pointer = thread.registers.rsp || thread.registers.sp;
+				assert.ok(Segfault.readCrashDumpMemory(dump, pointer, 8));
+			}
+
+			assert.ok(dump.modules.some((module) => module.path.endsWith('.node')));
+			assert.ok(dump.modules.some((module) => /^[0-9a-f]{16,}$/.test(module.buildId)));
+		});
+	}
+});
@@ -0,0 +1,65 @@
+'use strict';
+
+const assert = require('node:assert').strict;
+const { describe, it } = require('node:test');
+const fs = require('node:fs');
+const os = require('node:os');
+const path = require('node:path');
+const util = require('node:util');
+const exec = util.promisify(require('node:child_process').exec);
+
+const Segfault = require('..');
+
+
+const crashWithDedup = async (dedupPath, limit) => {
+	try {
+		await exec(
+			`node -e "const sf = require('.'); sf.setOutputFormat(true); ` +
+			`sf.setCrashDedup('${dedupPath}', { limit: ${limit}, window: 600 }); sf.causeSegfault()"`
+		);
+	} catch (error) {
+		return JSON.parse(error.stderr.split('\n').find((line) => line.startsWith('{')));
+	}
+	return null;
+};
+
+
+describe('Crash Dedup', () => {
+	it('rejects invalid options', () => {
+		const dedupPath = path.join(os.tmpdir(), `segfault-dedup-${process.pid}-options.bin`);
+		assert.throws(() => Segfault.setCrashDedup(dedupPath, { window: 0 }), /`window` must be an integer/);
+		assert.throws(() => Segfault.setCrashDedup(dedupPath, { limit: -1 }), /`limit` must be an integer/);
+		assert.strictEqual(Segfault.getCrashDedup(), null);
+	});
+
+	if (process.platform !== 'win32') {
+		it('can get and set the table', () => {
+			const dedupPath = path.join(os.tmpdir(), `segfault-dedup-${process.pid}-get.bin`);
+			Segfault.setCrashDedup(dedupPath, { limit: 5 });
+			assert.deepStrictEqual(Segfault.getCrashDedup(), { path: dedupPath, limit: 5, window: 3600 });
+			Segfault.setCrashDedup(null);
+			assert.strictEqual(Segfault.getCrashDedup(), null);
+			fs.rmSync(dedupPath, { force: true });
+		});
+	}
+
+	if (process.platform === 'linux') {
+		it('reports the same crash in full up to the limit, across processes', async () => {
+			const dedupPath = path.join(os.tmpdir(), `segfault-dedup-${process.pid}-crash.bin`);
+			fs.rmSync(dedupPath, { force: true });
+			const reports = [];
+			for (let i = 0; i < 4; i++) {
+				reports.push(await crashWithDedup(dedupPath, 2));
+			}
+			fs.rmSync(dedupPath, { force: true });
+
+			assert.deepStrictEqual(reports.map((report) => report.type), [
+				'segfault', 'segfault', 'segfault_repeat', 'segfault_repeat',
+			]);
+			assert.deepStrictEqual(reports.map((report) => report.seen), [1, 2, 3, 4]);
+			assert.ok(reports.every((report) => report.signature === reports[0].signature));
+			assert.ok(reports[0].stack.length > 0);
+			assert.strictEqual(reports[2].stack, undefined);
+		});
+	}
+});
@@ -2,6 +2,9 @@
 
 const assert = require('node:assert').strict;
 const { describe, it } = require('node:test');
+const fs = require('node:fs');
+const os = require('node:os');
+const path = require('node:path');
 const util = require('node:util');
 const exec = util.promisify(require('node:child_process').exec);
 
@@ -335,6 +338,25 @@ describe('Plain Text Output Format', () => {
 	});
 });
 
+describe('Log File', () => {
+	it('appends the report to an existing segfault.log', async () => {
+		const cwd = fs.mkdtempSync(path.join(os.tmpdir(), 'segfault-'));
+		const logPath = path.join(cwd, 'segfault.log');
+		fs.writeFileSync(logPath, '');
+		const modulePath = path.resolve(__dirname, '..').replace(/\\/g, '/');
+		try {
+			await exec(`node -e "require('${modulePath}').causeSegfault()"`, { cwd });
+		} catch (_e) {
+			// The child is expected to crash
+		}
+		const log = fs.readFileSync(logPath, 'utf8');
+		fs.rmSync(cwd, { recursive: true, force: true });
+		
+		const exceptionName = getPlatform() === 'windows' ? 'ACCESS_VIOLATION' : 'SIGSEGV';
+		assert.ok(log.includes(`received ${exceptionName}`), `Unexpected log: ${log.substring(0, 300)}`);
+	});
+});
+
 describe('Output Format Configuration', () => {
 	it('can get and set output format', async () => {
 		try {
@@ -58,6 +58,132 @@ describe('Segfault', () => {
 	it('contains `setSignal` function', () => {
 		assert.strictEqual(typeof Segfault.setSignal, 'function');
 	});
+	it('contains `setRawAddresses` function', () => {
+		assert.strictEqual(typeof Segfault.setRawAddresses, 'function');
+	});
+	it('contains `getRawAddresses` function', () => {
+		assert.strictEqual(typeof Segfault.getRawAddresses, 'function');
+	});
+	it('contains `setCrashRecordFile` function', () => {
+		assert.strictEqual(typeof Segfault.setCrashRecordFile, 'function');
+	});
+	it('contains `getCrashRecordFile` function', () => {
+		assert.strictEqual(typeof Segfault.getCrashRecordFile, 'function');
+	});
+	it('contains `decodeCrashRecord` function', () => {
+		assert.strictEqual(typeof Segfault.decodeCrashRecord, 'function');
+	});
+	it('contains `setCrashJournal` function', () => {
+		assert.strictEqual(typeof Segfault.setCrashJournal, 'function');
+	});
+	it('contains `getCrashJournal` function', () => {
+		assert.strictEqual(typeof Segfault.getCrashJournal, 'function');
+	});
+	it('contains `setCrashDedup` function', () => {
+		assert.strictEqual(typeof Segfault.setCrashDedup, 'function');
+	});
+	it('contains `getCrashDedup` function', () => {
+		assert.strictEqual(typeof Segfault.getCrashDedup, 'function');
+	});
+	it('contains `setCrashSinks` function', () => {
+		assert.strictEqual(typeof Segfault.setCrashSinks, 'function');
+	});
+	it('contains `getCrashSinks` function', () => {
+		assert.strictEqual(typeof Segfault.getCrashSinks, 'function');
+	});
+	it('contains `openCrashCollector` function', () => {
+		assert.strictEqual(typeof Segfault.openCrashCollector, 'function');
+	});
+	it('contains `readCrashCollector` function', () => {
+		assert.strictEqual(typeof Segfault.readCrashCollector, 'function');
+	});
+	it('contains `closeCrashCollector` function', () => {
+		assert.strictEqual(typeof Segfault.closeCrashCollector, 'function');
+	});
+	it('contains `setReportEnv` function', () => {
+		assert.strictEqual(typeof Segfault.setReportEnv, 'function');
+	});
+	it('contains `getReportEnv` function', () => {
+		assert.strictEqual(typeof Segfault.getReportEnv, 'function');
+	});
+	it('contains `setCrashDump` function', () => {
+		assert.strictEqual(typeof Segfault.setCrashDump, 'function');
+	});
+	it('contains `getCrashDump` function', () => {
+		assert.strictEqual(typeof Segfault.getCrashDump, 'function');
+	});
+	it('contains `decodeCrashDump` function', () => {
+		assert.strictEqual(typeof Segfault.decodeCrashDump, 'function');
+	});
+	it('contains `readCrashDumpMemory` function', () => {
+		assert.strictEqual(typeof Segfault.readCrashDumpMemory, 'function');
+	});
+	it('contains `readCrashJournal` function', () => {
+		assert.strictEqual(typeof Segfault.readCrashJournal, 'function');
+	});
+	it('contains `startProfiler` function', () => {
+		assert.strictEqual(typeof Segfault.startProfiler, 'function');
+	});
+	it('contains `stopProfiler` function', () => {
+		assert.strictEqual(typeof Segfault.stopProfiler, 'function');
+	});
+	it('contains `profileToFolded` function', () => {
+		assert.strictEqual(typeof Segfault.profileToFolded, 'function');
+	});
+	it('contains `profileToPprof` function', () => {
+		assert.strictEqual(typeof Segfault.profileToPprof, 'function');
+	});
+	it('contains `startWatchdog` function', () => {
+		assert.strictEqual(typeof Segfault.startWatchdog, 'function');
+	});
+	it('contains `stopWatchdog` function', () => {
+		assert.strictEqual(typeof Segfault.stopWatchdog, 'function');
+	});
+	it('contains `getWatchdog` function', () => {
+		assert.strictEqual(typeof Segfault.getWatchdog, 'function');
+	});
+	it('contains `setThreadDump` function', () => {
+		assert.strictEqual(typeof Segfault.setThreadDump, 'function');
+	});
+	it('contains `getThreadDump` function', () => {
+		assert.strictEqual(typeof Segfault.getThreadDump, 'function');
+	});
+	it('contains `getHandlerStats` function', () => {
+		assert.strictEqual(typeof Segfault.getHandlerStats, 'function');
+	});
+	it('contains `setAltStackSize` function', () => {
+		assert.strictEqual(typeof Segfault.setAltStackSize, 'function');
+	});
+	it('contains `updateAltStacks` function', () => {
+		assert.strictEqual(typeof Segfault.updateAltStacks, 'function');
+	});
+	it('contains `getAltStacks` function', () => {
+		assert.strictEqual(typeof Segfault.getAltStacks, 'function');
+	});
+	it('contains `captureStack` function', () => {
+		assert.strictEqual(typeof Segfault.captureStack, 'function');
+	});
+	it('contains `symbolizeStack` function', () => {
+		assert.strictEqual(typeof Segfault.symbolizeStack, 'function');
+	});
+	it('contains `setCaptureOptions` function', () => {
+		assert.strictEqual(typeof Segfault.setCaptureOptions, 'function');
+	});
+	it('contains `getCaptureOptions` function', () => {
+		assert.strictEqual(typeof Segfault.getCaptureOptions, 'function');
+	});
+	it('contains `setUnwinder` function', () => {
+		assert.strictEqual(typeof Segfault.setUnwinder, 'function');
+	});
+	it('contains `getUnwinder` function', () => {
+		assert.strictEqual(typeof Segfault.getUnwinder, 'function');
+	});
+	it('contains `updateModules` function', () => {
+		assert.strictEqual(typeof Segfault.updateModules, 'function');
+	});
+	it('contains `getModules` function', () => {
+		assert.strictEqual(typeof Segfault.getModules, 'function');
+	});
 	
 	(getPlatform() === 'windows' ? signalsWindows : signalsUnix).forEach((name) => {
 		it(`contains the \`${name}\` constant`, () => {
@@ -0,0 +1,64 @@
+'use strict';
+
+const assert = require('node:assert').strict;
+const { describe, it } = require('node:test');
+const fs = require('node:fs');
+const os = require('node:os');
+const path = require('node:path');
+const util = require('node:util');
+const exec = util.promisify(require('node:child_process').exec);
+
+const Segfault = require('..');
+
+
+const crashWithJournal = async (journalPath, useJson) => {
+	try {
+		await exec(
+			`node -e "const sf = require('.'); sf.setOutputFormat(${useJson}); ` +
+			`sf.setCrashJournal('${journalPath}', 65536); console.log('pid', process.pid); sf.causeSegfault()"`
+		);
+	} catch (error) {
+		return Number(error.stdout.match(/pid (\d+)/)[1]);
+	}
+	return 0;
+};
+
+
+describe('Crash Journal', () => {
+	it('rejects a file that is not a journal', () => {
+		assert.throws(() => Segfault.readCrashJournal(Buffer.alloc(128)), /Not a crash journal/);
+	});
+
+	if (process.platform === 'linux') {
+		it('can get and set the journal', async () => {
+			const journalPath = path.join(os.tmpdir(), `segfault-journal-${process.pid}-get.bin`);
+			const { stdout } = await exec(
+				'node -e "const sf = require(\'.\'); const a = sf.getCrashJournal(); ' +
+				`sf.setCrashJournal('${journalPath}', 32768); const b = sf.getCrashJournal(); ` +
+				'sf.setCrashJournal(null); console.log(JSON.stringify([a, b, sf.getCrashJournal()]))"'
+			);
+			fs.rmSync(journalPath, { force: true });
+			assert.deepStrictEqual(
+				JSON.parse(stdout), [null, { path: journalPath, size: 32768 }, null]
+			);
+		});
+
+		it('rejects journals that are too small', () => {
+			assert.throws(() => Segfault.setCrashJournal('unused.journal', 100), /at least/);
+		});
+
+		it('keeps reports of consecutive crashes', async () => {
+			const journalPath = path.join(os.tmpdir(), `segfault-journal-${process.pid}.bin`);
+			fs.rmSync(journalPath, { force: true });
+			const jsonPid = await crashWithJournal(journalPath, true);
+			const textPid = await crashWithJournal(journalPath, false);
+			const journal = Segfault.readCrashJournal(journalPath);
+			fs.rmSync(journalPath, { force: true });
+
+			const line = journal.split('\n').find((l) => l.includes('"type":"segfault"'));
+			assert.strictEqual(JSON.parse(line).pid, jsonPid);
+			assert.match(journal, new RegExp(`PID ${textPid} received SIGSEGV`));
+			assert.match(journal, /_segfaultStackFrame1/);
+		});
+	}
+});
@@ -0,0 +1,63 @@
+'use strict';
+
+const assert = require('node:assert').strict;
+const { describe, it } = require('node:test');
+const util = require('node:util');
+const exec = util.promisify(require('node:child_process').exec);
+
+const Segfault = require('..');
+
+
+describe('Module Map', () => {
+	// The module table is built from `dl_iterate_phdr()`
+	if (process.platform !== 'linux') {
+		return;
+	}
+	
+	it('lists loaded modules sorted by address', () => {
+		const modules = Segfault.getModules();
+		
+		assert.ok(modules.length > 1, 'Should have the executable and some libraries');
+		assert.ok(
+			modules.some((m) => m.path.endsWith('.node')),
+			'Should contain the addon itself'
+		);
+		modules.forEach((m, i) => {
+			assert.ok(m.start < m.end);
+			if (i > 0) {
+				assert.ok(modules[i - 1].end <= m.start, 'Modules should be sorted and disjoint');
+			}
+		});
+	});
+	
+	it('indexes function symbols of the modules', () => {
+		const addon = Segfault.getModules().find((m) => m.path.endsWith('.node'));
+		assert.ok(addon.symbols > 0, 'Should have symbols for the addon');
+	});
+	
+	it('names frames from the indexed symbols', async () => {
+		let response = '';
+		try {
+			await exec('node -e "require(\'.\').causeSegfault()"');
+		} catch (error) {
+			response = error.stderr;
+		}
+		assert.match(response, /\.node\(\S*_segfaultStackFrame1\S*\+0x[0-9a-f]+\)/);
+	});
+	
+	it('picks up addons loaded later', async () => {
+		// Load a copy of this very addon, under a different path
+		const { stdout } = await exec(
+			'node -e "const fs = require(\'fs\'); const os = require(\'os\'); ' +
+			'const path = require(\'path\'); const sf = require(\'.\'); ' +
+			'const addon = sf.getModules().find((m) => m.path.endsWith(\'.node\')).path; ' +
+			'const copy = path.join(fs.mkdtempSync(path.join(os.tmpdir(), \'sf-\')), \'copy.node\'); ' +
+			'fs.copyFileSync(addon, copy); const before = sf.getModules().length; require(copy); ' +
+			'console.log(before, sf.getModules().length, sf.getModules().some((m) => m.path === copy))"'
+		);
+		const [before, after, found] = stdout.trim().split(' ');
+		
+		assert.strictEqual(found, 'true', 'Should contain the new addon');
+		assert.ok(Number(after) > Number(before));
+	});
+});
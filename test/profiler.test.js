@@ -0,0 +1,59 @@
+'use strict';
+
+const assert = require('node:assert').strict;
+const { describe, it } = require('node:test');
+const zlib = require('node:zlib');
+
+const Segfault = require('..');
+
+
+const spin = (ms) => {
+	const until = Date.now() + ms;
+	let value = 0;
+	while (Date.now() < until) {
+		value += Math.sqrt(value + 1);
+	}
+	return value;
+};
+
+
+describe('Profiler', () => {
+	it('rejects invalid options', () => {
+		assert.throws(() => Segfault.startProfiler({ hz: 0 }), /`hz` must be an integer from 1 to 1000/);
+		assert.throws(() => Segfault.startProfiler({ threads: 'some' }), /`threads` must be/);
+	});
+
+	// Per-thread CPU timers and the built-in unwinder are Linux-only
+	if (process.platform === 'linux') {
+		it('samples native stacks of busy threads', () => {
+			Segfault.startProfiler({ hz: 250, threads: 'current' });
+			spin(300);
+			const profile = Segfault.stopProfiler();
+
+			assert.strictEqual(profile.threads, 1);
+			assert.ok(profile.samples > 10, `Expected samples, got ${profile.samples}`);
+			assert.strictEqual(
+				profile.stacks.reduce((sum, stack) => sum + stack.count, 0), profile.samples
+			);
+			assert.ok(
+				profile.locations.some((location) => /^(node|v8)::/.test(location.symbol)),
+				'Should name frames of the node binary'
+			);
+		});
+
+		it('formats folded stacks and pprof', () => {
+			Segfault.startProfiler({ hz: 250 });
+			spin(200);
+			const profile = Segfault.stopProfiler();
+
+			const folded = Segfault.profileToFolded(profile).trim().split('\n');
+			assert.ok(folded.length > 0);
+			folded.forEach((line) => assert.match(line, /^\S.* \d+$/));
+			assert.ok(folded.some((line) => line.includes(';')), 'Stacks should have several frames');
+
+			const pprof = zlib.gunzipSync(Segfault.profileToPprof(profile));
+			assert.strictEqual(pprof[0], 0x0a, 'Should start with the sample types');
+			assert.ok(pprof.includes('thread_id'));
+		});
+	}
+});
@@ -0,0 +1,86 @@
+'use strict';
+
+const assert = require('node:assert').strict;
+const { describe, it } = require('node:test');
+const fs = require('node:fs');
+const os = require('node:os');
+const path = require('node:path');
+const util = require('node:util');
+const execFile = util.promisify(require('node:child_process').execFile);
+
+const Segfault = require('..');
+
+
+const crashWithEnv = async (json) => {
+	const script = `
+		const sf = require('.');
+		sf.setOutputFormat(${json});
+		sf.setReportEnv(['SEGFAULT_TEST_VALUE', 'SEGFAULT_TEST_UNSET']);
+		sf.causeSegfault();
+	`;
+	try {
+		await execFile('node', ['-e', script, 'first', 'second'], {
+			env: { ...process.env, SEGFAULT_TEST_VALUE: 'a "quoted"\nvalue' },
+		});
+	} catch (error) {
+		return error.stderr;
+	}
+	return null;
+};
+
+
+describe('Report Prologue', () => {
+	it('rejects invalid variable names', () => {
+		assert.throws(() => Segfault.setReportEnv('HOME'), /must be of type `Array`/);
+		assert.throws(() => Segfault.setReportEnv([1]), /must be non-empty strings/);
+		assert.throws(() => Segfault.setReportEnv(['']), /must be non-empty strings/);
+		assert.deepStrictEqual(Segfault.getReportEnv(), []);
+	});
+
+	it('can get and set the variables', () => {
+		Segfault.setReportEnv(['HOME', 'PATH']);
+		assert.deepStrictEqual(Segfault.getReportEnv(), ['HOME', 'PATH']);
+		Segfault.setReportEnv(null);
+		assert.deepStrictEqual(Segfault.getReportEnv(), []);
+	});
+
+	if (process.platform !== 'win32') {
+		it('describes the process in JSON reports', async () => {
+			const stderr = await crashWithEnv(true);
+			const line = stderr.split('\n').find((item) => item.includes('"type":"segfault"'));
+			const report = JSON.parse(line);
+			assert.strictEqual(report.message, `Process ${report.pid} received SIGSEGV signal`);
+			assert.strictEqual(report.node, process.version);
+			assert.strictEqual(report.cwd, process.cwd());
+			assert.strictEqual(typeof report.hostname, 'string');
+			assert.strictEqual(report.argv[1], '-e');
+			assert.deepStrictEqual(report.argv.slice(-2), ['first', 'second']);
+			assert.deepStrictEqual(report.env, { SEGFAULT_TEST_VALUE: 'a "quoted"\nvalue' });
+			if (process.platform === 'linux') {
+				assert.match(report.build_ids.node, /^[0-9a-f]+$/);
+				assert.match(report.build_ids['vlad_fresha_segfault_handler.node'], /^[0-9a-f]+$/);
+			}
+		});
+
+		it('follows the working directory', async () => {
+			const script = `
+				const sf = require(${JSON.stringify(path.join(__dirname, '..'))});
+				sf.setOutputFormat(true);
+				process.chdir(${JSON.stringify(os.tmpdir())});
+				sf.causeSegfault();
+			`;
+			const { stderr } = await execFile('node', ['-e', script]).catch((error) => error);
+			const line = stderr.split('\n').find((item) => item.includes('"type":"segfault"'));
+			assert.strictEqual(JSON.parse(line).cwd, fs.realpathSync(os.tmpdir()));
+		});
+
+		it('describes the process in text reports', async () => {
+			const stderr = await crashWithEnv(false);
+			assert.match(stderr, /received SIGSEGV for address: 0x[0-9a-f]+\nHost: .+, Node\.js /);
+			assert.ok(stderr.includes(`, Node.js ${process.version}\n`));
+			assert.match(stderr, /\nCommand line: .* -e .* first second\n/);
+			assert.ok(stderr.includes(`\nWorking directory: ${process.cwd()}\n`));
+			assert.ok(stderr.includes('\nEnvironment: SEGFAULT_TEST_VALUE=a "quoted" value\n'));
+		});
+	}
+});
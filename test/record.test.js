@@ -0,0 +1,72 @@
+'use strict';
+
+const assert = require('node:assert').strict;
+const { describe, it } = require('node:test');
+const fs = require('node:fs');
+const os = require('node:os');
+const path = require('node:path');
+const util = require('node:util');
+const exec = util.promisify(require('node:child_process').exec);
+
+const Segfault = require('..');
+const { decodeCrashRecords } = require('../src/js/crash-record');
+const { symbolizeReport } = require('../src/js/symbolize');
+
+
+const crashWithRecord = async (recordPath, times = 1) => {
+	for (let i = 0; i < times; i++) {
+		try {
+			await exec(
+				`node -e "const sf = require('.'); sf.setCrashRecordFile('${recordPath}'); sf.causeSegfault()"`
+			);
+		} catch (_e) {
+			// The child is expected to crash
+		}
+	}
+	return fs.readFileSync(recordPath);
+};
+
+
+describe('Crash Records', () => {
+	it('rejects data that is not a crash record', () => {
+		assert.throws(() => Segfault.decodeCrashRecord(Buffer.alloc(128)), /No complete crash record/);
+	});
+
+	if (process.platform === 'linux') {
+		it('can get and set the record file', async () => {
+			const recordPath = path.join(os.tmpdir(), `segfault-record-${process.pid}-get.bin`);
+			const { stdout } = await exec(
+				'node -e "const sf = require(\'.\'); const a = sf.getCrashRecordFile(); ' +
+				`sf.setCrashRecordFile('${recordPath}'); const b = sf.getCrashRecordFile(); ` +
+				'sf.setCrashRecordFile(null); console.log(a, b, sf.getCrashRecordFile())"'
+			);
+			fs.rmSync(recordPath, { force: true });
+			assert.strictEqual(stdout.trim(), `null ${recordPath} null`);
+		});
+
+		it('decodes records appended by crashes', async () => {
+			const recordPath = path.join(os.tmpdir(), `segfault-record-${process.pid}.bin`);
+			fs.rmSync(recordPath, { force: true });
+			const records = await crashWithRecord(recordPath, 2);
+			fs.rmSync(recordPath, { force: true });
+
+			const reports = decodeCrashRecords(records);
+			assert.strictEqual(reports.length, 2);
+			assert.strictEqual(Segfault.decodeCrashRecord(records).pid, reports[0].pid);
+
+			const [report] = reports;
+			assert.strictEqual(report.signal, Segfault.SIGSEGV);
+			assert.strictEqual(report.signal_name, 'SIGSEGV');
+			assert.strictEqual(report.address, '0x1');
+			assert.ok(report.tid > 0);
+			assert.ok(Object.keys(report.registers).length > 0, 'Should have registers');
+
+			const frame = report.stack[0];
+			assert.ok(frame.module, 'The crash frame should be in a module');
+			assert.strictEqual(BigInt(frame.address), BigInt(frame.base) + BigInt(frame.offset));
+
+			const symbolized = JSON.parse(symbolizeReport(JSON.stringify(report), { lines: false }));
+			assert.match(symbolized.stack[0].symbol, /_segfaultStackFrame1/);
+		});
+	}
+});
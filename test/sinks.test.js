@@ -0,0 +1,177 @@
+'use strict';
+
+const assert = require('node:assert').strict;
+const { describe, it } = require('node:test');
+const fs = require('node:fs');
+const os = require('node:os');
+const path = require('node:path');
+const util = require('node:util');
+const execFile = util.promisify(require('node:child_process').execFile);
+
+const Segfault = require('..');
+
+
+const crashWithSinks = async (sinks, cwd = undefined) => {
+	const script = `
+		const sf = require(${JSON.stringify(path.join(__dirname, '..'))});
+		sf.setCrashSinks(${JSON.stringify(sinks)});
+		sf.causeSegfault();
+	`;
+	try {
+		await execFile('node', ['-e', script], { cwd });
+	} catch (error) {
+		return error.stderr;
+	}
+	return null;
+};
+
+
+describe('Crash Sinks', () => {
+	it('rejects invalid sinks', () => {
+		assert.throws(() => Segfault.setCrashSinks({}), /must be of type `Array`/);
+		assert.throws(() => Segfault.setCrashSinks([{ type: 'printer' }]), /`type` must be one of/);
+		assert.throws(() => Segfault.setCrashSinks([{ type: 'stderr', format: 'xml' }]), /`format` must be/);
+		assert.throws(() => Segfault.setCrashSinks([{ type: 'stderr', path: 'x.log' }]), /`path` must be/);
+		assert.throws(
+			() => Segfault.setCrashSinks([{ type: 'stderr' }, { type: 'stderr', format: 'json' }]),
+			/must not repeat/
+		);
+		assert.throws(
+			() => Segfault.setCrashSinks([{ type: 'directory' }]),
+			/required for 'socket' and 'directory'/
+		);
+		assert.throws(
+			() => Segfault.setCrashSinks([{ type: 'directory', path: path.join(__dirname, 'none') }]),
+			/Can't open crash sink directory/
+		);
+		assert.strictEqual(Segfault.getCrashSinks(), null);
+	});
+
+	if (process.platform !== 'win32') {
+		it('can get and set the sinks', () => {
+			const logPath = path.join(os.tmpdir(), `segfault-sinks-${process.pid}-get.log`);
+			const sinks = [
+				{ type: 'stderr', format: 'json' },
+				{ type: 'file', format: 'text', path: logPath },
+				{ type: 'journal', format: 'json' },
+			];
+			Segfault.setCrashSinks(sinks);
+			assert.deepStrictEqual(Segfault.getCrashSinks(), sinks);
+			Segfault.setCrashSinks(null);
+			assert.strictEqual(Segfault.getCrashSinks(), null);
+			fs.rmSync(logPath, { force: true });
+		});
+	}
+
+	if (process.platform === 'linux') {
+		it('writes one crash in a format per sink', async () => {
+			const logPath = path.join(os.tmpdir(), `segfault-sinks-${process.pid}-crash.log`);
+			fs.rmSync(logPath, { force: true });
+			const stderr = await crashWithSinks([
+				{ type: 'stderr', format: 'json' },
+				{ type: 'file', format: 'text', path: logPath },
+			]);
+			const text = fs.readFileSync(logPath, 'utf8');
+			fs.rmSync(logPath, { force: true });
+
+			const lines = stderr.split('\n').filter((line) => line.startsWith('{'));
+			assert.strictEqual(lines.length, 1);
+			const report = JSON.parse(lines[0]);
+			assert.strictEqual(report.signal_name, 'SIGSEGV');
+			assert.ok(report.stack.length > 0);
+			assert.ok(!stderr.includes('Handler phases'));
+
+			assert.match(text, /^\n\nAt /);
+			assert.match(text, new RegExp(`PID ${report.pid} received SIGSEGV`));
+			assert.match(text, /Handler phases: /);
+			// Both formats come from the same frames
+			assert.ok(text.includes(report.stack[0].symbol));
+		});
+
+		it('keeps the log file warning out of JSON on stderr', async () => {
+			// No "segfault.log" there, so the text file sink has nowhere to write
+			const dir = fs.mkdtempSync(path.join(os.tmpdir(), 'segfault-sinks-'));
+			const stderr = await crashWithSinks([
+				{ type: 'stderr', format: 'json' },
+				{ type: 'file', format: 'text' },
+			], dir);
+			fs.rmSync(dir, { recursive: true, force: true });
+
+			const lines = stderr.split('\n');
+			const warnings = lines.filter((line) => line.includes("unless 'segfault.log' exists"));
+			const reports = lines.filter((line) => line.startsWith('{')).map((line) => JSON.parse(line));
+			assert.strictEqual(warnings.length, 1);
+			assert.ok(lines.indexOf(warnings[0]) < lines.findIndex((line) => line.startsWith('{')));
+			assert.strictEqual(reports.length, 1);
+			assert.strictEqual(reports[0].signal_name, 'SIGSEGV');
+			assert.ok(reports[0].phases_us);
+		});
+
+		it('writes a whole file per crash and sink to a directory', async () => {
+			const dir = fs.mkdtempSync(path.join(os.tmpdir(), 'segfault-sinks-'));
+			const sinks = [
+				{ type: 'directory', format: 'json', path: dir },
+				{ type: 'directory', format: 'text', path: dir },
+			];
+			// Workers sharing a directory crash at once
+			const stderrs = await Promise.all([1, 2, 3, 4].map(() => crashWithSinks(sinks)));
+			const names = fs.readdirSync(dir).sort();
+			const reports = names.filter((name) => name.endsWith('.json')).map(
+				(name) => JSON.parse(fs.readFileSync(path.join(dir, name), 'utf8'))
+			);
+			const texts = names.filter((name) => name.endsWith('.log')).map(
+				(name) => fs.readFileSync(path.join(dir, name), 'utf8')
+			);
+			fs.rmSync(dir, { recursive: true, force: true });
+
+			// Nothing temporary is left, and no report went to stderr
+			assert.strictEqual(names.length, 8);
+			assert.ok(names.every((name) => /^crash-\d+-\d+\.(json|log)$/.test(name)));
+			assert.ok(stderrs.every((stderr) => !stderr.includes('SIGSEGV')));
+			assert.strictEqual(new Set(reports.map((report) => report.pid)).size, 4);
+			for (const report of reports) {
+				assert.ok(names.some((name) => name.startsWith(`crash-${report.pid}-`)));
+				assert.ok(report.phases_us);
+			}
+			for (const text of texts) {
+				assert.match(text, /received SIGSEGV[^]*Handler phases: /);
+			}
+		});
+
+		it('writes whole summaries to a shared stderr pipe', async () => {
+			const dir = fs.mkdtempSync(path.join(os.tmpdir(), 'segfault-sinks-'));
+			const sinks = [
+				{ type: 'stderr', format: 'summary' },
+				{ type: 'directory', format: 'json', path: dir },
+			];
+			const script = `
+				const sf = require('.');
+				sf.setCrashSinks(${JSON.stringify(sinks)});
+				sf.causeSegfault();
+			`;
+			const crash = 'node -e "$SCRIPT"';
+			const { stderr } = await execFile(
+				'sh', ['-c', `${crash} & ${crash} & ${crash} & ${crash} & wait`],
+				{ env: { ...process.env, SCRIPT: script } }
+			);
+			const names = fs.readdirSync(dir);
+			const reports = names.map((name) => JSON.parse(fs.readFileSync(path.join(dir, name), 'utf8')));
+			fs.rmSync(dir, { recursive: true, force: true });
+
+			// Every summary line is whole, and points at a full report by pid and signature
+			const lines = stderr.split('\n').filter((line) => line.includes('segfault_summary'));
+			assert.strictEqual(reports.length, 4);
+			assert.strictEqual(lines.length, 4);
+			for (const line of lines) {
+				assert.ok(Buffer.byteLength(line) < 4096);
+				const summary = JSON.parse(line);
+				assert.strictEqual(summary.signal_name, 'SIGSEGV');
+				assert.match(summary.signature, /^0x[0-9a-f]+$/);
+				assert.ok(summary.stack.length > 0 && summary.stack.length <= 16);
+				const report = reports.find((item) => item.pid === summary.pid);
+				assert.strictEqual(report.stack.length, summary.frames);
+				assert.ok(report.stack[0].symbol.endsWith(summary.stack[0]));
+			}
+		});
+	}
+});
@@ -0,0 +1,46 @@
+'use strict';
+
+const assert = require('node:assert').strict;
+const { describe, it } = require('node:test');
+
+const Segfault = require('..');
+
+
+describe('Stack Capture', () => {
+	it('rejects invalid options', () => {
+		assert.throws(() => Segfault.captureStack({ maxFrames: 0 }), /`maxFrames` must be an integer from 1/);
+		assert.throws(() => Segfault.captureStack({ format: 'text' }), /`format` must be/);
+		assert.throws(() => Segfault.symbolizeStack('0x1'), /must be a Buffer or an array/);
+	});
+
+	// Windows has no on-demand capture, macOS has no module map for symbols
+	if (process.platform === 'linux') {
+		it('captures symbolized frames of the calling thread', () => {
+			const stack = Segfault.captureStack({ maxFrames: 16 });
+			assert.ok(stack.length > 2 && stack.length <= 16);
+			assert.ok(
+				stack.every((frame) => !/segfault|vlad_fresha/.test(frame.module)),
+				'Should start outside of the addon'
+			);
+			assert.ok(stack.some((frame) => /^v8::/.test(frame.symbol)), 'Should name V8 frames');
+
+			const addresses = Segfault.captureStack({ maxFrames: 16, symbolize: false });
+			assert.ok(addresses.every((address) => typeof address === 'number'));
+		});
+
+		it('symbolizes compact captures on the threadpool', async () => {
+			const buffer = Segfault.captureStack({ format: 'buffer', maxFrames: 8 });
+			assert.ok(Buffer.isBuffer(buffer));
+			assert.strictEqual(buffer.length % 8, 0);
+
+			const addresses = Array.from(new BigUint64Array(
+				buffer.buffer, buffer.byteOffset, buffer.length / 8
+			), Number);
+			const fromBuffer = await Segfault.symbolizeStack(buffer);
+			const fromArray = await Segfault.symbolizeStack(addresses);
+			assert.deepStrictEqual(fromBuffer, fromArray);
+			assert.deepStrictEqual(fromBuffer.map((frame) => frame.address), addresses);
+			assert.ok(fromBuffer[0].symbol, 'Should name the innermost frame');
+		});
+	}
+});
@@ -0,0 +1,51 @@
+'use strict';
+
+const assert = require('node:assert').strict;
+const { describe, it } = require('node:test');
+const util = require('node:util');
+const exec = util.promisify(require('node:child_process').exec);
+
+const Segfault = require('..');
+
+
+describe('Handler Stats', () => {
+	it('starts with no reports', () => {
+		const stats = Segfault.getHandlerStats();
+		assert.deepStrictEqual(stats.signals, {});
+		assert.strictEqual(stats.reports, 0);
+		assert.strictEqual(stats.phases.unwind.count, 0);
+		assert.strictEqual(stats.phases.write.histogram.length, 16);
+	});
+
+	if (process.platform !== 'win32') {
+		it('counts a report that the process survives', async () => {
+			const { stdout } = await exec(
+				'node -e "const sf = require(\'.\'); sf.setOutputFormat(true); sf.setSignal(sf.SIGILL, true); ' +
+				'sf.causeIllegal(); console.log(JSON.stringify(sf.getHandlerStats()))"'
+			);
+			const stats = JSON.parse(stdout.split('\n').find((line) => line.startsWith('{')));
+			assert.deepStrictEqual(stats.signals, { [Segfault.SIGILL]: 1 });
+			assert.strictEqual(stats.reports, 1);
+			assert.ok(stats.bytes > 0);
+			assert.strictEqual(stats.dropped, 0);
+			['unwind', 'symbolize', 'format', 'write'].forEach((name) => {
+				const phase = stats.phases[name];
+				assert.strictEqual(phase.count, 1);
+				assert.ok(phase.maxUs >= phase.avgUs);
+				assert.strictEqual(phase.histogram.reduce((sum, count) => sum + count, 0), 1);
+			});
+		});
+
+		it('reports the phases with each crash', async () => {
+			let stderr = '';
+			try {
+				await exec('node -e "const sf = require(\'.\'); sf.setOutputFormat(true); sf.causeSegfault()"');
+			} catch (error) {
+				stderr = error.stderr;
+			}
+			const report = JSON.parse(stderr.split('\n').find((line) => line.startsWith('{')));
+			assert.deepStrictEqual(Object.keys(report.phases_us), ['unwind', 'symbolize', 'format', 'write']);
+			assert.ok(Object.values(report.phases_us).every((us) => Number.isInteger(us) && us >= 0));
+		});
+	}
+});
@@ -0,0 +1,71 @@
+'use strict';
+
+const assert = require('node:assert').strict;
+const { describe, it } = require('node:test');
+const util = require('node:util');
+const exec = util.promisify(require('node:child_process').exec);
+
+const { symbolizeReport } = require('../src/js/symbolize');
+
+
+const runRaw = async (useJson) => {
+	let response = '';
+	try {
+		const command = 'node -e "const sf = require(\'.\'); sf.setRawAddresses(true); ' +
+			`sf.setOutputFormat(${useJson}); sf.causeSegfault()"`;
+		const { stderr, stdout } = await exec(command);
+		response = stderr + stdout;
+	} catch (error) {
+		response = error.stderr || error.message;
+	}
+	return response;
+};
+
+
+describe('Raw Addresses', () => {
+	it('can get and set raw address mode', async () => {
+		const { stdout } = await exec(
+			'node -e "const sf = require(\'.\'); const a = sf.getRawAddresses(); ' +
+			'sf.setRawAddresses(true); console.log(a, sf.getRawAddresses())"'
+		);
+		assert.strictEqual(stdout.trim(), 'false true');
+	});
+	
+	// Module tables and offline symbolization are ELF-only
+	if (process.platform === 'linux') {
+		it('reports module, base and offset instead of symbols in JSON', async () => {
+			const response = await runRaw(true);
+			const line = response.split('\n').find((l) => l.includes('"type":"segfault"'));
+			const report = JSON.parse(line);
+			const frame = report.stack.find((f) => f.module);
+			
+			assert.ok(frame, 'Should have frames with modules');
+			assert.strictEqual(frame.symbol, undefined);
+			assert.ok(frame.base.startsWith('0x'));
+			assert.strictEqual(
+				BigInt(frame.address), BigInt(frame.base) + BigInt(frame.offset),
+				'address should be base + offset'
+			);
+		});
+		
+		it('symbolizes JSON reports offline', async () => {
+			const response = await runRaw(true);
+			const symbolized = symbolizeReport(response, { lines: false });
+			const line = symbolized.split('\n').find((l) => l.includes('"type":"segfault"'));
+			const report = JSON.parse(line);
+			
+			assert.ok(
+				report.stack.some((f) => f.symbol && f.symbol.includes('causeSegfault')),
+				`Expected causeSegfault in ${line}`
+			);
+		});
+		
+		it('symbolizes plain text reports offline', async () => {
+			const response = await runRaw(false);
+			assert.match(response, /^#0 0x[0-9a-f]+ .+\+0x[0-9a-f]+ \(base 0x[0-9a-f]+\)$/m);
+			
+			const symbolized = symbolizeReport(response, { lines: false });
+			assert.match(symbolized, /causeSegfault.*\+0x[0-9a-f]+/);
+		});
+	}
+});
@@ -0,0 +1,43 @@
+'use strict';
+
+const assert = require('node:assert').strict;
+const { describe, it } = require('node:test');
+const util = require('node:util');
+const exec = util.promisify(require('node:child_process').exec);
+
+const Segfault = require('..');
+
+
+describe('Thread Dump', () => {
+	it('rejects an invalid timeout', () => {
+		assert.throws(() => Segfault.setThreadDump(true, 0), /timeout must be from 1 to 10000 ms/);
+		assert.strictEqual(Segfault.getThreadDump(), null);
+	});
+
+	if (process.platform === 'linux') {
+		it('reports the stacks of all threads on a crash', async () => {
+			let stderr = '';
+			try {
+				await exec(
+					'node -e "const sf = require(\'.\'); sf.setOutputFormat(true); sf.setThreadDump(true, 1000); ' +
+					'sf.causeSegfault()"'
+				);
+			} catch (error) {
+				stderr = error.stderr;
+			}
+
+			const report = JSON.parse(stderr.split('\n').find((line) => line.startsWith('{')));
+			assert.strictEqual(report.tid, report.pid, 'The main thread crashed');
+			assert.strictEqual(typeof report.thread_name, 'string');
+			assert.ok(report.threads.length > 0, 'Node always has helper threads');
+			assert.ok(report.threads.every((thread) => thread.tid !== report.tid));
+
+			const captured = report.threads.filter((thread) => thread.captured);
+			assert.ok(captured.length > 0, 'Some threads should answer');
+			assert.ok(
+				captured.some((thread) => thread.stack.some((frame) => /uv_cond_wait|uv_run/.test(frame.symbol))),
+				'Idle libuv and platform workers wait in libuv'
+			);
+		});
+	}
+});
@@ -0,0 +1,61 @@
+'use strict';
+
+const assert = require('node:assert').strict;
+const fs = require('node:fs');
+const { describe, it } = require('node:test');
+const util = require('node:util');
+const exec = util.promisify(require('node:child_process').exec);
+
+
+const getJsonStack = async (unwinder = 'cfi') => {
+	let response = '';
+	try {
+		await exec(
+			'node -e "const sf = require(\'.\'); sf.setOutputFormat(true); ' +
+			`sf.setUnwinder('${unwinder}'); sf.causeSegfault()"`
+		);
+	} catch (error) {
+		response = error.stderr;
+	}
+	const line = response.split('\n').find((l) => l.includes('"type":"segfault"'));
+	return JSON.parse(line).stack;
+};
+
+
+describe('Unwinder', () => {
+	it('can get and set the unwinder', async () => {
+		const { stdout } = await exec(
+			'node -e "const sf = require(\'.\'); sf.setUnwinder(\'fp\'); const a = sf.getUnwinder(); ' +
+			'sf.setUnwinder(\'cfi\'); console.log(a, sf.getUnwinder())"'
+		);
+		assert.strictEqual(stdout.trim(), 'fp cfi');
+	});
+	
+	it('rejects unknown unwinders', () => {
+		const Segfault = require('..');
+		assert.throws(() => Segfault.setUnwinder('magic'));
+	});
+	
+	// The built-in CFI unwinder covers Linux on x86_64 and aarch64
+	if (process.platform !== 'linux' || !['x64', 'arm64'].includes(process.arch)) {
+		return;
+	}
+	
+	['cfi', 'fp'].forEach((unwinder) => {
+		it(`starts at the crashing function (${unwinder})`, async () => {
+			const stack = await getJsonStack(unwinder);
+			assert.match(stack[0].symbol, /_segfaultStackFrame1/);
+		});
+		
+		it(`unwinds through the addon into the executable (${unwinder})`, async () => {
+			const stack = await getJsonStack(unwinder);
+			const executable = fs.realpathSync(process.execPath);
+			const addonIndex = stack.findIndex((f) => f.symbol.includes('causeSegfault'));
+			const nodeIndex = stack.findIndex((f) => f.symbol.startsWith(`${executable}(`));
+			
+			assert.ok(addonIndex >= 0, 'Should have the addon caller');
+			assert.ok(nodeIndex > addonIndex, 'Should continue into the node executable');
+			assert.ok(stack.length > 5, `Expected a deep stack, got ${stack.length} frames`);
+		});
+	});
+});
@@ -0,0 +1,69 @@
+'use strict';
+
+const assert = require('node:assert').strict;
+const { describe, it } = require('node:test');
+const fs = require('node:fs');
+const os = require('node:os');
+const path = require('node:path');
+const util = require('node:util');
+const exec = util.promisify(require('node:child_process').exec);
+
+const Segfault = require('..');
+
+
+// The child blocks its loop for `blockMs` after a short delay, then exits normally
+const runWatched = async (blockMs, setup = 'sf.setOutputFormat(true);') => {
+	const { stdout, stderr } = await exec(
+		'node -e "const sf = require(\'.\'); ' + setup + ' sf.startWatchdog({ threshold: 200 }); ' +
+		'setTimeout(() => { const until = Date.now() + ' + blockMs + '; while (Date.now() < until); }, 50); ' +
+		'setTimeout(() => { console.log(sf.getWatchdog().stalls); sf.stopWatchdog(); }, ' + (blockMs + 400) + ');"'
+	);
+	return { stalls: Number(stdout.trim()), stderr };
+};
+
+
+describe('Watchdog', () => {
+	it('rejects invalid options', () => {
+		assert.throws(() => Segfault.startWatchdog({ threshold: 1 }), /`threshold` must be an integer from 10/);
+		assert.strictEqual(Segfault.getWatchdog(), null);
+	});
+
+	if (process.platform === 'linux') {
+		it('reports the stack of a stalled loop once per stall', async () => {
+			const { stalls, stderr } = await runWatched(800);
+			assert.strictEqual(stalls, 1);
+
+			const reports = stderr.split('\n').filter((line) => line.includes('"type":"stall"'));
+			assert.strictEqual(reports.length, 1);
+			const report = JSON.parse(reports[0]);
+			assert.strictEqual(report.level, 'WARN');
+			assert.ok(report.duration_ms >= 200);
+			assert.strictEqual(report.tid, report.pid, 'Should capture the main thread');
+			assert.ok(
+				report.stack.some((frame) => /uv_run/.test(frame.symbol)),
+				'Should unwind into the event loop'
+			);
+		});
+
+		it('reports stalls to the crash sinks', async () => {
+			const logPath = path.join(os.tmpdir(), `segfault-watchdog-${process.pid}.log`);
+			fs.rmSync(logPath, { force: true });
+			const { stalls, stderr } = await runWatched(
+				800, `sf.setCrashSinks([{ type: 'stderr' }, { type: 'file', format: 'json', path: '${logPath}' }]);`
+			);
+			const log = fs.readFileSync(logPath, 'utf8');
+			fs.rmSync(logPath, { force: true });
+
+			assert.strictEqual(stalls, 1);
+			assert.match(stderr, /PID \d+ event loop blocked for \d+ ms/);
+			assert.ok(!stderr.includes('"type":"stall"'));
+			assert.strictEqual(JSON.parse(log).type, 'stall');
+		});
+
+		it('stays silent while the loop is healthy', async () => {
+			const { stalls, stderr } = await runWatched(0);
+			assert.strictEqual(stalls, 0);
+			assert.ok(!stderr.includes('"type":"stall"'));
+		});
+	}
+});